@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @file       latency_trace.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Gyro to motor latency histograms for the control loop
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef _LATENCY_TRACE_H
+#define _LATENCY_TRACE_H
+
+#include <stdint.h>
+
+/**
+ * The hops a gyro sample takes to the motors, in the order of the
+ * LoopLatency elements.  The wake stages are from the firing of the
+ * UAVObject event to the consumer running, as given by the event's
+ * timestamp; the total is from the sample's origin to the outputs.
+ */
+enum latency_trace_stage {
+	LATENCY_TRACE_SENSORS,		/* sample received -> Gyros set */
+	LATENCY_TRACE_STABILIZATION_WAKE,
+	LATENCY_TRACE_STABILIZATION,	/* -> ActuatorDesired set */
+	LATENCY_TRACE_ACTUATOR_WAKE,
+	LATENCY_TRACE_ACTUATOR,		/* -> outputs updated */
+	LATENCY_TRACE_TOTAL,
+	LATENCY_TRACE_NUM_STAGES
+};
+
+int32_t latency_trace_init(void);
+
+void latency_trace_record(enum latency_trace_stage stage, uint32_t from_raw,
+		uint32_t to_raw);
+
+void latency_trace_publish(void);
+
+#endif /* _LATENCY_TRACE_H */
@@ -65,9 +65,48 @@ struct fileresp_data {
 	uint8_t flags;
 } __attribute__((packed));
 
+/*
+ * A batch frame carries several objects after a minimal header (whose object
+ * ID is unused and zero).  Each object is a record of:
+ *   object ID (4), length (1), instance ID (2, multi-instance objects only),
+ *   object data
+ * where length counts the bytes after it, so unknown objects can be skipped.
+ * Batches are kept to what the GCS can take, which reads one length byte.
+ */
+struct batch_record_header {
+	uint32_t objId;
+	uint8_t length;
+} __attribute__((packed));
+
+#define UAVTALK_BATCH_MAX_LENGTH        255
+#define UAVTALK_BATCH_MAX_PAYLOAD       ((int)(UAVTALK_BATCH_MAX_LENGTH - UAVTALK_MIN_HEADER_LENGTH))
+
+/*
+ * A delta frame has the usual header and instance ID, then the CRC-16-CCITT
+ * (little endian) of the keyframe it applies to, a bitmap with one bit per 4-byte word of the
+ * object (LSB first) and the words whose bit is set; a final partial word is
+ * sent at its actual length.  Keyframes are plain object messages, and the
+ * receiver keeps the last one it got as the reference.  Any full object
+ * message replaces that reference, so the check is 16 bits wide to make
+ * applying a delta to the wrong base unlikely.
+ */
+struct delta_ref {
+	UAVObjHandle obj;
+	uint8_t *data;		//!< Last keyframe sent
+	uint16_t instId;
+	uint16_t crc;		//!< CRC-16-CCITT of data
+	uint8_t sinceKeyframe;
+};
+
+#define UAVTALK_DELTA_WORD              4
+#define UAVTALK_DELTA_CRC_LENGTH        2
+#define UAVTALK_DELTA_SLOTS             8
+#define UAVTALK_DELTA_KEYFRAME_INTERVAL 16
+
 typedef uint8_t uavtalk_checksum;
 #define UAVTALK_CHECKSUM_LENGTH         sizeof(uavtalk_checksum)
-#define UAVTALK_MAX_PAYLOAD_LENGTH      (UAVOBJECTS_LARGEST + 1)
+#define UAVTALK_MAX_PAYLOAD_LENGTH      ((UAVOBJECTS_LARGEST > UAVTALK_BATCH_MAX_PAYLOAD ? \
+		UAVOBJECTS_LARGEST : UAVTALK_BATCH_MAX_PAYLOAD) + 1)
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
@@ -96,6 +135,15 @@ typedef struct {
 	uint32_t txSize;
 	uint8_t *txBuffer;
 
+	// Batch frame being built, allocated on first use
+	uint8_t *batchBuffer;
+	uint16_t batchLength;
+	uint8_t batchCount;
+	uint16_t batchObjectBytes;
+
+	// Keyframes of delta-encoded objects, allocated on first use
+	struct delta_ref *deltaRefs;
+
 	UAVTalkOutputCb outCb;
 	UAVTalkAckCb ackCb;
 	UAVTalkFileCb fileCb;
@@ -116,10 +164,13 @@ typedef struct {
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
 #define UAVTALK_TYPE_FILEREQ   (UAVTALK_TYPE_VER | 0x08)
 #define UAVTALK_TYPE_FILEDATA  (UAVTALK_TYPE_VER | 0x09)
+#define UAVTALK_TYPE_OBJ_BATCH (UAVTALK_TYPE_VER | 0x0A)
+#define UAVTALK_TYPE_OBJ_DELTA (UAVTALK_TYPE_VER | 0x0B)
 #define UAVTALK_TYPE_OBJ_TS    (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 
 #define UAVTALK_FILEDATA_EOF   0x01
 #define UAVTALK_FILEDATA_LAST  0x02
+#define UAVTALK_FILEDATA_ERROR 0x04
 
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
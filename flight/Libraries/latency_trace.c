@@ -0,0 +1,225 @@
+/**
+ ******************************************************************************
+ * @file       latency_trace.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @brief      Gyro to motor latency histograms for the control loop
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "openpilot.h"
+#include "latency_trace.h"
+#include "misc_math.h"
+#include "looplatency.h"
+
+#ifdef SIM_POSIX
+#include <stdio.h>
+
+/* Publishing periods between dumps to the console */
+#define LATENCY_TRACE_DUMP_EVERY 10
+#endif
+
+/* Exact below 16us, then four buckets an octave up to 16ms.  The last
+ * bucket also takes everything beyond. */
+#define LATENCY_TRACE_BUCKETS 56
+
+DONT_BUILD_IF(LOOPLATENCY_P50_NUMELEM != LATENCY_TRACE_NUM_STAGES, LatencyTraceStages);
+
+/*
+ * Each stage is recorded from one task only, and its counts only ever
+ * grow, so the publisher never writes them: it takes the difference to
+ * the counts it saw last time.  The maximum can't be differenced, so it
+ * is kept per publishing period, in a slot picked by the period's parity
+ * that the recording task clears when it first sees a new period.
+ */
+struct latency_hist {
+	uint16_t count[LATENCY_TRACE_BUCKETS];
+	uint16_t seen[LATENCY_TRACE_BUCKETS];
+	uint32_t max[2];
+	uint32_t max_period;
+};
+
+struct latency_trace {
+	struct latency_hist hist[LATENCY_TRACE_NUM_STAGES];
+	volatile uint32_t period;
+};
+
+static struct latency_trace *trace;
+
+static uint8_t bucket_of(uint32_t us)
+{
+	if (us < 16) {
+		return us;
+	}
+
+	int msb = 31 - __builtin_clz(us);
+	uint32_t bucket = 16 + (msb - 4) * 4 + ((us >> (msb - 2)) & 3);
+
+	return MIN(bucket, LATENCY_TRACE_BUCKETS - 1);
+}
+
+//! Largest latency that falls in the bucket
+static uint32_t bucket_top(uint8_t bucket)
+{
+	if (bucket < 16) {
+		return bucket;
+	}
+
+	int msb = 4 + (bucket - 16) / 4;
+
+	return ((5 + (bucket - 16) % 4) << (msb - 2)) - 1;
+}
+
+static uint16_t percentile(const uint16_t *window, uint32_t samples,
+		uint32_t pct)
+{
+	if (samples == 0) {
+		return 0;
+	}
+
+	uint32_t rank = (samples * pct + 99) / 100;
+	uint32_t seen = 0;
+
+	for (int i = 0; i < LATENCY_TRACE_BUCKETS; i++) {
+		seen += window[i];
+
+		if (seen >= rank) {
+			return MIN(bucket_top(i), UINT16_MAX);
+		}
+	}
+
+	return UINT16_MAX;
+}
+
+/**
+ * Start tracing.  Until this is called recording does nothing, so the
+ * modules can record unconditionally and only targets built with
+ * DIAG_LATENCY pay for the histograms.
+ * \return 0 on success, -1 on failure
+ */
+int32_t latency_trace_init(void)
+{
+	if (LoopLatencyInitialize() == -1) {
+		return -1;
+	}
+
+	struct latency_trace *t = PIOS_malloc(sizeof(*t));
+
+	if (t == NULL) {
+		return -1;
+	}
+
+	memset(t, 0, sizeof(*t));
+
+	trace = t;
+
+	return 0;
+}
+
+/**
+ * Record the latency of one stage
+ * \param[in] stage The stage
+ * \param[in] from_raw PIOS_DELAY_GetRaw() time the stage started
+ * \param[in] to_raw PIOS_DELAY_GetRaw() time the stage ended
+ */
+void latency_trace_record(enum latency_trace_stage stage, uint32_t from_raw,
+		uint32_t to_raw)
+{
+	if (trace == NULL) {
+		return;
+	}
+
+	struct latency_hist *hist = &trace->hist[stage];
+	uint32_t us = PIOS_DELAY_DiffuS2(from_raw, to_raw);
+	uint32_t period = trace->period;
+
+	hist->count[bucket_of(us)]++;
+
+	if (hist->max_period != period) {
+		hist->max[period & 1] = 0;
+		hist->max_period = period;
+	}
+
+	if (us > hist->max[period & 1]) {
+		hist->max[period & 1] = us;
+	}
+}
+
+#ifdef SIM_POSIX
+static void dump(const LoopLatencyData *data)
+{
+	static const char * const names[LATENCY_TRACE_NUM_STAGES] = {
+		"Sensors", "StabilizationWake", "Stabilization",
+		"ActuatorWake", "Actuator", "Total"
+	};
+
+	printf("Loop latency (us)       p50     p99     max  samples\n");
+
+	for (int i = 0; i < LATENCY_TRACE_NUM_STAGES; i++) {
+		printf("  %-18s %7u %7u %7u %8u\n", names[i],
+				data->P50[i], data->P99[i], data->Max[i],
+				data->Samples[i]);
+	}
+}
+#endif
+
+/**
+ * Update LoopLatency with the stages' latencies since the last call.
+ * To be called periodically, from one task.
+ */
+void latency_trace_publish(void)
+{
+	if (trace == NULL) {
+		return;
+	}
+
+	LoopLatencyData data;
+	uint32_t period = trace->period;
+
+	/* Recording moves on to the other max slot from here */
+	trace->period = period + 1;
+
+	for (int i = 0; i < LATENCY_TRACE_NUM_STAGES; i++) {
+		struct latency_hist *hist = &trace->hist[i];
+		uint16_t window[LATENCY_TRACE_BUCKETS];
+		uint32_t samples = 0;
+
+		for (int j = 0; j < LATENCY_TRACE_BUCKETS; j++) {
+			uint16_t count = hist->count[j];
+
+			window[j] = count - hist->seen[j];
+			hist->seen[j] = count;
+			samples += window[j];
+		}
+
+		data.P50[i] = percentile(window, samples, 50);
+		data.P99[i] = percentile(window, samples, 99);
+		data.Max[i] = (hist->max_period == period) ?
+			MIN(hist->max[period & 1], UINT16_MAX) : 0;
+		data.Samples[i] = MIN(samples, UINT16_MAX);
+	}
+
+	LoopLatencySet(&data);
+
+#ifdef SIM_POSIX
+	if (period % LATENCY_TRACE_DUMP_EVERY == LATENCY_TRACE_DUMP_EVERY - 1) {
+		dump(&data);
+	}
+#endif
+}
@@ -59,17 +59,23 @@ static const float lpfilter_butterworth_factors[16] = {
 	0.3902f, 1.1111f, 1.6629f, 1.9616f
 };
 
-struct lpfilter_biquad_state {
-	float x1, x2, y1, y2;
-};
-
+/**
+ * One second order section, shared by all axes of the filter.
+ *
+ * The state is kept structure-of-arrays (all x1, then all x2, ...) in a
+ * single allocation, so a section runs across every axis in one loop
+ * with the coefficients held in registers. Both section types have
+ * b2 == b0, so only b0 and the feedback terms are stored; a1 and a2 are
+ * stored negated so everything is a sum.
+ */
 struct lpfilter_biquad {
 	float b0, a1, a2;
-	struct lpfilter_biquad_state *s;
+	float *x1, *x2, *y1, *y2;
 };
 
 struct lpfilter_first_order {
 	float alpha;
+	float beta;	// 1 - alpha
 	float *prev;
 };
 
@@ -77,11 +83,36 @@ struct lpfilter_state {
 
 	struct lpfilter_first_order *first_order;
 	struct lpfilter_biquad *biquad[4];
+	struct lpfilter_biquad *notch[LPFILTER_MAX_NOTCHES];
 	uint8_t order;
 	uint8_t width;
+	uint8_t notch_active;	// bitmask over notch[]
 
 };
 
+static struct lpfilter_biquad *lpfilter_alloc_biquad(uint8_t width)
+{
+	struct lpfilter_biquad *b = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad));
+	if(!b)
+		PIOS_Assert(0);
+
+	float *s = PIOS_malloc_no_dma(sizeof(float) * 4 * width);
+	if(!s)
+		PIOS_Assert(0);
+
+	b->x1 = s;
+	b->x2 = s + width;
+	b->y1 = s + 2 * width;
+	b->y2 = s + 3 * width;
+
+	return b;
+}
+
+static void lpfilter_reset_biquad(struct lpfilter_biquad *b, uint8_t width)
+{
+	memset((void*)b->x1, 0, sizeof(float) * 4 * width);
+}
+
 void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, float dT, float q, uint8_t width)
 {
 	float f = 1.0f / tanf((float)M_PI*cutoff*dT);
@@ -92,11 +123,7 @@ void lpfilter_construct_single_biquad(struct lpfilter_biquad *b, float cutoff, f
 	b->a1 = 2.0f * (f*f - 1.0f) * b->b0;
 	b->a2 = -(1.0f - q*f + f*f) * b->b0;
 
-	b->s = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad_state)*width);
-	if(!b->s)
-		PIOS_Assert(0);
-
-	memset((void*)b->s, 0, sizeof(struct lpfilter_biquad_state)*width);
+	lpfilter_reset_biquad(b, width);
 }
 
 void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, int o, uint8_t width)
@@ -116,11 +143,9 @@ void lpfilter_construct_biquads(lpfilter_state_t filt, float cutoff, float dT, i
 	// Create all necessary biquads and allocate, too, if not yet done so.
 	for(int i = 0; i < len; i++)
 	{
-		if(!filt->biquad[i]) {
-			filt->biquad[i] = PIOS_malloc_no_dma(sizeof(struct lpfilter_biquad));
-			if(!filt->biquad[i])
-				PIOS_Assert(0);
-		}
+		if(!filt->biquad[i])
+			filt->biquad[i] = lpfilter_alloc_biquad(width);
+
 		lpfilter_construct_single_biquad(filt->biquad[i], cutoff, dT, lpfilter_butterworth_factors[addr+i], width);
 	}
 }
@@ -147,6 +172,10 @@ void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8
 		PIOS_Assert(0);
 	}
 
+	// Notches can be configured on a bypassed filter, so the width
+	// has to be known either way.
+	filter->width = width;
+
 	// Clamp order count. If zero, this bypasses the filter.
 	if(order == 0) {
 		filter->order = 0;
@@ -166,94 +195,161 @@ void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8
 		}
 
 		filter->first_order->alpha = expf(-2.0f * (float)(M_PI) * cutoff * dT);
+		filter->first_order->beta = 1 - filter->first_order->alpha;
 		memset((void*)filter->first_order->prev, 0, sizeof(float)*width);
 	}
 
 	filter->order = order;
-	filter->width = width;
 	lpfilter_construct_biquads(filter, cutoff, dT, order, width);
 }
 
-float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
+void lpfilter_set_notch(lpfilter_state_t filter, uint8_t idx, float center, float q, float dT)
 {
-	if(!filter)
-		return sample;
-
-	if(axis >= filter->width) {
+	if(!filter || !filter->width || idx >= LPFILTER_MAX_NOTCHES) {
 		PIOS_Assert(0);
 	}
 
-	int order = filter->order;
+	if(center <= 0.0f || center >= 0.5f / dT) {
+		filter->notch_active &= ~(1 << idx);
+		return;
+	}
 
-	// Order at zero means bypass.
-	if(!order)
-		return sample;
+	struct lpfilter_biquad *b = filter->notch[idx];
 
-	if(order & 0x1) {
-		// Odd order filter
-		filter->first_order->prev[axis] *= filter->first_order->alpha;
-		filter->first_order->prev[axis] += (1 - filter->first_order->alpha) * sample;
-		sample = filter->first_order->prev[axis];
+	if(!b) {
+		b = filter->notch[idx] = lpfilter_alloc_biquad(filter->width);
+		lpfilter_reset_biquad(b, filter->width);
+	} else if(!(filter->notch_active & (1 << idx))) {
+		// Don't ring on stale history from when it was last on
+		lpfilter_reset_biquad(b, filter->width);
 	}
 
-	// Run all generated biquads.
-	order >>= 1;
-	for(int i = 0; i < order; i++)
+	// RBJ cookbook notch, normalized by a0. b1 == -a1, which the
+	// section exploits; see lpfilter_notch_step().
+	float w0 = 2.0f * (float)M_PI * center * dT;
+	float alpha = sinf(w0) / (2.0f * q);
+	float a0_inv = 1.0f / (1.0f + alpha);
+
+	b->b0 = a0_inv;
+	b->a1 = 2.0f * cosf(w0) * a0_inv;
+	b->a2 = -(1.0f - alpha) * a0_inv;
+
+	filter->notch_active |= 1 << idx;
+}
+
+/*
+ * The sections below are Direct Form I: the history is the actual past
+ * input and output, so coefficients may change from one sample to the
+ * next (a tracking notch) without disturbing the state.
+ */
+
+static inline void lpfilter_first_order_step(const struct lpfilter_first_order *f,
+		float *sample, uint8_t first, uint8_t n)
+{
+	const float alpha = f->alpha;
+	const float beta = f->beta;
+	float * restrict prev = f->prev + first;
+
+	for(int j = 0; j < n; j++)
 	{
-		struct lpfilter_biquad *b = filter->biquad[i];
-		struct lpfilter_biquad_state *s = &b->s[axis];
+		prev[j] = prev[j] * alpha + beta * sample[j];
+		sample[j] = prev[j];
+	}
+}
 
-		float y = b->b0 * (sample + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
+static inline void lpfilter_lowpass_step(const struct lpfilter_biquad *b,
+		float *sample, uint8_t first, uint8_t n)
+{
+	const float b0 = b->b0, a1 = b->a1, a2 = b->a2;
+	float * restrict x1 = b->x1 + first;
+	float * restrict x2 = b->x2 + first;
+	float * restrict y1 = b->y1 + first;
+	float * restrict y2 = b->y2 + first;
 
-		s->y2 = s->y1;
-		s->y1 = y;
+	for(int j = 0; j < n; j++)
+	{
+		// Butterworth lowpass: b1 = 2 * b0, b2 = b0
+		float y = b0 * (sample[j] + 2.0f * x1[j] + x2[j]) + a1 * y1[j] + a2 * y2[j];
+
+		y2[j] = y1[j];
+		y1[j] = y;
 
-		s->x2 = s->x1;
-		s->x1 = sample;
+		x2[j] = x1[j];
+		x1[j] = sample[j];
 
-		sample = y;
+		sample[j] = y;
 	}
+}
 
-	return sample;
+static inline void lpfilter_notch_step(const struct lpfilter_biquad *b,
+		float *sample, uint8_t first, uint8_t n)
+{
+	const float b0 = b->b0, a1 = b->a1, a2 = b->a2;
+	float * restrict x1 = b->x1 + first;
+	float * restrict x2 = b->x2 + first;
+	float * restrict y1 = b->y1 + first;
+	float * restrict y2 = b->y2 + first;
+
+	for(int j = 0; j < n; j++)
+	{
+		// Notch: b2 = b0, b1 = -a1
+		float y = b0 * (sample[j] + x2[j]) + a1 * (y1[j] - x1[j]) + a2 * y2[j];
+
+		y2[j] = y1[j];
+		y1[j] = y;
+
+		x2[j] = x1[j];
+		x1[j] = sample[j];
+
+		sample[j] = y;
+	}
 }
 
-void lpfilter_run(lpfilter_state_t filter, float *sample)
+/**
+ * Run every stage over n consecutive axes starting at first. Each stage
+ * finishes all the axes before the next one starts.
+ */
+static inline void lpfilter_run_axes(lpfilter_state_t filter, float *sample,
+		uint8_t first, uint8_t n)
 {
-	if(!filter) return;
 	int order = filter->order;
 
-	// Order at zero means bypass.
-	if(order == 0) return;
-
 	if(order & 0x1) {
 		// Odd order filter
-		for(int i = 0; i < filter->width; i++)
-		{
-			filter->first_order->prev[i] *= filter->first_order->alpha;
-			filter->first_order->prev[i] += (1 - filter->first_order->alpha) * sample[i];
-			sample[i] = filter->first_order->prev[i];
-		}
+		lpfilter_first_order_step(filter->first_order, sample, first, n);
 	}
 
 	// Run all generated biquads.
 	order >>= 1;
 	for(int i = 0; i < order; i++)
 	{
-		struct lpfilter_biquad *b = filter->biquad[i];
+		lpfilter_lowpass_step(filter->biquad[i], sample, first, n);
+	}
 
-		for(int j = 0; j < filter->width; j++)
-		{
-			struct lpfilter_biquad_state *s = &b->s[j];
+	for(int i = 0; filter->notch_active >> i; i++)
+	{
+		if(filter->notch_active & (1 << i))
+			lpfilter_notch_step(filter->notch[i], sample, first, n);
+	}
+}
 
-			float y = b->b0 * (sample[j] + 2.0f * s->x1 + s->x2) + b->a1 * s->y1 + b->a2 * s->y2;
+float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample)
+{
+	if(!filter)
+		return sample;
 
-			s->y2 = s->y1;
-			s->y1 = y;
+	if(axis >= filter->width) {
+		PIOS_Assert(0);
+	}
 
-			s->x2 = s->x1;
-			s->x1 = sample[j];
+	lpfilter_run_axes(filter, &sample, axis, 1);
 
-			sample[j] = y;
-		}
-	}
+	return sample;
+}
+
+void lpfilter_run(lpfilter_state_t filter, float *sample)
+{
+	if(!filter) return;
+
+	lpfilter_run_axes(filter, sample, 0, filter->width);
 }
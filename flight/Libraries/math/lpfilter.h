@@ -30,9 +30,23 @@
 #ifndef FILTER_H
 #define FILTER_H
 
+//! Notch sections that can follow the lowpass in one filter
+#define LPFILTER_MAX_NOTCHES	2
+
 typedef struct lpfilter_state* lpfilter_state_t;
 
 void lpfilter_create(lpfilter_state_t *filter_ptr, float cutoff, float dT, uint8_t order, uint8_t width);
+
+/**
+ * Configure a notch section after the lowpass, on every axis. May be
+ * called as often as every sample to track a moving frequency.
+ * @param[in] idx which notch, below LPFILTER_MAX_NOTCHES
+ * @param[in] center center frequency in Hz; zero (or above Nyquist) disables
+ * @param[in] q quality factor, center / bandwidth
+ * @param[in] dT sample period in seconds
+ */
+void lpfilter_set_notch(lpfilter_state_t filter, uint8_t idx, float center, float q, float dT);
+
 float lpfilter_run_single(lpfilter_state_t filter, uint8_t axis, float sample);
 void lpfilter_run(lpfilter_state_t filter, float *sample);
 
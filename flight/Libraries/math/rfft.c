@@ -0,0 +1,166 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Filtering support libraries
+ * @{
+ *
+ * @file       rfft.c
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Real-input fast Fourier transform
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "pios.h"
+#include "rfft.h"
+
+/*
+ * n real points are transformed as an n/2 point complex FFT of the
+ * even/odd interleaved samples (iterative radix-2, decimation in time),
+ * followed by the usual split step that untangles the two half-length
+ * spectra.  One twiddle table of exp(-2*pi*i*k/n), k < n/2, serves both.
+ */
+struct rfft_state {
+	uint16_t n;
+	uint16_t *bitrev;	// n/2 entries
+	float *twiddle;		// n/2 complex (cos, -sin) pairs
+};
+
+rfft_state_t rfft_create(uint16_t n)
+{
+	if(n < 8 || n > 4096 || (n & (n - 1)))
+		return NULL;
+
+	uint16_t m = n / 2;
+	uint8_t bits = 0;
+
+	while((1 << bits) < m)
+		bits++;
+
+	struct rfft_state *fft = PIOS_malloc_no_dma(sizeof(*fft));
+	if(!fft)
+		return NULL;
+
+	fft->bitrev = PIOS_malloc_no_dma(sizeof(uint16_t) * m);
+	fft->twiddle = PIOS_malloc_no_dma(sizeof(float) * 2 * m);
+	if(!fft->bitrev || !fft->twiddle)
+		return NULL;	// Can't free; the caller gives up on us
+
+	fft->n = n;
+
+	for(uint16_t i = 0; i < m; i++)
+	{
+		uint16_t r = 0;
+		for(uint8_t b = 0; b < bits; b++)
+			if(i & (1 << b))
+				r |= 1 << (bits - 1 - b);
+		fft->bitrev[i] = r;
+
+		float theta = 2.0f * (float)M_PI * i / n;
+		fft->twiddle[2 * i] = cosf(theta);
+		fft->twiddle[2 * i + 1] = -sinf(theta);
+	}
+
+	return fft;
+}
+
+void rfft_run(rfft_state_t fft, float *buf)
+{
+	const uint16_t n = fft->n;
+	const uint16_t m = n / 2;
+	const float *tw = fft->twiddle;
+
+	// Reorder the complex pairs
+	for(uint16_t i = 0; i < m; i++)
+	{
+		uint16_t j = fft->bitrev[i];
+		if(j > i) {
+			float re = buf[2 * i], im = buf[2 * i + 1];
+			buf[2 * i] = buf[2 * j];
+			buf[2 * i + 1] = buf[2 * j + 1];
+			buf[2 * j] = re;
+			buf[2 * j + 1] = im;
+		}
+	}
+
+	// Butterflies.  A span of `size` needs exp(-2*pi*i*k/size), which is
+	// every (n/size)th entry of the table.
+	for(uint16_t size = 2; size <= m; size <<= 1)
+	{
+		const uint16_t half = size >> 1;
+		const uint16_t stride = n / size;
+
+		for(uint16_t start = 0; start < m; start += size)
+		{
+			for(uint16_t k = 0; k < half; k++)
+			{
+				const float wr = tw[2 * k * stride];
+				const float wi = tw[2 * k * stride + 1];
+				float *a = &buf[2 * (start + k)];
+				float *b = &buf[2 * (start + k + half)];
+
+				float tr = b[0] * wr - b[1] * wi;
+				float ti = b[0] * wi + b[1] * wr;
+
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+
+	// Split into the spectrum of the real input.  With Z the half-length
+	// transform, E = (Z[k] + conj(Z[m-k]))/2 and O = -i*(Z[k] - conj(Z[m-k]))/2
+	// are the transforms of the even and odd samples, and
+	//   X[k] = E + W^k*O,  X[m-k] = conj(E - W^k*O)
+	float z0r = buf[0], z0i = buf[1];
+	buf[0] = z0r + z0i;
+	buf[1] = z0r - z0i;
+
+	for(uint16_t k = 1; k <= m / 2; k++)
+	{
+		float *zk = &buf[2 * k];
+		float *zm = &buf[2 * (m - k)];
+
+		float er = 0.5f * (zk[0] + zm[0]);
+		float ei = 0.5f * (zk[1] - zm[1]);
+		float or = 0.5f * (zk[1] + zm[1]);
+		float oi = -0.5f * (zk[0] - zm[0]);
+
+		const float wr = tw[2 * k], wi = tw[2 * k + 1];
+		float tr = or * wr - oi * wi;
+		float ti = or * wi + oi * wr;
+
+		zk[0] = er + tr;
+		zk[1] = ei + ti;
+		if(zm != zk) {
+			zm[0] = er - tr;
+			zm[1] = -(ei - ti);
+		}
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Filtering support libraries
+ * @{
+ *
+ * @file       rfft.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @brief      Real-input fast Fourier transform
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef RFFT_H
+#define RFFT_H
+
+typedef struct rfft_state* rfft_state_t;
+
+/**
+ * Prepare the tables for transforms of one length.
+ * @param[in] n number of real input points, a power of two from 8 to 4096
+ * @returns the transform state, or NULL if n is unsupported or out of memory
+ */
+rfft_state_t rfft_create(uint16_t n);
+
+/**
+ * Transform n real samples in place. The result is packed the same way
+ * as CMSIS arm_rfft_fast_f32: buf[0] is bin 0, buf[1] is bin n/2 (both
+ * purely real), and buf[2k], buf[2k+1] are the real and imaginary parts
+ * of bin k for 0 < k < n/2.
+ */
+void rfft_run(rfft_state_t fft, float *buf);
+
+#endif // RFFT_H
+
+/**
+ * @}
+ * @}
+ */
@@ -39,32 +39,37 @@
 #include "ecc.h"
 
 /* The Error Locator Polynomial, also known as Lambda or Sigma. Lambda[0] == 1 */
-static int Lambda[MAXDEG];
+static uint8_t Lambda[MAXDEG];
 
 /* The Error Evaluator Polynomial */
-static int Omega[MAXDEG];
+static uint8_t Omega[MAXDEG];
+
+/* Length of the LFSR Berlekamp-Massey found, the number of errors and
+ * erasures it accounts for */
+static int LambdaLen;
 
 /* local ANSI declarations */
-static int compute_discrepancy(int lambda[], int S[], int L, int n);
-static void init_gamma(int gamma[]);
+static uint8_t compute_discrepancy(const uint8_t lambda[], const uint8_t S[], int L, int n);
+static void init_gamma(uint8_t gamma[]);
 static void compute_modified_omega (void);
-static void mul_z_poly (int src[]);
+static void mul_z_poly (uint8_t src[]);
 
 /* error locations found using Chien's search*/
-static int ErrorLocs[256];
+static uint8_t ErrorLocs[MAXDEG];
 static int NErrors;
 
 /* erasure flags */
-static int ErasureLocs[256];
+static uint8_t ErasureLocs[MAXDEG];
 static int NErasures;
 
 /* From  Cain, Clark, "Error-Correction Coding For Digital Communications", pp. 216. */
 void
 Modified_Berlekamp_Massey (void)
 {	
-  int n, L, L2, k, d, i;
-  int psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
-  int gamma[MAXDEG];
+  int n, L, L2, k, i;
+  uint8_t d, dinv;
+  uint8_t psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
+  uint8_t gamma[MAXDEG];
 	
   /* initialize Gamma, the erasure locator polynomial */
   init_gamma(gamma);
@@ -90,18 +95,20 @@ Modified_Berlekamp_Massey (void)
 	L2 = n-k;
 	k = n-L;
 	/* D = scale_poly(ginv(d), psi); */
-	for (i = 0; i < MAXDEG; i++) D[i] = gmult(psi[i], ginv(d));
+	dinv = ginv(d);
+	for (i = 0; i < MAXDEG; i++) D[i] = gmult(psi[i], dinv);
 	L = L2;
       }
 			
       /* psi = psi2 */
-      for (i = 0; i < MAXDEG; i++) psi[i] = psi2[i];
+      copy_poly(psi, psi2);
     }
 		
     mul_z_poly(D);
   }
 	
-  for(i = 0; i < MAXDEG; i++) Lambda[i] = psi[i];
+  copy_poly(Lambda, psi);
+  LambdaLen = L;
   compute_modified_omega();
 
 	
@@ -114,35 +121,30 @@ Modified_Berlekamp_Massey (void)
 void
 compute_modified_omega ()
 {
-  int i;
-  int product[MAXDEG*2];
-	
-  mult_polys(product, Lambda, synBytes);	
-  zero_poly(Omega);
-  for(i = 0; i < RS_ECC_NPARITY; i++) Omega[i] = product[i];
+  int i, j;
+  uint8_t sum;
 
+  /* Only the terms below z^NPAR of the product are needed */
+  zero_poly(Omega);
+  for (i = 0; i < RS_ECC_NPARITY; i++) {
+    sum = 0;
+    for (j = 0; j <= i; j++) sum ^= gmult(Lambda[j], synBytes[i-j]);
+    Omega[i] = sum;
+  }
 }
 
 /* polynomial multiplication */
 void
-mult_polys (int dst[], int p1[], int p2[])
+mult_polys (uint8_t dst[], const uint8_t p1[], const uint8_t p2[])
 {
   int i, j;
-  int tmp1[MAXDEG*2];
 	
   for (i=0; i < (MAXDEG*2); i++) dst[i] = 0;
 	
   for (i = 0; i < MAXDEG; i++) {
-    for(j=MAXDEG; j<(MAXDEG*2); j++) tmp1[j]=0;
-		
-    /* scale tmp1 by p1[i] */
-    for(j=0; j<MAXDEG; j++) tmp1[j]=gmult(p2[j], p1[i]);
-    /* and mult (shift) tmp1 right by i */
-    for (j = (MAXDEG*2)-1; j >= i; j--) tmp1[j] = tmp1[j-i];
-    for (j = 0; j < i; j++) tmp1[j] = 0;
-		
-    /* add into partial product */
-    for(j=0; j < (MAXDEG*2); j++) dst[j] ^= tmp1[j];
+    if (p1[i] == 0) continue;
+    /* add p2 scaled by p1[i] and shifted right by i */
+    for (j = 0; j < MAXDEG; j++) dst[i+j] ^= gmult(p2[j], p1[i]);
   }
 }
 
@@ -150,9 +152,10 @@ mult_polys (int dst[], int p1[], int p2[])
 	
 /* gamma = product (1-z*a^Ij) for erasure locs Ij */
 void
-init_gamma (int gamma[])
+init_gamma (uint8_t gamma[])
 {
-  int e, tmp[MAXDEG];
+  int e;
+  uint8_t tmp[MAXDEG];
 	
   zero_poly(gamma);
   zero_poly(tmp);
@@ -169,7 +172,7 @@ init_gamma (int gamma[])
 	
 	
 void 
-compute_next_omega (int d, int A[], int dst[], int src[])
+compute_next_omega (uint8_t d, const uint8_t A[], uint8_t dst[], const uint8_t src[])
 {
   int i;
   for ( i = 0; i < MAXDEG;  i++) {
@@ -179,10 +182,11 @@ compute_next_omega (int d, int A[], int dst[], int src[])
 	
 
 
-int
-compute_discrepancy (int lambda[], int S[], int L, int n)
+uint8_t
+compute_discrepancy (const uint8_t lambda[], const uint8_t S[], int L, int n)
 {
-  int i, sum=0;
+  int i;
+  uint8_t sum=0;
 	
   for (i = 0; i <= L; i++) 
     sum ^= gmult(lambda[i], S[n-i]);
@@ -191,26 +195,26 @@ compute_discrepancy (int lambda[], int S[], int L, int n)
 
 /********** polynomial arithmetic *******************/
 
-void add_polys (int dst[], int src[]) 
+void add_polys (uint8_t dst[], const uint8_t src[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) dst[i] ^= src[i];
 }
 
-void copy_poly (int dst[], int src[]) 
+void copy_poly (uint8_t dst[], const uint8_t src[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) dst[i] = src[i];
 }
 
-void scale_poly (int k, int poly[]) 
+void scale_poly (uint8_t k, uint8_t poly[]) 
 {	
   int i;
   for (i = 0; i < MAXDEG; i++) poly[i] = gmult(k, poly[i]);
 }
 
 
-void zero_poly (int poly[]) 
+void zero_poly (uint8_t poly[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) poly[i] = 0;
@@ -218,7 +222,7 @@ void zero_poly (int poly[])
 
 
 /* multiply by z, i.e., shift right by 1 */
-static void mul_z_poly (int src[])
+static void mul_z_poly (uint8_t src[])
 {
   int i;
   for (i = MAXDEG-1; i > 0; i--) src[i] = src[i-1];
@@ -226,31 +230,51 @@ static void mul_z_poly (int src[])
 }
 
 
-/* Finds all the roots of an error-locator polynomial with coefficients
+/* Finds the roots of an error-locator polynomial with coefficients
  * Lambda[j] by evaluating Lambda at successive values of alpha. 
  * 
- * This can be tested with the decoder's equations case.
+ * Only roots that are locations within a codeword of csize bytes are
+ * looked for, and the search stops once there are as many as the
+ * degree of Lambda.  Each term Lambda[k]*a^(k*r) is kept as a log and
+ * stepped along by k, rather than multiplied out for every r.
+ *
+ * Returns the degree of Lambda.
  */
 
-
-void 
-Find_Roots (void)
+int
+Find_Roots (int csize)
 {
-  int sum, r, k;	
+  int r, k, deg;
+  int lg[MAXDEG];
+  uint8_t sum;
+
   NErrors = 0;
-  
-  for (r = 1; r < 256; r++) {
-    sum = 0;
-    /* evaluate lambda at r */
-    for (k = 0; k < RS_ECC_NPARITY+1; k++) {
-      sum ^= gmult(gexp[(k*r)%255], Lambda[k]);
+
+  for (deg = MAXDEG-1; deg > 0 && Lambda[deg] == 0; deg--);
+  if (deg == 0 || deg > RS_ECC_NPARITY) return (deg);
+
+  /* location 255-r has to be below csize */
+  r = 256 - csize;
+  if (r < 1) r = 1;
+
+  for (k = 1; k <= deg; k++)
+    lg[k] = (glog[Lambda[k]] + k*r) % 255;
+
+  for (; r < 256; r++) {
+    sum = Lambda[0];
+    for (k = 1; k <= deg; k++) {
+      if (Lambda[k]) sum ^= gexp[lg[k]];
+      lg[k] += k;
+      if (lg[k] >= 255) lg[k] -= 255;
     }
     if (sum == 0) 
       { 
 	ErrorLocs[NErrors] = (255-r); NErrors++; 
-	//if (DEBUG) fprintf(stderr, "Root found at r = %d, (255-r) = %d\n", r, (255-r));
+	if (NErrors == deg) break;
       }
   }
+
+  return (deg);
 }
 
 /* Combined Erasure And Error Magnitude Computation 
@@ -262,7 +286,10 @@ Find_Roots (void)
  * Evaluate Omega(actually Psi)/Lambda' at the roots
  * alpha^(-i) for error locs i. 
  *
- * Returns 1 if everything ok, or 0 if an out-of-bounds error is found
+ * Returns 1 if everything ok, or 0 if the codeword can't be corrected
+ * (too many errors for the parity, or the error locator doesn't have as
+ * many roots within the codeword as its degree) or there was nothing to
+ * correct.
  *
  */
 
@@ -272,42 +299,42 @@ correct_errors_erasures (unsigned char codeword[],
 			 int nerasures,
 			 int erasures[])
 {
-  int r, i, j, err;
+  int r, i, j, deg;
+  uint8_t num, denom, err;
+
+  /* Nothing to find */
+  if (!check_syndrome() && nerasures == 0) return (0);
 
   /* If you want to take advantage of erasure correction, be sure to
      set NErasures and ErasureLocs[] with the locations of erasures. 
      */
+  if (nerasures > RS_ECC_NPARITY) return (0);
   NErasures = nerasures;
   for (i = 0; i < NErasures; i++) ErasureLocs[i] = erasures[i];
 
   Modified_Berlekamp_Massey();
-  Find_Roots();
+  deg = Find_Roots(csize);
   
 
-  if ((NErrors <= RS_ECC_NPARITY) && NErrors > 0) { 
+  /* The locator is only unique while 2*errors + erasures <= NPAR, and
+   * it has to have the degree Berlekamp-Massey meant it to */
+  if ((NErrors <= RS_ECC_NPARITY) && NErrors > 0 && NErrors == deg &&
+      deg == LambdaLen && 2 * (deg - NErasures) + NErasures <= RS_ECC_NPARITY) { 
 
-    /* first check for illegal error locs */
     for (r = 0; r < NErrors; r++) {
-      if (ErrorLocs[r] >= csize) {
-				//if (DEBUG) fprintf(stderr, "Error loc i=%d outside of codeword length %d\n", i, csize);
-	return(0);
-      }
-    }
-
-    for (r = 0; r < NErrors; r++) {
-      int num, denom;
       i = ErrorLocs[r];
       /* evaluate Omega at alpha^(-i) */
 
       num = 0;
-      for (j = 0; j < MAXDEG; j++) 
-	num ^= gmult(Omega[j], gexp[((255-i)*j)%255]);
+      for (j = 0; j < RS_ECC_NPARITY; j++) 
+	if (Omega[j]) num ^= gexp[(glog[Omega[j]] + (255-i)*j) % 255];
       
       /* evaluate Lambda' (derivative) at alpha^(-i) ; all odd powers disappear */
       denom = 0;
-      for (j = 1; j < MAXDEG; j += 2) {
-	denom ^= gmult(Lambda[j], gexp[((255-i)*(j-1)) % 255]);
+      for (j = 1; j <= deg; j += 2) {
+	if (Lambda[j]) denom ^= gexp[(glog[Lambda[j]] + (255-i)*(j-1)) % 255];
       }
+      if (denom == 0) return (0);
       
       err = gmult(num, ginv(denom));
       //if (DEBUG) fprintf(stderr, "Error magnitude %#x at loc %d\n", err, csize-i);
@@ -321,4 +348,3 @@ correct_errors_erasures (unsigned char codeword[],
     return(0);
   }
 }
-
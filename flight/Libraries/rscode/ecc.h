@@ -60,12 +60,15 @@ typedef unsigned short BIT16;
 /* Maximum degree of various polynomials. */
 #define MAXDEG (RS_ECC_NPARITY*2)
 
+/* Most codewords interleaved by the *_interleaved routines */
+#define RS_ECC_MAX_INTERLEAVE 8
+
 /*************************************/
 /* Encoder parity bytes */
-extern int pBytes[MAXDEG];
+extern uint8_t pBytes[MAXDEG];
 
 /* Decoder syndrome bytes */
-extern int synBytes[MAXDEG];
+extern uint8_t synBytes[MAXDEG];
 
 /* print debugging info */
 extern int DEBUG;
@@ -76,25 +79,45 @@ int check_syndrome (void);
 void decode_data (unsigned char data[], int nbytes);
 void encode_data (unsigned char msg[], int nbytes, unsigned char dst[]);
 
+/* Interleaved codewords, for burst errors.  Byte k of the result, parity
+ * included, belongs to codeword k % depth; the result is nbytes +
+ * depth*RS_ECC_NPARITY long.  A burst of up to depth*RS_ECC_NPARITY/2
+ * bytes is correctable.
+ *
+ * decode_data_interleaved returns 0 if all codewords were clean, 1 if
+ * errors were corrected, -1 if any codeword was uncorrectable. */
+void encode_data_interleaved (unsigned char msg[], int nbytes, unsigned char dst[], int depth);
+int decode_data_interleaved (unsigned char codeword[], int csize, int depth);
+
 /* CRC-CCITT checksum generator */
 BIT16 crc_ccitt(unsigned char *msg, int len);
 
 /* galois arithmetic tables */
-extern const int gexp[];
-extern const int glog[];
+extern const uint8_t gexp[];
+extern const uint8_t glog[];
 
 void init_galois_tables (void);
-int ginv(int elt); 
-int gmult(int a, int b);
+
+/* multiplication using logarithms */
+static inline uint8_t gmult(uint8_t a, uint8_t b)
+{
+  if (a == 0 || b == 0) return (0);
+  return (gexp[glog[a] + glog[b]]);
+}
+
+static inline uint8_t ginv(uint8_t elt)
+{
+  return (gexp[255 - glog[elt]]);
+}
 
 
 /* Error location routines */
 int correct_errors_erasures (unsigned char codeword[], int csize,int nerasures, int erasures[]);
 
 /* polynomial arithmetic */
-void add_polys(int dst[], int src[]) ;
-void scale_poly(int k, int poly[]);
-void mult_polys(int dst[], int p1[], int p2[]);
+void add_polys(uint8_t dst[], const uint8_t src[]) ;
+void scale_poly(uint8_t k, uint8_t poly[]);
+void mult_polys(uint8_t dst[], const uint8_t p1[], const uint8_t p2[]);
 
-void copy_poly(int dst[], int src[]);
-void zero_poly(int poly[]);
+void copy_poly(uint8_t dst[], const uint8_t src[]);
+void zero_poly(uint8_t poly[]);
@@ -30,28 +30,40 @@
 #include "ecc.h"
 
 /* Encoder parity bytes */
-int pBytes[MAXDEG];
+uint8_t pBytes[MAXDEG];
 
 /* Decoder syndrome bytes */
-int synBytes[MAXDEG];
+uint8_t synBytes[MAXDEG];
+
+/* Nonzero if any syndrome byte is */
+static int synNonzero;
 
 /* generator polynomial */
-int genPoly[MAXDEG*2];
+uint8_t genPoly[MAXDEG*2];
+
+/* genMul[j][b] = genPoly[j] * b, for the LFSR taps */
+static uint8_t genMul[RS_ECC_NPARITY][256];
 
 int DEBUG = FALSE;
 
 static void
-compute_genpoly (int nbytes, int genpoly[]);
+compute_genpoly (int nbytes, uint8_t genpoly[]);
 
 /* Initialize lookup tables, polynomials, etc. */
 void
 initialize_ecc ()
 {
+  int j, b;
+
   /* Initialize the galois field arithmetic tables */
     init_galois_tables();
 
     /* Compute the encoder generator polynomial */
     compute_genpoly(RS_ECC_NPARITY, genPoly);
+
+    for (j = 0; j < RS_ECC_NPARITY; j++)
+      for (b = 0; b < 256; b++)
+	genMul[j][b] = gmult(genPoly[j], b);
 }
 
 void
@@ -99,24 +111,94 @@ build_codeword (unsigned char msg[], int nbytes, unsigned char dst[])
     dst[i+nbytes] = pBytes[RS_ECC_NPARITY-1-i];
   }
 }
-	
+
+/* Simulate a LFSR with generator polynomial for n byte RS code over
+ * count bytes of data, stride bytes apart.  The remainder of the data
+ * (times x^NPAR) divided by the generator is left in LFSR[], LFSR[j]
+ * being the coefficient of x^j.
+ */
+static void
+run_lfsr (const unsigned char data[], int count, int stride, uint8_t LFSR[])
+{
+  int i, j;
+  uint8_t dbyte;
+
+  for (j = 0; j < RS_ECC_NPARITY; j++) LFSR[j] = 0;
+
+  for (i = 0; i < count; i++, data += stride) {
+    dbyte = *data ^ LFSR[RS_ECC_NPARITY-1];
+    for (j = RS_ECC_NPARITY-1; j > 0; j--) {
+      LFSR[j] = LFSR[j-1] ^ genMul[j][dbyte];
+    }
+    LFSR[0] = genMul[0][dbyte];
+  }
+}
+
 /**********************************************************
  * Reed Solomon Decoder 
  *
  * Computes the syndrome of a codeword. Puts the results
  * into the synBytes[] array.
+ *
+ * The syndromes are the codeword evaluated at the roots of the
+ * generator, so they are also the remainder of the codeword divided by
+ * the generator evaluated there.  That remainder is the parity the
+ * encoder would produce for the data plus the parity received, which
+ * the LFSR finds a lot faster than evaluating the whole codeword
+ * NPAR times; when it is zero, so are all the syndromes.
  */
- 
+
+/* Syndromes of a codeword of count data bytes, stride apart, followed by
+ * RS_ECC_NPARITY parity bytes at parity[0], parity[pstride], ... */
+static int
+compute_syndromes (const unsigned char data[], int count, int stride,
+		   const unsigned char parity[], int pstride)
+{
+  uint8_t rem[RS_ECC_NPARITY];
+  int j, k;
+
+  run_lfsr(data, count, stride, rem);
+
+  synNonzero = 0;
+  for (k = 0; k < RS_ECC_NPARITY; k++) {
+    rem[k] ^= parity[(RS_ECC_NPARITY-1-k) * pstride];
+    synNonzero |= rem[k];
+  }
+
+  for (j = 0; j < RS_ECC_NPARITY; j++) synBytes[j] = 0;
+  if (!synNonzero) return 0;
+
+  /* S[j] = rem(a^(j+1)) */
+  for (k = 0; k < RS_ECC_NPARITY; k++) {
+    if (rem[k] == 0) continue;
+    for (j = 0; j < RS_ECC_NPARITY; j++) {
+      synBytes[j] ^= gexp[(glog[rem[k]] + (j+1) * k) % 255];
+    }
+  }
+
+  return 1;
+}
+
 void
 decode_data(unsigned char data[], int nbytes)
 {
   int i, j, sum;
+
+  if (nbytes >= RS_ECC_NPARITY) {
+    compute_syndromes(data, nbytes - RS_ECC_NPARITY, 1,
+		      data + nbytes - RS_ECC_NPARITY, 1);
+    return;
+  }
+
+  /* Too short to hold the parity; evaluate it directly */
+  synNonzero = 0;
   for (j = 0; j < RS_ECC_NPARITY;  j++) {
     sum	= 0;
     for (i = 0; i < nbytes; i++) {
       sum = data[i] ^ gmult(gexp[j+1], sum);
     }
     synBytes[j]  = sum;
+    synNonzero |= sum;
   }
 }
 
@@ -125,14 +207,7 @@ decode_data(unsigned char data[], int nbytes)
 int
 check_syndrome (void)
 {
- int i, nz = 0;
- for (i =0 ; i < RS_ECC_NPARITY; i++) {
-  if (synBytes[i] != 0) {
-      nz = 1;
-      break;
-  }
- }
- return nz;
+  return (synNonzero != 0);
 }
 
 
@@ -157,9 +232,10 @@ debug_check_syndrome (void)
  */
 
 static void
-compute_genpoly (int nbytes, int genpoly[])
+compute_genpoly (int nbytes, uint8_t genpoly[])
 {
-  int i, tp[MAXDEG], tp1[MAXDEG];
+  int i;
+  uint8_t tp[MAXDEG], tp1[MAXDEG];
 	
   /* multiply (x + a^n) for n = 1 to nbytes */
 
@@ -176,8 +252,7 @@ compute_genpoly (int nbytes, int genpoly[])
   }
 }
 
-/* Simulate a LFSR with generator polynomial for n byte RS code. 
- * Pass in a pointer to the data array, and amount of data. 
+/* Encode a message of nbytes.
  *
  * The parity bytes are deposited into pBytes[], and the whole message
  * and parity are copied to dest to make a codeword.
@@ -187,21 +262,64 @@ compute_genpoly (int nbytes, int genpoly[])
 void
 encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
 {
-  int i, LFSR[RS_ECC_NPARITY+1],dbyte, j;
+  run_lfsr(msg, nbytes, 1, pBytes);
 	
-  for(i=0; i < RS_ECC_NPARITY+1; i++) LFSR[i]=0;
+  build_codeword(msg, nbytes, dst);
+}
 
-  for (i = 0; i < nbytes; i++) {
-    dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
-    for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+/**********************************************************
+ * Interleaved codewords
+ */
+
+void
+encode_data_interleaved (unsigned char msg[], int nbytes, unsigned char dst[], int depth)
+{
+  int l, i, count;
+
+  if (dst != msg)
+    for (i = 0; i < nbytes; i++) dst[i] = msg[i];
+
+  for (l = 0; l < depth; l++) {
+    count = (nbytes - l + depth - 1) / depth;
+    run_lfsr(msg + l, count, depth, pBytes);
+    for (i = 0; i < RS_ECC_NPARITY; i++)
+      dst[l + (count + i) * depth] = pBytes[RS_ECC_NPARITY-1-i];
+  }
+}
+
+int
+decode_data_interleaved (unsigned char codeword[], int csize, int depth)
+{
+  unsigned char lane[255];
+  int nbytes = csize - depth * RS_ECC_NPARITY;
+  int l, i, count, result = 0;
+
+  if (depth < 1 || depth > RS_ECC_MAX_INTERLEAVE || nbytes < 0)
+    return -1;
+
+  for (l = 0; l < depth; l++) {
+    count = (nbytes - l + depth - 1) / depth + RS_ECC_NPARITY;
+
+    if (!compute_syndromes(codeword + l, count - RS_ECC_NPARITY, depth,
+			   codeword + l + (count - RS_ECC_NPARITY) * depth, depth))
+      continue;
+
+    /* Gather the codeword, correct it and put it back */
+    if (count > (int) sizeof(lane))
+      return -1;
+    for (i = 0; i < count; i++)
+      lane[i] = codeword[l + i*depth];
+
+    if (!correct_errors_erasures(lane, count, 0, NULL)) {
+      result = -1;
+      continue;
     }
-    LFSR[0] = gmult(genPoly[0], dbyte);
+
+    for (i = 0; i < count; i++)
+      codeword[l + i*depth] = lane[i];
+    if (result == 0)
+      result = 1;
   }
 
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    pBytes[i] = LFSR[i];
-	
-  build_codeword(msg, nbytes, dst);
+  return result;
 }
-
@@ -46,6 +46,10 @@ static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, u
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection);
+static int32_t receiveBatch(UAVTalkConnectionData *connection);
+static int32_t flushBatch(UAVTalkConnectionData *connection);
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void updateDeltaRef(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, const uint8_t *data);
 static int32_t sendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
 
 /**
@@ -146,6 +150,151 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	return objectTransaction(connection, obj, instId, UAVTALK_TYPE_OBJ_TS);
 }
 
+/**
+ * Add an object to the batch frame of the connection.  Small objects queued
+ * back to back then share one header and checksum on the link.  The batch is
+ * sent when the next object would not fit, or by UAVTalkFlushBatch().
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectBatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (!connection->outCb) return -1;
+
+	bool single = UAVObjIsSingleInstance(obj);
+
+	if (instId == UAVOBJ_ALL_INSTANCES) {
+		if (single) {
+			instId = 0;
+		} else {
+			uint32_t numInst = UAVObjGetNumInstances(obj);
+			for (uint32_t n = 0; n < numInst; ++n) {
+				UAVTalkSendObjectBatched(connectionHandle, obj, n);
+			}
+			return 0;
+		}
+	}
+
+	uint16_t length = UAVObjGetNumBytes(obj);
+	uint16_t instLength = single ? 0 : 2;
+	uint16_t recordLength = sizeof(struct batch_record_header) +
+		instLength + length;
+
+	// Objects too large to share a frame go out on their own
+	if (recordLength > UAVTALK_BATCH_MAX_PAYLOAD) {
+		return sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (!connection->batchBuffer) {
+		connection->batchBuffer = PIOS_malloc(UAVTALK_BATCH_MAX_LENGTH +
+				UAVTALK_CHECKSUM_LENGTH);
+
+		if (!connection->batchBuffer) {
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+			return sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+		}
+	}
+
+	if (connection->batchLength + recordLength > UAVTALK_BATCH_MAX_LENGTH) {
+		flushBatch(connection);
+	}
+
+	if (connection->batchCount == 0) {
+		connection->batchLength = UAVTALK_MIN_HEADER_LENGTH;
+	}
+
+	uint8_t *rec = &connection->batchBuffer[connection->batchLength];
+	uint32_t objId = UAVObjGetID(obj);
+
+	rec[0] = (uint8_t)(objId & 0xFF);
+	rec[1] = (uint8_t)((objId >> 8) & 0xFF);
+	rec[2] = (uint8_t)((objId >> 16) & 0xFF);
+	rec[3] = (uint8_t)((objId >> 24) & 0xFF);
+	rec[4] = (uint8_t)(instLength + length);
+	rec += sizeof(struct batch_record_header);
+
+	if (instLength) {
+		rec[0] = (uint8_t)(instId & 0xFF);
+		rec[1] = (uint8_t)((instId >> 8) & 0xFF);
+		rec += 2;
+	}
+
+	if (UAVObjPack(obj, instId, rec) < 0) {
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return -1;
+	}
+
+	updateDeltaRef(connection, obj, instId, rec);
+
+	connection->batchLength += recordLength;
+	connection->batchCount++;
+	connection->batchObjectBytes += length;
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
+/**
+ * Send the objects batched so far on the connection, if any.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	int32_t ret = flushBatch(connection);
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Send an object as a delta against the last keyframe sent for it, i.e.
+ * only the words that changed since.  A full keyframe goes out periodically,
+ * when the delta would not be smaller, or when the object cannot be tracked.
+ * Meant for large periodic objects on slow links; the receiver must keep
+ * up with keyframes, so this is never used for acked sends.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectDelta(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (instId == UAVOBJ_ALL_INSTANCES) {
+		if (UAVObjIsSingleInstance(obj)) {
+			instId = 0;
+		} else {
+			uint32_t numInst = UAVObjGetNumInstances(obj);
+			for (uint32_t n = 0; n < numInst; ++n) {
+				sendDeltaObject(connection, obj, n);
+			}
+			return 0;
+		}
+	}
+
+	return sendDeltaObject(connection, obj, instId);
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -281,11 +430,33 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 			break;
 		}
 
-		// Search for object.
-		iproc->obj = UAVObjGetByID(iproc->objId);
+		// Search for object.  Batches are passed along whole and
+		// split into their objects on receive.
+		if (iproc->type == UAVTALK_TYPE_OBJ_BATCH) {
+			iproc->obj = NULL;
+		} else {
+			iproc->obj = UAVObjGetByID(iproc->objId);
+		}
 
 		// Determine data length
-		if (iproc->type == UAVTALK_TYPE_OBJ_REQ || iproc->type == UAVTALK_TYPE_ACK || iproc->type == UAVTALK_TYPE_NACK) {
+		if (iproc->type == UAVTALK_TYPE_OBJ_DELTA) {
+			iproc->instanceLength = 0;
+
+			if (iproc->obj && !UAVObjIsSingleInstance(iproc->obj)) {
+				iproc->instanceLength = 2;
+			}
+
+			// Deltas vary in size; at least the keyframe check is there
+			if (iproc->packet_size <
+					iproc->rxPacketLength + iproc->instanceLength +
+					UAVTALK_DELTA_CRC_LENGTH) {
+				iproc->state = UAVTALK_STATE_ERROR;
+				break;
+			}
+
+			iproc->length = iproc->packet_size -
+				iproc->rxPacketLength - iproc->instanceLength;
+		} else if (iproc->type == UAVTALK_TYPE_OBJ_REQ || iproc->type == UAVTALK_TYPE_ACK || iproc->type == UAVTALK_TYPE_NACK) {
 			iproc->length = 0;
 			iproc->instanceLength = 0;
 
@@ -564,6 +735,20 @@ uint32_t UAVTalkGetPacketInstId(UAVTalkConnection connectionHandle)
 	return connection->iproc.instId;
 }
 
+/**
+ * Check whether the current packet is a batch of several objects.
+ * \param[in] connectionHandle UAVTalkConnection to be used
+ * \return true if it is a batch, false otherwise or on error.
+ */
+bool UAVTalkIsPacketBatch(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+
+	CHECKCONHANDLE(connectionHandle, connection, return false);
+
+	return connection->iproc.type == UAVTALK_TYPE_OBJ_BATCH;
+}
+
 /**
  * Process an byte from the telemetry stream, sending the packet out the output stream when it's complete
  * This allows the interlieving of packets on an output UAVTalk stream, and is used by the OPLink device to
@@ -715,6 +900,12 @@ static void handleFileReq(UAVTalkConnectionData *connection)
 			/* End of file, last chunk in sequence */
 			resp->flags = UAVTALK_FILEDATA_LAST |
 				UAVTALK_FILEDATA_EOF;
+
+			/* Unreadable right now (e.g. being written); the
+			 * requester shouldn't take this as the real end */
+			if (cb_numbytes < 0) {
+				resp->flags |= UAVTALK_FILEDATA_ERROR;
+			}
 		}
 
 		// Store the packet length
@@ -824,6 +1015,13 @@ static int32_t receiveObject(UAVTalkConnectionData *connection)
 		else
 			sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
 		break;
+	case UAVTALK_TYPE_OBJ_BATCH:
+		ret = receiveBatch(connection);
+		break;
+	case UAVTALK_TYPE_OBJ_DELTA:
+		// Deltas only flow to the ground; we keep no references
+		ret = -1;
+		break;
 	default:
 		ret = -1;
 	}
@@ -834,6 +1032,127 @@ static int32_t receiveObject(UAVTalkConnectionData *connection)
 	return ret;
 }
 
+/**
+ * Unpack the objects of a received batch.  Unknown objects are skipped, and
+ * settings are never taken from a batch since they are only sent acked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t receiveBatch(UAVTalkConnectionData *connection)
+{
+	const uint8_t *rec = connection->rxBuffer;
+	const uint8_t *end = rec + connection->iproc.length;
+	int32_t ret = 0;
+
+	while (end - rec >= (int32_t) sizeof(struct batch_record_header)) {
+		uint32_t objId = rec[0] | (rec[1] << 8) | (rec[2] << 16) |
+			((uint32_t) rec[3] << 24);
+		uint8_t length = rec[4];
+
+		rec += sizeof(struct batch_record_header);
+
+		if (end - rec < length) {
+			return -1;
+		}
+
+		UAVObjHandle obj = UAVObjGetByID(objId);
+
+		if (obj && !UAVObjIsSettings(obj)) {
+			uint16_t instLength = UAVObjIsSingleInstance(obj) ? 0 : 2;
+
+			if (length == instLength + UAVObjGetNumBytes(obj)) {
+				uint16_t instId = instLength ?
+					(rec[0] | (rec[1] << 8)) : 0;
+
+				UAVObjUnpack(obj, instId, rec + instLength);
+			} else {
+				ret = -1;
+			}
+		}
+
+		rec += length;
+	}
+
+	if (rec != end) {
+		ret = -1;
+	}
+
+	return ret;
+}
+
+/**
+ * Send the pending batch frame.  A batch holding only one object is sent as a
+ * plain object message, so it costs nothing over the unbatched path.
+ * Must be called with the connection locked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBatch(UAVTalkConnectionData *connection)
+{
+	uint8_t *buf = connection->batchBuffer;
+	uint16_t length = connection->batchLength;
+	int32_t ret = 0;
+
+	if (connection->batchCount == 0) {
+		return 0;
+	}
+
+	if (connection->batchCount == 1) {
+		const uint16_t rec = UAVTALK_MIN_HEADER_LENGTH;
+		const uint16_t data = rec + sizeof(struct batch_record_header);
+
+		// Object ID into the header, instance and data right after
+		memmove(&buf[4], &buf[rec], 4);
+		memmove(&buf[8], &buf[data], length - data);
+		length -= data - 8;
+
+		buf[1] = UAVTALK_TYPE_OBJ;
+	} else {
+		buf[1] = UAVTALK_TYPE_OBJ_BATCH;
+		buf[4] = 0;
+		buf[5] = 0;
+		buf[6] = 0;
+		buf[7] = 0;
+	}
+
+	buf[0] = UAVTALK_SYNC_VAL;
+	buf[2] = (uint8_t)(length & 0xFF);
+	buf[3] = (uint8_t)((length >> 8) & 0xFF);
+
+	// Calculate checksum
+	buf[length] = PIOS_CRC_updateCRC(0, buf, length);
+
+	uint16_t tx_msg_len = length + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outCb)(connection->cbCtx, buf, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		connection->stats.txObjects += connection->batchCount;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += connection->batchObjectBytes;
+	} else {
+		connection->stats.txErrors++;
+		ret = -1;
+
+		// The batched objects already became delta references; resync
+		// them all with keyframes, as it is unknown which got through
+		if (connection->deltaRefs) {
+			for (int i = 0; i < UAVTALK_DELTA_SLOTS; i++) {
+				connection->deltaRefs[i].sinceKeyframe =
+					UAVTALK_DELTA_KEYFRAME_INTERVAL;
+			}
+		}
+	}
+
+	connection->batchLength = 0;
+	connection->batchCount = 0;
+	connection->batchObjectBytes = 0;
+
+	return ret;
+}
+
 /**
  * Send an object through the telemetry link.
  * \param[in] connection UAVTalkConnection to be used
@@ -968,11 +1287,247 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 		connection->stats.txObjectBytes += length;
 	}
 
+	if (length > 0) {
+		updateDeltaRef(connection, obj, instId, (rc == tx_msg_len) ?
+				&connection->txBuffer[dataOffset] : NULL);
+	}
+
 	// Done
 	PIOS_Recursive_Mutex_Unlock(connection->lock);
 	return 0;
 }
 
+/**
+ * Find the keyframe slot of an object instance, if it has one.
+ * Must be called with the connection locked.
+ * \return The slot, or NULL if the instance is not delta-encoded
+ */
+static struct delta_ref *findDeltaRef(UAVTalkConnectionData *connection,
+		UAVObjHandle obj, uint16_t instId)
+{
+	if (!connection->deltaRefs) {
+		return NULL;
+	}
+
+	for (int i = 0; i < UAVTALK_DELTA_SLOTS; i++) {
+		struct delta_ref *ref = &connection->deltaRefs[i];
+
+		if (ref->obj == obj && ref->instId == instId) {
+			return ref;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Account for a full copy of an object instance sent other than by
+ * sendDeltaObject(), e.g. an acked send, a request reply or a batch.  The
+ * receiver takes every full copy as its delta reference, so ours must
+ * follow.  Must be called with the connection locked.
+ * \param[in] data The object data sent, or NULL if sending failed
+ */
+static void updateDeltaRef(UAVTalkConnectionData *connection,
+		UAVObjHandle obj, uint16_t instId, const uint8_t *data)
+{
+	struct delta_ref *ref = findDeltaRef(connection, obj, instId);
+
+	if (!ref) {
+		return;
+	}
+
+	if (data) {
+		uint16_t length = UAVObjGetNumBytes(obj);
+
+		memcpy(ref->data, data, length);
+		ref->crc = PIOS_CRC16_CCITT_updateCRC(0, ref->data, length);
+		ref->sinceKeyframe = 0;
+	} else {
+		// Unknown what the receiver has now; send a keyframe next
+		ref->sinceKeyframe = UAVTALK_DELTA_KEYFRAME_INTERVAL;
+	}
+}
+
+/**
+ * Find or allocate the keyframe slot for an object instance.
+ * Must be called with the connection locked.
+ * \return The slot, or NULL if none is available
+ */
+static struct delta_ref *getDeltaRef(UAVTalkConnectionData *connection,
+		UAVObjHandle obj, uint16_t instId)
+{
+	if (!connection->deltaRefs) {
+		connection->deltaRefs = PIOS_malloc_no_dma(
+				sizeof(struct delta_ref) * UAVTALK_DELTA_SLOTS);
+
+		if (!connection->deltaRefs) {
+			return NULL;
+		}
+
+		memset(connection->deltaRefs, 0,
+				sizeof(struct delta_ref) * UAVTALK_DELTA_SLOTS);
+	}
+
+	for (int i = 0; i < UAVTALK_DELTA_SLOTS; i++) {
+		struct delta_ref *ref = &connection->deltaRefs[i];
+
+		if (ref->obj == obj && ref->instId == instId) {
+			return ref;
+		}
+
+		if (!ref->obj) {
+			ref->data = PIOS_malloc_no_dma(UAVObjGetNumBytes(obj));
+
+			if (!ref->data) {
+				return NULL;
+			}
+
+			ref->obj = obj;
+			ref->instId = instId;
+			// Nothing sent yet; force a keyframe first
+			ref->sinceKeyframe = UAVTALK_DELTA_KEYFRAME_INTERVAL;
+
+			return ref;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Send an object instance as a delta or a keyframe, see
+ * UAVTalkSendObjectDelta().
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	if (!connection->outCb) return -1;
+
+	uint16_t length = UAVObjGetNumBytes(obj);
+	uint16_t words = (length + UAVTALK_DELTA_WORD - 1) / UAVTALK_DELTA_WORD;
+	uint16_t deltaHeader = UAVTALK_DELTA_CRC_LENGTH + (words + 7) / 8;
+	uint16_t dataOffset = UAVObjIsSingleInstance(obj) ? 8 : 10;
+
+	// The object is packed after room for the delta header, and must fit
+	if (dataOffset + deltaHeader + length + UAVTALK_CHECKSUM_LENGTH >
+			UAVTALK_MAX_PACKET_LENGTH) {
+		return sendSingleObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// Batched copies may have moved the reference; they go out first
+	if (connection->batchCount) {
+		flushBatch(connection);
+	}
+
+	struct delta_ref *ref = getDeltaRef(connection, obj, instId);
+
+	if (!ref) {
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return sendSingleObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+	}
+
+	uint8_t *buf = connection->txBuffer;
+	uint8_t *bitmap = &buf[dataOffset + UAVTALK_DELTA_CRC_LENGTH];
+	uint8_t *cur = &buf[dataOffset + deltaHeader];
+
+	if (UAVObjPack(obj, instId, cur) < 0) {
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return -1;
+	}
+
+	// Mark the changed words and total up what the delta would take
+	uint16_t deltaLength = deltaHeader;
+
+	memset(bitmap, 0, deltaHeader - UAVTALK_DELTA_CRC_LENGTH);
+
+	for (uint16_t i = 0; i < words; i++) {
+		uint16_t offs = i * UAVTALK_DELTA_WORD;
+		uint16_t n = length - offs;
+		if (n > UAVTALK_DELTA_WORD) n = UAVTALK_DELTA_WORD;
+
+		if (memcmp(&cur[offs], &ref->data[offs], n)) {
+			bitmap[i / 8] |= 1 << (i % 8);
+			deltaLength += n;
+		}
+	}
+
+	uint8_t type;
+
+	if (ref->sinceKeyframe >= UAVTALK_DELTA_KEYFRAME_INTERVAL ||
+			deltaLength >= length) {
+		// Keyframe: the whole object, which becomes the new reference
+		memcpy(ref->data, cur, length);
+		memmove(&buf[dataOffset], cur, length);
+		ref->crc = PIOS_CRC16_CCITT_updateCRC(0, ref->data, length);
+		ref->sinceKeyframe = 0;
+
+		type = UAVTALK_TYPE_OBJ;
+	} else {
+		// Squeeze the changed words together, in place
+		uint16_t out = 0;
+
+		for (uint16_t i = 0; i < words; i++) {
+			if (bitmap[i / 8] & (1 << (i % 8))) {
+				uint16_t offs = i * UAVTALK_DELTA_WORD;
+				uint16_t n = length - offs;
+				if (n > UAVTALK_DELTA_WORD) n = UAVTALK_DELTA_WORD;
+
+				memmove(&cur[out], &cur[offs], n);
+				out += n;
+			}
+		}
+
+		buf[dataOffset] = ref->crc & 0xFF;
+		buf[dataOffset + 1] = (ref->crc >> 8) & 0xFF;
+		ref->sinceKeyframe++;
+
+		type = UAVTALK_TYPE_OBJ_DELTA;
+		length = deltaLength;
+	}
+
+	uint32_t objId = UAVObjGetID(obj);
+
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = type;
+	buf[2] = (uint8_t)((dataOffset + length) & 0xFF);
+	buf[3] = (uint8_t)(((dataOffset + length) >> 8) & 0xFF);
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+
+	if (dataOffset == 10) {
+		buf[8] = (uint8_t)(instId & 0xFF);
+		buf[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Calculate checksum
+	buf[dataOffset + length] = PIOS_CRC_updateCRC(0, buf, dataOffset + length);
+
+	uint16_t tx_msg_len = dataOffset + length + UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outCb)(connection->cbCtx, buf, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats; a delta counts as the object bytes it stands for
+		++connection->stats.txObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += UAVObjGetNumBytes(obj);
+	} else if (type == UAVTALK_TYPE_OBJ) {
+		// The ground never got this keyframe; send another next time
+		ref->sinceKeyframe = UAVTALK_DELTA_KEYFRAME_INTERVAL;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Send a NACK through the telemetry link.
  * \param[in] connection UAVTalkConnection to be used
@@ -52,6 +52,7 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "latency_trace.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -611,6 +612,11 @@ static void actuator_task(void* parameters)
 			continue;
 		}
 
+		uint32_t wake_time = PIOS_DELAY_GetRaw();
+
+		latency_trace_record(LATENCY_TRACE_ACTUATOR_WAKE,
+				ev.timestamp, wake_time);
+
 		uint32_t this_systime = PIOS_Thread_Systime();
 
 		/* Check how long since last update; this is stored into the
@@ -686,6 +692,16 @@ static void actuator_task(void* parameters)
 		post_process_scale_and_commit(motor_vect, dT, armed,
 				spin_while_armed, stabilize_now);
 
+		/* ev.origin is when the gyro sample behind this update
+		 * was received, or when ActuatorDesired was set if it
+		 * wasn't derived from one. */
+		uint32_t output_time = PIOS_DELAY_GetRaw();
+
+		latency_trace_record(LATENCY_TRACE_ACTUATOR, wake_time,
+				output_time);
+		latency_trace_record(LATENCY_TRACE_TOTAL, ev.origin,
+				output_time);
+
 		/* If we got this far, everything is OK. */
 		AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
 	}
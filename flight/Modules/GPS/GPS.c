@@ -69,7 +69,8 @@ static void updateSettings();
 
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
-#define STACK_SIZE_BYTES                850
+#define GPS_COM_BLOCK_LEN               32	// the usual size of the COM rx FIFO
+#define STACK_SIZE_BYTES                900
 
 #define TASK_PRIORITY                   PIOS_THREAD_PRIO_LOW
 
@@ -256,21 +257,23 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint8_t block[GPS_COM_BLOCK_LEN];
+		uint16_t received;
 
-		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		// This blocks the task until there is something on the buffer,
+		// then drains the fifo a block at a time
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, block, sizeof(block), xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_stream (block, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_stream (block, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
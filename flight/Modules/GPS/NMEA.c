@@ -102,86 +102,92 @@ const static struct nmea_parser nmea_parsers[] = {
 	},
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+/**
+ * Handle a complete sentence in gps_rx_buffer, "\r\n" already stripped
+ * \return PARSER_COMPLETE if the checksum was valid
+ * \return PARSER_ERROR otherwise
+ */
+static int parse_nmea_sentence (char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
-	static uint8_t rx_count = 0;
-	static bool start_flag = false;
-	static bool found_cr = false;
-
-	// detect start while acquiring stream
-	if (!start_flag && (c == '$')) // NMEA identifier found
-	{
-		start_flag = true;
-		found_cr = false;
-		rx_count = 0;
-	}
-	else
-	if (!start_flag)
+	// Validate the checksum over the sentence
+	if (!NMEA_checksum(&gps_rx_buffer[1]))
+	{	// Invalid checksum.  May indicate dropped characters on Rx.
+		gpsRxStats->gpsRxChkSumError++;
 		return PARSER_ERROR;
-
-	if (rx_count >= NMEA_MAX_PACKET_LENGTH)
-	{
-		// The buffer is already full and we haven't found a valid NMEA sentence.
-		// Flush the buffer and note the overflow event.
-		gpsRxStats->gpsRxOverflow++;
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		return PARSER_OVERRUN;
-	}
-	else
-	{
-		gps_rx_buffer[rx_count] = c;
-		rx_count++;
 	}
 
-	// look for ending '\r\n' sequence
-	if (!found_cr && (c == '\r') )
-		found_cr = true;
+	// Valid checksum, use this packet to update the GPS position
+	if (!NMEA_update_position(&gps_rx_buffer[1], GpsData))
+		gpsRxStats->gpsRxParserError++;
 	else
-	if (found_cr && (c != '\n') )
-		found_cr = false;  // false end flag
-	else
-	if (found_cr && (c == '\n') )
-	{
-		// The NMEA functions require a zero-terminated string
-		// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
-		gps_rx_buffer[rx_count-2] = 0;
-
-		// prepare to parse next sentence
-		start_flag = false;
-		found_cr = false;
-		rx_count = 0;
-		// Our rxBuffer must look like this now:
-		//   [0]           = '$'
-		//   ...           = zero or more bytes of sentence payload
-		//   [end_pos - 1] = '\r'
-		//   [end_pos]     = '\n'
-		//
-		// Prepare to consume the sentence from the buffer
-
-		// Validate the checksum over the sentence
-		if (!NMEA_checksum(&gps_rx_buffer[1]))
-		{	// Invalid checksum.  May indicate dropped characters on Rx.
-			//PIOS_DEBUG_PinHigh(2);
-			gpsRxStats->gpsRxChkSumError++;
-			//PIOS_DEBUG_PinLow(2);
-			return PARSER_ERROR;
+		gpsRxStats->gpsRxReceived++;
+
+	return PARSER_COMPLETE;
+}
+
+/**
+ * Parse a block of the incoming stream for NMEA sentences.  The start
+ * and end of each sentence are found with memchr and the bytes between
+ * are copied at once.  State carries over between calls, sentences can
+ * span blocks.
+ * \return PARSER_COMPLETE if at least one sentence was completed
+ * \return PARSER_INCOMPLETE otherwise
+ */
+int parse_nmea_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	static uint8_t rx_count = 0;
+	static bool start_flag = false;
+	const uint8_t *end = rx + len;
+	int ret = PARSER_INCOMPLETE;
+
+	while (rx < end) {
+		// detect start while acquiring stream
+		if (!start_flag) {
+			const uint8_t *start = memchr(rx, '$', end - rx);
+			if (!start)
+				break;
+
+			// NMEA identifier found
+			start_flag = true;
+			rx_count = 0;
+			rx = start;
 		}
-		else
-		{	// Valid checksum, use this packet to update the GPS position
-			if (!NMEA_update_position(&gps_rx_buffer[1], GpsData)) {
-				//PIOS_DEBUG_PinHigh(2);
-				gpsRxStats->gpsRxParserError++;
-				//PIOS_DEBUG_PinLow(2);
-			}
-			else
-				gpsRxStats->gpsRxReceived++;;
-
-			return PARSER_COMPLETE;
+
+		// Take everything up to and including the next '\n'
+		const uint8_t *lf = memchr(rx, '\n', end - rx);
+		uint16_t n = (lf ? lf + 1 : end) - rx;
+
+		if (rx_count + n > NMEA_MAX_PACKET_LENGTH)
+		{
+			// The buffer would be full before finding a valid NMEA sentence.
+			// Flush the buffer and note the overflow event.
+			gpsRxStats->gpsRxOverflow++;
+			start_flag = false;
+			rx += NMEA_MAX_PACKET_LENGTH - rx_count + 1;
+			continue;
+		}
+
+		memcpy(&gps_rx_buffer[rx_count], rx, n);
+		rx_count += n;
+		rx += n;
+
+		// look for ending '\r\n' sequence
+		if (lf && rx_count >= 2 && gps_rx_buffer[rx_count - 2] == '\r')
+		{
+			// The NMEA functions require a zero-terminated string
+			// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
+			gps_rx_buffer[rx_count - 2] = 0;
+
+			// prepare to parse next sentence
+			start_flag = false;
+			rx_count = 0;
+
+			if (parse_nmea_sentence(gps_rx_buffer, GpsData, gpsRxStats) == PARSER_COMPLETE)
+				ret = PARSER_COMPLETE;
 		}
 	}
-	return PARSER_INCOMPLETE;
+
+	return ret;
 }
 
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
@@ -212,24 +218,34 @@ const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
  */
 bool NMEA_checksum(char *nmea_sentence)
 {
-	uint8_t checksum_computed = 0;
 	uint8_t checksum_received;
 
-	while (*nmea_sentence != '\0' && *nmea_sentence != '*') {
-		checksum_computed ^= *nmea_sentence;
-		nmea_sentence++;
-	}
+	char *star = strchr(nmea_sentence, '*');
 
-	/* Make sure we're now pointing at the checksum */
-	if (*nmea_sentence == '\0') {
+	/* Make sure there is a checksum */
+	if (star == NULL) {
 		/* Buffer ran out before we found a checksum marker */
 		return false;
 	}
 
-	/* Load the checksum from the buffer */
-	checksum_received = strtol(nmea_sentence + 1, NULL, 16);
+	/* XOR the sentence a word at a time, then fold the word */
+	uint32_t word_sum = 0;
+	const char *p = nmea_sentence;
 
-	//PIOS_COM_SendFormattedStringNonBlocking(COM_DEBUG_USART,"$%d=%d\r\n",checksum_received,checksum_computed);
+	for (; star - p >= 4; p += 4) {
+		uint32_t w;
+		memcpy(&w, p, sizeof(w));
+		word_sum ^= w;
+	}
+
+	uint8_t checksum_computed = word_sum ^ (word_sum >> 8) ^
+		(word_sum >> 16) ^ (word_sum >> 24);
+
+	for (; p < star; p++)
+		checksum_computed ^= *p;
+
+	/* Load the checksum from the buffer */
+	checksum_received = strtol(star + 1, NULL, 16);
 
 	return (checksum_computed == checksum_received);
 }
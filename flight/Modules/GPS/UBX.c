@@ -41,9 +41,15 @@ static uint32_t parse_errors;
 static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
-
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+/**
+ * Parse a block of the incoming stream for messages in UBX binary format.
+ * Sync is searched for with memchr and payloads are copied whole, so the
+ * per byte work is only done on the few header and checksum bytes.  State
+ * carries over between calls, messages can span blocks.
+ * \return PARSER_COMPLETE if at least one message was completed
+ * \return PARSER_INCOMPLETE otherwise
+ */
+int parse_ubx_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	enum proto_states {
 		START,
@@ -54,83 +60,88 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 		UBX_LEN2,
 		UBX_PAYLOAD,
 		UBX_CHK1,
-		UBX_CHK2,
-		FINISHED
+		UBX_CHK2
 	};
 
 	static enum proto_states proto_state = START;
 	static uint16_t rx_count = 0;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
-
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
+	const uint8_t *end = rx + len;
+	int ret = PARSER_INCOMPLETE;
+
+	while (rx < end) {
+		switch (proto_state) {
+			case START: // detect protocol
+			{
+				const uint8_t *sync = memchr(rx, UBX_SYNC1, end - rx);
+				if (!sync)
+					return ret;
+				rx = sync + 1;
 				proto_state = UBX_SY2;
-			break;
-		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
-			break;
-		case UBX_CLASS:
-			ubx->header.class = c;
-			proto_state = UBX_ID;
-			break;
-		case UBX_ID:
-			ubx->header.id = c;
-			proto_state = UBX_LEN1;
-			break;
-		case UBX_LEN1:
-			ubx->header.len = c;
-			proto_state = UBX_LEN2;
-			break;
-		case UBX_LEN2:
-			ubx->header.len += (c << 8);
-			if (ubx->header.len > sizeof(UBXPayload)) {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			} else {
-				rx_count = 0;
-				proto_state = UBX_PAYLOAD;
+				break;
 			}
-			break;
-		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
+			case UBX_SY2:
+				if (*rx == UBX_SYNC2) { // second UBX sync char found
+					rx++;
+					proto_state = UBX_CLASS;
+				} else {
+					// reset state, this byte may be a first sync char
+					proto_state = START;
+				}
+				break;
+			case UBX_CLASS:
+				ubx->header.class = *rx++;
+				proto_state = UBX_ID;
+				break;
+			case UBX_ID:
+				ubx->header.id = *rx++;
+				proto_state = UBX_LEN1;
+				break;
+			case UBX_LEN1:
+				ubx->header.len = *rx++;
+				proto_state = UBX_LEN2;
+				break;
+			case UBX_LEN2:
+				ubx->header.len += (*rx++ << 8);
+				if (ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				} else {
+					rx_count = 0;
+					proto_state = ubx->header.len ? UBX_PAYLOAD : UBX_CHK1;
+				}
+				break;
+			case UBX_PAYLOAD:
+			{
+				uint16_t n = ubx->header.len - rx_count;
+				if (n > end - rx)
+					n = end - rx;
+				memcpy(&ubx->payload.payload[rx_count], rx, n);
+				rx += n;
+				rx_count += n;
+				if (rx_count == ubx->header.len)
 					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
+				break;
 			}
-			break;
-		case UBX_CHK1:
-			ubx->header.ck_a = c;
-			proto_state = UBX_CHK2;
-			break;
-		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
-				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
-			} else {
-				gpsRxStats->gpsRxChkSumError++;
+			case UBX_CHK1:
+				ubx->header.ck_a = *rx++;
+				proto_state = UBX_CHK2;
+				break;
+			case UBX_CHK2:
+				ubx->header.ck_b = *rx++;
 				proto_state = START;
-			}
-			break;
-		default: break;
-	}
-
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
-		return PARSER_COMPLETE;	// message complete & processed
+				if (checksum_ubx_message(ubx)) { // message complete and valid
+					parse_ubx_message(ubx, GpsData);
+					gpsRxStats->gpsRxReceived++;
+					ret = PARSER_COMPLETE;
+				} else {
+					gpsRxStats->gpsRxChkSumError++;
+				}
+				break;
+		}
 	}
 
-	return PARSER_INCOMPLETE; // message not (yet) complete
+	return ret;
 }
 
 
@@ -165,30 +176,43 @@ bool check_msgtracker (uint32_t tow, uint8_t msg_flag)
 	return true;
 }
 
-static bool checksum_ubx_message (const struct UBXPacket *ubx)
+/**
+ * Run the UBX checksum (8-bit Fletcher) over a block, four bytes a step.
+ * After bytes d0..d3 a has grown by their sum and b by
+ * 4a + 4d0 + 3d1 + 2d2 + d3.  Only the low eight bits of either are
+ * used, so the sums are free to wrap.
+ */
+static void checksum_ubx_block (const uint8_t *data, uint16_t len, uint32_t *ck_a, uint32_t *ck_b)
 {
-	int i;
-	uint8_t ck_a, ck_b;
+	uint32_t a = *ck_a, b = *ck_b;
 
-	ck_a = ubx->header.class;
-	ck_b = ck_a;
+	for (; len >= 4; len -= 4, data += 4) {
+		b += 4 * a + 4 * data[0] + 3 * data[1] + 2 * data[2] + data[3];
+		a += data[0] + data[1] + data[2] + data[3];
+	}
 
-	ck_a += ubx->header.id;
-	ck_b += ck_a;
+	for (; len; len--) {
+		a += *data++;
+		b += a;
+	}
 
-	ck_a += ubx->header.len & 0xff;
-	ck_b += ck_a;
+	*ck_a = a;
+	*ck_b = b;
+}
 
-	ck_a += ubx->header.len >> 8;
-	ck_b += ck_a;
+static bool checksum_ubx_message (const struct UBXPacket *ubx)
+{
+	const uint8_t header[4] = {
+		ubx->header.class, ubx->header.id,
+		ubx->header.len & 0xff, ubx->header.len >> 8
+	};
+	uint32_t ck_a = 0, ck_b = 0;
 
-	for (i = 0; i < ubx->header.len; i++) {
-		ck_a += ubx->payload.payload[i];
-		ck_b += ck_a;
-	}
+	checksum_ubx_block(header, sizeof(header), &ck_a, &ck_b);
+	checksum_ubx_block(ubx->payload.payload, ubx->header.len, &ck_a, &ck_b);
 
-	if (ubx->header.ck_a == ck_a &&
-			ubx->header.ck_b == ck_b)
+	if (ubx->header.ck_a == (uint8_t)ck_a &&
+			ubx->header.ck_b == (uint8_t)ck_b)
 		return true;
 	else {
 		parse_errors++;
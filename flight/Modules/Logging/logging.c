@@ -44,6 +44,8 @@
 #include "pios_streamfs.h"
 #include <pios_board_info.h>
 
+#include "telemetry.h"
+
 #include "accels.h"
 #include "actuatorcommand.h"
 #include "actuatordesired.h"
@@ -114,6 +116,17 @@ static const struct streamfs_cfg streamfs_settings = {
 	.arena_size    = PIOS_LOGFLASH_SECT_SIZE,
 	.write_size    = 0x00000100, /* 256 bytes */
 };
+
+/* The logging task and file requests from telemetry share the one
+ * streamfs file handle; fs_mutex guards it and everything below. */
+static struct pios_mutex *fs_mutex;
+static bool write_open;
+static bool read_open;
+static int32_t read_file_id;
+static uint32_t read_pos;
+
+static int32_t read_log_file(uint8_t *buf, uint32_t log_id,
+		uint32_t offset, uint32_t len);
 #endif
 
 /**
@@ -151,6 +164,12 @@ int32_t LoggingInitialize(void)
 			return -1;
 		}
 
+		fs_mutex = PIOS_Mutex_Create();
+		if (!fs_mutex) {
+			module_enabled = false;
+			return -1;
+		}
+
 		destination_onboard_flash = true;
 		updateSettings();
 	}
@@ -187,6 +206,12 @@ int32_t LoggingInitialize(void)
 		module_enabled = false;
 		return -1;
 	}
+
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+	if (destination_onboard_flash) {
+		TelemetrySetLogFileCallback(read_log_file);
+	}
+#endif
 	
 	return 0;
 }
@@ -219,8 +244,6 @@ static void loggingTask(void *parameters)
 	uint32_t now = PIOS_Thread_Systime();
 
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
-	bool write_open = false;
-	bool read_open = false;
 	int32_t read_sector = 0;
 	uint8_t read_data[LOGGINGSTATS_FILESECTOR_NUMELEM];
 #endif
@@ -278,6 +301,8 @@ static void loggingTask(void *parameters)
 			// Format the file system
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash){
+				PIOS_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
 				if (read_open || write_open) {
 					PIOS_STREAMFS_Close(logging_com_id);
 					read_open = false;
@@ -287,6 +312,8 @@ static void loggingTask(void *parameters)
 				PIOS_STREAMFS_Format(logging_com_id);
 				loggingData.MinFileId = PIOS_STREAMFS_MinFileId(logging_com_id);
 				loggingData.MaxFileId = PIOS_STREAMFS_MaxFileId(logging_com_id);
+
+				PIOS_Mutex_Unlock(fs_mutex);
 			}
 #endif /* PIOS_INCLUDE_LOG_TO_FLASH */
 			loggingData.Operation = LOGGINGSTATS_OPERATION_IDLE;
@@ -297,6 +324,8 @@ static void loggingTask(void *parameters)
 			UAVObjIterate(&unregister_object);
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash){
+				PIOS_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
 				// Close the file if it is open for reading
 				if (read_open) {
 					PIOS_STREAMFS_Close(logging_com_id);
@@ -306,6 +335,7 @@ static void loggingTask(void *parameters)
 				// Open the file if it is not open for writing
 				if (!write_open) {
 					if (PIOS_STREAMFS_OpenWrite(logging_com_id) != 0) {
+						PIOS_Mutex_Unlock(fs_mutex);
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
 						continue;
 					} else {
@@ -315,6 +345,8 @@ static void loggingTask(void *parameters)
 					loggingData.MaxFileId = PIOS_STREAMFS_MaxFileId(logging_com_id);
 					LoggingStatsSet(&loggingData);
 				}
+
+				PIOS_Mutex_Unlock(fs_mutex);
 			}
 			else {
 				read_open = false;
@@ -361,13 +393,38 @@ static void loggingTask(void *parameters)
 		case LOGGINGSTATS_OPERATION_DOWNLOAD:
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash) {
+				PIOS_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+				if (read_open && (read_file_id != loggingData.FileRequest ||
+						read_pos != (uint32_t) (read_sector + 1) * LOGGINGSTATS_FILESECTOR_NUMELEM)) {
+					// A file request moved the handle; start over
+					PIOS_STREAMFS_Close(logging_com_id);
+					read_open = false;
+				}
+
 				if (!read_open) {
 					// Start reading
 					if (PIOS_STREAMFS_OpenRead(logging_com_id, loggingData.FileRequest) != 0) {
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
 					} else {
 						read_open = true;
+						read_file_id = loggingData.FileRequest;
+						read_pos = 0;
 						read_sector = -1;
+
+						// Resuming part way through the file
+						uint32_t offset = (uint32_t) loggingData.FileSectorNum * LOGGINGSTATS_FILESECTOR_NUMELEM;
+
+						if (offset > 0) {
+							if (PIOS_STREAMFS_Seek(logging_com_id, offset) == 0) {
+								read_pos = offset;
+								read_sector = loggingData.FileSectorNum - 1;
+							} else {
+								loggingData.Operation = LOGGINGSTATS_OPERATION_COMPLETE;
+								PIOS_STREAMFS_Close(logging_com_id);
+								read_open = false;
+							}
+						}
 					}
 				}
 				if (read_open && read_sector == loggingData.FileSectorNum) {
@@ -377,6 +434,10 @@ static void loggingTask(void *parameters)
 
 				} else if (read_open && (read_sector + 1) == loggingData.FileSectorNum) {
 					int32_t bytes_read = PIOS_STREAMFS_Read(logging_com_id, loggingData.FileSector, LOGGINGSTATS_FILESECTOR_NUMELEM);
+					if (bytes_read > 0) {
+						read_pos += bytes_read;
+					}
+
 					if (bytes_read < 0) {
 						// close on error
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
@@ -396,6 +457,8 @@ static void loggingTask(void *parameters)
 
 					}
 				}
+				PIOS_Mutex_Unlock(fs_mutex);
+
 				LoggingStatsSet(&loggingData);
 
 				// Store the data in case it's needed again /
@@ -411,6 +474,8 @@ static void loggingTask(void *parameters)
 			PIOS_Thread_Sleep(10);
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 			if (destination_onboard_flash) {
+				PIOS_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
 				// Close the file if necessary
 				if (write_open) {
 					PIOS_STREAMFS_Close(logging_com_id);
@@ -419,12 +484,80 @@ static void loggingTask(void *parameters)
 					LoggingStatsSet(&loggingData);
 					write_open = false;
 				}
+
+				PIOS_Mutex_Unlock(fs_mutex);
 			}
 #endif /* PIOS_INCLUDE_LOG_TO_FLASH */
 		}
 	}
 }
 
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+/**
+ * Serve onboard logs to file requests over telemetry.  These arrive on
+ * the telemetry receive task, usually in ascending order, so the open
+ * handle is kept between calls and only moved when a request skips
+ * around (retransmits, resuming a download).
+ * \param[in] buf Where to put the data
+ * \param[in] log_id The log number
+ * \param[in] offset Offset within the log
+ * \param[in] len Maximum number of bytes to return
+ * \returns The number of bytes filled, 0 on EOF, negative on error.
+ */
+static int32_t read_log_file(uint8_t *buf, uint32_t log_id,
+		uint32_t offset, uint32_t len)
+{
+	int32_t rc;
+
+	PIOS_Mutex_Lock(fs_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	// Never interfere with a log being written
+	if (write_open) {
+		rc = -1;
+		goto out;
+	}
+
+	if (read_open && read_file_id != (int32_t) log_id) {
+		PIOS_STREAMFS_Close(logging_com_id);
+		read_open = false;
+	}
+
+	if (!read_open) {
+		if (PIOS_STREAMFS_OpenRead(logging_com_id, log_id) != 0) {
+			rc = -2;
+			goto out;
+		}
+
+		read_open = true;
+		read_file_id = log_id;
+		read_pos = 0;
+	}
+
+	if (read_pos != offset) {
+		rc = PIOS_STREAMFS_Seek(logging_com_id, offset);
+
+		if (rc != 0) {
+			// Past the end is EOF, anything else an error
+			rc = (rc > 0) ? 0 : -3;
+			goto out;
+		}
+
+		read_pos = offset;
+	}
+
+	rc = PIOS_STREAMFS_Read(logging_com_id, buf, len);
+
+	if (rc > 0) {
+		read_pos += rc;
+	}
+
+out:
+	PIOS_Mutex_Unlock(fs_mutex);
+
+	return rc;
+}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+
 /**
  * Log all objects' initial value.
  * \param[in] obj Object to log
@@ -56,14 +56,259 @@ extern uint8_t *draw_buffer;
 extern uint8_t *disp_buffer;
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define DAMAGE_BUFFER draw_buffer_mask
+#else
+#define DAMAGE_BUFFER draw_buffer
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+/* Word-wide access to the byte buffers, for filling spans */
+typedef uint32_t __attribute__((may_alias)) osd_word_t;
+
+#define WORDS_PER_ROW (BUFFER_WIDTH / 4)
+
+#if (BUFFER_WIDTH % 4) || (WORDS_PER_ROW > 32)
+#error "Damage tracking needs rows of at most 32 whole words"
+#endif
+
+/* Each of the two video buffers remembers which words of each row may
+ * have been drawn into since it was last cleared, so that clearGraphics()
+ * only has to zero those.  The video ISR swaps buffers on its own schedule,
+ * possibly mid-frame, so drawing is recorded against both buffers. */
+struct osd_damage {
+	const uint8_t *buffer;
+	uint32_t rows[BUFFER_HEIGHT];
+};
+
+static struct osd_damage damage[2];
+static uint16_t osd_frame;
+
+static struct osd_damage *get_damage(void)
+{
+	const uint8_t *buffer = DAMAGE_BUFFER;
+
+	if (damage[0].buffer == buffer)
+		return &damage[0];
+	if (damage[1].buffer == buffer)
+		return &damage[1];
+
+	// First use of this buffer; it was blanked by the video driver
+	struct osd_damage *d = (damage[0].buffer == NULL) ? &damage[0] : &damage[1];
+	d->buffer = buffer;
+	return d;
+}
+
+/**
+ * mark_damage: note that bytes col0..col1 of rows y0..y1 are drawn into.
+ * Arguments are clipped to the buffer.
+ */
+static void mark_damage(int y0, int y1, int col0, int col1)
+{
+	if (y0 < 0)
+		y0 = 0;
+	if (y1 >= BUFFER_HEIGHT)
+		y1 = BUFFER_HEIGHT - 1;
+	if (col0 < 0)
+		col0 = 0;
+	if (col1 >= BUFFER_WIDTH)
+		col1 = BUFFER_WIDTH - 1;
+	if (y0 > y1 || col0 > col1)
+		return;
+
+	// Words w0..w1; wraps correctly for w1 == 31
+	uint32_t bits = (2u << (col1 / 4)) - (1u << (col0 / 4));
+
+	for (int y = y0; y <= y1; y++) {
+		damage[0].rows[y] |= bits;
+		damage[1].rows[y] |= bits;
+	}
+}
+
+/**
+ * mark_damage_addr: as mark_damage(), for bytes addr0..addr1 of one row
+ * that are already known to be inside the buffer.
+ */
+static inline void mark_damage_addr(int addr0, int addr1)
+{
+	int y = addr0 / BUFFER_WIDTH;
+	int row = y * BUFFER_WIDTH;
+	uint32_t bits = (2u << ((addr1 - row) / 4)) - (1u << ((addr0 - row) / 4));
 
+	damage[0].rows[y] |= bits;
+	damage[1].rows[y] |= bits;
+}
+
+static void clear_words(uint8_t *buff, int y, uint32_t bits)
+{
+	osd_word_t *row = (osd_word_t *)&buff[y * BUFFER_WIDTH];
+
+	while (bits) {
+		int w = __builtin_ctz(bits);
+		row[w] = 0;
+		bits &= bits - 1;
+	}
+}
+
+/**
+ * clearGraphics: blank the draw buffer, touching only what was drawn
+ * into it last time round.
+ */
 void clearGraphics()
 {
+	struct osd_damage *d = get_damage();
+
+	for (int y = 0; y < BUFFER_HEIGHT; y++) {
+		uint32_t bits = d->rows[y];
+
+		if (!bits)
+			continue;
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+		clear_words(draw_buffer_mask, y, bits);
+		clear_words(draw_buffer_level, y, bits);
+#else
+		clear_words(draw_buffer, y, bits);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+		d->rows[y] = 0;
+	}
+
+	osd_frame++;
+}
+
+/**
+ * fill_bytes: apply a mode to whole bytes from..to of a buffer, a word at
+ * a time where alignment allows.
+ *
+ * @param       buff    buffer to write in
+ * @param       from    first byte
+ * @param       to      last byte
+ * @param       value   byte pattern, for mode 3
+ * @param       mode    0 = clear, 1 = set, 2 = toggle, 3 = store value
+ */
+static void fill_bytes(uint8_t *buff, int from, int to, uint8_t value, int mode)
+{
+	uint32_t pattern;
+
+	switch (mode) {
+	case 0:
+		pattern = 0;
+		break;
+	case 3:
+		pattern = value * 0x01010101u;
+		break;
+	default:
+		pattern = 0xffffffff;
+		break;
+	}
+
+	while (from <= to && (from & 3)) {
+		if (mode == 2)
+			buff[from] ^= pattern;
+		else
+			buff[from] = pattern;
+		from++;
+	}
+
+	osd_word_t *w = (osd_word_t *)&buff[from];
+	for (; from + 3 <= to; from += 4, w++) {
+		if (mode == 2)
+			*w ^= pattern;
+		else
+			*w = pattern;
+	}
+
+	for (; from <= to; from++) {
+		if (mode == 2)
+			buff[from] ^= pattern;
+		else
+			buff[from] = pattern;
+	}
+}
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define SPAN_L_MASK(x) (0xff >> ((x) & 7))
+#define SPAN_R_MASK(x) ((0xff << (7 - ((x) & 7))) & 0xff)
+#else
+#define SPAN_L_MASK(x) (0xff >> (2 * ((x) & 3)))
+#define SPAN_R_MASK(x) ((0xff << (6 - 2 * ((x) & 3))) & 0xff)
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+/**
+ * write_span_lm: set pixels x0..x1 (inclusive, x0 <= x1) of row y on both
+ * surfaces. Clipped; unlike write_hline_lm, both ends and one pixel spans
+ * are drawn.
+ */
+static void write_span_lm(int x0, int x1, int y, int mmode, int lmode)
+{
+	if (x1 < GRAPHICS_LEFT || x0 > GRAPHICS_RIGHT)
+		return;
+	CHECK_COORD_Y(y);
+	CLIP_COORD_X(x0);
+	CLIP_COORD_X(x1);
+
+	int addr0 = CALC_BUFF_ADDR(x0, y);
+	int addr1 = CALC_BUFF_ADDR(x1, y);
+	uint8_t mask_l = SPAN_L_MASK(x0);
+	uint8_t mask_r = SPAN_R_MASK(x1);
+
+	mark_damage_addr(addr0, addr1);
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	if (addr0 == addr1) {
+		uint8_t mask = mask_l & mask_r;
+		WRITE_WORD_MODE(draw_buffer_mask, addr0, mask, mmode);
+		WRITE_WORD_MODE(draw_buffer_level, addr0, mask, lmode);
+		return;
+	}
+
+	WRITE_WORD_MODE(draw_buffer_mask, addr0, mask_l, mmode);
+	WRITE_WORD_MODE(draw_buffer_level, addr0, mask_l, lmode);
+	WRITE_WORD_MODE(draw_buffer_mask, addr1, mask_r, mmode);
+	WRITE_WORD_MODE(draw_buffer_level, addr1, mask_r, lmode);
+	fill_bytes(draw_buffer_mask, addr0 + 1, addr1 - 1, 0, mmode);
+	fill_bytes(draw_buffer_level, addr0 + 1, addr1 - 1, 0, lmode);
+#else
+	uint8_t value = PACK_BITS(mmode, lmode);
+
+	if (addr0 == addr1) {
+		uint8_t mask = mask_l & mask_r;
+		WRITE_WORD(draw_buffer, addr0, mask, value);
+		return;
+	}
+
+	WRITE_WORD(draw_buffer, addr0, mask_l, value);
+	WRITE_WORD(draw_buffer, addr1, mask_r, value);
+	fill_bytes(draw_buffer, addr0 + 1, addr1 - 1, value, 3);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/**
+ * write_vspan_lm: set pixels y0..y1 (inclusive, y0 <= y1) of column x on
+ * both surfaces. Clipped.
+ */
+static void write_vspan_lm(int x, int y0, int y1, int mmode, int lmode)
+{
+	if (y1 < GRAPHICS_TOP || y0 > GRAPHICS_BOTTOM)
+		return;
+	CHECK_COORD_X(x);
+	CLIP_COORD_Y(y0);
+	CLIP_COORD_Y(y1);
+
+	int addr = CALC_BUFF_ADDR(x, y0);
+	uint8_t mask = CALC_BIT_MASK(x);
+
+	mark_damage(y0, y1, x / PIXELS_PER_BIT, x / PIXELS_PER_BIT);
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	memset((uint8_t *)draw_buffer_mask, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
-	memset((uint8_t *)draw_buffer_level, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	for (int y = y0; y <= y1; y++, addr += BUFFER_WIDTH) {
+		WRITE_WORD_MODE(draw_buffer_mask, addr, mask, mmode);
+		WRITE_WORD_MODE(draw_buffer_level, addr, mask, lmode);
+	}
 #else
-	memset((uint8_t *)draw_buffer, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+	uint8_t value = PACK_BITS(mmode, lmode);
+
+	for (int y = y0; y <= y1; y++, addr += BUFFER_WIDTH) {
+		WRITE_WORD(draw_buffer, addr, mask, value);
+	}
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
 
@@ -73,6 +318,8 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 	CHECK_COORDS(x + image->width, y + image->height);
 	uint8_t byte_width = image->width / 8;
 	uint8_t pixel_offset = x % 8;
+
+	mark_damage(y, y + image->height - 1, x / 8, x / 8 + byte_width);
 	uint8_t mask1 = 0xFF;
 	uint8_t mask2 = 0x00;
 
@@ -99,6 +346,8 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 	CHECK_COORDS(x + image->width, y + image->height);
 	uint8_t byte_width = image->width / 4;
 	uint8_t pixel_offset = 2 * (x % 4);
+
+	mark_damage(y, y + image->height - 1, x / 4, x / 4 + byte_width);
 	uint8_t mask1 = 0xFF;
 	uint8_t mask2 = 0x00;
 
@@ -235,6 +484,7 @@ void write_pixel(uint8_t *buff, int x, int y, int mode)
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_damage_addr(wordnum, wordnum);
 	WRITE_WORD_MODE(buff, wordnum, mask, mode);
 }
 #else
@@ -245,6 +495,7 @@ void write_pixel(int x, int y, uint8_t value)
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_damage_addr(wordnum, wordnum);
 	WRITE_WORD(draw_buffer, wordnum, mask, value);
 }
 #endif /* PIOS_VIDEO_SPLITBUFFER */
@@ -265,6 +516,7 @@ void write_pixel_lm(int x, int y, int mmode, int lmode)
 	// index to set it in.
 	int addr   = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_damage_addr(addr, addr);
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	WRITE_WORD_MODE(draw_buffer_mask, addr, mask, mmode);
 	WRITE_WORD_MODE(draw_buffer_level, addr, mask, lmode);
@@ -302,6 +554,7 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 	int addr0_bit = CALC_BIT_IN_WORD(x0);
 	int addr1_bit = CALC_BIT_IN_WORD(x1);
 	int mask, mask_l, mask_r, i;
+	mark_damage_addr(addr0, addr1);
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -339,6 +592,7 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 	int addr0_bit = CALC_BIT1_IN_WORD(x0);
 	int addr1_bit = CALC_BIT0_IN_WORD(x1);
 	int mask, mask_l, mask_r, i;
+	mark_damage_addr(addr0, addr1);
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -372,10 +626,21 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 void write_hline_lm(int x0, int x1, int y, int lmode, int mmode)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	// TODO: an optimisation would compute the masks and apply to
-	// both buffers simultaneously.
-	write_hline(draw_buffer_level, x0, x1, y, lmode);
-	write_hline(draw_buffer_mask, x0, x1, y, mmode);
+	// Same pixels as write_hline() on each buffer, in one pass
+	CHECK_COORD_Y(y);
+	CLIP_COORD_X(x0);
+	CLIP_COORD_X(x1);
+	if (x0 > x1) {
+		SWAP(x0, x1);
+	}
+	if (x0 == x1) {
+		return;
+	}
+	// An island within one byte stops short of x1
+	if (CALC_BUFF_ADDR(x0, y) == CALC_BUFF_ADDR(x1, y)) {
+		x1--;
+	}
+	write_span_lm(x0, x1, y, mmode, lmode);
 #else
 	uint8_t value = PACK_BITS(mmode, lmode);
 	write_hline(x0, x1, y, value);
@@ -438,6 +703,7 @@ void write_vline(uint8_t *buff, int x, int y0, int y1, int mode)
 	int addr1  = CALC_BUFF_ADDR(x, y1);
 	/* Then we calculate the pixel data to be written. */
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_damage(y0, y1, x / PIXELS_PER_BIT, x / PIXELS_PER_BIT);
 	/* Run from addr0 to addr1 placing pixels. Increment by the number
 	 * of words n each graphics line. */
 	for (int a = addr0; a <= addr1; a += BUFFER_WIDTH) {
@@ -462,6 +728,7 @@ void write_vline(int x, int y0, int y1, uint8_t value)
 	int addr1  = CALC_BUFF_ADDR(x, y1);
 	/* Then we calculate the pixel data to be written. */
 	uint8_t mask = CALC_BIT_MASK(x);
+	mark_damage(y0, y1, x / PIXELS_PER_BIT, x / PIXELS_PER_BIT);
 	/* Run from addr0 to addr1 placing pixels. Increment by the number
 	 * of words n each graphics line. */
 	for (int a = addr0; a <= addr1; a += BUFFER_WIDTH) {
@@ -483,10 +750,17 @@ void write_vline(int x, int y0, int y1, uint8_t value)
 void write_vline_lm(int x, int y0, int y1, int lmode, int mmode)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	// TODO: an optimisation would compute the masks and apply to
-	// both buffers simultaneously.
-	write_vline(draw_buffer_level, x, y0, y1, lmode);
-	write_vline(draw_buffer_mask, x, y0, y1, mmode);
+	// Same pixels as write_vline() on each buffer, in one pass
+	CHECK_COORD_X(x);
+	CLIP_COORD_Y(y0);
+	CLIP_COORD_Y(y1);
+	if (y0 > y1) {
+		SWAP(y0, y1);
+	}
+	if (y0 == y1) {
+		return;
+	}
+	write_vspan_lm(x, y0, y1, mmode, lmode);
 #else
 	uint8_t value = PACK_BITS(mmode, lmode);
 	write_vline(x, y0, y1, value);
@@ -553,6 +827,7 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
 	int mask, mask_l, mask_r, i;
+	mark_damage(y, y + height - 1, addr0 - y * BUFFER_WIDTH, addr1 - y * BUFFER_WIDTH);
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -607,6 +882,7 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
 	int mask, mask_l, mask_r, i;
+	mark_damage(y, y + height - 1, addr0 - y * BUFFER_WIDTH, addr1 - y * BUFFER_WIDTH);
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -659,8 +935,19 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 void write_filled_rectangle_lm(int x, int y, int width, int height, int lmode, int mmode)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	write_filled_rectangle(draw_buffer_mask, x, y, width, height, mmode);
-	write_filled_rectangle(draw_buffer_level, x, y, width, height, lmode);
+	// Same pixels as write_filled_rectangle() on each buffer, in one pass
+	CHECK_COORDS(x, y);
+	CHECK_COORDS(x + width, y + height);
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+	int x1 = x + width;
+	if (CALC_BUFF_ADDR(x, y) == CALC_BUFF_ADDR(x1, y)) {
+		x1--;
+	}
+	for (int yy = y; yy < y + height; yy++) {
+		write_span_lm(x, x1, yy, mmode, lmode);
+	}
 #else
 	uint8_t value = PACK_BITS(mmode, lmode);
 	write_filled_rectangle(x, y, width, height, value);
@@ -909,6 +1196,102 @@ void write_line(int x0, int y0, int x1, int y1, uint8_t value)
 }
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
+/* A run of pixels of a Bresenham line that share a row (or a column, for
+ * steep lines): a0..a1 along the major axis, at b on the minor one. */
+struct line_run {
+	bool steep;
+	int a0, a1;
+	int b;
+};
+
+typedef void (*line_run_fn)(const struct line_run *run, int mmode, int lmode);
+
+/**
+ * line_runs: Walk a line with Bresenham's algorithm like write_line(),
+ * including x0 but not x1 along the major axis, and pass on runs instead
+ * of single pixels.
+ *
+ * @param       dots    0 = solid, > 0 = length of dashes and gaps
+ * @param       fn      called for each run that is drawn
+ */
+static void line_runs(int x0, int y0, int x1, int y1, int dots,
+		line_run_fn fn, int mmode, int lmode)
+{
+	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+	int steep = abs(y1 - y0) > abs(x1 - x0);
+
+	if (steep) {
+		SWAP(x0, y0);
+		SWAP(x1, y1);
+	}
+	if (x0 > x1) {
+		SWAP(x0, x1);
+		SWAP(y0, y1);
+	}
+	int deltax = x1 - x0;
+	int deltay = abs(y1 - y0);
+	int error  = deltax / 2;
+	int ystep  = (y0 < y1) ? 1 : -1;
+	int y = y0;
+	int dot_cnt = 0;
+	int draw    = 1;
+	bool in_run = false;
+	struct line_run run = { .steep = steep };
+
+	for (int x = x0; x < x1; x++) {
+		if (dots && !(dot_cnt++ % dots)) {
+			draw++;
+		}
+		if (draw % 2) {
+			if (!in_run) {
+				run.a0 = x;
+				run.b  = y;
+				in_run = true;
+			}
+			run.a1 = x;
+		} else if (in_run) {
+			fn(&run, mmode, lmode);
+			in_run = false;
+		}
+		error -= deltay;
+		if (error < 0) {
+			y     += ystep;
+			error += deltax;
+			if (in_run) {
+				fn(&run, mmode, lmode);
+				in_run = false;
+			}
+		}
+	}
+	if (in_run) {
+		fn(&run, mmode, lmode);
+	}
+}
+
+static void line_run_plain(const struct line_run *run, int mmode, int lmode)
+{
+	if (run->steep) {
+		write_vspan_lm(run->b, run->a0, run->a1, mmode, lmode);
+	} else {
+		write_span_lm(run->a0, run->a1, run->b, mmode, lmode);
+	}
+}
+
+/* The 4-neighbour outline of a run.  This also covers the run itself
+ * (for runs longer than one pixel), which the inner pass redraws. */
+static void line_run_outline(const struct line_run *run, int mmode, int lmode)
+{
+	if (run->steep) {
+		write_vspan_lm(run->b - 1, run->a0, run->a1, mmode, lmode);
+		write_vspan_lm(run->b + 1, run->a0, run->a1, mmode, lmode);
+		write_vspan_lm(run->b, run->a0 - 1, run->a1 + 1, mmode, lmode);
+	} else {
+		write_span_lm(run->a0, run->a1, run->b - 1, mmode, lmode);
+		write_span_lm(run->a0, run->a1, run->b + 1, mmode, lmode);
+		write_span_lm(run->a0 - 1, run->a1 + 1, run->b, mmode, lmode);
+	}
+}
+
 /**
  * write_line_lm: Draw a line of arbitrary angle.
  *
@@ -921,13 +1304,7 @@ void write_line(int x0, int y0, int x1, int y1, uint8_t value)
  */
 void write_line_lm(int x0, int y0, int x1, int y1, int mmode, int lmode)
 {
-#if defined(PIOS_VIDEO_SPLITBUFFER)
-	write_line(draw_buffer_mask, x0, y0, x1, y1, mmode);
-	write_line(draw_buffer_level, x0, y0, x1, y1, lmode);
-#else
-	uint8_t value = PACK_BITS(mmode, lmode);
-	write_line(x0, y0, x1, y1, value);
-#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	line_runs(x0, y0, x1, y1, 0, line_run_plain, mmode, lmode);
 }
 
 /**
@@ -946,71 +1323,7 @@ void write_line_outlined(int x0, int y0, int x1, int y1,
 						 __attribute__((unused)) int endcap0, __attribute__((unused)) int endcap1,
 						 int mode, int mmode)
 {
-	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
-	// This could be improved for speed.
-	int omode, imode;
-
-	if (mode == 0) {
-		omode = 0;
-		imode = 1;
-	} else {
-		omode = 1;
-		imode = 0;
-	}
-	int steep = abs(y1 - y0) > abs(x1 - x0);
-	if (steep) {
-		SWAP(x0, y0);
-		SWAP(x1, y1);
-	}
-	if (x0 > x1) {
-		SWAP(x0, x1);
-		SWAP(y0, y1);
-	}
-	int deltax     = x1 - x0;
-	int deltay = abs(y1 - y0);
-	int error      = deltax / 2;
-	int ystep;
-	int y = y0;
-	int x;
-	if (y0 < y1) {
-		ystep = 1;
-	} else {
-		ystep = -1;
-	}
-	// Draw the outline.
-	for (x = x0; x < x1; x++) {
-		if (steep) {
-			write_pixel_lm(y - 1, x, mmode, omode);
-			write_pixel_lm(y + 1, x, mmode, omode);
-			write_pixel_lm(y, x - 1, mmode, omode);
-			write_pixel_lm(y, x + 1, mmode, omode);
-		} else {
-			write_pixel_lm(x - 1, y, mmode, omode);
-			write_pixel_lm(x + 1, y, mmode, omode);
-			write_pixel_lm(x, y - 1, mmode, omode);
-			write_pixel_lm(x, y + 1, mmode, omode);
-		}
-		error -= deltay;
-		if (error < 0) {
-			y     += ystep;
-			error += deltax;
-		}
-	}
-	// Now draw the innards.
-	error = deltax / 2;
-	y     = y0;
-	for (x = x0; x < x1; x++) {
-		if (steep) {
-			write_pixel_lm(y, x, mmode, imode);
-		} else {
-			write_pixel_lm(x, y, mmode, imode);
-		}
-		error -= deltay;
-		if (error < 0) {
-			y     += ystep;
-			error += deltax;
-		}
-	}
+	write_line_outlined_dashed(x0, y0, x1, y1, endcap0, endcap1, mode, mmode, 0);
 }
 
 /**
@@ -1030,8 +1343,6 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 								__attribute__((unused)) int endcap0, __attribute__((unused)) int endcap1,
 								int mode, int mmode, int dots)
 {
-	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
-	// This could be improved for speed.
 	int omode, imode;
 
 	if (mode == 0) {
@@ -1041,74 +1352,9 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 		omode = 1;
 		imode = 0;
 	}
-	int steep = abs(y1 - y0) > abs(x1 - x0);
-	if (steep) {
-		SWAP(x0, y0);
-		SWAP(x1, y1);
-	}
-	if (x0 > x1) {
-		SWAP(x0, x1);
-		SWAP(y0, y1);
-	}
-	int deltax = x1 - x0;
-	int deltay = abs(y1 - y0);
-	int error  = deltax / 2;
-	int ystep;
-	int y = y0;
-	int x;
-	if (y0 < y1) {
-		ystep = 1;
-	} else {
-		ystep = -1;
-	}
-	// Draw the outline.
-	int dot_cnt = 0;
-	int draw    = 1;
-	for (x = x0; x < x1; x++) {
-		if (dots && !(dot_cnt++ % dots)) {
-			draw++;
-		}
-		if (draw % 2) {
-			if (steep) {
-				write_pixel_lm(y - 1, x, mmode, omode);
-				write_pixel_lm(y + 1, x, mmode, omode);
-				write_pixel_lm(y, x - 1, mmode, omode);
-				write_pixel_lm(y, x + 1, mmode, omode);
-			} else {
-				write_pixel_lm(x - 1, y, mmode, omode);
-				write_pixel_lm(x + 1, y, mmode, omode);
-				write_pixel_lm(x, y - 1, mmode, omode);
-				write_pixel_lm(x, y + 1, mmode, omode);
-			}
-		}
-		error -= deltay;
-		if (error < 0) {
-			y     += ystep;
-			error += deltax;
-		}
-	}
-	// Now draw the innards.
-	error = deltax / 2;
-	y     = y0;
-	dot_cnt = 0;
-	draw    = 1;
-	for (x = x0; x < x1; x++) {
-		if (dots && !(dot_cnt++ % dots)) {
-			draw++;
-		}
-		if (draw % 2) {
-			if (steep) {
-				write_pixel_lm(y, x, mmode, imode);
-			} else {
-				write_pixel_lm(x, y, mmode, imode);
-			}
-		}
-		error -= deltay;
-		if (error < 0) {
-			y     += ystep;
-			error += deltax;
-		}
-	}
+	// Draw the outline, then the innards over it.
+	line_runs(x0, y0, x1, y1, dots, line_run_outline, mmode, omode);
+	line_runs(x0, y0, x1, y1, dots, line_run_plain, mmode, imode);
 }
 
 /**
@@ -1229,6 +1475,10 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 	int wbit = CALC_BIT_IN_WORD(x);
 	row = ch * font_info->height;
 
+	// Misaligned 16 bit words spill into two more bytes (four for wide
+	// characters with two bits per pixel)
+	mark_damage(y, y + font_info->height - 1, x / PIXELS_PER_BIT, x / PIXELS_PER_BIT + 4);
+
 	if (font_info->width > 8) {
 		uint32_t data;
 		for (yy = y; yy < y + font_info->height; yy++) {
@@ -1327,6 +1577,143 @@ void calc_text_dimensions(char *str, const struct FontEntry *font, int xs, int y
 	dim->height = lines * (font->height + ys);
 }
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+/*
+ * Most strings on a page are the same from one frame to the next, so the
+ * rendered mask and level planes of recent strings are kept and copied in
+ * a few bytes per row instead of drawing every glyph again.  Direct mapped
+ * by a hash of the string.  A slot that was used in the last frame isn't
+ * given up to another string, so that strings which change every frame
+ * don't push out the ones that don't.
+ */
+#ifndef OSD_STRING_CACHE_ENTRIES
+#define OSD_STRING_CACHE_ENTRIES 16
+#endif
+#define STRING_CACHE_CHARS   24
+#define STRING_CACHE_BYTES   432   // both planes of 12 bytes x 18 rows
+
+struct string_cache_entry {
+	const struct FontEntry *font;
+	int8_t xs;
+	uint8_t len;
+	uint16_t used;      // osd_frame it was last drawn in
+	char str[STRING_CACHE_CHARS];
+	uint8_t data[STRING_CACHE_BYTES + 2];  // mask rows, then level rows; the
+	                                       // glyph writes may touch two more
+};
+
+static struct string_cache_entry string_cache[OSD_STRING_CACHE_ENTRIES];
+
+/**
+ * write_string_cached: Draw a single line of text through the string cache.
+ *
+ * @returns false if the string can't be cached, in which case nothing is
+ * drawn; the caller has to check it is fully inside the graphics area.
+ */
+static bool write_string_cached(const char *str, int len, int x, int y, int xs,
+		const struct FontEntry *font_info)
+{
+	int glyph_bits = (font_info->width > 8) ? 16 : 8;
+	int row_bytes = ((len - 1) * (font_info->width + xs) + glyph_bits + 7) / 8;
+
+	if (len > STRING_CACHE_CHARS || xs < 0 || xs > INT8_MAX ||
+			2 * row_bytes * font_info->height > STRING_CACHE_BYTES) {
+		return false;
+	}
+
+	uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)font_info ^ (uint32_t)xs;
+	for (int i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+	}
+
+	struct string_cache_entry *e = &string_cache[hash % OSD_STRING_CACHE_ENTRIES];
+	uint8_t *cmask  = e->data;
+	uint8_t *clevel = e->data + row_bytes * font_info->height;
+
+	if (e->font != font_info || e->xs != xs || e->len != len ||
+			memcmp(e->str, str, len)) {
+		if (e->font && (uint16_t)(osd_frame - e->used) <= 1) {
+			return false;
+		}
+
+		// Render it exactly as write_char() would into empty planes
+		memset(e->data, 0, 2 * row_bytes * font_info->height);
+
+		for (int i = 0; i < len; i++) {
+			uint8_t ch = font_info->lookup[(uint8_t)str[i]];
+			if (ch == 255)
+				continue;
+
+			int off = i * (font_info->width + xs);
+			int row = ch * font_info->height;
+			unsigned int addr = off / 8;
+
+			for (int yy = 0; yy < font_info->height; yy++) {
+				uint16_t mask, levels;
+
+				if (font_info->width > 8) {
+					uint32_t data = ((uint32_t*)font_info->data)[row];
+					mask   = data & 0xFFFF;
+					levels = (data >> 16) & 0xFFFF;
+				} else {
+					uint16_t data = font_info->data[row];
+					levels = data & 0xFF00;
+					mask   = (data & 0x00FF) << 8;
+				}
+				write_word_misaligned_OR(cmask, mask, addr, off & 7);
+				write_word_misaligned_OR(clevel, mask, addr, off & 7);
+				write_word_misaligned_NAND(clevel, mask & levels, addr, off & 7);
+				addr += row_bytes;
+				row++;
+			}
+		}
+
+		e->font = font_info;
+		e->xs   = xs;
+		e->len  = len;
+		memcpy(e->str, str, len);
+	}
+
+	// Glyph pixels are fully determined by the string, everything else
+	// is left alone, so a shifted copy is the same as drawing each char.
+	e->used = osd_frame;
+
+	int wbit = CALC_BIT_IN_WORD(x);
+	int addr = CALC_BUFF_ADDR(x, y);
+
+	mark_damage(y, y + font_info->height - 1, x / PIXELS_PER_BIT, x / PIXELS_PER_BIT + row_bytes);
+
+	for (int yy = 0; yy < font_info->height; yy++) {
+		uint8_t *m = draw_buffer_mask + addr;
+		uint8_t *l = draw_buffer_level + addr;
+		unsigned int pm = 0, pl = 0;
+		int i;
+
+		for (i = 0; i < row_bytes; i++) {
+			pm = (pm << 8) | cmask[i];
+			pl = (pl << 8) | clevel[i];
+			uint8_t sm = pm >> wbit;
+			uint8_t sl = pl >> wbit;
+
+			m[i] |= sm;
+			l[i]  = (l[i] & ~sm) | sl;
+		}
+		if (wbit) {
+			uint8_t sm = pm << (8 - wbit);
+			uint8_t sl = pl << (8 - wbit);
+
+			m[i] |= sm;
+			l[i]  = (l[i] & ~sm) | sl;
+		}
+		cmask  += row_bytes;
+		clevel += row_bytes;
+		addr   += BUFFER_WIDTH;
+	}
+
+	return true;
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 /**
  * write_string: Draw a string on the screen with certain
  * alignment parameters.
@@ -1373,6 +1760,17 @@ void write_string(char *str, int x, int y, int xs, int ys, int va, int ha, int f
 		xx = x - dim.width;
 		break;
 	}
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	// Single lines that are fully on screen go through the string cache
+	int len = strcspn(str, "\n\r");
+	if (len > 0 && str[len] == 0 && xx >= GRAPHICS_LEFT && yy >= GRAPHICS_TOP &&
+			xx + (len - 1) * (font_info->width + xs) + font_info->width <= GRAPHICS_RIGHT &&
+			yy + font_info->height <= GRAPHICS_BOTTOM &&
+			write_string_cached(str, len, xx, yy, xs, font_info)) {
+		return;
+	}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
 	// Then write each character.
 	xx_original = xx;
 	while (*str != 0) {
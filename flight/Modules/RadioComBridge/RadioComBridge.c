@@ -91,7 +91,10 @@ typedef struct {
 
 	// Queue handles.
 	struct pios_queue *uavtalkEventQueue;
-	struct pios_queue *radioEventQueue;
+
+	// Receiver updates for the radio; only the latest value matters, so
+	// a coalescing ring keeps a burst of them from queueing up.
+	struct UAVObjEventRing *radioEventRing;
 
 	// Error statistics.
 	uint32_t telemetryTxRetries;
@@ -144,8 +147,8 @@ static int32_t RadioComBridgeStart(void)
 		UAVObjConnectQueue(UAVObjGetByID(OBJECTPERSISTENCE_OBJID), data->uavtalkEventQueue,
 				   EV_UPDATED | EV_UPDATED_MANUAL);
 		if (data->isCoordinator) {
-			UAVObjConnectQueue(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->radioEventQueue,
-					   EV_UPDATED | EV_UPDATED_MANUAL);
+			UAVObjConnectRing(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->radioEventRing,
+					  EV_UPDATED | EV_UPDATED_MANUAL);
 		} else {
 			UAVObjConnectQueue(UAVObjGetByID(RFM22BRECEIVER_OBJID), data->uavtalkEventQueue,
 					   EV_UPDATED | EV_UPDATED_MANUAL);
@@ -228,7 +231,7 @@ static int32_t RadioComBridgeInitialize(void)
 	}
 	// Initialize the queues.
 	data->uavtalkEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
-	data->radioEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
+	data->radioEventRing = UAVObjEventRingCreate(EVENT_QUEUE_SIZE);
 
 	// Initialize the statistics.
 	data->telemetryTxRetries = 0;
@@ -357,11 +360,11 @@ static void radioTxTask( __attribute__ ((unused))
 		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIOTX);
 #endif
 
-		// Process the radio event queue, sending UAVObjects over the radio link as necessary.
+		// Process the radio event ring, sending UAVObjects over the radio link as necessary.
 		UAVObjEvent ev;
 
-		// Wait for queue message
-		if (PIOS_Queue_Receive(data->radioEventQueue, &ev, 20)) {
+		// Wait for ring message
+		if (UAVObjEventRingReceive(data->radioEventRing, &ev, 20)) {
 			if (ev.event == EV_UPDATED) {
 				// Send update (with retries)
 				int32_t ret = -1;
@@ -622,6 +625,14 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
 
 	if (state == UAVTALK_STATE_COMPLETE) {
+		if (UAVTalkIsPacketBatch(inConnectionHandle)) {
+			// Batches only carry periodic telemetry; take what we
+			// know of locally (e.g. for taranis) and pass it on
+			UAVTalkReceiveObject(inConnectionHandle);
+			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+			return;
+		}
+
 		// We only want to unpack certain objects from the remote modem
 		// Similarly we only want to relay certain objects to the telemetry port
 		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
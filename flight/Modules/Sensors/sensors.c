@@ -36,6 +36,7 @@
 #include "pios_queue.h"
 #include "misc_math.h"
 #include "lpfilter.h"
+#include "latency_trace.h"
 
 #if defined(PIOS_INCLUDE_PX4FLOW)
 #include "pios_px4flow_priv.h"
@@ -78,7 +79,7 @@ static void SensorsTask(void *parameters);
 static void settingsUpdatedCb(UAVObjEvent * objEv, void *ctx, void *obj, int len);
 
 static void update_accels(struct pios_sensor_accel_data *accel);
-static void update_gyros(struct pios_sensor_gyro_data *gyro);
+static void update_gyros(struct pios_sensor_gyro_data *gyro, uint32_t sample_time);
 static void update_mags(struct pios_sensor_mag_data *mag);
 static void update_baro(struct pios_sensor_baro_data *baro);
 
@@ -262,6 +263,9 @@ static void SensorsTask(void *parameters)
 			continue;
 		}
 
+		// Origin of the loop latency trace through to the motors
+		uint32_t gyro_sample_time = PIOS_DELAY_GetRaw();
+
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
 		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
 			//If no new accels data is ready, reuse the latest sample
@@ -272,7 +276,7 @@ static void SensorsTask(void *parameters)
 
 		// Update gyros after the accels since the rest of the code expects
 		// the accels to be available first
-		update_gyros(&gyros);
+		update_gyros(&gyros, gyro_sample_time);
 
 		bool test_good_run = good_runs > REQUIRED_GOOD_CYCLES;
 
@@ -386,8 +390,9 @@ static void update_accels(struct pios_sensor_accel_data *accels)
 /**
  * @brief Apply calibration and rotation to the raw gyro data
  * @param[in] gyros The raw gyro data
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time the data was received
  */
-static void update_gyros(struct pios_sensor_gyro_data *gyros)
+static void update_gyros(struct pios_sensor_gyro_data *gyros, uint32_t sample_time)
 {
 	// Scale the gyros
 	float gyros_out[3] = {
@@ -441,7 +446,9 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 		}
 	}
 
-	GyrosSet(&gyrosData);
+	latency_trace_record(LATENCY_TRACE_SENSORS, sample_time,
+			PIOS_DELAY_GetRaw());
+	GyrosSetTraced(&gyrosData, sample_time);
 }
 
 /**
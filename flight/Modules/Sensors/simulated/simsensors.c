@@ -1103,12 +1103,29 @@ static void simulateModelCar()
 }
 
 
+/**
+ * Uniform random number in [0, 1).  Uses its own fixed-seed generator
+ * rather than rand(), so that the simulated noise is the same on every
+ * run and every host C library.
+ */
+static float rand_unit(void)
+{
+	static uint32_t state = 2463534242;
+
+	/* xorshift32 */
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
 static float rand_gauss (void) {
 	float v1,v2,s;
 
 	do {
-		v1 = 2.0 * ((float) rand()/RAND_MAX) - 1;
-		v2 = 2.0 * ((float) rand()/RAND_MAX) - 1;
+		v1 = 2.0 * rand_unit() - 1;
+		v2 = 2.0 * rand_unit() - 1;
 
 		s = v1*v1 + v2*v2;
 	} while ( s >= 1.0 );
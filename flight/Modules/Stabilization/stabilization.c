@@ -66,6 +66,7 @@
 #include "pid.h"
 #include "misc_math.h"
 #include "smoothcontrol.h"
+#include "latency_trace.h"
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
@@ -384,6 +385,9 @@ static void stabilizationTask(void* parameters)
 		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
 
+		latency_trace_record(LATENCY_TRACE_STABILIZATION_WAKE,
+				ev.timestamp, timeval);
+
 		if (iteration < 100) {
 			dT_measured = 0;
 		} else if (iteration < 2100) {
@@ -1008,7 +1012,11 @@ static void stabilizationTask(void* parameters)
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 
-		ActuatorDesiredSet(&actuatorDesired);
+		latency_trace_record(LATENCY_TRACE_STABILIZATION, timeval,
+				PIOS_DELAY_GetRaw());
+
+		// Pass the gyro sample's time on, for the latency trace
+		ActuatorDesiredSetTraced(&actuatorDesired, ev.origin);
 
 		if(flightStatus.Armed != FLIGHTSTATUS_ARMED_ARMED ||
 		   (lowThrottleZeroIntegral && get_throttle(&stabDesired, &airframe_type) < 0))
@@ -42,6 +42,7 @@
 #include "pios_queue.h"
 #include "misc_math.h"
 #include "morsel.h"
+#include "latency_trace.h"
 
 #include "annunciatorsettings.h"
 #include "flightstatus.h"
@@ -66,6 +67,10 @@
 extern annuncdac_dev_t pios_dac_annunciator_id;
 #endif
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+extern uintptr_t pios_uavo_settings_fs_id;
+#endif
+
 #if defined(PIOS_INCLUDE_DEBUG_CONSOLE) && defined(DEBUG_THIS_FILE)
 #define DEBUG_MSG(format, ...) PIOS_COM_SendFormattedString(PIOS_COM_DEBUG, format, ## __VA_ARGS__)
 #else
@@ -103,6 +108,8 @@ extern annuncdac_dev_t pios_dac_annunciator_id;
 
 #endif
 
+#define LATENCY_UPDATE_PERIOD_MS 1000
+
 // Private types
 
 /**
@@ -141,6 +148,9 @@ static volatile bool config_check_needed;
 
 // Private functions
 static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len);
+#if defined(DIAG_LATENCY)
+static void latencyPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len);
+#endif
 static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj, int len);
 static uint32_t processPeriodicUpdates();
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
@@ -168,6 +178,9 @@ int32_t SystemModStart(void)
 	UAVObjEvent ev;
 	memset(&ev, 0, sizeof(UAVObjEvent));
 	EventPeriodicCallbackCreate(&ev, systemPeriodicCb, SYSTEM_UPDATE_PERIOD_MS);
+#if defined(DIAG_LATENCY)
+	EventPeriodicCallbackCreate(&ev, latencyPeriodicCb, LATENCY_UPDATE_PERIOD_MS);
+#endif
 
 	EventClearStats();
 
@@ -209,6 +222,10 @@ int32_t SystemModInitialize(void)
 	if (WatchdogStatusInitialize() == -1)
 		return -1;
 #endif
+#if defined(DIAG_LATENCY)
+	if (latency_trace_init() == -1)
+		return -1;
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -265,6 +282,20 @@ static void systemTask(void *parameters)
 			// If object persistence is updated call the callback
 			objectUpdatedCb(&ev, NULL, NULL, 0);
 		}
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		else {
+			// Nothing to save; get ahead on settings flash garbage
+			// collection so saves don't have to wait for an erase.
+			// Only on the ground: an erase can stall the CPU when
+			// settings live in internal flash.
+			uint8_t armed;
+			FlightStatusArmedGet(&armed);
+
+			if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
+				PIOS_FLASHFS_Compact(pios_uavo_settings_fs_id);
+			}
+		}
+#endif
 	}
 }
 
@@ -397,6 +428,14 @@ static inline void consider_annunc(AnnunciatorSettingsData *annunciatorSettings,
 }
 #endif
 
+#if defined(DIAG_LATENCY)
+static void latencyPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len) {
+	(void) ev; (void) ctx; (void) obj_data; (void) len;
+
+	latency_trace_publish();
+}
+#endif
+
 static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len) {
 	(void) ev; (void) ctx; (void) obj_data; (void) len;
 
@@ -634,7 +673,6 @@ static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj_data, int len
 		} else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_FULLERASE) {
 			retval = -1;
 #if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
-			extern uintptr_t pios_uavo_settings_fs_id;
 			retval = PIOS_FLASHFS_Format(pios_uavo_settings_fs_id);
 #endif
 		}
@@ -972,6 +1010,8 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
+	objEntry->evInfo.ev.timestamp = 0;	// stamped when dispatched
+	objEntry->evInfo.ev.origin = 0;
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
 	objEntry->updatePeriodMs = periodMs;
@@ -1052,6 +1092,9 @@ static uint32_t processPeriodicUpdates()
 				// Reset timer
 				offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
 				objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
+				// A periodic event is its own origin
+				objEntry->evInfo.ev.timestamp = PIOS_DELAY_GetRaw();
+				objEntry->evInfo.ev.origin = objEntry->evInfo.ev.timestamp;
 				// Invoke callback, if one
 				if ( objEntry->evInfo.cb != 0)
 				{
@@ -0,0 +1,58 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup TelemetryModule Telemetry Module
+ * @{
+ *
+ * @file       telemetry.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @brief      Telemetry module, handles telemetry and UAVObject updates
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "openpilot.h"
+
+/* File ids below FLASH_PARTITION_NUM_LABELS are raw flash partitions.
+ * File ids from here on are onboard logs; the low bits are the log
+ * number.
+ */
+#define TELEMETRY_FILEID_LOG_BASE 0x00010000
+
+/**
+ * Supplies the contents of onboard logs for file requests.
+ * \param[in] buf Where to put the data
+ * \param[in] log_id The log number
+ * \param[in] offset Offset within the log
+ * \param[in] len Maximum number of bytes to return
+ * \returns The number of bytes filled, 0 on EOF, negative on error.
+ */
+typedef int32_t (*TelemetryLogFileCb)(uint8_t *buf, uint32_t log_id,
+		uint32_t offset, uint32_t len);
+
+void TelemetrySetLogFileCallback(TelemetryLogFileCb cb);
+
+#endif /* TELEMETRY_H */
+
+/**
+  * @}
+  * @}
+  */
@@ -33,6 +33,7 @@
  */
 
 #include "openpilot.h"
+#include "telemetry.h"
 #include <eventdispatcher.h>
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
@@ -54,6 +55,13 @@
 #define TELEM_QUEUE_SIZE 60
 #endif
 
+#ifndef TELEM_DELTA_MIN_BYTES
+/* Periodic updates of objects at least this large are delta-encoded on the
+ * radio link, where each byte counts.  0 disables delta encoding.
+ */
+#define TELEM_DELTA_MIN_BYTES 32
+#endif
+
 #ifndef TELEM_STACK_SIZE
 #define TELEM_STACK_SIZE 624
 #endif
@@ -72,6 +80,19 @@
 #define MAX_ACKS_PENDING 3
 #define ACK_TIMEOUT_MS 250
 
+/* Link budget: the fraction of time spent blocked in sends tells how close
+ * the link is to saturation.  Past LINK_BUSY_HIGH_PCT periodic objects are
+ * slowed down one level further, below LINK_BUSY_LOW_PCT one level less.
+ * Each level doubles the period of slow (>= 1s) objects, and from the second
+ * and third level on also that of medium (>= 250ms) and fast objects.
+ */
+#define LINK_CHECK_MIN_US 1000000
+#define LINK_BUSY_HIGH_PCT 85
+#define LINK_BUSY_LOW_PCT 40
+#define MAX_DEGRADE_LEVEL 4
+#define SLOW_PERIOD_MS 1000
+#define MEDIUM_PERIOD_MS 250
+
 // Private types
 
 // Private variables
@@ -91,6 +112,14 @@ struct telemetry_state {
 	uint32_t tx_retries;
 	uint32_t time_of_last_update;
 
+	uint32_t link_check_time;
+	uint32_t tx_busy_us;
+	uint8_t degrade_level;
+
+	/* Frame types the GCS has said it can parse */
+	bool peer_batch;
+	bool peer_delta;
+
 	struct pending_ack acks[MAX_ACKS_PENDING];
 
 	struct pios_mutex *ack_mutex;
@@ -100,6 +129,8 @@ struct telemetry_state {
 
 static struct telemetry_state telem_state = { };
 
+static volatile TelemetryLogFileCb log_file_cb;
+
 #if defined(PIOS_COM_TELEM_USB)
 static volatile uint32_t usb_timeout_time;
 #endif
@@ -117,6 +148,9 @@ static void ackCallback(void *ctx, uint32_t obj_id, uint16_t inst_id);
 static void registerObject(telem_t telem, UAVObjHandle obj);
 static void updateObject(telem_t telem, UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(telem_t telem, UAVObjHandle obj, int32_t updatePeriodMs);
+static int32_t scaledUpdatePeriod(telem_t telem, UAVObjHandle obj, int32_t updatePeriodMs);
+static void updateLinkBudget(telem_t telem);
+static void rescheduleObject(telem_t telem, UAVObjHandle obj);
 static void processObjEvent(telem_t telem, UAVObjEvent * ev);
 static void updateTelemetryStats(telem_t telem);
 static void gcsTelemetryStatsUpdated();
@@ -188,6 +222,7 @@ int32_t TelemetryInitialize(void)
 
 	// Initialize vars
 	telem_state.time_of_last_update = 0;
+	telem_state.link_check_time = PIOS_DELAY_GetRaw();
 
 	// Create object queues
 	telem_state.queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -265,8 +300,9 @@ static void updateObject(telem_t telem, UAVObjHandle obj, int32_t eventType)
 	// Setup object depending on update mode
 	switch (updateMode) {
 	case UPDATEMODE_PERIODIC:
-		// Set update period
-		setUpdatePeriod(telem, obj, metadata.telemetryUpdatePeriod);
+		// Set update period, stretched if the link is saturated
+		setUpdatePeriod(telem, obj, scaledUpdatePeriod(telem, obj,
+					metadata.telemetryUpdatePeriod));
 
 		// Connect queue
 		eventMask = EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL;
@@ -419,7 +455,8 @@ static void addAckPending(telem_t telem, UAVObjHandle obj, uint16_t inst_id)
 /**
  * Callback for when we receive a request for data.  Converts a file
  * id to the actual unit of information, and returns/copies it.
- * Currently only operates on partitions.
+ * Operates on partitions, and on onboard logs when the logging module
+ * has registered a source for them.
  *
  * \param[in] ctx Callback context (telemetry subsystem handle)
  * \param[in] file_id The requested file_id
@@ -467,9 +504,24 @@ static int32_t fileReqCallback(void *ctx, uint8_t *buf,
 		return len;
 	}
 
+	TelemetryLogFileCb cb = log_file_cb;
+
+	if (cb && (file_id >= TELEMETRY_FILEID_LOG_BASE)) {
+		return cb(buf, file_id - TELEMETRY_FILEID_LOG_BASE, offset, len);
+	}
+
 	return -1;
 }
 
+/**
+ * Register the source of onboard log contents for file requests.
+ * \param[in] cb The callback, or NULL to stop serving logs
+ */
+void TelemetrySetLogFileCallback(TelemetryLogFileCb cb)
+{
+	log_file_cb = cb;
+}
+
 /**
  * Callback for when we receive an ack.
  *
@@ -510,6 +562,23 @@ static void ackCallback(void *ctx, uint32_t obj_id, uint16_t inst_id)
 	DEBUG_PRINTF(3, "telem: Got UNEXPECTED ack for %d/%d\n", obj_id, inst_id);
 }
 
+/**
+ * Whether to send an update as a delta against the last keyframe: only
+ * periodic updates of large objects, and only over the radio.
+ */
+static bool useDelta(telem_t telem, UAVObjEvent *ev)
+{
+	if (TELEM_DELTA_MIN_BYTES == 0 || !telem->peer_delta ||
+			ev->event != EV_UPDATED_PERIODIC ||
+			UAVObjGetNumBytes(ev->obj) < TELEM_DELTA_MIN_BYTES) {
+		return false;
+	}
+
+	uintptr_t port = getComPort();
+
+	return port && (port == PIOS_COM_TELEM_RF);
+}
+
 /**
  * Processes queue events
  */
@@ -538,9 +607,26 @@ static void processObjEvent(telem_t telem, UAVObjEvent * ev)
 				addAckPending(telem, ev->obj, ev->instId);
 			}
 
-			success = UAVTalkSendObject(telem->uavTalkCon,
-					ev->obj, ev->instId,
-					acked);
+			/* Anything that doesn't need an ack can share a
+			 * frame with its neighbours in the queue.  Settings
+			 * still go alone, so relays can tell them apart.
+			 */
+			if (acked || UAVObjIsSettings(ev->obj)) {
+				success = UAVTalkSendObject(telem->uavTalkCon,
+						ev->obj, ev->instId,
+						acked);
+			} else if (useDelta(telem, ev)) {
+				success = UAVTalkSendObjectDelta(
+						telem->uavTalkCon,
+						ev->obj, ev->instId);
+			} else if (telem->peer_batch) {
+				success = UAVTalkSendObjectBatched(
+						telem->uavTalkCon,
+						ev->obj, ev->instId);
+			} else {
+				success = UAVTalkSendObject(telem->uavTalkCon,
+						ev->obj, ev->instId, false);
+			}
 
 			if (success == -1) {
 				telem->tx_errors++;
@@ -574,12 +660,19 @@ static void telemetryTxTask(void *parameters)
 		// Wait for queue message
 		if (PIOS_Queue_Receive(telem->queue,&ev,
 					PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(telem, &ev);
+			// Process the event and everything else already
+			// queued, so that the objects get batched together
+			do {
+				processObjEvent(telem, &ev);
 
-			PIOS_Mutex_Lock(telem->ack_mutex, PIOS_MUTEX_TIMEOUT_MAX);
-			ackHousekeeping(telem);
-			PIOS_Mutex_Unlock(telem->ack_mutex);
+				PIOS_Mutex_Lock(telem->ack_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+				ackHousekeeping(telem);
+				PIOS_Mutex_Unlock(telem->ack_mutex);
+			} while (PIOS_Queue_Receive(telem->queue, &ev, 0) == true);
+
+			if (UAVTalkFlushBatch(telem->uavTalkCon) == -1) {
+				telem->tx_errors++;
+			}
 		}
 	}
 }
@@ -672,12 +765,20 @@ static void telemetryRxTask(void *parameters)
  */
 static int32_t transmitData(void *ctx, uint8_t * data, int32_t length)
 {
-	(void) ctx;
+	telem_t telem = ctx;
 
 	uintptr_t outputPort = getComPort();
 
-	if (outputPort)
-		return PIOS_COM_SendBuffer(outputPort, data, length);
+	if (outputPort) {
+		// Time spent waiting on the port is our measure of link load
+		uint32_t start = PIOS_DELAY_GetRaw();
+
+		int32_t ret = PIOS_COM_SendBuffer(outputPort, data, length);
+
+		telem->tx_busy_us += PIOS_DELAY_DiffuS(start);
+
+		return ret;
+	}
 
 	return -1;
 }
@@ -701,6 +802,104 @@ static int32_t setUpdatePeriod(telem_t telem, UAVObjHandle obj,
 	return EventPeriodicQueueUpdate(&ev, telem->queue, updatePeriodMs);
 }
 
+/**
+ * Stretch the update period of a periodic object according to the current
+ * degrade level and the object's priority, as given by its nominal period.
+ * \param[in] obj The object being scheduled
+ * \param[in] updatePeriodMs The update period from the metadata
+ * \return The update period to use
+ */
+static int32_t scaledUpdatePeriod(telem_t telem, UAVObjHandle obj,
+		int32_t updatePeriodMs)
+{
+	int32_t shift = telem->degrade_level;
+
+	// Keep reporting the link state itself at its nominal rate
+	if (updatePeriodMs <= 0 || obj == FlightTelemetryStatsHandle()) {
+		return updatePeriodMs;
+	}
+
+	if (updatePeriodMs < MEDIUM_PERIOD_MS) {
+		shift -= 2;
+	} else if (updatePeriodMs < SLOW_PERIOD_MS) {
+		shift -= 1;
+	}
+
+	if (shift <= 0) {
+		return updatePeriodMs;
+	}
+
+	updatePeriodMs <<= shift;
+
+	if (updatePeriodMs > UINT16_MAX) {
+		updatePeriodMs = UINT16_MAX;
+	}
+
+	return updatePeriodMs;
+}
+
+/**
+ * Check how busy the link has been since the last call, and move the degrade
+ * level of periodic objects up or down a step accordingly.
+ */
+static void updateLinkBudget(telem_t telem)
+{
+	uint32_t elapsed_us = PIOS_DELAY_DiffuS(telem->link_check_time);
+
+	// Also called on GCSTelemetryStats updates; wait for a usable sample
+	if (elapsed_us < LINK_CHECK_MIN_US) {
+		return;
+	}
+
+	uint32_t busy_pct = (uint64_t) telem->tx_busy_us * 100 / elapsed_us;
+
+	telem->tx_busy_us = 0;
+	telem->link_check_time = PIOS_DELAY_GetRaw();
+
+	uint8_t level = telem->degrade_level;
+
+	if (busy_pct >= LINK_BUSY_HIGH_PCT && level < MAX_DEGRADE_LEVEL) {
+		level++;
+	} else if (busy_pct <= LINK_BUSY_LOW_PCT && level > 0) {
+		level--;
+	}
+
+	if (level != telem->degrade_level) {
+		DEBUG_PRINTF(2, "telem: link %d%% busy, degrade level %d\n",
+				busy_pct, level);
+
+		telem->degrade_level = level;
+
+		/* Not through UAVObjIterate(): setUpdatePeriod() takes the
+		 * periodic event lock, and periodic callbacks set objects
+		 * while holding it, so the object manager's locks must not
+		 * be held here.
+		 */
+		for (uint8_t i = 0; i < UAVObjCount(); i++) {
+			UAVObjHandle obj = UAVObjGetByID(UAVObjIDByIndex(i));
+
+			if (obj) {
+				rescheduleObject(telem, obj);
+			}
+		}
+	}
+}
+
+/**
+ * Apply the current degrade level to a periodic object's update period.
+ * \param[in] obj Object to reschedule
+ */
+static void rescheduleObject(telem_t telem, UAVObjHandle obj)
+{
+	UAVObjMetadata metadata;
+	UAVObjGetMetadata(obj, &metadata);
+
+	if (UAVObjGetTelemetryUpdateMode(&metadata) == UPDATEMODE_PERIODIC) {
+		setUpdatePeriod(telem, obj, scaledUpdatePeriod(telem, obj,
+					metadata.telemetryUpdatePeriod));
+	}
+}
+
 /**
  * Called each time the GCS telemetry stats object is updated.
  * Trigger a flight telemetry stats update if a connection is not
@@ -732,6 +931,8 @@ static void updateTelemetryStats(telem_t telem)
 	// Get stats
 	UAVTalkGetStats(telem->uavTalkCon, &utalkStats);
 
+	updateLinkBudget(telem);
+
 	// Get object data
 	FlightTelemetryStatsGet(&flightStats);
 	GCSTelemetryStatsGet(&gcsStats);
@@ -746,6 +947,12 @@ static void updateTelemetryStats(telem_t telem)
 		flightStats.RxFailures += utalkStats.rxErrors;
 		flightStats.TxFailures += telem->tx_errors;
 		flightStats.TxRetries += telem->tx_retries;
+		flightStats.TxObjectRate = (float)utalkStats.txObjects / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
+		if (utalkStats.txBytes > utalkStats.txObjectBytes) {
+			flightStats.TxOverhead = 100 * (utalkStats.txBytes - utalkStats.txObjectBytes) / utalkStats.txBytes;
+		} else {
+			flightStats.TxOverhead = 0;
+		}
 		telem->tx_errors = 0;
 		telem->tx_retries = 0;
 	} else {
@@ -754,10 +961,14 @@ static void updateTelemetryStats(telem_t telem)
 		flightStats.RxFailures = 0;
 		flightStats.TxFailures = 0;
 		flightStats.TxRetries = 0;
+		flightStats.TxObjectRate = 0;
+		flightStats.TxOverhead = 0;
 		telem->tx_errors = 0;
 		telem->tx_retries = 0;
 	}
 
+	flightStats.TxDegradeLevel = telem->degrade_level;
+
 	// Check for connection timeout
 	timeNow = PIOS_Thread_Systime();
 	if (utalkStats.rxObjects > 0) {
@@ -793,6 +1004,16 @@ static void updateTelemetryStats(telem_t telem)
 		flightStats.Status = FLIGHTTELEMETRYSTATS_STATUS_DISCONNECTED;
 	}
 
+	// Batch and delta frames only go to a GCS that parses them
+	bool connected = flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED;
+
+	telem->peer_batch = connected &&
+		gcsStats.Features[GCSTELEMETRYSTATS_FEATURES_BATCHFRAMES] ==
+		GCSTELEMETRYSTATS_FEATURES_TRUE;
+	telem->peer_delta = connected &&
+		gcsStats.Features[GCSTELEMETRYSTATS_FEATURES_DELTAFRAMES] ==
+		GCSTELEMETRYSTATS_FEATURES_TRUE;
+
 	// Update the telemetry alarm
 	if (flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED) {
 		AlarmsClear(SYSTEMALARMS_ALARM_TELEMETRY);
@@ -28,12 +28,19 @@
  */
 
 /**
- * Input objects: @ref Accels, @ref VibrationAnalysisSettings
- * Output object: @ref VibrationAnalysisOutput
+ * Input objects: @ref Accels, @ref Gyros, @ref VibrationAnalysisSettings
+ * Output object: @ref VibrationAnalysisOutput, @ref VibrationAnalysisPeaks
  *
- * This module executes on a timer trigger. When the module is
+ * In Raw mode this module executes on a timer trigger. When the module is
  * triggered it will update the data of VibrationAnalysiOutput,
  * with the accumulated accelerometer samples. 
+ *
+ * In Spectrum mode every gyro and accel sample is queued from the object
+ * callbacks.  The task cuts them into half-overlapping Hann windowed
+ * segments, averages their power spectra (Welch's method) and publishes
+ * the strongest peaks of each axis in VibrationAnalysisPeaks.  The FFT
+ * work done per wakeup is bounded, so a fast sensor rate makes samples
+ * drop (and get counted) rather than starving other tasks.
  */
 
 #include "openpilot.h"
@@ -41,9 +48,14 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 
+#include "circqueue.h"
+#include "rfft.h"
+
 #include "accels.h"
+#include "gyros.h"
 #include "modulesettings.h"
 #include "vibrationanalysisoutput.h"
+#include "vibrationanalysispeaks.h"
 #include "vibrationanalysissettings.h"
 
 
@@ -51,7 +63,7 @@
 
 #define MAX_QUEUE_SIZE 2
 
-#define STACK_SIZE_BYTES (200 + 448 + 16 + (2*3*window_size)*0) // The memory requirement grows linearly 
+#define STACK_SIZE_BYTES (200 + 448 + 16 + 128 + (2*3*window_size)*0) // The memory requirement grows linearly 
 																				  // with window size. The constant is multiplied
 																				  // by 0 in order to reflect the fact that the
 																				  // malloc'ed memory is not taken from the module 
@@ -67,6 +79,14 @@
 
 #define MAX_WINDOW_SIZE 1024
 
+#define SPECTRUM_MAX_WINDOW 256      // Larger windows are clamped to this in Spectrum mode
+#define SPECTRUM_QUEUE_LEN 128       // Samples buffered per sensor between wakeups
+#define SPECTRUM_PERIOD_MS 4
+#define SPECTRUM_BUDGET_US 400       // FFT time allowed per wakeup, 10% of the CPU
+#define SPECTRUM_PUBLISH_MS 500
+#define SPECTRUM_PEAKS 3
+#define SPECTRUM_MIN_FREQUENCY 10.0f // [Hz] Ignore peaks in the flight dynamics
+
 // Comment for larger smaller buffers and much better accuracy. The maximum window size will be allocated.
 #define USE_SINGLE_INSTANCE_BUFFERS 1
 
@@ -99,8 +119,44 @@ static struct VibrationAnalysis_data {
 } *vtd;
 
 
+enum spectrum_sensor {
+	SPECTRUM_GYROS,
+	SPECTRUM_ACCELS,
+	SPECTRUM_NUM_SENSORS
+};
+
+struct spectrum_sensor_data {
+	circ_queue_t queue;
+	volatile uint32_t dropped;  // Written from the sensor's context
+	uint32_t dropped_seen;
+	uint32_t samples;           // Since the last publish
+	uint16_t fill;
+	uint16_t averages;
+	float *segment[3];
+	float *power[3];
+};
+
+static struct vibration_spectrum {
+	volatile bool running;
+	uint16_t window_size;
+	float window_gain;          // Sum of the window coefficients
+	float *window;
+	float *work;
+	rfft_state_t fft[3];        // Window sizes 16, 64, 256; created as needed
+	uint32_t fft_time_us;
+	uint32_t fft_count;
+	uint32_t last_publish;
+	struct spectrum_sensor_data sensor[SPECTRUM_NUM_SENSORS];
+	VibrationAnalysisPeaksData peaks;
+} *vsp;
+
+// Set once the spectrum state could not be allocated
+static bool spectrum_out_of_memory;
+
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static int32_t VibrationSpectrumConfigure(uint16_t window_size);
+static void VibrationSpectrumRun(void);
 
 /*
 *   Releases any memory dinamically allocated
@@ -144,6 +200,28 @@ static void VibrationAnalysisCleanup(void) {
 
 }
 
+/**
+ * Get the configured window size
+ * \returns the size in samples, or 0 if the setting is invalid
+ */
+static uint16_t VibrationAnalysisWindowSize(void)
+{
+    VibrationAnalysisSettingsFFTWindowSizeOptions window_size_enum;
+    VibrationAnalysisSettingsFFTWindowSizeGet(&window_size_enum);
+    switch (window_size_enum) {
+        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_16:
+            return 16;
+        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_64:
+            return 64;
+        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_256:
+            return 256;
+        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_1024:
+            return 1024;
+        default:
+            return 0;
+    }
+}
+
 /**
  * Start the module, called on startup
  */
@@ -154,9 +232,15 @@ static int32_t VibrationAnalysisStart(void)
 		return -1;
 
     //Get the window size
-    uint16_t window_size; // Make a local copy in order to check settings before allocating memory
+    uint16_t window_size = VibrationAnalysisWindowSize(); // Make a local copy in order to check settings before allocating memory
     uint16_t instances = 1;
 
+    if (window_size == 0) {
+        //This represents a serious configuration error. Do not start module.
+        module_enabled = false;
+        return -1;
+    }
+
     // Allocate and initialize the static data storage only if module is enabled the first time
     if (vtd == NULL){
         vtd = (struct VibrationAnalysis_data *) PIOS_malloc(sizeof(struct VibrationAnalysis_data));
@@ -171,28 +255,6 @@ static int32_t VibrationAnalysisStart(void)
         vtd->accels_static_bias_z -= GRAVITY; // [See note in definition of VibrationAnalysis_data structure]
     }
 
-    VibrationAnalysisSettingsFFTWindowSizeOptions window_size_enum;
-    VibrationAnalysisSettingsFFTWindowSizeGet(&window_size_enum);
-    switch (window_size_enum) {
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_16:
-            window_size = 16;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_64:
-            window_size = 64;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_256:
-            window_size = 256;
-            break;
-        case VIBRATIONANALYSISSETTINGS_FFTWINDOWSIZE_1024:
-            window_size = 1024;
-            break;
-        default:
-            //This represents a serious configuration error. Do not start module.
-            module_enabled = false;
-            return -1;
-            break;
-    }
-
     // Is the new window size different?
     // Will happen upon initialization and when the window size changes
     if (window_size != vtd->window_size) {
@@ -320,7 +382,8 @@ static int32_t VibrationAnalysisInitialize(void)
 		return -1;
 
 	// Initialize UAVOs
-	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1) {
+	if (VibrationAnalysisSettingsInitialize() == -1 || VibrationAnalysisOutputInitialize() == -1 ||
+			VibrationAnalysisPeaksInitialize() == -1) {
         module_enabled = false;
         return -1;
     }
@@ -333,12 +396,345 @@ static int32_t VibrationAnalysisInitialize(void)
 }
 MODULE_INITCALL(VibrationAnalysisInitialize, VibrationAnalysisStart)
 
+static void spectrum_push(enum spectrum_sensor which, float x, float y, float z)
+{
+	struct spectrum_sensor_data *sensor = &vsp->sensor[which];
+	const float sample[3] = { x, y, z };
+
+	if (circ_queue_write_data(sensor->queue, sample, 1) == 0)
+		sensor->dropped++;
+}
+
+static void spectrum_gyros_cb(UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	if (!vsp->running)
+		return;
+
+	GyrosData gyros;
+	GyrosGet(&gyros);
+
+	spectrum_push(SPECTRUM_GYROS, gyros.x, gyros.y, gyros.z);
+}
+
+static void spectrum_accels_cb(UAVObjEvent *ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	if (!vsp->running)
+		return;
+
+	AccelsData accels;
+	AccelsGet(&accels);
+
+	spectrum_push(SPECTRUM_ACCELS, accels.x, accels.y, accels.z);
+}
+
+static void spectrum_reset(void)
+{
+	for (int i = 0; i < SPECTRUM_NUM_SENSORS; i++) {
+		struct spectrum_sensor_data *sensor = &vsp->sensor[i];
+
+		circ_queue_clear(sensor->queue);
+		sensor->dropped_seen = sensor->dropped;
+		sensor->samples = 0;
+		sensor->fill = 0;
+		sensor->averages = 0;
+
+		for (int axis = 0; axis < 3; axis++)
+			memset(sensor->power[axis], 0,
+					(SPECTRUM_MAX_WINDOW / 2 + 1) * sizeof(float));
+	}
+
+	vsp->fft_time_us = 0;
+	vsp->fft_count = 0;
+	vsp->last_publish = PIOS_Thread_Systime();
+}
+
+/**
+ * Allocate the spectrum state the first time Spectrum mode is entered and
+ * prepare it for a window size.  The buffers are always sized for the
+ * largest window, since memory can't be given back to the heap.
+ *
+ * For the same reason a failed allocation is not retried: what was already
+ * allocated is lost, and retrying would only lose more.  The failed malloc
+ * has raised the OutOfMemory alarm.
+ * \returns 0 on success or -1 if out of memory or the window size is invalid
+ */
+static int32_t VibrationSpectrumConfigure(uint16_t window_size)
+{
+	if (spectrum_out_of_memory || window_size == 0)
+		return -1;
+
+	if (window_size > SPECTRUM_MAX_WINDOW)
+		window_size = SPECTRUM_MAX_WINDOW;
+
+	if (vsp == NULL) {
+		struct vibration_spectrum *v = PIOS_malloc(sizeof(*v));
+		if (v == NULL)
+			goto out_of_memory;
+
+		memset(v, 0, sizeof(*v));
+
+		v->window = PIOS_malloc(SPECTRUM_MAX_WINDOW * sizeof(float));
+		v->work = PIOS_malloc(SPECTRUM_MAX_WINDOW * sizeof(float));
+		if (v->window == NULL || v->work == NULL)
+			goto out_of_memory;
+
+		for (int i = 0; i < SPECTRUM_NUM_SENSORS; i++) {
+			struct spectrum_sensor_data *sensor = &v->sensor[i];
+
+			sensor->queue = circ_queue_new(3 * sizeof(float), SPECTRUM_QUEUE_LEN);
+			if (sensor->queue == NULL)
+				goto out_of_memory;
+
+			for (int axis = 0; axis < 3; axis++) {
+				sensor->segment[axis] = PIOS_malloc(SPECTRUM_MAX_WINDOW * sizeof(float));
+				sensor->power[axis] = PIOS_malloc((SPECTRUM_MAX_WINDOW / 2 + 1) * sizeof(float));
+				if (sensor->segment[axis] == NULL || sensor->power[axis] == NULL)
+					goto out_of_memory;
+			}
+		}
+
+		vsp = v;
+
+		GyrosConnectCallback(spectrum_gyros_cb);
+		AccelsConnectCallback(spectrum_accels_cb);
+	}
+
+	if (window_size != vsp->window_size) {
+		uint8_t idx = (window_size == 16) ? 0 : (window_size == 64) ? 1 : 2;
+
+		if (vsp->fft[idx] == NULL) {
+			vsp->fft[idx] = rfft_create(window_size);
+			if (vsp->fft[idx] == NULL)
+				goto out_of_memory;
+		}
+
+		// Periodic Hann window
+		vsp->window_gain = 0;
+		for (uint16_t i = 0; i < window_size; i++) {
+			vsp->window[i] = 0.5f - 0.5f * cosf(2 * (float)M_PI * i / window_size);
+			vsp->window_gain += vsp->window[i];
+		}
+
+		vsp->window_size = window_size;
+		spectrum_reset();
+	}
+
+	return 0;
+
+out_of_memory:
+	spectrum_out_of_memory = true;
+	return -1;
+}
+
+static rfft_state_t spectrum_fft(void)
+{
+	switch (vsp->window_size) {
+	case 16:
+		return vsp->fft[0];
+	case 64:
+		return vsp->fft[1];
+	default:
+		return vsp->fft[2];
+	}
+}
+
+/**
+ * Remove the mean from a segment, window it, and add its power spectrum
+ * to the running sums.
+ */
+static void spectrum_accumulate(const float *segment, float *power)
+{
+	const uint16_t n = vsp->window_size;
+	float *work = vsp->work;
+	float mean = 0;
+
+	for (uint16_t i = 0; i < n; i++)
+		mean += segment[i];
+	mean /= n;
+
+	for (uint16_t i = 0; i < n; i++)
+		work[i] = (segment[i] - mean) * vsp->window[i];
+
+	uint32_t start = PIOS_DELAY_GetRaw();
+	rfft_run(spectrum_fft(), work);
+	vsp->fft_time_us += PIOS_DELAY_DiffuS(start);
+	vsp->fft_count++;
+
+	power[0] += work[0] * work[0];
+	power[n / 2] += work[1] * work[1];
+	for (uint16_t k = 1; k < n / 2; k++)
+		power[k] += work[2 * k] * work[2 * k] + work[2 * k + 1] * work[2 * k + 1];
+}
+
+/**
+ * Move queued samples into the segment buffers, transforming each segment
+ * as it fills, until the queue is empty or this wakeup's budget is spent.
+ */
+static void spectrum_consume(struct spectrum_sensor_data *sensor, uint32_t start)
+{
+	const uint16_t n = vsp->window_size;
+
+	// A gap in the data would smear the spectrum, so start over
+	uint32_t dropped = sensor->dropped;
+	if (dropped != sensor->dropped_seen) {
+		sensor->dropped_seen = dropped;
+		sensor->fill = 0;
+	}
+
+	float sample[3];
+
+	while (circ_queue_read_data(sensor->queue, sample, 1) == 1) {
+		sensor->samples++;
+
+		for (int axis = 0; axis < 3; axis++)
+			sensor->segment[axis][sensor->fill] = sample[axis];
+
+		if (++sensor->fill < n)
+			continue;
+
+		for (int axis = 0; axis < 3; axis++) {
+			spectrum_accumulate(sensor->segment[axis], sensor->power[axis]);
+
+			// Half overlap: the second half starts the next segment
+			memmove(sensor->segment[axis], sensor->segment[axis] + n / 2,
+					n / 2 * sizeof(float));
+		}
+
+		sensor->fill = n / 2;
+		sensor->averages++;
+
+		if (PIOS_DELAY_DiffuS(start) > SPECTRUM_BUDGET_US)
+			break;
+	}
+}
+
+/**
+ * Find the strongest local maxima of an averaged power spectrum, refining
+ * each by a parabola through its neighbouring bins.
+ */
+static void spectrum_find_peaks(const float *power, float rate, uint16_t averages,
+		float *frequency, float *amplitude)
+{
+	const uint16_t n = vsp->window_size;
+	const float bin_hz = rate / n;
+	// Sine amplitude from the averaged power of its bin
+	const float scale = 2.0f / vsp->window_gain;
+
+	for (int i = 0; i < SPECTRUM_PEAKS; i++) {
+		frequency[i] = 0;
+		amplitude[i] = 0;
+	}
+
+	if (averages == 0 || rate <= 0)
+		return;
+
+	for (uint16_t k = 1; k < n / 2; k++) {
+		if (k * bin_hz < SPECTRUM_MIN_FREQUENCY)
+			continue;
+		if (power[k] <= power[k - 1] || power[k] < power[k + 1])
+			continue;
+
+		float a = sqrtf(power[k - 1]), b = sqrtf(power[k]), c = sqrtf(power[k + 1]);
+		float denom = a - 2 * b + c;
+		float delta = (denom < 0) ? 0.5f * (a - c) / denom : 0;
+
+		float amp = scale * sqrtf(power[k] / averages);
+
+		int slot = SPECTRUM_PEAKS;
+		while (slot > 0 && amp > amplitude[slot - 1])
+			slot--;
+		if (slot == SPECTRUM_PEAKS)
+			continue;
+
+		for (int i = SPECTRUM_PEAKS - 1; i > slot; i--) {
+			frequency[i] = frequency[i - 1];
+			amplitude[i] = amplitude[i - 1];
+		}
+
+		frequency[slot] = (k + delta) * bin_hz;
+		amplitude[slot] = amp;
+	}
+}
+
+static void spectrum_publish(void)
+{
+	VibrationAnalysisPeaksData *peaks = &vsp->peaks;
+	float elapsed = (PIOS_Thread_Systime() - vsp->last_publish) * 0.001f;
+
+	float *frequency[SPECTRUM_NUM_SENSORS] = { peaks->GyroFrequency, peaks->AccelFrequency };
+	float *amplitude[SPECTRUM_NUM_SENSORS] = { peaks->GyroAmplitude, peaks->AccelAmplitude };
+
+	peaks->DroppedSamples = 0;
+
+	for (int i = 0; i < SPECTRUM_NUM_SENSORS; i++) {
+		struct spectrum_sensor_data *sensor = &vsp->sensor[i];
+		float rate = sensor->samples / elapsed;
+
+		for (int axis = 0; axis < 3; axis++)
+			spectrum_find_peaks(sensor->power[axis], rate, sensor->averages,
+					&frequency[i][axis * SPECTRUM_PEAKS],
+					&amplitude[i][axis * SPECTRUM_PEAKS]);
+
+		peaks->SampleRate[i] = rate;
+		peaks->Averages[i] = sensor->averages;
+		peaks->DroppedSamples += sensor->dropped;
+	}
+
+	peaks->WindowSize = vsp->window_size;
+	peaks->FFTTime = vsp->fft_count ? vsp->fft_time_us / vsp->fft_count : 0;
+
+	VibrationAnalysisPeaksSet(peaks);
+
+	// Start the next average with the segments already in progress
+	for (int i = 0; i < SPECTRUM_NUM_SENSORS; i++) {
+		struct spectrum_sensor_data *sensor = &vsp->sensor[i];
+
+		sensor->samples = 0;
+		sensor->averages = 0;
+
+		for (int axis = 0; axis < 3; axis++)
+			memset(sensor->power[axis], 0,
+					(SPECTRUM_MAX_WINDOW / 2 + 1) * sizeof(float));
+	}
+
+	vsp->fft_time_us = 0;
+	vsp->fft_count = 0;
+	vsp->last_publish = PIOS_Thread_Systime();
+}
+
+/**
+ * One wakeup of Spectrum mode
+ */
+static void VibrationSpectrumRun(void)
+{
+	uint32_t start = PIOS_DELAY_GetRaw();
+
+	if (!vsp->running) {
+		// Whatever is queued predates the pause
+		spectrum_reset();
+		vsp->running = true;
+	}
+
+	for (int i = 0; i < SPECTRUM_NUM_SENSORS; i++)
+		spectrum_consume(&vsp->sensor[i], start);
+
+	if (PIOS_Thread_Systime() - vsp->last_publish >= SPECTRUM_PUBLISH_MS)
+		spectrum_publish();
+
+	PIOS_Thread_Sleep(SPECTRUM_PERIOD_MS);
+}
+
 
 static void VibrationAnalysisTask(void *parameters)
 {
     uint32_t lastSysTime;
     uint32_t lastSettingsUpdateTime;
     uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF; // By default, turn analysis off
+    uint8_t analysis = VIBRATIONANALYSISSETTINGS_ANALYSIS_RAW;
     uint16_t sampleRate_ms = 100; // Default sample rate of 100ms
     uint16_t sample_count;
     
@@ -372,23 +768,49 @@ static void VibrationAnalysisTask(void *parameters)
             //First check if the analysis is active
             VibrationAnalysisSettingsTestingStatusGet(&runAnalysisFlag);
             
+            VibrationAnalysisSettingsAnalysisGet(&analysis);
+
+            // Stop queueing spectrum samples unless they'll be used
+            if (vsp != NULL && (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF ||
+                    analysis != VIBRATIONANALYSISSETTINGS_ANALYSIS_SPECTRUM))
+                vsp->running = false;
+
             // If analysis is turned off, delay and then loop.
             if (runAnalysisFlag == VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF) {
                 PIOS_Thread_Sleep(200);
                 continue;
             }
-            // Get sample rate
-            VibrationAnalysisSettingsSampleRateGet(&sampleRate_ms);
-            sampleRate_ms = sampleRate_ms > 0 ? sampleRate_ms : 1; //Ensure sampleRate never is 0.
-            
-            //Reconfigure any parameter
-            VibrationAnalysisStart();
-            
-            vibrationAnalysisOutputData.samples = vtd->window_size;
 
-            lastSettingsUpdateTime = PIOS_Thread_Systime();
+            if (analysis == VIBRATIONANALYSISSETTINGS_ANALYSIS_SPECTRUM) {
+                if (VibrationSpectrumConfigure(VibrationAnalysisWindowSize()) != 0) {
+                    // Out of memory or bad window size; nothing to do
+                    PIOS_Thread_Sleep(200);
+                    continue;
+                }
+
+                lastSettingsUpdateTime = PIOS_Thread_Systime();
+            } else {
+                // Get sample rate
+                VibrationAnalysisSettingsSampleRateGet(&sampleRate_ms);
+                sampleRate_ms = sampleRate_ms > 0 ? sampleRate_ms : 1; //Ensure sampleRate never is 0.
+
+                //Reconfigure any parameter
+                VibrationAnalysisStart();
+
+                vibrationAnalysisOutputData.samples = vtd->window_size;
+
+                lastSettingsUpdateTime = PIOS_Thread_Systime();
 
-            runningAcquisition = 1;
+                runningAcquisition = 1;
+            }
+        }
+
+        if (analysis == VIBRATIONANALYSISSETTINGS_ANALYSIS_SPECTRUM) {
+            // The Raw mode queue isn't read here; keep it from backing up
+            while (PIOS_Queue_Receive(queue, &ev, 0) == true);
+
+            VibrationSpectrumRun();
+            continue;
         }
         
 
@@ -42,6 +42,23 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+/* Where the active copy of an object instance lives in the active arena */
+struct logfs_index_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t slot_id;
+};
+
+/* Progress of a compaction of the active arena into a fresh one */
+enum logfs_gc_state {
+	LOGFS_GC_IDLE,
+	LOGFS_GC_ERASE,		/* destination chosen, not yet erased */
+	LOGFS_GC_COPY,		/* destination reserved, copying active slots */
+};
+
+/* Active slots copied per compaction step */
+#define LOGFS_GC_COPY_SLOTS 4
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -55,6 +72,23 @@ struct logfs_state {
 	uint16_t num_free_slots;   /* slots in free state */
 	uint16_t num_active_slots; /* slots in active state */
 
+	/* Optional index of the active slots, so finding an object doesn't
+	 * mean reading every slot header before it.  Rebuilt on every mount;
+	 * when index_valid is false we fall back to scanning the arena.
+	 */
+	struct logfs_index_entry *index;
+	uint16_t index_len;
+	bool index_valid;
+
+	/* Compaction is spread over several saves (or done in the background
+	 * by PIOS_FLASHFS_Compact) instead of all at once when the log fills.
+	 * Slots of the active arena before gc_src_slot_id have been copied.
+	 */
+	enum logfs_gc_state gc_state;
+	uint8_t gc_arena_id;
+	uint16_t gc_src_slot_id;
+	uint16_t gc_dst_slot_id;
+
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
@@ -101,8 +135,35 @@ enum arena_state {
 struct arena_header {
 	uint32_t magic;
 	enum arena_state state;
+	uint32_t erase_count;	/* left erased on arenas formatted before it was kept */
 } __attribute__((packed));
 
+/**
+ * @brief Read how many times an arena has been erased
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_get_erase_count(const struct logfs_state *logfs, uint8_t arena_id, uint32_t *erase_count)
+{
+	struct arena_header arena_hdr;
+	if (PIOS_FLASH_read_data(logfs->partition_id,
+					logfs_get_addr(logfs, arena_id, 0),
+					(uint8_t *)&arena_hdr,
+					sizeof(arena_hdr)) != 0) {
+		return -1;
+	}
+
+	if ((arena_hdr.magic != logfs->cfg->fs_magic) ||
+		(arena_hdr.erase_count == 0xFFFFFFFF)) {
+		/* Blank, foreign or older arena; nothing known about it */
+		*erase_count = 0;
+	} else {
+		*erase_count = arena_hdr.erase_count;
+	}
+
+	return 0;
+}
+
 
 /****************************************
  * Arena life-cycle transition functions
@@ -117,6 +178,12 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
 {
 	uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
 
+	/* Carry the erase count over the erase */
+	uint32_t erase_count;
+	if (logfs_get_erase_count(logfs, arena_id, &erase_count) != 0) {
+		return -3;
+	}
+
 	/* Erase all of the sectors in the arena */
 	if (PIOS_FLASH_erase_range(logfs->partition_id, arena_addr, logfs->cfg->arena_size) != 0) {
 		return -1;
@@ -126,6 +193,7 @@ static int32_t logfs_erase_arena(const struct logfs_state *logfs, uint8_t arena_
 	struct arena_header arena_hdr = {
 		.magic = logfs->cfg->fs_magic,
 		.state = ARENA_STATE_ERASED,
+		.erase_count = erase_count + 1,
 	};
 
 	if (PIOS_FLASH_write_data(logfs->partition_id,
@@ -306,6 +374,38 @@ static int32_t logfs_find_active_arena(const struct logfs_state *logfs)
 	return -1;
 }
 
+/**
+ * @brief Obsolete any active arena other than the one we are about to mount
+ * @return 0 if success, < 0 on failure
+ * @note Power loss part way through garbage collection leaves two active
+ * arenas, both complete.  Arenas are no longer used in address order, so the
+ * lower numbered one may be the older; drop the extra one now so that it
+ * can't be the one found on some later boot.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_obsolete_other_arenas(const struct logfs_state *logfs, uint8_t active_arena_id)
+{
+	for (uint8_t arena_id = active_arena_id + 1;
+	     arena_id < logfs->partition_size / logfs->cfg->arena_size;
+	     arena_id++) {
+		struct arena_header arena_hdr;
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						logfs_get_addr(logfs, arena_id, 0),
+						(uint8_t *)&arena_hdr,
+						sizeof (arena_hdr)) != 0) {
+			return -1;
+		}
+		if ((arena_hdr.state == ARENA_STATE_ACTIVE) &&
+			(arena_hdr.magic == logfs->cfg->fs_magic)) {
+			if (logfs_obsolete_arena(logfs, arena_id) != 0) {
+				return -2;
+			}
+		}
+	}
+
+	return 0;
+}
+
 /*
  * The bits within these enum values must progress ONLY
  * from 1 -> 0 so that we can write later ones on top
@@ -397,12 +497,57 @@ static bool logfs_log_is_full(const struct logfs_state *logfs)
 	return (logfs->num_free_slots == 0);
 }
 
+/*
+ * Slot index maintenance.  Capacity is one entry per slot in the arena
+ * (less the header slot), which is also the most that can be active.
+ */
+static int32_t logfs_index_find(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	for (uint16_t i = 0; i < logfs->index_len; i++) {
+		if (logfs->index[i].obj_id == obj_id &&
+			logfs->index[i].obj_inst_id == obj_inst_id) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void logfs_index_add(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	if (!logfs->index_valid) {
+		return;
+	}
+
+	if (logfs->index_len >= (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1) {
+		/* Can't happen unless flash is inconsistent; stop trusting the index */
+		logfs->index_valid = false;
+		return;
+	}
+
+	struct logfs_index_entry *entry = &logfs->index[logfs->index_len++];
+
+	entry->obj_id      = obj_id;
+	entry->obj_inst_id = obj_inst_id;
+	entry->slot_id     = slot_id;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint16_t pos)
+{
+	PIOS_Assert(pos < logfs->index_len);
+
+	/* Order doesn't matter; fill the hole with the last entry */
+	logfs->index[pos] = logfs->index[--logfs->index_len];
+}
+
 static int32_t logfs_unmount_log(struct logfs_state *logfs)
 {
 	PIOS_Assert (logfs->mounted);
 
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
+	logfs->index_len        = 0;
+	logfs->index_valid      = false;
 	logfs->mounted          = false;
 
 	return 0;
@@ -415,8 +560,11 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_active_slots = 0;
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
+	logfs->index_len        = 0;
+	logfs->index_valid      = (logfs->index != NULL);
+	logfs->gc_state         = LOGFS_GC_IDLE;
 
-	/* Scan the log to find out how full it is */
+	/* Scan the log to find out how full it is, indexing as we go */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
@@ -442,6 +590,15 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+
+			if (logfs->index_valid &&
+				logfs_index_find(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id) >= 0) {
+				/* Duplicate active copies (interrupted save); only
+				 * the full scan in logfs_delete_object cleans those up */
+				logfs->index_valid = false;
+			}
+
+			logfs_index_add(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -475,6 +632,9 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->index) {
+		PIOS_free(logfs->index);
+	}
 	PIOS_free(logfs);
 }
 
@@ -519,6 +679,16 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->partition_id   = partition_id; /* underlying partition */
 	logfs->partition_size = partition_size; /* size of underlying partition */
 	logfs->mounted        = false;
+	logfs->index          = NULL;
+	logfs->index_len      = 0;
+	logfs->index_valid    = false;
+	logfs->gc_state       = LOGFS_GC_IDLE;
+
+	if (cfg->slot_index) {
+		/* Without the memory we just run slower */
+		logfs->index = PIOS_malloc_no_dma(((cfg->arena_size / cfg->slot_size) - 1) *
+				sizeof(struct logfs_index_entry));
+	}
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
@@ -549,6 +719,11 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 		goto out_end_trans;
 	}
 
+	if (logfs_obsolete_other_arenas(logfs, arena_id) != 0) {
+		rc = -2;
+		goto out_end_trans;
+	}
+
 	/* We've found an active arena, mount it */
 	if (logfs_mount_log(logfs, arena_id) != 0) {
 		/* Failed to mount the log, something is broken */
@@ -586,72 +761,248 @@ out_exit:
 	return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
-	PIOS_Assert (logfs->mounted);
+/*
+ * Garbage collection copies the active slots of the active arena into
+ * another arena, which then becomes the active one.  It is broken into steps
+ * so that no one save pays for both the erase and the copy: the first step
+ * erases the destination and each later step copies a few active slots.
+ * Saves landing in the active arena meanwhile are appended after the copy
+ * point and get copied in turn, and deletes of slots already copied are
+ * repeated in the destination, which stays reserved (and so is ignored at
+ * mount) until everything is across.
+ */
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+/* Slot in the active arena after the last one written */
+static uint16_t logfs_end_slot(const struct logfs_state *logfs)
+{
+	return (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+}
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+/*
+ * Should compaction start now?  Only once the log is nearly full, with room
+ * left for the steps that copy what is active, and only if it would at least
+ * double the free space.  When idle, start a little sooner so that the erase
+ * is done before any save gets to it.
+ */
+static bool logfs_gc_wanted(const struct logfs_state *logfs, bool idle)
+{
+	uint16_t num_obsolete_slots = logfs_end_slot(logfs) - 1 - logfs->num_active_slots;
+	uint16_t threshold = logfs->num_active_slots / (LOGFS_GC_COPY_SLOTS - 1) + 4;
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
-		return -1;
+	if (idle) {
+		threshold *= 2;
 	}
 
-	/* Reserve the destination arena so we can start filling it */
-	if (logfs_reserve_arena (logfs, dst_arena_id) != 0) {
-		/* Unable to reserve the arena */
-		return -2;
-	}
+	return (logfs->gc_state == LOGFS_GC_IDLE &&
+		logfs->num_free_slots <= threshold &&
+		num_obsolete_slots > logfs->num_free_slots);
+}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
-		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
-						src_addr,
-						(uint8_t *)&slot_hdr,
-						sizeof (slot_hdr)) != 0) {
-			return -3;
+/**
+ * @brief Choose the destination arena for compaction
+ * @return 0 if success, < 0 on failure
+ * @note Picks the least erased arena, and among equals the first one after
+ * the active arena, so wear stays level even across formats and remounts.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_start(struct logfs_state *logfs)
+{
+	PIOS_Assert(logfs->mounted);
+	PIOS_Assert(logfs->gc_state == LOGFS_GC_IDLE);
+
+	uint8_t num_arenas = logfs->partition_size / logfs->cfg->arena_size;
+	uint32_t best_erase_count = UINT32_MAX;
+
+	for (uint8_t i = 1; i < num_arenas; i++) {
+		uint8_t arena_id = (logfs->active_arena_id + i) % num_arenas;
+
+		uint32_t erase_count;
+		if (logfs_get_erase_count(logfs, arena_id, &erase_count) != 0) {
+			return -1;
 		}
 
-		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
-			if (logfs_raw_copy_bytes(logfs,
-							src_addr,
-							sizeof(slot_hdr) + slot_hdr.obj_size,
-							dst_addr) != 0) {
-				/* Failed to copy all bytes */
-				return -4;
-			}
-			dst_slot_id++;
+		if (erase_count < best_erase_count) {
+			best_erase_count = erase_count;
+			logfs->gc_arena_id = arena_id;
 		}
 	}
 
+	logfs->gc_state = LOGFS_GC_ERASE;
+
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t logfs_gc_commit(struct logfs_state *logfs)
+{
+	uint8_t src_arena_id = logfs->active_arena_id;
+
 	/* Activate the destination arena */
-	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
-		return -5;
+	if (logfs_activate_arena (logfs, logfs->gc_arena_id) != 0) {
+		return -1;
 	}
 
 	/* Unmount the source arena */
 	if (logfs_unmount_log (logfs) != 0) {
-		return -6;
+		return -2;
 	}
 
 	/* Obsolete the source arena */
 	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
-		return -7;
+		return -3;
 	}
 
 	/* Mount the new arena */
-	if (logfs_mount_log (logfs, dst_arena_id) != 0) {
-		return -8;
+	if (logfs_mount_log (logfs, logfs->gc_arena_id) != 0) {
+		return -4;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Do one step of a compaction that has been started
+ * @return 0 if success, < 0 on failure
+ * @note On failure the compaction is abandoned, to be started over later
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step(struct logfs_state *logfs)
+{
+	PIOS_Assert(logfs->mounted);
+
+	int32_t rc = 0;
+
+	switch (logfs->gc_state) {
+	case LOGFS_GC_IDLE:
+		break;
+	case LOGFS_GC_ERASE:
+		/* Erase destination arena */
+		if (logfs_erase_arena (logfs, logfs->gc_arena_id) != 0) {
+			rc = -1;
+			break;
+		}
+
+		/* Reserve the destination arena so we can start filling it */
+		if (logfs_reserve_arena (logfs, logfs->gc_arena_id) != 0) {
+			rc = -2;
+			break;
+		}
+
+		logfs->gc_src_slot_id = 1;
+		logfs->gc_dst_slot_id = 1;
+		logfs->gc_state = LOGFS_GC_COPY;
+		break;
+	case LOGFS_GC_COPY:
+		/* Copy the next few active slots from the active arena */
+		for (uint8_t copied = 0;
+		     copied < LOGFS_GC_COPY_SLOTS && logfs->gc_src_slot_id < logfs_end_slot(logfs);
+		     logfs->gc_src_slot_id++) {
+			struct slot_header slot_hdr;
+			uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->gc_src_slot_id);
+			if (PIOS_FLASH_read_data(logfs->partition_id,
+							src_addr,
+							(uint8_t *)&slot_hdr,
+							sizeof (slot_hdr)) != 0) {
+				rc = -3;
+				break;
+			}
+
+			if (slot_hdr.state == SLOT_STATE_ACTIVE) {
+				uintptr_t dst_addr = logfs_get_addr (logfs, logfs->gc_arena_id, logfs->gc_dst_slot_id);
+				if (logfs_raw_copy_bytes(logfs,
+								src_addr,
+								sizeof(slot_hdr) + slot_hdr.obj_size,
+								dst_addr) != 0) {
+					/* Failed to copy all bytes */
+					rc = -4;
+					break;
+				}
+				logfs->gc_dst_slot_id++;
+				copied++;
+			}
+		}
+
+		if (rc == 0 && logfs->gc_src_slot_id == logfs_end_slot(logfs)) {
+			/* Everything is across, switch over */
+			if (logfs_gc_commit(logfs) != 0) {
+				rc = -5;
+			}
+		}
+		break;
+	}
+
+	if (rc != 0) {
+		logfs->gc_state = LOGFS_GC_IDLE;
+	}
+
+	return rc;
+}
+
+/**
+ * @brief Repeat the deletion of an active slot in the compaction destination
+ * @note Done when the slot has already been copied, otherwise the object
+ * would come back when the destination becomes active.
+ * @note Must be called while holding the flash transaction lock
+ */
+static void logfs_gc_obsolete_copy(struct logfs_state *logfs, uint16_t src_slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (logfs->gc_state != LOGFS_GC_COPY || src_slot_id >= logfs->gc_src_slot_id) {
+		/* Not copied (yet) */
+		return;
+	}
+
+	for (uint16_t slot_id = 1; slot_id < logfs->gc_dst_slot_id; slot_id++) {
+		struct slot_header slot_hdr;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->gc_arena_id, slot_id);
+		if (PIOS_FLASH_read_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			break;
+		}
+
+		if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+			slot_hdr.obj_id      == obj_id &&
+			slot_hdr.obj_inst_id == obj_inst_id) {
+			slot_hdr.state = SLOT_STATE_OBSOLETE;
+			if (PIOS_FLASH_write_data(logfs->partition_id,
+							slot_addr,
+							(uint8_t *)&slot_hdr,
+							sizeof(slot_hdr)) != 0) {
+				break;
+			}
+
+			return;
+		}
+	}
+
+	/* Couldn't find or obsolete the copy; this compaction can't be trusted */
+	logfs->gc_state = LOGFS_GC_IDLE;
+}
+
+/**
+ * @brief Run garbage collection to completion, for when the log is full
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs)
+{
+	PIOS_Assert (logfs->mounted);
+
+	/* A compaction already under way may be carrying copies that went
+	 * obsolete while it ran and so free nothing; follow it with a fresh one */
+	for (uint8_t pass = 0; pass < 2 && logfs_log_is_full(logfs); pass++) {
+		if (logfs->gc_state == LOGFS_GC_IDLE) {
+			if (logfs_gc_start(logfs) != 0) {
+				return -1;
+			}
+		}
+
+		while (logfs->gc_state != LOGFS_GC_IDLE) {
+			if (logfs_gc_step(logfs) != 0) {
+				return -2;
+			}
+		}
 	}
 
 	return 0;
@@ -694,12 +1045,81 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	return -1;
 }
 
+/**
+ * @brief Find the active copy of an object, through the index if there is one
+ * @return 0 if found, -1 if not found, -2 on flash error, -3 if the index
+ * disagrees with flash
+ * @note Must be called while holding the flash transaction lock
+ */
+static int16_t logfs_object_find (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs->index_valid) {
+		*slot_id = 0;
+		return logfs_object_find_next (logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+	}
+
+	int32_t pos = logfs_index_find(logfs, obj_id, obj_inst_id);
+	if (pos < 0) {
+		return -1;
+	}
+
+	*slot_id = logfs->index[pos].slot_id;
+
+	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, *slot_id);
+	if (PIOS_FLASH_read_data(logfs->partition_id,
+					slot_addr,
+					(uint8_t *)slot_hdr,
+					sizeof (*slot_hdr)) != 0) {
+		return -2;
+	}
+
+	if (slot_hdr->state != SLOT_STATE_ACTIVE ||
+		slot_hdr->obj_id      != obj_id ||
+		slot_hdr->obj_inst_id != obj_inst_id) {
+		PIOS_DEBUG_Assert(0);
+		return -3;
+	}
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
 
+	if (logfs->index_valid) {
+		/* The index only holds one active copy per object, and was
+		 * dropped at mount if flash had more than that */
+		struct slot_header slot_hdr;
+		uint16_t slot_id;
+
+		switch (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id)) {
+		case 0:
+			break;
+		case -1:
+			return 0;
+		default:
+			return -1;
+		}
+
+		slot_hdr.state = SLOT_STATE_OBSOLETE;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+
+		if (PIOS_FLASH_write_data(logfs->partition_id,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof(slot_hdr)) != 0) {
+			return -2;
+		}
+
+		logfs->num_active_slots--;
+		logfs_index_remove(logfs, logfs_index_find(logfs, obj_id, obj_inst_id));
+		logfs_gc_obsolete_copy(logfs, slot_id, obj_id, obj_inst_id);
+
+		return 0;
+	}
+
 	bool more = true;
 	uint16_t curr_slot_id = 0;
 	do {
@@ -719,6 +1139,7 @@ static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, u
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_gc_obsolete_copy(logfs, curr_slot_id, obj_id, obj_inst_id);
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -831,6 +1252,7 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_add(logfs, obj_id, obj_inst_id, free_slot_id);
 	return 0;
 }
 
@@ -920,6 +1342,14 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 		goto out_end_trans;
 	}
 
+	/* Keep any compaction moving so it's done before the log fills.  The
+	 * object is safely written, so a failure here only abandons the
+	 * compaction; a full log will force a fresh one. */
+	if (logfs_gc_wanted(logfs, false)) {
+		logfs_gc_start(logfs);
+	}
+	logfs_gc_step(logfs);
+
 	/* Object successfully written to the log */
 	rc = 0;
 
@@ -963,9 +1393,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	}
 
 	/* Find the object in the log */
-	uint16_t slot_id = 0;
+	uint16_t slot_id;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -1042,6 +1472,53 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Do one bounded step of garbage collection, if any is due
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if there is nothing more to do, 1 if there is, or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if the garbage collection step failed
+ * @note Meant to be called from a low priority task when idle, so that
+ * saves rarely have to wait for an erase.
+ */
+int32_t PIOS_FLASHFS_Compact(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	if (logfs_gc_wanted(logfs, true)) {
+		if (logfs_gc_start(logfs) != 0) {
+			rc = -3;
+			goto out_end_trans;
+		}
+	}
+
+	if (logfs_gc_step(logfs) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	rc = (logfs->gc_state != LOGFS_GC_IDLE) ? 1 : 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @brief Erases all filesystem arenas and activate the first arena
  * @param[in] fs_id The filesystem to use for this action
@@ -59,6 +59,20 @@ struct pios_semaphore *PIOS_Semaphore_Create(void)
 	return sema;
 }
 
+/**
+ *
+ * @brief   Destroys an instance of @p struct pios_semaphore
+ *
+ * @param[in] sema         pointer to instance of @p struct pios_semaphore
+ *
+ */
+void PIOS_Semaphore_Delete(struct pios_semaphore *sema)
+{
+	PIOS_Assert(sema != NULL);
+
+	PIOS_free(sema);
+}
+
 /**
  *
  * @brief   Takes binary semaphore.
@@ -162,6 +176,20 @@ struct pios_semaphore *PIOS_Semaphore_Create(void)
 	return sema;
 }
 
+/**
+ *
+ * @brief   Destroys an instance of @p struct pios_semaphore
+ *
+ * @param[in] sema         pointer to instance of @p struct pios_semaphore
+ *
+ */
+void PIOS_Semaphore_Delete(struct pios_semaphore *sema)
+{
+	PIOS_Assert(sema != NULL);
+
+	PIOS_free(sema);
+}
+
 /**
  *
  * @brief   Takes binary semaphore.
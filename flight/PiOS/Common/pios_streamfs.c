@@ -97,6 +97,10 @@ struct streamfs_state {
 	int32_t active_file_arena;
 	int32_t active_file_arena_offset;
 
+	/* Where the file being read starts, for seeking */
+	int32_t read_first_arena;
+	uint16_t read_first_segment;
+
 	/* Information about file system contents */
 	int32_t min_file_id;
 	int32_t max_file_id;
@@ -821,9 +825,20 @@ int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id)
 	// Find start of file
 	streamfs->active_file_arena = streamfs_find_first_arena(streamfs, file_id);
 	if (streamfs->active_file_arena >= 0) {
+		struct streamfs_footer footer;
+		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+				                                   streamfs->cfg->arena_size - sizeof(footer));
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			streamfs->active_file_arena = 0;
+			rc = -5;
+			goto out_end_trans;
+		}
+
 		streamfs->active_file_id = file_id;
 		streamfs->active_file_segment = 0;
 		streamfs->active_file_arena_offset = 0;
+		streamfs->read_first_arena = streamfs->active_file_arena;
+		streamfs->read_first_segment = footer.file_segment;
 		streamfs->file_open_reading = true;
 	} else {
 		streamfs->active_file_arena = 0;
@@ -971,6 +986,69 @@ int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len) {
 	return rc;
 }
 
+/**
+ * Move the read position of the open file.  Files occupy consecutive
+ * arenas, so this costs one footer read instead of reading through
+ * everything before the offset.
+ * @param[in] fs_id the file system handle
+ * @param[in] offset byte offset from the start of the file
+ * @return 0 if success, 1 if offset is at or past the end of the file,
+ * < 0 on failure
+ */
+int32_t PIOS_STREAMFS_Seek(uintptr_t fs_id, uint32_t offset)
+{
+	int32_t rc;
+
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	bool valid = streamfs_validate(streamfs);
+	PIOS_Assert(valid);
+
+	if (!streamfs->file_open_reading)
+		return -1;
+
+	uint32_t payload = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
+	uint32_t segment = offset / payload;
+
+	if (segment >= streamfs->partition_arenas)
+		return 1;
+
+	uint32_t arena = (streamfs->read_first_arena + segment) %
+		streamfs->partition_arenas;
+
+	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+		return -2;
+	}
+
+	struct streamfs_footer footer;
+	uint32_t start_address = streamfs_get_addr(streamfs, arena,
+			                                   streamfs->cfg->arena_size - sizeof(footer));
+
+	if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	if (footer.magic != streamfs->cfg->fs_magic ||
+			footer.file_id != streamfs->active_file_id ||
+			footer.file_segment != (uint16_t) (streamfs->read_first_segment + segment) ||
+			(offset % payload) >= footer.written_bytes) {
+		rc = 1;
+		goto out_end_trans;
+	}
+
+	streamfs->active_file_arena = arena;
+	streamfs->active_file_arena_offset = offset % payload;
+
+	rc = 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+	return rc;
+}
+
 // Testing methods for unit tests
 int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len)
 {
@@ -127,6 +127,9 @@ void TaskMonitorUpdateAll(void)
 	 */
 #if defined(PIOS_INCLUDE_CHIBIOS)
 	currentTime = hal_lld_get_counter_value();
+#elif defined(SIM_POSIX)
+	/* Posix thread runtimes are in us */
+	currentTime = PIOS_DELAY_GetRaw();
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 	deltaTime = ((currentTime - lastMonitorTime) / 100) ? : 1; /* avoid divide-by-zero if the interval is too small */
 	lastMonitorTime = currentTime;
@@ -139,7 +142,10 @@ void TaskMonitorUpdateAll(void)
 			data.Running[n] = TASKINFO_RUNNING_TRUE;
 			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
-			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			uint32_t runningTime = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			/* Can exceed 100% in the simulator's virtual time mode */
+			data.RunningTime[n] = (runningTime > UINT8_MAX) ?
+				UINT8_MAX : runningTime;
 		}
 		else
 		{
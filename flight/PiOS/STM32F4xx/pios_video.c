@@ -74,8 +74,9 @@ static const struct pios_video_type_cfg pios_video_type_cfg_pal = {
 };
 
 // Allocate buffers.
-// Must be allocated in one block, so it is in a struct.
-struct _buffers {
+// Must be allocated in one block, so it is in a struct.  Word aligned, the
+// OSD clears and fills the buffers a 32 bit word at a time.
+struct __attribute__((aligned(4))) _buffers {
 	uint8_t buffer0_level[BUFFER_HEIGHT * BUFFER_WIDTH];
 	uint8_t buffer0_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
 	uint8_t buffer1_level[BUFFER_HEIGHT * BUFFER_WIDTH];
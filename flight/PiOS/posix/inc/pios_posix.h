@@ -66,5 +66,7 @@ struct timespec;
 int clock_gettime(clockid_t clk_id, struct timespec *t);
 #endif
 
+int32_t PIOS_Thread_Stats_Start(const char *path, uint32_t period_ms);
+
 #endif
 
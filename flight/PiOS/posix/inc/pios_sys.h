@@ -42,6 +42,7 @@ extern int32_t PIOS_SYS_SerialNumberGet(char str[PIOS_SYS_SERIAL_NUM_ASCII_LEN+1
 extern size_t PIOS_SYS_IrqStackUnused(void);
 extern size_t PIOS_SYS_OsStackUnused(void);
 
+extern void PIOS_SYS_Early_Args(int argc, char *argv[]);
 extern void PIOS_SYS_Args(int argc, char *argv[]);
 
 #endif /* PIOS_SYS_H */
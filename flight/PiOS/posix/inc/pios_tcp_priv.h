@@ -48,6 +48,17 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+/* Observers (GCS, loggers, HIL bridges) that may share one port */
+#ifndef PIOS_TCP_MAX_CLIENTS
+#define PIOS_TCP_MAX_CLIENTS 8
+#endif
+
+/* Per-client send backlog; a client further behind than this is
+ * disconnected.  Must be a power of two. */
+#ifndef PIOS_TCP_TX_BACKLOG_SIZE
+#define PIOS_TCP_TX_BACKLOG_SIZE (256 * 1024)
+#endif
+
 struct pios_tcp_cfg {
 	const char *ip;
 	uint16_t port;
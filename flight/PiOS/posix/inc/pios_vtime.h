@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * @file       pios_vtime.h
+ * @author     dRonin, http://dRonin.org, Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_VTIME Virtual time lockstep scheduler
+ * @{
+ * @brief Runs the posix simulator on a simulated clock
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef PIOS_VTIME_H_
+#define PIOS_VTIME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * In virtual time mode only one PIOS thread runs at any instant, like on
+ * a single core RTOS.  The running thread keeps the CPU until it blocks
+ * (sleep, queue, semaphore, mutex) or wakes a higher priority thread.
+ * When every thread is blocked the clock jumps straight to the earliest
+ * timeout.  Code takes no simulated time to execute, so a given build and
+ * command line always produces the same schedule.
+ *
+ * Threads that block in the host OS (socket and serial receive) must
+ * bracket the call with PIOS_VTIME_Blocking_Begin/End so the rest of the
+ * system can run meanwhile.  Anything they feed in arrives at whatever
+ * simulated time it happens to, so runs are only reproducible without
+ * external inputs.
+ */
+
+struct pios_vtime_thread;
+
+void PIOS_VTIME_Enable(void);
+bool PIOS_VTIME_Enabled(void);
+uint64_t PIOS_VTIME_Now_us(void);
+
+struct pios_vtime_thread *PIOS_VTIME_Thread_Add(uint8_t prio);
+void PIOS_VTIME_Thread_Added(struct pios_vtime_thread *vt);
+void PIOS_VTIME_Thread_Start(struct pios_vtime_thread *vt);
+void PIOS_VTIME_Thread_Exit(void);
+
+uint64_t PIOS_VTIME_Deadline(uint32_t timeout_ms);
+bool PIOS_VTIME_Wait(const void *chan, uint64_t deadline_us);
+void PIOS_VTIME_Wake(const void *chan);
+void PIOS_VTIME_Sleep_us(uint64_t us);
+
+void PIOS_VTIME_Blocking_Begin(void);
+void PIOS_VTIME_Blocking_End(void);
+
+#endif /* PIOS_VTIME_H_ */
+
+/**
+  * @}
+  * @}
+  */
@@ -30,6 +30,7 @@
 
 /* Project Includes */
 #include "pios.h"
+#include "pios_vtime.h"
 #include "time.h"
 
 #include <time.h>
@@ -115,6 +116,11 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+	if (PIOS_VTIME_Enabled()) {
+		PIOS_VTIME_Sleep_us(uS);
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -139,6 +145,11 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+	if (PIOS_VTIME_Enabled()) {
+		PIOS_VTIME_Sleep_us(mS * 1000ULL);
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -152,6 +163,10 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+	if (PIOS_VTIME_Enabled()) {
+		return PIOS_VTIME_Now_us();
+	}
+
 	uint32_t raw_us = get_monotonic_us_time() - base_time;
 	return raw_us;
 }
@@ -35,6 +35,7 @@
 #include "pios.h"
 #include "pios_thread.h"
 #include "pios_flightgear.h"
+#include "pios_vtime.h"
 #include <unistd.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -78,8 +79,10 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 	while (true) {
 		char buf[320];
 
+		PIOS_VTIME_Blocking_Begin();
 		ssize_t cnt = recv(fg_dev->socket, buf, sizeof(buf) - 1,
 				0);
+		PIOS_VTIME_Blocking_End();
 
 		if (cnt < 0) {
 			perror("fg-recv");
@@ -146,7 +149,9 @@ static void PIOS_FLIGHTGEAR_RxTask(void *param)
 				.tv_usec = 2800,
 			};
 
+			PIOS_VTIME_Blocking_Begin();
 			select(fg_dev->socket + 1, &r, NULL, NULL, &timeout);
+			PIOS_VTIME_Blocking_End();
 
 			if (FD_ISSET(fg_dev->socket, &r)) {
 				break;
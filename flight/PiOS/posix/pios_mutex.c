@@ -30,6 +30,7 @@
 
 #include <pios.h>
 #include <pios_mutex.h>
+#include <pios_vtime.h>
 
 struct pios_mutex {
 	pthread_mutex_t mutex;
@@ -67,6 +68,20 @@ bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 {
 	int ret;
 
+	if (PIOS_VTIME_Enabled()) {
+		/* Only one thread runs at a time, so the holder is blocked
+		 * somewhere; wait for it to get around to unlocking. */
+		uint64_t deadline = PIOS_VTIME_Deadline(timeout_ms);
+
+		while (pthread_mutex_trylock(&mtx->mutex)) {
+			if (!PIOS_VTIME_Wait(mtx, deadline)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	if (timeout_ms >= PIOS_MUTEX_TIMEOUT_MAX) {
 		ret = pthread_mutex_lock(&mtx->mutex);
 
@@ -109,6 +124,10 @@ bool PIOS_Mutex_Unlock(struct pios_mutex *mtx)
 
 	PIOS_Assert(!ret);
 
+	if (PIOS_VTIME_Enabled()) {
+		PIOS_VTIME_Wake(mtx);
+	}
+
 	return true;
 }
 
@@ -30,6 +30,7 @@
 
 #include <pios_queue.h>
 #include <pios_thread.h>
+#include <pios_vtime.h>
 
 struct pios_queue {
 #define QUEUE_MAGIC 75657551	/* 'Queu' */
@@ -103,6 +104,20 @@ bool PIOS_Queue_Send(struct pios_queue *queuep,
 {
 	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
 
+	if (PIOS_VTIME_Enabled()) {
+		uint64_t deadline = PIOS_VTIME_Deadline(timeout_ms);
+
+		while (!circ_queue_write_data(queuep->queue, itemp, 1)) {
+			if (!PIOS_VTIME_Wait(queuep, deadline)) {
+				return false;
+			}
+		}
+
+		PIOS_VTIME_Wake(queuep);
+
+		return true;
+	}
+
 	struct timespec abstime;
 
 	if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
@@ -155,6 +170,20 @@ bool PIOS_Queue_Receive(struct pios_queue *queuep,
 {
 	PIOS_Assert(queuep->magic == QUEUE_MAGIC);
 
+	if (PIOS_VTIME_Enabled()) {
+		uint64_t deadline = PIOS_VTIME_Deadline(timeout_ms);
+
+		while (!circ_queue_read_data(queuep->queue, itemp, 1)) {
+			if (!PIOS_VTIME_Wait(queuep, deadline)) {
+				return false;
+			}
+		}
+
+		PIOS_VTIME_Wake(queuep);
+
+		return true;
+	}
+
 	struct timespec abstime;
 
 	if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
@@ -28,6 +28,7 @@
 
 #include <pios.h>
 #include <pios_semaphore.h>
+#include <pios_vtime.h>
 
 struct pios_semaphore {
 #define SEMAPHORE_MAGIC 0x616d6553	/* 'Sema' */
@@ -70,10 +71,36 @@ struct pios_semaphore *PIOS_Semaphore_Create(void)
 	return s;
 }
 
+void PIOS_Semaphore_Delete(struct pios_semaphore *sema)
+{
+	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
+
+	pthread_cond_destroy(&sema->cond);
+	pthread_mutex_destroy(&sema->mutex);
+
+	sema->magic = 0;
+
+	PIOS_free(sema);
+}
+
 bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
 {
 	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
 
+	if (PIOS_VTIME_Enabled()) {
+		uint64_t deadline = PIOS_VTIME_Deadline(timeout_ms);
+
+		while (!sema->given) {
+			if (!PIOS_VTIME_Wait(sema, deadline)) {
+				return false;
+			}
+		}
+
+		sema->given = false;
+
+		return true;
+	}
+
         struct timespec abstime;
 
         if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
@@ -115,6 +142,15 @@ bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
 
 	PIOS_Assert(sema->magic == SEMAPHORE_MAGIC);
 
+	if (PIOS_VTIME_Enabled()) {
+		old = sema->given;
+		sema->given = true;
+
+		PIOS_VTIME_Wake(sema);
+
+		return !old;
+	}
+
 	pthread_mutex_lock(&sema->mutex);
 
 	old = sema->given;
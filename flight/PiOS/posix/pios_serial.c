@@ -39,6 +39,7 @@
 
 #include <pios_serial_priv.h>
 #include "pios_thread.h"
+#include "pios_vtime.h"
 #include <unistd.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -91,7 +92,9 @@ static void PIOS_SERIAL_RxTask(void *ser_dev_n)
 	char incoming_buffer[INCOMING_BUFFER_SIZE];
 
 	while (1) {
+		PIOS_VTIME_Blocking_Begin();
 		int result = read(ser_dev->fd, incoming_buffer, INCOMING_BUFFER_SIZE);
+		PIOS_VTIME_Blocking_End();
 
 		if (result > 0 && ser_dev->rx_in_cb) {
 			bool rx_need_yield = false;
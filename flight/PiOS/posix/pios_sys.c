@@ -58,6 +58,7 @@
 #include "pios_tcp_priv.h"
 #include "pios_flightgear.h"
 #include "pios_thread.h"
+#include "pios_vtime.h"
 
 #include "pios_hal.h"
 #include "pios_adc_priv.h"
@@ -98,12 +99,15 @@ uintptr_t external_i2c_adapter_id;
 #endif
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f] [-r] [-m orientation] [-s spibase] [-d drvname:bus:id]\n"
-		"\t\t[-l logfile] [-I i2cdev] [-i drvname:bus] [-g port]"
+	printf( "usage: %s [-f] [-r] [-V] [-m orientation] [-s spibase] [-d drvname:bus:id]\n"
+		"\t\t[-l logfile] [-t statsfile] [-I i2cdev] [-i drvname:bus] [-g port]"
 		"\n"
 		"\t-f\tEnables floating point exception trapping mode\n"
 		"\t-r\tGoes realtime-class and pins all memory (requires root)\n"
+		"\t-V\tRuns on a virtual clock, as fast as possible and reproducibly\n"
 		"\t-l log\tWrites simulation data to a log\n"
+		"\t-t statsfile\tWrites per-thread CPU and stack use every second\n"
+		"\t\t\t(CSV, or JSON lines if statsfile ends in .json)\n"
 		"\t-g port\tStarts FlightGear driver on port\n"
 #ifdef PIOS_INCLUDE_SERIAL
 		"\t-S drvname:serialpath\tStarts a serial driver on serialpath\n"
@@ -435,6 +439,29 @@ static void go_realtime() {
 static int saved_argc;
 static char **saved_argv;
 
+#define SYS_ARGS_OPTSTRING "frVg:l:t:s:d:S:I:i:"
+
+/**
+ * Handles the arguments that must take effect before any thread is
+ * started.  Everything else is left to PIOS_SYS_Args.
+ */
+void PIOS_SYS_Early_Args(int argc, char *argv[]) {
+	int opt;
+
+	opterr = 0;
+
+	while ((opt = getopt(argc, argv, SYS_ARGS_OPTSTRING)) != -1) {
+		switch (opt) {
+			case 'V':
+				PIOS_VTIME_Enable();
+				break;
+		}
+	}
+
+	opterr = 1;
+	optind = 1;
+}
+
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	saved_argc = argc;
 	saved_argv = argv;
@@ -443,11 +470,21 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 
 	bool first_arg = true;
 
-	while ((opt = getopt(argc, argv, "frg:l:s:d:S:I:i:")) != -1) {
+	while ((opt = getopt(argc, argv, SYS_ARGS_OPTSTRING)) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe = true;
 				break;
+			case 'V':
+				/* Handled by PIOS_SYS_Early_Args */
+				break;
+			case 't':
+				if (PIOS_Thread_Stats_Start(optarg, 1000)) {
+					printf("Couldn't open stats file %s\n",
+							optarg);
+					exit(1);
+				}
+				break;
 			case 'r':
 				if (!first_arg) {
 					printf("Realtime must be before hw\n");
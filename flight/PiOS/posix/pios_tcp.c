@@ -40,11 +40,24 @@
 
 #include <pios_tcp_priv.h>
 #include "pios_thread.h"
+#include "pios_vtime.h"
 #include <unistd.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
 
+#if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
+#define TCP_WINSOCK
+#define poll WSAPoll
+#elif defined(__linux__)
+#define TCP_EPOLL
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#else
+#include <poll.h>
+#include <sys/uio.h>
+#endif
+
 #ifndef INVALID_SOCKET
 #define INVALID_SOCKET (-1)
 #endif
@@ -56,19 +69,60 @@ static void PIOS_TCP_RegisterTxCallback(uintptr_t udp_id, pios_com_callback tx_o
 static void PIOS_TCP_TxStart(uintptr_t udp_id, uint16_t tx_bytes_avail);
 static void PIOS_TCP_RxStart(uintptr_t udp_id, uint16_t rx_bytes_avail);
 
+/* Event interest / readiness bits, independent of epoll vs poll */
+#define TCP_EV_READ	0x01
+#define TCP_EV_WRITE	0x02
+#define TCP_EV_ERROR	0x04
+
+/* Event slots beyond the clients */
+#define TCP_SLOT_LISTEN	(PIOS_TCP_MAX_CLIENTS)
+#define TCP_SLOT_WAKE	(PIOS_TCP_MAX_CLIENTS + 1)
+#define TCP_NUM_SLOTS	(PIOS_TCP_MAX_CLIENTS + 2)
+
+struct pios_tcp_client {
+	int fd;
+	uint8_t events;
+
+	/* Bytes queued for this client but not yet accepted by the
+	 * kernel.  head/tail are free-running; masked on access. */
+	uint8_t *backlog;
+	uint32_t head;
+	uint32_t tail;
+};
+
+struct tcp_event {
+	uint8_t slot;
+	uint8_t flags;
+};
+
 typedef struct {
 	const struct pios_tcp_cfg * cfg;
 
 	int socket;
 	struct sockaddr_in6 server;
-	struct sockaddr_in6 client;
-	int socket_connection;
+
+	/* Other threads never touch a socket; they poke the I/O thread
+	 * through this pipe instead. */
+	int wake_rd;
+	int wake_wr;
+	bool wake_pending;
+
+#ifdef TCP_EPOLL
+	int epoll_fd;
+#endif
+
+	struct pios_tcp_client clients[PIOS_TCP_MAX_CLIENTS];
 
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
 	pios_com_callback rx_in_cb;
 	uintptr_t rx_in_context;
 
+	/* Received bytes the COM layer had no room for yet.  While any
+	 * remain, reading from clients is suspended. */
+	uint16_t rx_len;
+	uint16_t rx_off;
+
 	uint8_t rx_buffer[PIOS_TCP_RX_BUFFER_SIZE];
 	uint8_t tx_buffer[PIOS_TCP_RX_BUFFER_SIZE];
 } pios_tcp_dev;
@@ -87,67 +141,489 @@ static pios_tcp_dev * find_tcp_dev_by_id(uintptr_t tcp)
 	return (pios_tcp_dev *) tcp;
 }
 
+static void tcp_set_nonblocking(int fd)
+{
+#ifdef TCP_WINSOCK
+	u_long mode = 1;
+
+	ioctlsocket(fd, FIONBIO, &mode);
+#else
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+static bool tcp_would_block(int error)
+{
+#ifdef TCP_WINSOCK
+	return error == WSAEWOULDBLOCK;
+#else
+	return (error == EAGAIN) || (error == EWOULDBLOCK);
+#endif
+}
+
+static int tcp_last_error(void)
+{
+#ifdef TCP_WINSOCK
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
+
 /**
- * RxTask
+ * Ask the I/O thread to look at the COM buffers.  Cheap enough to call
+ * on every TxStart: only the first call since the last wakeup touches
+ * the pipe.
  */
-static void PIOS_TCP_RxTask(void *tcp_dev_n)
+static void tcp_wake(pios_tcp_dev *tcp_dev)
 {
-	pios_tcp_dev *tcp_dev = (pios_tcp_dev*)tcp_dev_n;
-	
-	const int INCOMING_BUFFER_SIZE = 16;
-	char incoming_buffer[INCOMING_BUFFER_SIZE];
-	int error;
+	if (tcp_dev->wake_wr == INVALID_SOCKET) {
+		return;
+	}
 
-	while (1) {
-	
-		do
-		{
-			tcp_dev->socket_connection = accept(tcp_dev->socket, NULL, NULL);
-			error = errno;
-
-			PIOS_Thread_Sleep(1);
-		} while (tcp_dev->socket_connection == INVALID_SOCKET && (error == EINTR || error == EAGAIN));
-
-		if (tcp_dev->socket_connection < 0) {
-			int error = errno;
-			(void)error;
-			perror("Accept failed");
-			close(tcp_dev->socket);
-			exit(EXIT_FAILURE);
+	if (!__atomic_exchange_n(&tcp_dev->wake_pending, true, __ATOMIC_ACQ_REL)) {
+		uint8_t b = 0;
+
+		if (write(tcp_dev->wake_wr, &b, 1) < 0) {
+			/* Pipe full means a wakeup is already queued */
+		}
+	}
+}
+
+#ifdef TCP_EPOLL
+static void tcp_watch(pios_tcp_dev *tcp_dev, int op, int fd, uint8_t slot, uint8_t events)
+{
+	struct epoll_event ev = {
+		.events = ((events & TCP_EV_READ) ? EPOLLIN : 0) |
+			((events & TCP_EV_WRITE) ? EPOLLOUT : 0),
+		.data.u32 = slot,
+	};
+
+	epoll_ctl(tcp_dev->epoll_fd, op, fd, &ev);
+}
+
+/**
+ * Wait for socket activity.
+ * \param[out] evs ready slots
+ * \return number of entries filled in evs
+ */
+static int tcp_wait(pios_tcp_dev *tcp_dev, struct tcp_event *evs)
+{
+	struct epoll_event ready[TCP_NUM_SLOTS];
+
+	PIOS_VTIME_Blocking_Begin();
+	int n = epoll_wait(tcp_dev->epoll_fd, ready, TCP_NUM_SLOTS, -1);
+	PIOS_VTIME_Blocking_End();
+
+	for (int i = 0; i < n; i++) {
+		evs[i].slot = ready[i].data.u32;
+		evs[i].flags =
+			((ready[i].events & EPOLLIN) ? TCP_EV_READ : 0) |
+			((ready[i].events & EPOLLOUT) ? TCP_EV_WRITE : 0) |
+			((ready[i].events & (EPOLLERR | EPOLLHUP)) ? TCP_EV_ERROR : 0);
+	}
+
+	return n;
+}
+#else
+static int tcp_wait(pios_tcp_dev *tcp_dev, struct tcp_event *evs)
+{
+	struct pollfd fds[TCP_NUM_SLOTS];
+	uint8_t slots[TCP_NUM_SLOTS];
+	int nfds = 0;
+
+	for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+		struct pios_tcp_client *c = &tcp_dev->clients[i];
+
+		if (c->fd == INVALID_SOCKET) {
+			continue;
+		}
+
+		fds[nfds].fd = c->fd;
+		fds[nfds].events = ((c->events & TCP_EV_READ) ? POLLIN : 0) |
+			((c->events & TCP_EV_WRITE) ? POLLOUT : 0);
+		slots[nfds++] = i;
+	}
+
+	fds[nfds].fd = tcp_dev->socket;
+	fds[nfds].events = POLLIN;
+	slots[nfds++] = TCP_SLOT_LISTEN;
+
+	if (tcp_dev->wake_rd != INVALID_SOCKET) {
+		fds[nfds].fd = tcp_dev->wake_rd;
+		fds[nfds].events = POLLIN;
+		slots[nfds++] = TCP_SLOT_WAKE;
+	}
+
+	/* Without a wake pipe (Winsock), fall back to picking up queued
+	 * data once a millisecond. */
+	int timeout = (tcp_dev->wake_rd != INVALID_SOCKET) ? -1 : 1;
+
+	PIOS_VTIME_Blocking_Begin();
+	int res = poll(fds, nfds, timeout);
+	PIOS_VTIME_Blocking_End();
+
+	int n = 0;
+
+	if (res == 0 && tcp_dev->wake_rd == INVALID_SOCKET) {
+		evs[n].slot = TCP_SLOT_WAKE;
+		evs[n++].flags = 0;
+	}
+
+	for (int i = 0; (res > 0) && (i < nfds); i++) {
+		if (!fds[i].revents) {
+			continue;
+		}
+
+		evs[n].slot = slots[i];
+		evs[n++].flags =
+			((fds[i].revents & POLLIN) ? TCP_EV_READ : 0) |
+			((fds[i].revents & POLLOUT) ? TCP_EV_WRITE : 0) |
+			((fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) ? TCP_EV_ERROR : 0);
+	}
+
+	return n;
+}
+#endif
+
+static void tcp_set_events(pios_tcp_dev *tcp_dev, struct pios_tcp_client *c,
+		uint8_t events)
+{
+	if (c->events == events) {
+		return;
+	}
+
+	c->events = events;
+
+#ifdef TCP_EPOLL
+	tcp_watch(tcp_dev, EPOLL_CTL_MOD, c->fd, c - tcp_dev->clients, events);
+#endif
+}
+
+static uint8_t tcp_client_events(pios_tcp_dev *tcp_dev, struct pios_tcp_client *c)
+{
+	return ((tcp_dev->rx_off < tcp_dev->rx_len) ? 0 : TCP_EV_READ) |
+		((c->head != c->tail) ? TCP_EV_WRITE : 0);
+}
+
+static void tcp_update_all_events(pios_tcp_dev *tcp_dev)
+{
+	for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+		struct pios_tcp_client *c = &tcp_dev->clients[i];
+
+		if (c->fd != INVALID_SOCKET) {
+			tcp_set_events(tcp_dev, c, tcp_client_events(tcp_dev, c));
+		}
+	}
+}
+
+static void tcp_drop_client(pios_tcp_dev *tcp_dev, struct pios_tcp_client *c,
+		const char *why)
+{
+#ifdef TCP_EPOLL
+	epoll_ctl(tcp_dev->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+#endif
+
+	close(c->fd);
+
+	fprintf(stderr, "tcp port %d: client %d %s\n", tcp_dev->cfg->port,
+			(int)(c - tcp_dev->clients), why);
+
+	c->fd = INVALID_SOCKET;
+	c->events = 0;
+	c->head = c->tail = 0;
+}
+
+static void tcp_accept(pios_tcp_dev *tcp_dev)
+{
+	while (true) {
+		int fd = accept(tcp_dev->socket, NULL, NULL);
+
+		if (fd == INVALID_SOCKET) {
+			int error = tcp_last_error();
+
+			if (!tcp_would_block(error) && error != EINTR) {
+				perror("Accept failed");
+			}
+
+			return;
+		}
+
+		struct pios_tcp_client *c = NULL;
+
+		for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+			if (tcp_dev->clients[i].fd == INVALID_SOCKET) {
+				c = &tcp_dev->clients[i];
+				break;
+			}
 		}
 
-		fprintf(stderr, "Connection accepted\n");
+		if (!c) {
+			fprintf(stderr, "tcp port %d: too many clients, refusing connection\n",
+					tcp_dev->cfg->port);
+			close(fd);
+			continue;
+		}
+
+		/* Backlogs are kept for the life of the process once a slot
+		 * has been used. */
+		if (!c->backlog) {
+			c->backlog = PIOS_malloc(PIOS_TCP_TX_BACKLOG_SIZE);
+
+			if (!c->backlog) {
+				close(fd);
+				return;
+			}
+		}
+
+#ifdef TCP_WINSOCK
+		char optval = 1;
+#else
+		int optval = 1;
+#endif
+
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+		tcp_set_nonblocking(fd);
+
+		c->fd = fd;
+		c->head = c->tail = 0;
+		c->events = tcp_client_events(tcp_dev, c);
+
+#ifdef TCP_EPOLL
+		tcp_watch(tcp_dev, EPOLL_CTL_ADD, fd, c - tcp_dev->clients, c->events);
+#endif
+
+		fprintf(stderr, "tcp port %d: client %d connected\n", tcp_dev->cfg->port,
+				(int)(c - tcp_dev->clients));
+	}
+}
+
+/**
+ * Push as much of a client's backlog into the kernel as it will take,
+ * both halves of the ring in one call.
+ */
+static void tcp_flush_client(pios_tcp_dev *tcp_dev, struct pios_tcp_client *c)
+{
+	const uint32_t mask = PIOS_TCP_TX_BACKLOG_SIZE - 1;
 
-		while (1) {
-			// Received is used to track the scoket whereas the dev variable is only updated when it can be
+	while (c->head != c->tail) {
+		uint32_t pending = c->head - c->tail;
+		uint32_t off = c->tail & mask;
+		uint32_t first = PIOS_TCP_TX_BACKLOG_SIZE - off;
 
-			int result = recv(tcp_dev->socket_connection, (char *) incoming_buffer, INCOMING_BUFFER_SIZE, 0);
-			error = errno;
+		if (first > pending) {
+			first = pending;
+		}
 
-			if (result > 0 && tcp_dev->rx_in_cb) {
+#ifdef TCP_WINSOCK
+		int sent = send(c->fd, (char *) c->backlog + off, first, 0);
+#else
+		struct iovec iov[2] = {
+			{ .iov_base = c->backlog + off, .iov_len = first },
+			{ .iov_base = c->backlog, .iov_len = pending - first },
+		};
 
-				bool rx_need_yield = false;
+		ssize_t sent = writev(c->fd, iov, (pending > first) ? 2 : 1);
+#endif
 
-				tcp_dev->rx_in_cb(tcp_dev->rx_in_context, (uint8_t*)incoming_buffer, result, NULL, &rx_need_yield);
+		if (sent < 0) {
+			int error = tcp_last_error();
 
+			if (error == EINTR) {
+				continue;
 			}
 
-			if (result == 0) {
+			if (tcp_would_block(error)) {
 				break;
 			}
 
-			if (result == -1) {
-				if (error == EAGAIN)
-					PIOS_Thread_Sleep(1);
-				else if (error == EINTR)
-					(void)error;
-				else
-					break;
+			tcp_drop_client(tcp_dev, c, "write failed");
+			return;
+		}
+
+		c->tail += sent;
+	}
+
+	tcp_set_events(tcp_dev, c, tcp_client_events(tcp_dev, c));
+}
+
+/**
+ * Drain the COM transmit buffer and fan it out to every client.  A
+ * client that has fallen a whole backlog behind is disconnected rather
+ * than allowed to hold up the others (or the flight code).
+ */
+static void tcp_pull_tx(pios_tcp_dev *tcp_dev)
+{
+	const uint32_t mask = PIOS_TCP_TX_BACKLOG_SIZE - 1;
+
+	if (!tcp_dev->tx_out_cb) {
+		return;
+	}
+
+	while (true) {
+		bool tx_need_yield = false;
+		uint16_t len = (tcp_dev->tx_out_cb)(tcp_dev->tx_out_context,
+				tcp_dev->tx_buffer, sizeof(tcp_dev->tx_buffer),
+				NULL, &tx_need_yield);
+
+		if (!len) {
+			break;
+		}
+
+		for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+			struct pios_tcp_client *c = &tcp_dev->clients[i];
+
+			if (c->fd == INVALID_SOCKET) {
+				continue;
+			}
+
+			if (PIOS_TCP_TX_BACKLOG_SIZE - (c->head - c->tail) < len) {
+				tcp_drop_client(tcp_dev, c, "too slow, disconnected");
+				continue;
+			}
+
+			uint32_t off = c->head & mask;
+			uint32_t first = PIOS_TCP_TX_BACKLOG_SIZE - off;
+
+			if (first > len) {
+				first = len;
+			}
+
+			memcpy(c->backlog + off, tcp_dev->tx_buffer, first);
+			memcpy(c->backlog, tcp_dev->tx_buffer + first, len - first);
+
+			c->head += len;
+		}
+	}
+
+	for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+		struct pios_tcp_client *c = &tcp_dev->clients[i];
+
+		if ((c->fd != INVALID_SOCKET) && (c->head != c->tail)) {
+			tcp_flush_client(tcp_dev, c);
+		}
+	}
+}
+
+/**
+ * Hand held-over receive data to the COM layer.
+ * \return true if nothing is left over
+ */
+static bool tcp_deliver_rx(pios_tcp_dev *tcp_dev)
+{
+	while (tcp_dev->rx_off < tcp_dev->rx_len) {
+		if (!tcp_dev->rx_in_cb) {
+			/* Nobody listening; discard as before */
+			tcp_dev->rx_off = tcp_dev->rx_len;
+			break;
+		}
+
+		bool rx_need_yield = false;
+		uint16_t taken = tcp_dev->rx_in_cb(tcp_dev->rx_in_context,
+				tcp_dev->rx_buffer + tcp_dev->rx_off,
+				tcp_dev->rx_len - tcp_dev->rx_off,
+				NULL, &rx_need_yield);
+
+		if (!taken) {
+			return false;
+		}
+
+		tcp_dev->rx_off += taken;
+	}
+
+	tcp_dev->rx_off = tcp_dev->rx_len = 0;
+
+	return true;
+}
+
+static void tcp_read_client(pios_tcp_dev *tcp_dev, struct pios_tcp_client *c)
+{
+	while (tcp_dev->rx_off >= tcp_dev->rx_len) {
+		int result = recv(c->fd, (char *) tcp_dev->rx_buffer,
+				sizeof(tcp_dev->rx_buffer), 0);
+
+		if (result == 0) {
+			tcp_drop_client(tcp_dev, c, "disconnected");
+			return;
+		}
+
+		if (result < 0) {
+			int error = tcp_last_error();
+
+			if (error == EINTR) {
+				continue;
+			}
+
+			if (!tcp_would_block(error)) {
+				tcp_drop_client(tcp_dev, c, "read failed");
+			}
+
+			return;
+		}
+
+		tcp_dev->rx_off = 0;
+		tcp_dev->rx_len = result;
+
+		if (!tcp_deliver_rx(tcp_dev)) {
+			/* COM buffer full; stop reading until RxStart */
+			tcp_update_all_events(tcp_dev);
+			return;
+		}
+	}
+}
+
+/**
+ * I/O task.  Owns every socket of the device: accepts, reads, and
+ * writes all happen here, so the threads queueing data never block on
+ * the network.
+ */
+static void PIOS_TCP_IoTask(void *tcp_dev_n)
+{
+	pios_tcp_dev *tcp_dev = (pios_tcp_dev*)tcp_dev_n;
+	struct tcp_event evs[TCP_NUM_SLOTS];
+
+	while (1) {
+		int n = tcp_wait(tcp_dev, evs);
+
+		for (int i = 0; i < n; i++) {
+			uint8_t slot = evs[i].slot;
+
+			if (slot == TCP_SLOT_LISTEN) {
+				tcp_accept(tcp_dev);
+			} else if (slot == TCP_SLOT_WAKE) {
+				uint8_t drain[64];
+
+				if (tcp_dev->wake_rd != INVALID_SOCKET) {
+					while (read(tcp_dev->wake_rd, drain, sizeof(drain)) > 0);
+				}
+
+				__atomic_store_n(&tcp_dev->wake_pending, false, __ATOMIC_RELEASE);
+
+				if ((tcp_dev->rx_off < tcp_dev->rx_len) && tcp_deliver_rx(tcp_dev)) {
+					tcp_update_all_events(tcp_dev);
+				}
+
+				tcp_pull_tx(tcp_dev);
+			} else {
+				struct pios_tcp_client *c = &tcp_dev->clients[slot];
+
+				if (c->fd == INVALID_SOCKET) {
+					continue;	/* Dropped earlier this round */
+				}
+
+				/* Read first so a peer's last bytes before a
+				 * hangup are still delivered */
+				if ((evs[i].flags & TCP_EV_READ) && (c->events & TCP_EV_READ)) {
+					tcp_read_client(tcp_dev, c);
+				} else if (evs[i].flags & TCP_EV_ERROR) {
+					tcp_drop_client(tcp_dev, c, "disconnected");
+				}
+
+				if ((c->fd != INVALID_SOCKET) && (evs[i].flags & TCP_EV_WRITE)) {
+					tcp_flush_client(tcp_dev, c);
+				}
 			}
 		}
-		
-		close(tcp_dev->socket_connection);
-		tcp_dev->socket_connection = INVALID_SOCKET;
 	}
 }
 
@@ -155,7 +631,6 @@ static void PIOS_TCP_RxTask(void *tcp_dev_n)
 /**
  * Open TCP socket
  */
-struct pios_thread *tcpRxTaskHandle;
 int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 {
 	pios_tcp_dev *tcp_dev = PIOS_malloc(sizeof(pios_tcp_dev));
@@ -166,10 +641,13 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 	tcp_dev->rx_in_cb = NULL;
 	tcp_dev->tx_out_cb = NULL;
 	tcp_dev->cfg=cfg;
+
+	for (int i = 0; i < PIOS_TCP_MAX_CLIENTS; i++) {
+		tcp_dev->clients[i].fd = INVALID_SOCKET;
+	}
 	
 	/* assign socket */
 	tcp_dev->socket = socket(PF_INET6, SOCK_STREAM, IPPROTO_TCP);
-	tcp_dev->socket_connection = INVALID_SOCKET;
 
 #if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
 	char optval = 1;
@@ -187,7 +665,6 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
         setsockopt(tcp_dev->socket, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
 
 	memset(&tcp_dev->server, 0, sizeof(tcp_dev->server));
-	memset(&tcp_dev->client, 0, sizeof(tcp_dev->client));
 
 	tcp_dev->server.sin6_family = AF_INET6;
 	tcp_dev->server.sin6_addr = in6addr_any;
@@ -204,9 +681,40 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 		perror("Socket listen failed");
 		exit(EXIT_FAILURE);
 	}
+
+	tcp_set_nonblocking(tcp_dev->socket);
+
+#ifdef TCP_WINSOCK
+	tcp_dev->wake_rd = tcp_dev->wake_wr = INVALID_SOCKET;
+#else
+	int wake[2];
+
+	if (pipe(wake)) {
+		perror("Wake pipe failed");
+		exit(EXIT_FAILURE);
+	}
+
+	tcp_dev->wake_rd = wake[0];
+	tcp_dev->wake_wr = wake[1];
+
+	tcp_set_nonblocking(tcp_dev->wake_rd);
+	tcp_set_nonblocking(tcp_dev->wake_wr);
+#endif
+
+#ifdef TCP_EPOLL
+	tcp_dev->epoll_fd = epoll_create1(0);
+	if (tcp_dev->epoll_fd == -1) {
+		perror("epoll_create1 failed");
+		exit(EXIT_FAILURE);
+	}
+
+	tcp_watch(tcp_dev, EPOLL_CTL_ADD, tcp_dev->socket, TCP_SLOT_LISTEN, TCP_EV_READ);
+	tcp_watch(tcp_dev, EPOLL_CTL_ADD, tcp_dev->wake_rd, TCP_SLOT_WAKE, TCP_EV_READ);
+#endif
 	
-	tcpRxTaskHandle = PIOS_Thread_Create(
-			PIOS_TCP_RxTask, "pios_tcp_rx", PIOS_THREAD_STACK_SIZE_MIN, tcp_dev, PIOS_THREAD_PRIO_HIGHEST);
+	struct pios_thread *tcpIoTaskHandle = PIOS_Thread_Create(
+			PIOS_TCP_IoTask, "pios_tcp_io", PIOS_THREAD_STACK_SIZE_MIN, tcp_dev, PIOS_THREAD_PRIO_HIGHEST);
+	PIOS_Assert(tcpIoTaskHandle);
 	
 	printf("tcp dev %p - socket %i opened - result %i\n", tcp_dev, tcp_dev->socket, res);
 	
@@ -224,11 +732,16 @@ void PIOS_TCP_ChangeBaud(uintptr_t tcp_id, uint32_t baud)
 }
 
 
-static void PIOS_TCP_RxStart(uintptr_t tp_id, uint16_t rx_bytes_avail)
+static void PIOS_TCP_RxStart(uintptr_t tcp_id, uint16_t rx_bytes_avail)
 {
-	/**
-	 * lazy!
-	 */
+	pios_tcp_dev *tcp_dev = find_tcp_dev_by_id(tcp_id);
+
+	PIOS_Assert(tcp_dev);
+
+	/* Room has been made in the COM buffer.  Whether received data is
+	 * being held back is the I/O task's state, so let it check; wakeups
+	 * are coalesced, so this is cheap when nothing is held. */
+	tcp_wake(tcp_dev);
 }
 
 
@@ -237,31 +750,9 @@ static void PIOS_TCP_TxStart(uintptr_t tcp_id, uint16_t tx_bytes_avail)
 	pios_tcp_dev *tcp_dev = find_tcp_dev_by_id(tcp_id);
 	
 	PIOS_Assert(tcp_dev);
-	
-	int32_t length,rem;
-	
-	/**
-	 * we send everything directly whenever notified of data to send (lazy!)
-	 */
-	if (tcp_dev->tx_out_cb) {
-		while (tx_bytes_avail > 0) {
-			bool tx_need_yield = false;
-			length = (tcp_dev->tx_out_cb)(tcp_dev->tx_out_context, tcp_dev->tx_buffer, PIOS_TCP_RX_BUFFER_SIZE, NULL, &tx_need_yield);
-			rem = length;
-			while (rem > 0) {
-				ssize_t len = 0;
-				if (tcp_dev->socket_connection != INVALID_SOCKET) {
-					len = send(tcp_dev->socket_connection, (char *) tcp_dev->tx_buffer, length, 0);
-				}
-				if (len <= 0) {
-					rem = 0;
-				} else {
-					rem -= len;
-				}
-			}
-			tx_bytes_avail -= length;
-		}
-	}
+
+	/* The I/O task pulls from the COM buffer and does the sending */
+	tcp_wake(tcp_dev);
 }
 
 static void PIOS_TCP_RegisterRxCallback(uintptr_t tcp_id, pios_com_callback rx_in_cb, uintptr_t context)
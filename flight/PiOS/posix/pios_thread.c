@@ -26,20 +26,168 @@
 
 #include <pthread.h>
 #include <unistd.h>
+#include <time.h>
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+#include <sys/mman.h>
+#define THREAD_STACK_GUARD
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include <pios.h>
 #include <pios_thread.h>
+#include <pios_vtime.h>
+
+/*
+ * The host needs much more stack than the flight controller to run the
+ * same code (wider frames, a heavier libc), so threads get a multiple of
+ * what they ask for.  Stack usage is still reported against the
+ * requested size, so it stays comparable with the real targets.
+ */
+#define STACK_HOST_SCALE 8
+#define STACK_HOST_MIN (512 * 1024)
+#define STACK_PAINT 0xa5a5a5a5
 
 struct pios_thread
 {
 	pthread_t thread;
 
 	char *name;
+
+	void (*fp)(void *);
+	void *argp;
+	struct pios_vtime_thread *vt;	/* Only in virtual time mode */
+
+	struct pios_thread *next;	/* All threads, for the stats dump */
+	bool exited;
+
+	uint32_t *stack;		/* Lowest address of the stack */
+	size_t stack_len;
+	size_t stack_requested;
+	size_t stack_baseline;		/* Used before fp is entered */
+
+	int tid;
+
+	uint64_t runtime_last_us;	/* For PIOS_Thread_Get_Runtime */
+	uint64_t stats_last_us;		/* For the stats dump */
 };
 
+static pthread_mutex_t thread_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct pios_thread *thread_list;
+
+static __thread struct pios_thread *thread_self;
+
+static void thread_exited(void)
+{
+	struct pios_thread *thread = thread_self;
+
+	if (thread) {
+		thread->exited = true;
+	}
+
+	PIOS_VTIME_Thread_Exit();
+}
+
+static void *thread_main(void *arg)
+{
+	struct pios_thread *thread = arg;
+
+	thread_self = thread;
+
+#ifdef __linux__
+	thread->tid = syscall(SYS_gettid);
+#endif
+
+	/* libc keeps its thread control block at the top of the stack */
+	uintptr_t top = (uintptr_t) thread->stack + thread->stack_len;
+	thread->stack_baseline = top - (uintptr_t) __builtin_frame_address(0);
+
+	if (thread->vt) {
+		PIOS_VTIME_Thread_Start(thread->vt);
+	}
+
+	thread->fp(thread->argp);
+
+	thread_exited();
+
+	return NULL;
+}
+
+/**
+ * Allocate and paint a stack for a new thread, so its high water mark
+ * can be found later.  Where possible there's an inaccessible page below
+ * it so an overflow faults instead of corrupting the heap.
+ */
+static int32_t alloc_stack(struct pios_thread *thread, pthread_attr_t *attr,
+		size_t stack_bytes)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t len = stack_bytes * STACK_HOST_SCALE;
+
+	if (len < STACK_HOST_MIN) {
+		len = STACK_HOST_MIN;
+	}
+
+	len = (len + page - 1) & ~(page - 1);
+
+#ifdef THREAD_STACK_GUARD
+	uint8_t *base = mmap(NULL, len + page, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (base == MAP_FAILED) {
+		return -1;
+	}
+
+	mprotect(base, page, PROT_NONE);
+	base += page;
+#else
+	uint8_t *base = malloc(len);
+
+	if (!base) {
+		return -1;
+	}
+#endif
+
+	thread->stack = (uint32_t *) base;
+	thread->stack_len = len;
+	thread->stack_requested = stack_bytes;
+
+	for (size_t i = 0; i < len / sizeof(uint32_t); i++) {
+		thread->stack[i] = STACK_PAINT;
+	}
+
+	if (pthread_attr_setstack(attr, base, len)) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static void free_stack(struct pios_thread *thread)
+{
+	if (!thread->stack) {
+		return;
+	}
+
+#ifdef THREAD_STACK_GUARD
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	munmap((uint8_t *) thread->stack - page, thread->stack_len + page);
+#else
+	free(thread->stack);
+#endif
+}
+
 struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
 {
-	struct pios_thread *thread = malloc(sizeof(*thread));
+	struct pios_thread *thread = calloc(1, sizeof(*thread));
+
+	if (!thread) {
+		return NULL;
+	}
 
 	pthread_attr_t attr;
 
@@ -61,26 +209,57 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	}
 
 	thread->name = strdup(namep);
+	thread->fp = fp;
+	thread->argp = argp;
+
+	if (alloc_stack(thread, &attr, stack_bytes)) {
+		printf("Couldn't allocate stack for thr (%s)\n", namep);
+		goto fail;
+	}
 
-	void *(*thr_func)(void *) = (void *) fp;
+	if (PIOS_VTIME_Enabled()) {
+		thread->vt = PIOS_VTIME_Thread_Add(prio);
+
+		if (!thread->vt) {
+			goto fail;
+		}
+	}
 
-	int ret = pthread_create(&thread->thread, &attr, thr_func, argp);
+	int ret = pthread_create(&thread->thread, &attr, thread_main, thread);
 
 	if (ret) {
 		printf("Couldn't start thr (%s) ret=%d\n", namep, ret);
-
-		free(thread->name);
-		free(thread);
-		return NULL;
+		goto fail;
 	}
 
+	pthread_attr_destroy(&attr);
+
 #ifdef __linux__
 	pthread_setname_np(thread->thread, thread->name);
 #endif
 
 	printf("Started thread (%s) p=%p\n", namep, &thread->thread);
 
+	pthread_mutex_lock(&thread_list_lock);
+	thread->next = thread_list;
+	thread_list = thread;
+	pthread_mutex_unlock(&thread_list_lock);
+
+	if (thread->vt) {
+		PIOS_VTIME_Thread_Added(thread->vt);
+	}
+
 	return thread;
+
+fail:
+	pthread_attr_destroy(&attr);
+
+	free(thread->vt);
+	free_stack(thread);
+	free(thread->name);
+	free(thread);
+
+	return NULL;
 }
 
 void PIOS_Thread_Delete(struct pios_thread *threadp)
@@ -89,17 +268,19 @@ void PIOS_Thread_Delete(struct pios_thread *threadp)
 		abort();	// Only support this on "self"
 	}
 
-#if 0
-	/* Need to figure out our own thread structure to clean it up */
-	free(threadp->name);
-	free(threadp);
-#endif
+	/* The structure and stack stay around; the task monitor may still
+	 * hold a handle. */
+	thread_exited();
 
 	pthread_exit(0);
 }
 
 uint32_t PIOS_Thread_Systime(void)
 {
+	if (PIOS_VTIME_Enabled()) {
+		return PIOS_VTIME_Now_us() / 1000;
+	}
+
 	struct timespec monotime;
 
 	clock_gettime(CLOCK_MONOTONIC, &monotime);
@@ -117,6 +298,11 @@ uint32_t PIOS_Thread_Systime(void)
 
 void PIOS_Thread_Sleep(uint32_t time_ms)
 {
+	if (PIOS_VTIME_Enabled()) {
+		PIOS_VTIME_Wait(NULL, PIOS_VTIME_Deadline(time_ms));
+		return;
+	}
+
 	if (time_ms == PIOS_THREAD_TIMEOUT_MAX) {
 		while (true) {
 			usleep(50000000); /* 50s */
@@ -142,14 +328,208 @@ void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
 	}
 }
 
+/* Deepest the thread has been into its stack, less what libc uses */
+static size_t stack_high_water(struct pios_thread *threadp)
+{
+	const uint32_t *pos = threadp->stack;
+	const uint32_t *end = threadp->stack +
+		threadp->stack_len / sizeof(uint32_t);
+
+	while ((pos < end) && (*pos == STACK_PAINT)) {
+		pos++;
+	}
+
+	size_t used = (end - pos) * sizeof(uint32_t);
+
+	if (used < threadp->stack_baseline) {
+		return 0;
+	}
+
+	return used - threadp->stack_baseline;
+}
+
+/**
+ * Get the stack space a thread has never used, relative to the size it
+ * asked for at creation.
+ * \param[in] threadp The thread
+ * \return Bytes of requested stack that remain unused; 0 if exceeded
+ */
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 {
-	return 0;	/* XXX */
+	size_t used = stack_high_water(threadp);
+
+	if (used >= threadp->stack_requested) {
+		return 0;
+	}
+
+	return threadp->stack_requested - used;
+}
+
+/* Total CPU time the thread has consumed, in us */
+static uint64_t thread_cpu_us(struct pios_thread *threadp)
+{
+#ifdef __linux__
+	clockid_t cid;
+	struct timespec ts;
+
+	if (threadp->exited ||
+			pthread_getcpuclockid(threadp->thread, &cid) ||
+			clock_gettime(cid, &ts)) {
+		return threadp->runtime_last_us;
+	}
+
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+	return 0;
+#endif
 }
 
+/**
+ * Get the CPU time a thread has used since the last call.
+ * \param[in] threadp The thread
+ * \return CPU time in us
+ */
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 {
-	return 0;	/* XXX */
+	uint64_t now = thread_cpu_us(threadp);
+	uint32_t delta = now - threadp->runtime_last_us;
+
+	threadp->runtime_last_us = now;
+
+	return delta;
+}
+
+/* Voluntary and involuntary context switches of a thread so far */
+static void thread_ctx_switches(struct pios_thread *threadp,
+		unsigned long *voluntary, unsigned long *involuntary)
+{
+	*voluntary = 0;
+	*involuntary = 0;
+
+#ifdef __linux__
+	char path[64];
+
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status",
+			threadp->tid);
+
+	FILE *f = fopen(path, "r");
+
+	if (!f) {
+		return;
+	}
+
+	char line[128];
+
+	while (fgets(line, sizeof(line), f)) {
+		sscanf(line, "voluntary_ctxt_switches: %lu", voluntary);
+		sscanf(line, "nonvoluntary_ctxt_switches: %lu", involuntary);
+	}
+
+	fclose(f);
+#endif
+}
+
+static FILE *stats_file;
+static bool stats_json;
+static uint32_t stats_period_ms;
+
+static void write_stats(uint32_t now_ms, uint32_t interval_ms)
+{
+	pthread_mutex_lock(&thread_list_lock);
+
+	for (struct pios_thread *t = thread_list; t; t = t->next) {
+		if (t->exited) {
+			continue;
+		}
+
+		uint64_t cpu_us = thread_cpu_us(t);
+		uint32_t delta_us = cpu_us - t->stats_last_us;
+		t->stats_last_us = cpu_us;
+
+		float cpu_pct = interval_ms ?
+			delta_us / (interval_ms * 10.0f) : 0;
+
+		unsigned long vol, invol;
+		thread_ctx_switches(t, &vol, &invol);
+
+		if (stats_json) {
+			fprintf(stats_file, "{\"time_ms\":%u,\"thread\":\"%s\","
+					"\"cpu_us\":%u,\"cpu_pct\":%.2f,"
+					"\"stack_requested\":%zu,"
+					"\"stack_used\":%zu,"
+					"\"ctxsw_voluntary\":%lu,"
+					"\"ctxsw_involuntary\":%lu}\n",
+					now_ms, t->name, delta_us, cpu_pct,
+					t->stack_requested,
+					stack_high_water(t), vol, invol);
+		} else {
+			fprintf(stats_file, "%u,%s,%u,%.2f,%zu,%zu,%lu,%lu\n",
+					now_ms, t->name, delta_us, cpu_pct,
+					t->stack_requested,
+					stack_high_water(t), vol, invol);
+		}
+	}
+
+	pthread_mutex_unlock(&thread_list_lock);
+
+	fflush(stats_file);
+}
+
+static void stats_task(void *unused)
+{
+	(void) unused;
+
+	if (!stats_json) {
+		fprintf(stats_file, "time_ms,thread,cpu_us,cpu_pct,"
+				"stack_requested,stack_used,"
+				"ctxsw_voluntary,ctxsw_involuntary\n");
+	}
+
+	uint32_t last = PIOS_Thread_Systime();
+	uint32_t tm = last;
+
+	while (true) {
+		PIOS_Thread_Sleep_Until(&tm, stats_period_ms);
+
+		uint32_t now = PIOS_Thread_Systime();
+
+		write_stats(now, now - last);
+
+		last = now;
+	}
+}
+
+/**
+ * Periodically write per-thread CPU, stack and context switch figures to
+ * a file; JSON lines if the name ends in .json, otherwise CSV.  CPU
+ * percentages are relative to PIOS_Thread_Systime, so in virtual time
+ * mode they give host CPU per simulated second.
+ * \param[in] path File to write
+ * \param[in] period_ms Interval between samples
+ * \return 0 on success, -1 on failure
+ */
+int32_t PIOS_Thread_Stats_Start(const char *path, uint32_t period_ms)
+{
+	stats_file = fopen(path, "w");
+
+	if (!stats_file) {
+		return -1;
+	}
+
+	size_t len = strlen(path);
+
+	stats_json = (len > 5) && !strcmp(path + len - 5, ".json");
+	stats_period_ms = period_ms;
+
+	if (!PIOS_Thread_Create(stats_task, "threadstats",
+				PIOS_THREAD_STACK_SIZE_MIN, NULL,
+				PIOS_THREAD_PRIO_LOW)) {
+		fclose(stats_file);
+		stats_file = NULL;
+		return -1;
+	}
+
+	return 0;
 }
 
 /**
@@ -0,0 +1,401 @@
+/**
+ ******************************************************************************
+ * @file       pios_vtime.c
+ * @author     dRonin, http://dRonin.org, Copyright (C) 2017
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_VTIME Virtual time lockstep scheduler
+ * @{
+ * @brief Runs the posix simulator on a simulated clock
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <pios.h>
+#include <pios_thread.h>
+#include <pios_vtime.h>
+
+enum vtime_state {
+	VT_READY,
+	VT_RUNNING,
+	VT_BLOCKED,
+	VT_OUTSIDE,	/* Blocked in the host OS */
+};
+
+struct pios_vtime_thread {
+	struct pios_vtime_thread *next;
+
+	pthread_cond_t cond;
+
+	uint64_t ready_seq;	/* FIFO order among equal priorities */
+	uint64_t deadline;
+	const void *chan;
+
+	uint8_t prio;
+	uint8_t state;
+	bool timed_out;
+};
+
+static bool vt_enabled;
+
+/* Protects everything below.  Only held for scheduler bookkeeping; the
+ * thread that owns the CPU runs without it. */
+static pthread_mutex_t vt_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct pios_vtime_thread *vt_threads;	/* In creation order */
+static struct pios_vtime_thread *vt_running;
+static uint64_t vt_now;
+static uint64_t vt_seq;
+
+static __thread struct pios_vtime_thread *vt_self;
+
+/**
+ * Switch on virtual time.  Must be called before the first thread is
+ * created.
+ */
+void PIOS_VTIME_Enable(void)
+{
+	PIOS_Assert(!vt_threads);
+
+	vt_now = 0;
+	vt_seq = 0;
+	vt_enabled = true;
+}
+
+bool PIOS_VTIME_Enabled(void)
+{
+	return vt_enabled;
+}
+
+uint64_t PIOS_VTIME_Now_us(void)
+{
+	pthread_mutex_lock(&vt_lock);
+	uint64_t now = vt_now;
+	pthread_mutex_unlock(&vt_lock);
+
+	return now;
+}
+
+static void make_ready(struct pios_vtime_thread *t)
+{
+	t->state = VT_READY;
+	t->chan = NULL;
+	t->ready_seq = vt_seq++;
+}
+
+/**
+ * Hand the CPU to the next thread.  The caller must already have moved
+ * itself out of VT_RUNNING.  If nothing is ready, the clock advances to
+ * the earliest timeout.  Called with vt_lock held.
+ */
+static void vtime_schedule(void)
+{
+	while (true) {
+		struct pios_vtime_thread *best = NULL;
+		uint64_t next_deadline = UINT64_MAX;
+
+		for (struct pios_vtime_thread *t = vt_threads; t; t = t->next) {
+			if (t->state == VT_READY) {
+				if (!best || (t->prio > best->prio) ||
+						((t->prio == best->prio) &&
+						 (t->ready_seq < best->ready_seq))) {
+					best = t;
+				}
+			} else if ((t->state == VT_BLOCKED) &&
+					(t->deadline < next_deadline)) {
+				next_deadline = t->deadline;
+			}
+		}
+
+		if (best) {
+			best->state = VT_RUNNING;
+			vt_running = best;
+			pthread_cond_signal(&best->cond);
+			return;
+		}
+
+		vt_running = NULL;
+
+		if (next_deadline == UINT64_MAX) {
+			/* Idle until something outside wakes a thread. */
+			return;
+		}
+
+		if (next_deadline > vt_now) {
+			vt_now = next_deadline;
+		}
+
+		for (struct pios_vtime_thread *t = vt_threads; t; t = t->next) {
+			if ((t->state == VT_BLOCKED) && (t->deadline <= vt_now)) {
+				t->timed_out = true;
+				make_ready(t);
+			}
+		}
+	}
+}
+
+/* Called with vt_lock held */
+static void wait_turn(struct pios_vtime_thread *self)
+{
+	while (vt_running != self) {
+		pthread_cond_wait(&self->cond, &vt_lock);
+	}
+}
+
+/* Called with vt_lock held, by the running thread */
+static void yield(struct pios_vtime_thread *self)
+{
+	make_ready(self);
+	vtime_schedule();
+	wait_turn(self);
+}
+
+/**
+ * Allocate scheduler state for a thread about to be created.
+ * \param[in] prio Thread priority; higher runs first
+ * \return The thread state, or NULL on failure
+ */
+struct pios_vtime_thread *PIOS_VTIME_Thread_Add(uint8_t prio)
+{
+	struct pios_vtime_thread *vt = calloc(1, sizeof(*vt));
+
+	if (!vt) {
+		return NULL;
+	}
+
+	if (pthread_cond_init(&vt->cond, NULL)) {
+		free(vt);
+		return NULL;
+	}
+
+	vt->prio = prio;
+
+	return vt;
+}
+
+/**
+ * Make a newly created thread runnable.  Called by the creator once the
+ * host thread exists; yields if the new thread has higher priority.
+ */
+void PIOS_VTIME_Thread_Added(struct pios_vtime_thread *vt)
+{
+	pthread_mutex_lock(&vt_lock);
+
+	struct pios_vtime_thread **tail = &vt_threads;
+
+	while (*tail) {
+		tail = &(*tail)->next;
+	}
+
+	*tail = vt;
+
+	make_ready(vt);
+
+	if (!vt_running) {
+		vtime_schedule();
+	} else if (vt_self && (vt_running == vt_self) &&
+			(vt->prio > vt_self->prio)) {
+		yield(vt_self);
+	}
+
+	pthread_mutex_unlock(&vt_lock);
+}
+
+/**
+ * First thing a new thread does; waits until it is scheduled.
+ */
+void PIOS_VTIME_Thread_Start(struct pios_vtime_thread *vt)
+{
+	vt_self = vt;
+
+	pthread_mutex_lock(&vt_lock);
+	wait_turn(vt);
+	pthread_mutex_unlock(&vt_lock);
+}
+
+/**
+ * Remove the calling thread from the schedule.  It must not use any PIOS
+ * primitive afterwards.
+ */
+void PIOS_VTIME_Thread_Exit(void)
+{
+	struct pios_vtime_thread *self = vt_self;
+
+	if (!self) {
+		return;
+	}
+
+	pthread_mutex_lock(&vt_lock);
+
+	struct pios_vtime_thread **pos = &vt_threads;
+
+	while (*pos != self) {
+		pos = &(*pos)->next;
+	}
+
+	*pos = self->next;
+
+	vtime_schedule();
+
+	pthread_mutex_unlock(&vt_lock);
+
+	pthread_cond_destroy(&self->cond);
+	free(self);
+
+	vt_self = NULL;
+}
+
+/**
+ * Convert a PIOS timeout into an absolute virtual time.
+ * \param[in] timeout_ms Timeout; 0xffffffff waits forever
+ * \return Deadline in us
+ */
+uint64_t PIOS_VTIME_Deadline(uint32_t timeout_ms)
+{
+	if (timeout_ms == PIOS_THREAD_TIMEOUT_MAX) {
+		return UINT64_MAX;
+	}
+
+	return PIOS_VTIME_Now_us() + timeout_ms * 1000ULL;
+}
+
+/**
+ * Block the calling thread until PIOS_VTIME_Wake is called on chan or
+ * the deadline passes.  Callers recheck their condition after a wake.
+ * \param[in] chan What to wait for, or NULL to only wait for the deadline
+ * \param[in] deadline_us Absolute deadline, UINT64_MAX for none
+ * \return false if the deadline passed, true if woken
+ */
+bool PIOS_VTIME_Wait(const void *chan, uint64_t deadline_us)
+{
+	struct pios_vtime_thread *self = vt_self;
+
+	if (!self) {
+		/* Only main() gets here, parking itself forever */
+		PIOS_Assert(deadline_us == UINT64_MAX);
+
+		while (true) {
+			pause();
+		}
+	}
+
+	pthread_mutex_lock(&vt_lock);
+
+	if (deadline_us <= vt_now) {
+		pthread_mutex_unlock(&vt_lock);
+		return false;
+	}
+
+	self->state = VT_BLOCKED;
+	self->chan = chan;
+	self->deadline = deadline_us;
+	self->timed_out = false;
+
+	vtime_schedule();
+	wait_turn(self);
+
+	bool woken = !self->timed_out;
+
+	pthread_mutex_unlock(&vt_lock);
+
+	return woken;
+}
+
+/**
+ * Make every thread waiting on chan runnable.  If one of them has higher
+ * priority than the caller it runs immediately.
+ */
+void PIOS_VTIME_Wake(const void *chan)
+{
+	struct pios_vtime_thread *self = vt_self;
+	bool preempt = false;
+
+	pthread_mutex_lock(&vt_lock);
+
+	for (struct pios_vtime_thread *t = vt_threads; t; t = t->next) {
+		if ((t->state == VT_BLOCKED) && (t->chan == chan)) {
+			make_ready(t);
+
+			if (self && (t->prio > self->prio)) {
+				preempt = true;
+			}
+		}
+	}
+
+	if (!vt_running) {
+		vtime_schedule();
+	} else if (preempt && (vt_running == self)) {
+		yield(self);
+	}
+
+	pthread_mutex_unlock(&vt_lock);
+}
+
+void PIOS_VTIME_Sleep_us(uint64_t us)
+{
+	PIOS_VTIME_Wait(NULL, PIOS_VTIME_Now_us() + us);
+}
+
+/**
+ * Give up the CPU around a call that blocks in the host OS.
+ */
+void PIOS_VTIME_Blocking_Begin(void)
+{
+	struct pios_vtime_thread *self = vt_self;
+
+	if (!self) {
+		return;
+	}
+
+	pthread_mutex_lock(&vt_lock);
+
+	self->state = VT_OUTSIDE;
+	vtime_schedule();
+
+	pthread_mutex_unlock(&vt_lock);
+}
+
+/**
+ * Wait to get the CPU back after PIOS_VTIME_Blocking_Begin.
+ */
+void PIOS_VTIME_Blocking_End(void)
+{
+	struct pios_vtime_thread *self = vt_self;
+
+	if (!self) {
+		return;
+	}
+
+	pthread_mutex_lock(&vt_lock);
+
+	make_ready(self);
+
+	if (!vt_running) {
+		vtime_schedule();
+	}
+
+	wait_turn(self);
+
+	pthread_mutex_unlock(&vt_lock);
+}
+
+/**
+  * @}
+  * @}
+  */
@@ -118,13 +118,19 @@ typedef struct {
 	UAVObjHandle obj;
 	uint16_t instId;
 	UAVObjEventType event;
+	uint32_t timestamp; /**< PIOS_DELAY_GetRaw() when the event was fired */
+	uint32_t origin; /**< PIOS_DELAY_GetRaw() of the sample the update
+			  * derives from (see UAVObjSetDataTraced), else the
+			  * same as timestamp */
 } UAVObjEvent;
 
 
 /**
  * Event callback, this function is called when an event is invoked. The function
  * will be executed in the event task. The ev parameter should be copied if needed
- * after the function returns.
+ * after the function returns.  Callbacks don't run under the data lock, so
+ * uavo_data may change while they look at it; use the object's Get function
+ * for a consistent copy.
  */
 typedef void (*UAVObjEventCallback)(UAVObjEvent* ev, void* cb_ctx,
 	void *uavo_data, int uavo_len);
@@ -142,8 +148,17 @@ typedef struct {
 	uint32_t eventCallbackErrors;
 	uint32_t lastCallbackErrorID;
 	uint32_t lastQueueErrorID;
+	uint32_t eventRingDrops; /**< Events lost on full event rings (also counted in eventQueueErrors) */
+	uint32_t eventRingCoalesced; /**< Events merged into one already pending on an event ring */
 } UAVObjStats;
 
+/**
+ * Lock-free single-consumer event ring, an alternative to connecting a
+ * pios_queue.  Repeated events for an object instance that the consumer
+ * has not picked up yet are coalesced instead of filling the ring.
+ */
+struct UAVObjEventRing;
+
 typedef void (*new_uavo_instance_cb_t)(uint32_t,uint32_t);
 void UAVObjRegisterNewInstanceCB(new_uavo_instance_cb_t callback);
 
@@ -178,6 +193,7 @@ int32_t UAVObjLoadMetaobjects();
 int32_t UAVObjDeleteMetaobjects();
 int32_t UAVObjSetData(UAVObjHandle obj_handle, const void* dataIn);
 int32_t UAVObjSetDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjSetDataTraced(UAVObjHandle obj_handle, const void* dataIn, uint32_t origin);
 int32_t UAVObjGetData(UAVObjHandle obj_handle, void* dataOut);
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
@@ -206,6 +222,10 @@ int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle, struct pios_queue *
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask);
 int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask, uint16_t interval);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, void *cbCtx);
+struct UAVObjEventRing *UAVObjEventRingCreate(uint16_t length);
+bool UAVObjEventRingReceive(struct UAVObjEventRing *ring, UAVObjEvent *ev, uint32_t timeout_ms);
+int32_t UAVObjConnectRing(UAVObjHandle obj_handle, struct UAVObjEventRing *ring, uint8_t eventMask);
+int32_t UAVObjDisconnectRing(UAVObjHandle obj_handle, struct UAVObjEventRing *ring);
 void UAVObjUpdated(UAVObjHandle obj);
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId);
 void UAVObjIterate(void (*iterator)(UAVObjHandle obj));
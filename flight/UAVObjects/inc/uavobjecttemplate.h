@@ -69,6 +69,8 @@ static inline int32_t $(NAME)Get($(NAME)Data *dataOut) { return UAVObjGetData($(
 
 static inline int32_t $(NAME)Set(const $(NAME)Data *dataIn) { return UAVObjSetData($(NAME)Handle(), dataIn); }
 
+static inline int32_t $(NAME)SetTraced(const $(NAME)Data *dataIn, uint32_t origin) { return UAVObjSetDataTraced($(NAME)Handle(), dataIn, origin); }
+
 static inline int32_t $(NAME)InstGet(uint16_t instId, $(NAME)Data *dataOut) { return UAVObjGetInstanceData($(NAME)Handle(), instId, dataOut); }
 
 static inline int32_t $(NAME)InstSet(uint16_t instId, const $(NAME)Data *dataIn) { return UAVObjSetInstanceData($(NAME)Handle(), instId, dataIn); }
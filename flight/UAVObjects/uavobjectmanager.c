@@ -40,6 +40,8 @@
 #include "pios_heap.h"		/* PIOS_malloc_no_dma */
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "pios_semaphore.h"
+#include "circqueue.h"
 #include "misc_math.h"
 
 extern uintptr_t pios_uavo_settings_fs_id;
@@ -61,12 +63,14 @@ typedef void* InstanceHandle;
 struct ObjectEventEntry {
 	union {
 		struct pios_queue         *queue;
+		struct UAVObjEventRing    *ring;
 		void                      *cbCtx;
 	} cbInfo;
 
 	UAVObjEventCallback       cb;
 	uint8_t                   hasThrottle : 1;
-	uint8_t                   eventMask : 7;
+	uint8_t                   isRing : 1;
+	uint8_t                   eventMask : 6;
 	struct ObjectEventEntry * next;
 };
 
@@ -77,14 +81,43 @@ struct ObjectEventEntryThrottled {
 	uint16_t                  interval;
 };
 
+struct ObjectEventEntryRing {
+	struct ObjectEventEntry   entry; // MUST be first! So ring entry can be interpreted as ObjectEventEntry
+
+	/* Set by the producer when an event for this connection is put
+	 * on the ring, cleared by the consumer when it takes that same
+	 * event off: the last one pushed, as numbered by pushed. */
+	volatile uint8_t          pending;
+	uint8_t                   pendingEvent;
+	uint16_t                  pendingInst;
+	volatile uint16_t         pushed;
+};
+
+/*
+ * Event rings are single producer, single consumer.  The producer side is
+ * always pumpOneEvent, which is serialized by the events mutex; the
+ * consumer is the one task calling UAVObjEventRingReceive.
+ */
+struct UAVObjEventRing {
+	circ_queue_t              queue;
+	struct pios_semaphore    *wake;
+	volatile bool             waiting;
+};
+
+struct UAVObjEventRingElem {
+	UAVObjEvent                   ev;
+	struct ObjectEventEntryRing * entry;
+	uint16_t                      seq;
+};
+
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-                                                  \-->[InstanceData1 [next]]
-                                                  _________...________/
-                                                  \-->[InstanceDataN [next]]
+  MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstTable [InstanceData0]]]]
+                                                        |
+                                                        \-->[ptr1 ... ptrN]
+                                                               |       \-->[InstanceDataN]
+                                                               \-->[InstanceData1]
  */
 
 /*
@@ -96,6 +129,14 @@ struct UAVOBase {
 	/* Let these objects be added to an event queue */
 	struct ObjectEventEntry * next_event;
 
+	/*
+	 * Sequence counter guarding the instance data for lockless reads.
+	 * Odd while a writer is modifying the data.  Kept at an even offset
+	 * (and the header at 8 bytes) so it stays naturally aligned in both
+	 * data objects and their embedded meta objects.
+	 */
+	volatile uint16_t seq;
+
 	/* Describe the type of object that follows this header */
 	struct UAVOInfo {
 		bool isMeta        : 1;
@@ -103,6 +144,7 @@ struct UAVOBase {
 		bool isSettings    : 1;
 	} flags;
 
+	uint8_t           pad;
 } __attribute__((packed));
 
 /* Augmented type for Meta UAVO */
@@ -121,6 +163,7 @@ struct UAVOData {
 	 */
 	struct UAVOMeta   metaObj;
 	struct UAVOData * next;
+	struct UAVOData * hash_next;
 	uint16_t          instance_size;
 } __attribute__((packed));
 
@@ -135,22 +178,21 @@ struct UAVOSingle {
 	 */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
-struct UAVOMultiInst {
-	struct UAVOMultiInst * next;
-	uint8_t                instance[];
-	/* 
-	 * Additional space will be malloc'd here to hold the
-	 * the data for this instance.
-	 */
-} __attribute__((packed));
-
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
-	struct UAVOMultiInst   instance0;
+
+	/*
+	 * Instances other than the first are allocated separately.
+	 * inst_table[n-1] holds the data pointer for instance n, so
+	 * looking up an instance is a single index.
+	 */
+	uint16_t               inst_table_len;
+	uint8_t             ** inst_table;
+
+	uint8_t                instance0[];
 	/*
 	 * Additional space will be malloc'd here to hold the
 	 * the data for instance 0.
@@ -170,25 +212,70 @@ struct UAVOMulti {
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
-#define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/*
+ * Instance data is protected by a per-object seqlock.  Writers are still
+ * serialized by the object manager mutex; they bump the sequence counter
+ * around the copy into the object, and only dispatch events after the
+ * counter is even again.  Readers copy the data without taking any lock
+ * and retry if the counter moved underneath them.  A reader never spins
+ * waiting on a writer (on a single core the writer may be a lower priority
+ * task); after a few failed attempts it falls back to taking the mutex.
+ */
+#define UAVO_SEQ_READ_TRIES 3
+#define UAVO_BARRIER() __sync_synchronize()
+
+#define INSTANCE_COPY_ALL 0xffffffff
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
-			UAVObjEventType event, void *obj_data, int len);
+			UAVObjEventType event, void *obj_data, int len,
+			const uint32_t *origin);
+static int32_t setInstanceData(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn, uint32_t offset, uint32_t size,
+			const uint32_t *origin);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static int32_t readInstanceField(struct UAVOBase *obj, uint16_t instId,
+			void *dataOut, uint32_t offset, uint32_t size);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
+			UAVObjEventCallback cb, void *cbCtx,
+			struct UAVObjEventRing *ring, uint8_t eventMask,
 			uint16_t interval);
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, void *cbCtx);
+			UAVObjEventCallback cb, void *cbCtx,
+			struct UAVObjEventRing *ring);
+
+/*
+ * Objects are also chained into a small hash table keyed on object ID, so
+ * that UAVObjGetByID (on the path of every received UAVTalk packet) does
+ * not walk the whole object list.  Data object IDs always have the low bit
+ * clear and the metaobject uses ID+1, so both hash to the same bucket.
+ */
+#define UAVO_HASH_BUCKETS 64
+#define UAVO_HASH(id) (((id) >> 1) & (UAVO_HASH_BUCKETS - 1))
+
+/* Instance tables grow by doubling from this size */
+#define UAVO_INST_TABLE_MIN 4
 
 // Private variables
 static struct UAVOData * uavo_list;
+static struct UAVOData * uavo_hash[UAVO_HASH_BUCKETS];
+static uint8_t uavo_count;
 static struct ObjectEventEntry * events_unused;
 static struct ObjectEventEntry * events_unused_throttled;
+static struct ObjectEventEntry * events_unused_ring;
+/*
+ * mutex serializes writers of object data and guards the object list;
+ * readers only fall back to it under contention.  events_mutex guards
+ * the event connections and serializes dispatch, which needs it anyway
+ * for the shared callback stack.  Events are sent after the data mutex
+ * is released, so callbacks don't hold up readers or other writers'
+ * data.  Where both are needed, events_mutex is taken first.
+ */
 static struct pios_recursive_mutex *mutex;
+static struct pios_recursive_mutex *events_mutex;
 static const UAVObjMetadata defMetadata = {
 	.flags = (ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT |
 		ACCESS_READWRITE << UAVOBJ_GCS_ACCESS_SHIFT |
@@ -208,6 +295,40 @@ static new_uavo_instance_cb_t newUavObjInstanceCB;
 
 static void *cb_stack;
 
+/**
+ * Open the write side of an object's seqlock.  Must hold the mutex.
+ */
+static inline void seqWriteBegin(struct UAVOBase *obj)
+{
+	obj->seq++;
+	UAVO_BARRIER();
+}
+
+/**
+ * Close the write side of an object's seqlock.  Must hold the mutex.
+ */
+static inline void seqWriteEnd(struct UAVOBase *obj)
+{
+	UAVO_BARRIER();
+	obj->seq++;
+}
+
+/**
+ * Take both locks, for work that sends events while it needs the object
+ * list or data to hold still.
+ */
+static void lockWithEvents(void)
+{
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+}
+
+static void unlockWithEvents(void)
+{
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
+}
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -217,8 +338,11 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	memset(uavo_hash, 0, sizeof(uavo_hash));
+	uavo_count = 0;
 	events_unused = NULL;
 	events_unused_throttled = NULL;
+	events_unused_ring = NULL;
 
 	// Allocate the stack used for callbacks.
 	cb_stack = PIOS_malloc_no_dma(UAVO_CB_STACK_SIZE);
@@ -230,10 +354,15 @@ int32_t UAVObjInitialize()
 
 	memset(&stats, 0, sizeof(UAVObjStats));
 
-	// Create mutex
+	// Create mutexes
 	mutex = PIOS_Recursive_Mutex_Create();
 	if (mutex == NULL)
 		return -1;
+
+	events_mutex = PIOS_Recursive_Mutex_Create();
+	if (events_mutex == NULL)
+		return -1;
+
 	// Done
 	return 0;
 }
@@ -248,9 +377,9 @@ int32_t UAVObjInitialize()
  */
 void UAVObjGetStats(UAVObjStats * statsOut)
 {
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	memcpy(statsOut, &stats, sizeof(UAVObjStats));
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 }
 
 /**
@@ -258,9 +387,9 @@ void UAVObjGetStats(UAVObjStats * statsOut)
  */
 void UAVObjClearStats()
 {
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	memset(&stats, 0, sizeof(UAVObjStats));
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 }
 
 /************************
@@ -322,9 +451,11 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
 
+	uavo_multi->inst_table_len = 0;
+	uavo_multi->inst_table = NULL;
+
 	/* Clear the instance data carried in the UAVO */
-	uavo_multi->instance0.next = NULL;
-	memset (&(uavo_multi->instance0.instance), 0, num_bytes);
+	memset (&(uavo_multi->instance0), 0, num_bytes);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_multi->uavo));
@@ -351,7 +482,7 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 {
 	struct UAVOData * uavo_data = NULL;
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockWithEvents();
 
 	/* Don't allow duplicate registrations */
 	if (UAVObjGetByID(id))
@@ -379,6 +510,12 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 
 	/* Add the newly created object to the global list of objects */
 	LL_APPEND(uavo_list, uavo_data);
+	uavo_count++;
+
+	/* And make it visible to lookups, fully formed */
+	uavo_data->hash_next = uavo_hash[UAVO_HASH(id)];
+	UAVO_BARRIER();
+	uavo_hash[UAVO_HASH(id)] = uavo_data;
 
 	/* Initialize object fields and metadata to default values */
 	if (initCb)
@@ -396,7 +533,7 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	unlockWithEvents();
 	return (UAVObjHandle) uavo_data;
 }
 
@@ -407,27 +544,20 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle found_obj = NULL;
-
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Look for object
+	/* Objects are never unregistered and are published to the hash
+	 * table fully initialized, so this needs no lock. */
 	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
+	for (tmp_obj = uavo_hash[UAVO_HASH(id)]; tmp_obj;
+			tmp_obj = tmp_obj->hash_next) {
 		if (tmp_obj->id == id) {
-			found_obj = &tmp_obj->base;
-			goto unlock_exit;
+			return &tmp_obj->base;
 		}
 		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = &(tmp_obj->metaObj.base);
-			goto unlock_exit;
+			return &(tmp_obj->metaObj.base);
 		}
 	}
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return found_obj;
+	return NULL;
 }
 
 /**
@@ -541,7 +671,7 @@ uint16_t UAVObjCreateInstance(UAVObjHandle obj_handle, UAVObjInitializeCallback
 	}
 
 	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockWithEvents();
 
 	InstanceHandle instEntry;
 	uint16_t instId = 0;
@@ -559,7 +689,7 @@ uint16_t UAVObjCreateInstance(UAVObjHandle obj_handle, UAVObjInitializeCallback
 	}
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	unlockWithEvents();
 
 	return instId;
 }
@@ -618,22 +748,16 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
 	void *target;
 	int len;
 
 	if (UAVObjIsMetaobject(obj_handle)) {
 		if (instId != 0) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		target = MetaDataPtr((struct UAVOMeta *)obj_handle);
 		len = MetaNumBytes;
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
 	} else {
 		struct UAVOData *obj;
 		InstanceHandle instEntry;
@@ -646,28 +770,39 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 
 		// If the instance does not exist create it and any other instances before it
 		if (instEntry == NULL) {
-			instEntry = createInstance(obj, instId);
+			/* Creation announces the new instances */
+			lockWithEvents();
+
+			instEntry = getInstance(obj, instId);
 			if (instEntry == NULL) {
-				goto unlock_exit;
+				instEntry = createInstance(obj, instId);
+			}
+
+			unlockWithEvents();
+
+			if (instEntry == NULL) {
+				return -1;
 			}
 		}
-		// Set the data
 
 		target = InstanceData(instEntry);
 		len = obj->instance_size;
 	}
 
+	// Set the data
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	seqWriteBegin(obj_handle);
 	memcpy(target, dataIn, len);
+	seqWriteEnd(obj_handle);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED,
-		target, len);
+		target, len, NULL);
 
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return 0;
 }
 
 /**
@@ -681,37 +816,8 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
-
-		// Cast handle to object
-		obj = (struct UAVOData *) obj_handle;
-
-		// Get the instance
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Pack data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
-	}
-
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return readInstanceField(obj_handle, instId, dataOut, 0,
+			INSTANCE_COPY_ALL);
 }
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
@@ -800,15 +906,14 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 	return 0;
 }
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
 /**
  * Trampoline buffer used for loads from the underlying filesystem.
  * This is required on platforms that store the UAVO data in non-DMA
  * RAM regions since the underlying flash driver may use DMA to transfer
- * the data into the buffer that we give it.
+ * the data into the buffer that we give it.  Everywhere else it lets the
+ * slow flash read happen without holding the lock or the seqlock open.
  */
 static uint8_t uavobj_load_trampoline[256] __attribute__((aligned(4)));
-#endif	/* PIOS_INCLUDE_FASTHEAP */
 
 /**
  * Load an object from the file system (SD card).
@@ -842,30 +947,31 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 		len = UAVObjGetNumBytes(obj_handle);
 	}
 
+	if (len > sizeof(uavobj_load_trampoline))
+		return -1;
+
 	// Load the object from the filesystem
 	int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
 	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
 			UAVObjGetID(obj_handle),
 			instId,
 			uavobj_load_trampoline,
 			len);
-#else  /* PIOS_INCLUDE_FASTHEAP */
-	rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
-			UAVObjGetID(obj_handle),
-			instId,
-			target,
-			len);
-#endif  /* PIOS_INCLUDE_FASTHEAP */
 
 	if (rc != 0)
 		return -1;
 
-#if defined(PIOS_INCLUDE_FASTHEAP)
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	seqWriteBegin(obj_handle);
 	memcpy(target, uavobj_load_trampoline, len);
-#endif  /* PIOS_INCLUDE_FASTHEAP */
+	seqWriteEnd(obj_handle);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED, target, len,
+		NULL);
 
-	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED, target, len);
 	return 0;
 }
 
@@ -923,7 +1029,7 @@ int32_t UAVObjLoadSettings()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockWithEvents();
 
 	int32_t rc = -1;
 
@@ -942,7 +1048,7 @@ int32_t UAVObjLoadSettings()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	unlockWithEvents();
 	return rc;
 }
 
@@ -1016,7 +1122,7 @@ int32_t UAVObjLoadMetaobjects()
 	struct UAVOData *obj;
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockWithEvents();
 
 	int32_t rc = -1;
 
@@ -1032,7 +1138,7 @@ int32_t UAVObjLoadMetaobjects()
 	rc = 0;
 
 unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	unlockWithEvents();
 	return rc;
 }
 
@@ -1109,8 +1215,6 @@ int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offs
 	return UAVObjGetInstanceDataField(obj_handle, 0, dataOut, offset, size);
 }
 
-#define INSTANCE_COPY_ALL 0xffffffff
-
 /**
  * Set the data of a specific object instance
  * \param[in] obj The object handle
@@ -1125,6 +1229,23 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 		0, INSTANCE_COPY_ALL);
 }
 
+/**
+ * Set the object data, tagging the update event with the time of the
+ * sample it was computed from so consumers can measure the latency
+ * through a chain of objects.
+ * \param[in] obj The object handle
+ * \param[in] dataIn The object's data structure
+ * \param[in] origin PIOS_DELAY_GetRaw() time of the originating sample,
+ * usually the origin of the event that triggered this update
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDataTraced(UAVObjHandle obj_handle, const void *dataIn,
+		uint32_t origin)
+{
+	return setInstanceData(obj_handle, 0, dataIn, 0, INSTANCE_COPY_ALL,
+		&origin);
+}
+
 /**
  * Set the data of a specific object instance
  * \param[in] obj The object handle
@@ -1133,6 +1254,13 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
  * \return 0 if success or -1 if failure
  */
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	return setInstanceData(obj_handle, instId, dataIn, offset, size, NULL);
+}
+
+static int32_t setInstanceData(UAVObjHandle obj_handle, uint16_t instId,
+		const void *dataIn, uint32_t offset, uint32_t size,
+		const uint32_t *origin)
 {
 	PIOS_Assert(obj_handle);
 
@@ -1187,12 +1315,17 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 	}
 
 	// Set data
+	seqWriteBegin(obj_handle);
 	memcpy(target + offset, dataIn, size);
+	seqWriteEnd(obj_handle);
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
 
 	// Fire event
 	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED,
-		target, obj_len);
-	rc = 0;
+		target, obj_len, origin);
+
+	return 0;
 
 unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
@@ -1211,39 +1344,8 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
-	if (UAVObjIsMetaobject(obj_handle)) {
-		// Get instance information
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
-
-		// Cast to object info
-		obj = (struct UAVOData *) obj_handle;
-
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
-	}
-
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return readInstanceField(obj_handle, instId, dataOut, 0,
+			INSTANCE_COPY_ALL);
 }
 
 /**
@@ -1257,51 +1359,7 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
-	if (UAVObjIsMetaobject(obj_handle)) {
-		// Get instance information
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-
-		// Check for overrun
-		if ((size + offset) > MetaNumBytes) {
-			goto unlock_exit;
-		}
-
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
-	} else {
-		struct UAVOData * obj;
-		InstanceHandle instEntry;
-
-		// Cast to object info
-		obj = (struct UAVOData *)obj_handle;
-
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-
-		// Check for overrun
-		if ((size + offset) > obj->instance_size) {
-			goto unlock_exit;
-		}
-		
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry) + offset, size);
-	}
-
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return readInstanceField(obj_handle, instId, dataOut, offset, size);
 }
 
 /**
@@ -1319,11 +1377,8 @@ int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata * dataIn
 		return -1;
 	}
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	UAVObjSetData((UAVObjHandle) MetaObjectPtr((struct UAVOData *)obj_handle), dataIn);
 
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
 }
 
@@ -1337,9 +1392,6 @@ int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	// Get metadata
 	if (UAVObjIsMetaobject(obj_handle)) {
 		memcpy(dataOut, &defMetadata, sizeof(UAVObjMetadata));
@@ -1348,8 +1400,6 @@ int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata * dataOut)
 			dataOut);
 	}
 
-	// Unlock
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
 }
 
@@ -1513,9 +1563,10 @@ int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle,
 	PIOS_Assert(obj_handle);
 	PIOS_Assert(queue);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, queue, NULL, NULL, eventMask, interval);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, queue, NULL, NULL, NULL, eventMask,
+			interval);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 	return res;
 }
 
@@ -1536,9 +1587,9 @@ int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue)
 	PIOS_Assert(obj_handle);
 	PIOS_Assert(queue);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = disconnectObj(obj_handle, queue, NULL, NULL);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = disconnectObj(obj_handle, queue, NULL, NULL, NULL);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 	return res;
 }
 
@@ -1574,7 +1625,11 @@ void UAVObjCbSetFlag(UAVObjEvent *objEv, void *ctx, void *obj, int len) {
  * \param[in] len The length of data to copy.
  */
 void UAVObjCbCopyData(UAVObjEvent *objEv, void *ctx, void *obj, int len) {
-	memcpy(ctx, obj, len);
+	/* Callbacks run outside the data lock; take a consistent copy */
+	if (len) {
+		readInstanceField(objEv->obj, objEv->instId, ctx, 0,
+			INSTANCE_COPY_ALL);
+	}
 }
 
 /**
@@ -1591,9 +1646,9 @@ int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallb
 {
 	PIOS_Assert(obj_handle);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, 0, cb, cbCtx, eventMask, interval);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, 0, cb, cbCtx, NULL, eventMask, interval);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 	return res;
 }
 
@@ -1614,9 +1669,152 @@ int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb
 {
 	PIOS_Assert(obj_handle);
 	int32_t res;
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = disconnectObj(obj_handle, 0, cb, cbCtx);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = disconnectObj(obj_handle, 0, cb, cbCtx, NULL);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
+	return res;
+}
+
+/**
+ * Create an event ring.
+ * \param[in] length Maximum number of distinct pending events
+ * \return The ring, or NULL on failure
+ */
+struct UAVObjEventRing *UAVObjEventRingCreate(uint16_t length)
+{
+	struct UAVObjEventRing *ring = PIOS_malloc(sizeof(*ring));
+
+	if (!ring) {
+		return NULL;
+	}
+
+	ring->wake = PIOS_Semaphore_Create();
+
+	if (!ring->wake) {
+		PIOS_free(ring);
+		return NULL;
+	}
+
+	ring->queue = circ_queue_new(sizeof(struct UAVObjEventRingElem),
+			length + 1);
+
+	if (!ring->queue) {
+		PIOS_Semaphore_Delete(ring->wake);
+		PIOS_free(ring);
+		return NULL;
+	}
+
+	ring->waiting = false;
+
+	return ring;
+}
+
+/**
+ * Take the next event off an event ring, waiting for one if necessary.
+ * Must only be called from a single task per ring.
+ * \param[in] ring The event ring
+ * \param[out] ev The event
+ * \param[in] timeout_ms How long to wait for an event
+ * \return true if an event was received, false on timeout
+ */
+bool UAVObjEventRingReceive(struct UAVObjEventRing *ring, UAVObjEvent *ev,
+		uint32_t timeout_ms)
+{
+	PIOS_Assert(ring);
+
+	uint32_t start = PIOS_Thread_Systime();
+
+	while (true) {
+		struct UAVObjEventRingElem *elem =
+			circ_queue_read_pos(ring->queue, NULL, NULL);
+
+		if (elem) {
+			UAVO_BARRIER();
+
+			*ev = elem->ev;
+			struct ObjectEventEntryRing *entry = elem->entry;
+			uint16_t seq = elem->seq;
+
+			UAVO_BARRIER();
+
+			circ_queue_read_completed(ring->queue);
+
+			/* From here on, a new update of this instance must be
+			 * queued again rather than coalesced.  The caller reads
+			 * the object data after this, so nothing is lost.  If
+			 * a later event for the connection is still queued,
+			 * updates keep coalescing into that one. */
+			if (entry->pushed == seq) {
+				entry->pending = 0;
+			}
+
+			ring->waiting = false;
+
+			UAVO_BARRIER();
+
+			return true;
+		}
+
+		uint32_t wait_ms = PIOS_SEMAPHORE_TIMEOUT_MAX;
+
+		if (timeout_ms != PIOS_QUEUE_TIMEOUT_MAX) {
+			uint32_t elapsed = PIOS_Thread_Systime() - start;
+
+			if (elapsed >= timeout_ms) {
+				ring->waiting = false;
+				return false;
+			}
+
+			wait_ms = timeout_ms - elapsed;
+		}
+
+		ring->waiting = true;
+
+		UAVO_BARRIER();
+
+		/* Only sleep if the producer didn't get something in before
+		 * it could see that we are waiting. */
+		if (!circ_queue_read_pos(ring->queue, NULL, NULL)) {
+			PIOS_Semaphore_Take(ring->wake, wait_ms);
+		}
+	}
+}
+
+/**
+ * Connect an event ring to the object.  If the ring is already connected
+ * then the event mask is only updated.
+ * \param[in] obj The object handle
+ * \param[in] ring The event ring
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectRing(UAVObjHandle obj_handle,
+		struct UAVObjEventRing *ring, uint8_t eventMask)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(ring);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, NULL, NULL, NULL, ring, eventMask, 0);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
+	return res;
+}
+
+/**
+ * Disconnect an event ring from the object.
+ * \param[in] obj The object handle
+ * \param[in] ring The event ring
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjDisconnectRing(UAVObjHandle obj_handle,
+		struct UAVObjEventRing *ring)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(ring);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = disconnectObj(obj_handle, NULL, NULL, NULL, ring);
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
 	return res;
 }
 
@@ -1637,10 +1835,8 @@ void UAVObjUpdated(UAVObjHandle obj_handle)
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	sendEvent((struct UAVOBase *) obj_handle, instId, EV_UPDATED_MANUAL,
-		NULL, 0);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+		NULL, 0, NULL);
 }
 
 /**
@@ -1653,7 +1849,7 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 	PIOS_Assert(iterator);
 
 	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	lockWithEvents();
 
 	// Iterate through the list and invoke iterator for each object
 	struct UAVOData *obj;
@@ -1663,7 +1859,7 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 	}
 
 	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	unlockWithEvents();
 }
 
 /* type signature must match invokeCallback below, with 4 or fewer args */
@@ -1717,6 +1913,56 @@ static void invokeCallback(struct ObjectEventEntry *event, UAVObjEvent *msg,
 #define invokeCallback realInvokeCallback
 #endif
 
+/**
+ * Put an event on a ring, unless the same event for the same instance is
+ * still waiting there to be consumed.  Called with the events mutex held.
+ */
+static void pushRingEvent(struct ObjectEventEntryRing *entry,
+		UAVObjEvent *msg)
+{
+	struct UAVObjEventRing *ring = entry->entry.cbInfo.ring;
+
+	if (entry->pending && (entry->pendingInst == msg->instId) &&
+			(entry->pendingEvent == msg->event)) {
+		/* The consumer will read the new data when it gets to the
+		 * pending event, which keeps the timestamps of the first
+		 * update. */
+		stats.eventRingCoalesced++;
+		return;
+	}
+
+	struct UAVObjEventRingElem *elem =
+		circ_queue_write_pos(ring->queue, NULL, NULL);
+
+	elem->ev = *msg;
+	elem->entry = entry;
+	elem->seq = entry->pushed + 1;
+
+	/* Mark pending before publishing, so the consumer's clear can't
+	 * be overtaken by our set. */
+	entry->pendingInst = msg->instId;
+	entry->pendingEvent = msg->event;
+	entry->pushed = elem->seq;
+	entry->pending = 1;
+
+	UAVO_BARRIER();
+
+	if (circ_queue_advance_write(ring->queue) != 0) {
+		entry->pending = 0;
+
+		stats.lastQueueErrorID = UAVObjGetID(msg->obj);
+		++stats.eventQueueErrors;
+		++stats.eventRingDrops;
+		return;
+	}
+
+	UAVO_BARRIER();
+
+	if (ring->waiting) {
+		PIOS_Semaphore_Give(ring->wake);
+	}
+}
+
 /* First argument is deliberately not a pointer to get a copy of msg */
 static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 	// Go through each object and push the event message in the queue (if event is activated for the queue)
@@ -1742,6 +1988,9 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 			if (event->cb) {
 				// invoke callback directly; callbacks must be well behaved
 				invokeCallback(event, &msg, obj_data, len);
+			} else if (event->isRing) {
+				pushRingEvent((struct ObjectEventEntryRing *) event,
+					&msg);
 			} else if (event->cbInfo.queue) {
 				// Send to queue if a valid queue is registered
 				// will not block
@@ -1759,10 +2008,14 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 
 /**
  * Send a triggered event to all event queues registered on the object.
+ * origin is the time of the sample behind a traced update, or NULL when
+ * the update is its own origin.  Takes the events mutex; the caller must
+ * not hold the data mutex unless it took the events mutex first.
  */
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType triggered_event,
-			void *obj_data, int len)
+			void *obj_data, int len,
+			const uint32_t *origin)
 {
 	static uint8_t num_pending = 0;
 
@@ -1774,9 +2027,9 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 
 	/* The logic to spool up callbacks here may be a little confusing.
 	 * basically, this relies on the fact that we are in a re-entrant
-	 * locked section.  If we get in here and the static variable
-	 * in_progress is set, we are entering from a task that itself is
-	 * performing a parent callback.
+	 * locked section, under the events mutex.  If we get in here and
+	 * the static variable in_progress is set, we are entering from a
+	 * task that itself is performing a parent callback.
 	 *
 	 * In other words, while executing a callback it did a uav object
 	 * update that will trigger in turn more callbacks.
@@ -1794,11 +2047,14 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	 * trigger callback B which triggers callback A.  Don't do that.
 	 */
 
+	PIOS_Recursive_Mutex_Lock(events_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
 	if (num_pending >= 3) {
 		/* Unable to pump event; backlog too long */
 		stats.eventCallbackErrors++;
 		stats.lastCallbackErrorID = UAVObjGetID(obj);
 
+		PIOS_Recursive_Mutex_Unlock(events_mutex);
 		return -1;
 	}
 
@@ -1806,16 +2062,21 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 
 	if (num_pending) {
 		if (in_progress == obj) {
+			PIOS_Recursive_Mutex_Unlock(events_mutex);
 			return -1;	/* We don't fire events
 					 * of the same type generated by
 					 * an event callback. */
 		}
 	}
 
+	uint32_t now = PIOS_DELAY_GetRaw();
+
 	pending_events[num_pending].msg = (UAVObjEvent) {
-		.obj    = obj,
-		.event  = triggered_event,
-		.instId = instId
+		.obj       = obj,
+		.event     = triggered_event,
+		.instId    = instId,
+		.timestamp = now,
+		.origin    = origin ? *origin : now
 	};
 
 	pending_events[num_pending].obj_data = obj_data;
@@ -1843,6 +2104,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 
 	in_progress = NULL;
 
+	PIOS_Recursive_Mutex_Unlock(events_mutex);
+
 	return 0;
 }
 
@@ -1851,7 +2114,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
-	struct UAVOMultiInst *instEntry;
+	uint8_t *instEntry;
 
 	/* Don't allow more than one instance for single instance objects */
 	if (UAVObjIsSingleInstance(&(obj->base))) {
@@ -1876,14 +2139,45 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		}
 	}
 
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj;
+
+	if (instId > uavo_multi->inst_table_len) {
+		/*
+		 * Grow the instance table.  The old table is deliberately
+		 * not freed: lockless readers may still be indexing it.
+		 * Instance creation is rare and bounded, so the cost is at
+		 * most the size of the final table.
+		 */
+		uint16_t new_len = MAX(UAVO_INST_TABLE_MIN,
+				uavo_multi->inst_table_len * 2);
+		uint8_t **new_table = PIOS_malloc_no_dma(
+				new_len * sizeof(*new_table));
+		if (!new_table)
+			return NULL;
+
+		if (uavo_multi->inst_table_len) {
+			memcpy(new_table, uavo_multi->inst_table,
+				uavo_multi->inst_table_len * sizeof(*new_table));
+		}
+
+		uavo_multi->inst_table = new_table;
+		UAVO_BARRIER();
+		uavo_multi->inst_table_len = new_len;
+	}
+
 	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
+	instEntry = PIOS_malloc_no_dma(obj->instance_size);
 	if (!instEntry)
 		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
-	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+	memset(instEntry, 0, obj->instance_size);
+
+	uavo_multi->inst_table[instId - 1] = instEntry;
+
+	/* Lockless readers bound their lookup by num_instances, so the
+	 * new entry must be in the table before it is counted. */
+	UAVO_BARRIER();
 
-	( (struct UAVOMulti*)obj )->num_instances++;
+	uavo_multi->num_instances++;
 
 	// Fire event
 	UAVObjInstanceUpdated((UAVObjHandle) obj, instId);
@@ -1892,7 +2186,7 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	if (newUavObjInstanceCB) {
 		newUavObjInstanceCB(obj->id, UAVObjGetNumInstances(&obj->base));
 	}
-	return InstanceDataOffset(instEntry);
+	return instEntry;
 }
 
 /**
@@ -1926,18 +2220,118 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId >= uavo_multi->num_instances)
 			return NULL;
 
-		// Look for specified instance ID
-		uint16_t instance = 0;
-		struct UAVOMultiInst *instEntry;
-		LL_FOREACH(&(uavo_multi->instance0), instEntry) {
-			if (instance++ == instId) {
-				/* Found it */
-				return &(instEntry->instance);
-			}
+		if (instId == 0)
+			return uavo_multi->instance0;
+
+		/* Don't let the table pointer be read before the count */
+		UAVO_BARRIER();
+
+		return uavo_multi->inst_table[instId - 1];
+	}
+}
+
+/**
+ * Copy (part of) an instance out of an object.  Caller is responsible for
+ * consistency, either by holding the mutex or by checking the sequence.
+ * \return 0 if success or -1 if failure
+ */
+static int32_t copyInstanceField(struct UAVOBase *obj, uint16_t instId,
+			void *dataOut, uint32_t offset, uint32_t size)
+{
+	void *source;
+	uint32_t obj_len;
+
+	if (obj->flags.isMeta) {
+		if (instId != 0) {
+			return -1;
 		}
-		/* Instance was not found */
-		return NULL;
+
+		source = MetaDataPtr((struct UAVOMeta *)obj);
+		obj_len = MetaNumBytes;
+	} else {
+		InstanceHandle instEntry = getInstance((struct UAVOData *)obj,
+				instId);
+
+		if (instEntry == NULL) {
+			return -1;
+		}
+
+		source = InstanceData(instEntry);
+		obj_len = ((struct UAVOData *)obj)->instance_size;
+	}
+
+	if (size == INSTANCE_COPY_ALL) {
+		size = obj_len;
+	}
+
+	// Check for overrun
+	if ((size + offset) > obj_len) {
+		return -1;
+	}
+
+	memcpy(dataOut, source + offset, size);
+
+	return 0;
+}
+
+/**
+ * Read (part of) an instance, preferably without taking the lock.
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[out] dataOut Where to copy the data
+ * \param[in] offset Offset into the instance data
+ * \param[in] size Bytes to copy, or INSTANCE_COPY_ALL for the whole instance
+ * \return 0 if success or -1 if failure
+ */
+static int32_t readInstanceField(struct UAVOBase *obj, uint16_t instId,
+			void *dataOut, uint32_t offset, uint32_t size)
+{
+	int32_t rc;
+
+	for (int i = 0; i < UAVO_SEQ_READ_TRIES; i++) {
+		uint16_t seq = obj->seq;
+
+		if (seq & 1) {
+			/* Write in progress; don't spin on it. */
+			break;
+		}
+
+		UAVO_BARRIER();
+
+		rc = copyInstanceField(obj, instId, dataOut, offset, size);
+
+		UAVO_BARRIER();
+
+		if (obj->seq == seq) {
+			return rc;
+		}
+	}
+
+	/* Contended: exclude writers the old fashioned way */
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	rc = copyInstanceField(obj, instId, dataOut, offset, size);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return rc;
+}
+
+/**
+ * Check whether a connection is for the given queue, ring or callback.
+ */
+static inline bool eventEntryMatches(struct ObjectEventEntry *event,
+		struct pios_queue *queue, UAVObjEventCallback cb, void *cbCtx,
+		struct UAVObjEventRing *ring)
+{
+	if (ring) {
+		return event->isRing && event->cbInfo.ring == ring;
 	}
+
+	if (event->isRing) {
+		return false;
+	}
+
+	return (event->cb == cb && event->cbInfo.cbCtx == cbCtx) ||
+		((!event->cb) && event->cbInfo.queue == queue);
 }
 
 /**
@@ -1945,18 +2339,25 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] ring The event ring
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
  * \param[in] interval The interval at which to throttle updates; 0 is unthrottled
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
+			UAVObjEventCallback cb, void *cbCtx,
+			struct UAVObjEventRing *ring, uint8_t eventMask,
 			uint16_t interval)
 {
 	if (queue && cb) {
 		return -1;
 	}
 
+	/* Ring connections coalesce instead of throttling */
+	if (ring && (queue || cb || interval)) {
+		return -1;
+	}
+
 	struct ObjectEventEntry *event;
 	struct ObjectEventEntryThrottled *throttled;
 	struct UAVOBase *obj;
@@ -1964,8 +2365,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	// Check that the queue is not already connected, if it is simply update event mask
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if ((event->cb == cb && event->cbInfo.cbCtx == cbCtx) ||
-				((!event->cb) && event->cbInfo.queue == queue)) {
+		if (eventEntryMatches(event, queue, cb, cbCtx, ring)) {
 			// Already connected, update event mask and throttling (if possible)
 			event->eventMask = eventMask;
 			if (event->hasThrottle) {
@@ -1999,9 +2399,11 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	if (interval) {
 		mallocSize = sizeof(*throttled);
 		unused = &events_unused_throttled;
+	} else if (ring) {
+		mallocSize = sizeof(struct ObjectEventEntryRing);
+		unused = &events_unused_ring;
 	}
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	if (*unused != NULL) {
 		// We can re-use the memory of a previously disconnected event
 		event = *unused;
@@ -2010,16 +2412,17 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	else {
 		event =	(struct ObjectEventEntry *) PIOS_malloc_no_dma(mallocSize);
 		if (event == NULL) {
-			PIOS_Recursive_Mutex_Unlock(mutex);
 			return -1;
 		}
 	}
-	PIOS_Recursive_Mutex_Unlock(mutex);
 
 	memset(event, 0, mallocSize);
 	event->cb = cb;
 
-	if (!cb) {
+	if (ring) {
+		event->cbInfo.ring = ring;
+		event->isRing = 1;
+	} else if (!cb) {
 		event->cbInfo.queue = queue;
 	} else {
 		event->cbInfo.cbCtx = cbCtx;
@@ -2047,10 +2450,12 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] ring The event ring
  * \return 0 if success or -1 if failure
  */
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
-			UAVObjEventCallback cb, void *cbCtx)
+			UAVObjEventCallback cb, void *cbCtx,
+			struct UAVObjEventRing *ring)
 {
 	struct ObjectEventEntry *event;
 	struct UAVOBase *obj;
@@ -2058,18 +2463,21 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	// Find queue and remove it
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if ((event->cb == cb && event->cbInfo.cbCtx == cbCtx) ||
-				((!event->cb) && event->cbInfo.queue == queue)) {
+		if (eventEntryMatches(event, queue, cb, cbCtx, ring)) {
 			LL_DELETE(obj->next_event, event);
 			// store the unused memory for future reuse
-			PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 			if (event->hasThrottle) {
 				LL_APPEND(events_unused_throttled, event);
 			}
+			else if (event->isRing) {
+				/* Any event still on the ring refers to this
+				 * entry; it's only reused for another ring
+				 * connection, where pending is reset. */
+				LL_APPEND(events_unused_ring, event);
+			}
 			else {
 				LL_APPEND(events_unused, event);
 			}
-			PIOS_Recursive_Mutex_Unlock(mutex);
 			return 0;
 		}
 	}
@@ -2095,7 +2503,8 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
 	// Iterate over the event listeners, looking for the event matching the queue
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if (event->cbInfo.queue == queue && event->cb == 0) {
+		if (event->cbInfo.queue == queue && event->cb == 0 &&
+				!event->isRing) {
 			// Already connected, update event mask and return
 			eventMask = event->eventMask;
 			break;
@@ -2111,19 +2520,7 @@ int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue)
  */
 uint8_t UAVObjCount()
 {
-	uint8_t count = 0;
-	// Get lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		++count;
-	}
-
-	// Release lock
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return count;
+	return uavo_count;
 }
 
 /**
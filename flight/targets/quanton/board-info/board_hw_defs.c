@@ -470,6 +470,7 @@ static const struct flashfs_logfs_cfg flashfs_settings_cfg = {
 	.fs_magic = 0x3b1b14cf,
 	.arena_size = 0x00004000,	/* 64 * slot size */
 	.slot_size = 0x00000100,	/* 256 bytes */
+	.slot_index = true,	/* settings live on slow SPI flash */
 };
 
 #if defined(PIOS_INCLUDE_FLASH_JEDEC)
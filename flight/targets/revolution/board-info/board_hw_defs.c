@@ -384,6 +384,7 @@ static const struct flashfs_logfs_cfg flashfs_settings_cfg = {
 	.fs_magic      = 0x99abcedf,
 	.arena_size    = 0x00010000, /* 256 * slot size */
 	.slot_size     = 0x00000100, /* 256 bytes */
+	.slot_index    = true,       /* settings live on slow SPI flash */
 };
 
 #if defined(PIOS_INCLUDE_FLASH_JEDEC)
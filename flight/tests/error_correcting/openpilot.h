@@ -1 +1,3 @@
+#include <stdint.h>
+
 #define RS_ECC_NPARITY 4
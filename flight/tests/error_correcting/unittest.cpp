@@ -45,6 +45,8 @@ extern "C" {
 
 #include <math.h>   /* fabs() */
 
+#include "unittest_helpers.h"
+
 
 
 // To use a test fixture, derive a class from testing::Test.
@@ -103,3 +105,222 @@ TEST_F(EncodeDecode, Recover) {
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+/* Syndromes straight from the definition, S[j] = c(a^(j+1)) */
+static void reference_syndromes(const unsigned char *c, int n, uint8_t S[])
+{
+  for (int j = 0; j < RS_ECC_NPARITY; j++) {
+    uint8_t sum = 0;
+    for (int i = 0; i < n; i++)
+      sum = c[i] ^ gmult(gexp[j+1], sum);
+    S[j] = sum;
+  }
+}
+
+class Randomized : public EncodeDecode {
+protected:
+  virtual void SetUp() {
+    EncodeDecode::SetUp();
+    srand(4321);
+  }
+
+  /* A random message of 1..max_len bytes, encoded into c */
+  int random_codeword(unsigned char *c, int max_len) {
+    int len = 1 + rand() % max_len;
+    for (int i = 0; i < len; i++)
+      c[i] = rand();
+    encode_data(c, len, c);
+    return len + RS_ECC_NPARITY;
+  }
+
+  /* Corrupt count distinct bytes of c, recording where */
+  void corrupt(unsigned char *c, int n, int count, int *where) {
+    for (int e = 0; e < count; e++) {
+      int pos;
+      bool again;
+      do {
+        pos = rand() % n;
+        again = false;
+        for (int k = 0; k < e; k++)
+          again |= where[k] == pos;
+      } while (again);
+      where[e] = pos;
+      c[pos] ^= 1 + rand() % 255;
+    }
+  }
+};
+
+TEST_F(Randomized, SyndromesMatchDefinition) {
+  unsigned char c[255];
+  uint8_t S[RS_ECC_NPARITY];
+  int where[RS_ECC_NPARITY];
+
+  for (int t = 0; t < 5000; t++) {
+    int n = random_codeword(c, 250);
+    corrupt(c, n, rand() % 4, where);
+
+    decode_data(c, n);
+    reference_syndromes(c, n, S);
+    bool nz = false;
+    for (int j = 0; j < RS_ECC_NPARITY; j++) {
+      ASSERT_EQ(S[j], synBytes[j]);
+      nz |= S[j] != 0;
+    }
+    ASSERT_EQ(nz, check_syndrome() != 0);
+  }
+
+  /* Shorter than the parity */
+  for (int n = 0; n < RS_ECC_NPARITY; n++) {
+    decode_data(c, n);
+    reference_syndromes(c, n, S);
+    for (int j = 0; j < RS_ECC_NPARITY; j++)
+      ASSERT_EQ(S[j], synBytes[j]);
+  }
+}
+
+TEST_F(Randomized, CorrectsUpToHalfParity) {
+  unsigned char c[255], orig[255];
+  int where[RS_ECC_NPARITY];
+
+  for (int t = 0; t < 20000; t++) {
+    int n = random_codeword(c, 60);
+    memcpy(orig, c, n);
+    int errors = 1 + rand() % (RS_ECC_NPARITY / 2);
+    corrupt(c, n, errors, where);
+
+    decode_data(c, n);
+    ASSERT_EQ(1, check_syndrome());
+    ASSERT_EQ(1, correct_errors_erasures(c, n, 0, 0));
+    ASSERT_EQ(0, memcmp(orig, c, n));
+  }
+}
+
+TEST_F(Randomized, CorrectsErasures) {
+  unsigned char c[255], orig[255];
+  int where[RS_ECC_NPARITY], erasures[RS_ECC_NPARITY];
+
+  for (int t = 0; t < 20000; t++) {
+    int n = random_codeword(c, 60);
+    memcpy(orig, c, n);
+    /* 2 * errors + erasures <= NPAR */
+    int nerasures = 1 + rand() % RS_ECC_NPARITY;
+    int errors = (RS_ECC_NPARITY - nerasures) / 2;
+    corrupt(c, n, nerasures + errors, where);
+    for (int e = 0; e < nerasures; e++)
+      erasures[e] = n - 1 - where[e];
+
+    decode_data(c, n);
+    ASSERT_EQ(1, correct_errors_erasures(c, n, nerasures, erasures));
+    ASSERT_EQ(0, memcmp(orig, c, n));
+  }
+}
+
+/* Beyond the correction capability the decoder must mostly refuse, and
+ * must never hand back something that isn't a codeword. */
+TEST_F(Randomized, TooManyErrors) {
+  unsigned char c[255], orig[255];
+  int where[2 * RS_ECC_NPARITY];
+  int refused = 0, trials = 20000;
+
+  for (int t = 0; t < trials; t++) {
+    int n = random_codeword(c, 60);
+    memcpy(orig, c, n);
+    int errors = RS_ECC_NPARITY / 2 + 1 + rand() % (RS_ECC_NPARITY / 2);
+    if (errors > n)
+      errors = n;
+    corrupt(c, n, errors, where);
+
+    decode_data(c, n);
+    if (!check_syndrome())
+      continue;
+    if (!correct_errors_erasures(c, n, 0, 0)) {
+      refused++;
+      continue;
+    }
+    decode_data(c, n);
+    ASSERT_EQ(0, check_syndrome());
+  }
+
+  EXPECT_GT(refused, trials * 9 / 10);
+}
+
+TEST_F(Randomized, InterleavedBursts) {
+  unsigned char c[255], orig[255];
+
+  for (int t = 0; t < 10000; t++) {
+    int depth = 1 + rand() % RS_ECC_MAX_INTERLEAVE;
+    int len = 1 + rand() % 150;
+    int n = len + depth * RS_ECC_NPARITY;
+    for (int i = 0; i < len; i++)
+      c[i] = rand();
+    encode_data_interleaved(c, len, c, depth);
+    memcpy(orig, c, n);
+
+    ASSERT_EQ(0, decode_data_interleaved(c, n, depth));
+
+    /* Any burst of up to depth * NPAR/2 bytes */
+    int burst = 1 + rand() % (depth * RS_ECC_NPARITY / 2);
+    if (burst > n)
+      burst = n;
+    int start = rand() % (n - burst + 1);
+    for (int i = start; i < start + burst; i++)
+      c[i] ^= 1 + rand() % 255;
+
+    ASSERT_EQ(1, decode_data_interleaved(c, n, depth));
+    ASSERT_EQ(0, memcmp(orig, c, n));
+  }
+}
+
+TEST_F(Randomized, InterleavedDepthOneIsPlain) {
+  unsigned char a[64], b[64];
+
+  for (int i = 0; i < 40; i++)
+    a[i] = b[i] = rand();
+  encode_data(a, 40, a);
+  encode_data_interleaved(b, 40, b, 1);
+  EXPECT_EQ(0, memcmp(a, b, 40 + RS_ECC_NPARITY));
+}
+
+static double now_us(void)
+{
+  return ut_now_ns() / 1e3;
+}
+
+/* Not a pass/fail test: reports codec throughput on this host for a
+ * packet the size the RFM22B link uses. */
+TEST_F(Randomized, DISABLED_Benchmark) {
+  const int len = 60, packets = 20000;
+  static unsigned char pkts[packets][len + RS_ECC_NPARITY];
+  int where[RS_ECC_NPARITY];
+  int corrected = 0;
+
+  for (int p = 0; p < packets; p++)
+    for (int i = 0; i < len; i++)
+      pkts[p][i] = rand();
+
+  double t0 = now_us();
+  for (int p = 0; p < packets; p++)
+    encode_data(pkts[p], len, pkts[p]);
+  double t1 = now_us();
+  for (int p = 0; p < packets; p++) {
+    decode_data(pkts[p], len + RS_ECC_NPARITY);
+    ASSERT_EQ(0, check_syndrome());
+  }
+  double t2 = now_us();
+
+  for (int p = 0; p < packets; p++)
+    corrupt(pkts[p], len + RS_ECC_NPARITY, 1 + rand() % 2, where);
+  double t3 = now_us();
+  for (int p = 0; p < packets; p++) {
+    decode_data(pkts[p], len + RS_ECC_NPARITY);
+    corrected += correct_errors_erasures(pkts[p], len + RS_ECC_NPARITY, 0, 0);
+  }
+  double t4 = now_us();
+
+  EXPECT_EQ(packets, corrected);
+
+  printf("%d byte packets: encode %.2f us, clean decode %.2f us, "
+      "decode and correct %.2f us\n", len,
+      (t1 - t0) / packets, (t2 - t1) / packets, (t4 - t3) / packets);
+}
+
@@ -0,0 +1,30 @@
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+/* Fields the parsers fill in; the Set is provided by the test */
+#define GPSPOSITION_OBJID 0x1
+
+#define GPSPOSITION_STATUS_NOGPS 0
+#define GPSPOSITION_STATUS_NOFIX 1
+#define GPSPOSITION_STATUS_FIX2D 2
+#define GPSPOSITION_STATUS_FIX3D 3
+#define GPSPOSITION_STATUS_DIFF3D 4
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float GeoidSeparation;
+	float Heading;
+	float Groundspeed;
+	float Accuracy;
+	float PDOP;
+	float HDOP;
+	float VDOP;
+	uint8_t Status;
+	uint8_t Satellites;
+} GPSPositionData;
+
+int32_t GPSPositionSet(const GPSPositionData *data);
+
+#endif /* GPSPOSITION_H */
@@ -0,0 +1,16 @@
+#ifndef GPSSATELLITES_H
+#define GPSSATELLITES_H
+
+#define GPSSATELLITES_PRN_NUMELEM 30
+
+typedef struct {
+	uint8_t SatsInView;
+	uint8_t PRN[30];
+	int8_t Elevation[30];
+	int16_t Azimuth[30];
+	int8_t SNR[30];
+} GPSSatellitesData;
+
+int32_t GPSSatellitesSet(const GPSSatellitesData *data);
+
+#endif /* GPSSATELLITES_H */
@@ -0,0 +1,16 @@
+#ifndef GPSTIME_H
+#define GPSTIME_H
+
+typedef struct {
+	int8_t Month;
+	int8_t Day;
+	int16_t Year;
+	int8_t Hour;
+	int8_t Minute;
+	int8_t Second;
+} GPSTimeData;
+
+int32_t GPSTimeGet(GPSTimeData *data);
+int32_t GPSTimeSet(const GPSTimeData *data);
+
+#endif /* GPSTIME_H */
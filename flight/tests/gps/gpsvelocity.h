@@ -0,0 +1,13 @@
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} GPSVelocityData;
+
+int32_t GPSVelocitySet(const GPSVelocityData *data);
+
+#endif /* GPSVELOCITY_H */
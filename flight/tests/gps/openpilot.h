@@ -0,0 +1,14 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Just what the GPS parsers need from the real openpilot.h */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+#define PIOS_DEBUG_Assert(test)
+
+#endif /* OPENPILOT_H */
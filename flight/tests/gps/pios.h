@@ -0,0 +1,2 @@
+/* The parsers only need what openpilot.h provides */
+#include "openpilot.h"
@@ -0,0 +1,14 @@
+#ifndef UBLOXINFO_H
+#define UBLOXINFO_H
+
+typedef struct {
+	uint32_t swVersion;
+	uint16_t hwVersion;
+	uint32_t ParseErrors;
+} UBloxInfoData;
+
+int32_t UBloxInfoGet(UBloxInfoData *data);
+int32_t UBloxInfoSet(const UBloxInfoData *data);
+void UBloxInfoParseErrorsSet(uint32_t *value);
+
+#endif /* UBLOXINFO_H */
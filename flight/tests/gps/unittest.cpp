@@ -0,0 +1,425 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf, snprintf */
+#include <stdlib.h>		/* getenv */
+#include <string.h>		/* memset */
+#include <vector>
+
+extern "C" {
+#include "openpilot.h"
+#include "GPS.h"
+#include "NMEA.h"
+#include "unittest_helpers.h"
+
+/* UBX.h names a field 'class', so it can't be included from C++ */
+int parse_ubx_stream(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+/* The UAVObjects the parsers update */
+static int position_sets;
+static GPSPositionData last_position;
+
+int32_t GPSPositionSet(const GPSPositionData *data)
+{
+	position_sets++;
+	last_position = *data;
+	return 0;
+}
+
+int32_t GPSVelocitySet(const GPSVelocityData *) { return 0; }
+int32_t GPSSatellitesSet(const GPSSatellitesData *) { return 0; }
+int32_t GPSTimeGet(GPSTimeData *data) { memset(data, 0, sizeof(*data)); return 0; }
+int32_t GPSTimeSet(const GPSTimeData *) { return 0; }
+int32_t UBloxInfoGet(UBloxInfoData *data) { memset(data, 0, sizeof(*data)); return 0; }
+int32_t UBloxInfoSet(const UBloxInfoData *) { return 0; }
+void UBloxInfoParseErrorsSet(uint32_t *) { }
+}
+
+/* Ten minutes of output at 10 Hz, the rate the module configures */
+#define EPOCHS		6000
+/* Every so many epochs one message is damaged on the wire */
+#define CORRUPT_EVERY	97
+
+static int corrupted_epochs(void)
+{
+	return (EPOCHS + CORRUPT_EVERY - 1) / CORRUPT_EVERY;
+}
+
+static int32_t epoch_lat(int n) { return 473977000 + n * 3; }
+static int32_t epoch_lon(int n) { return 85455000 - n * 2; }
+
+static void put_le(std::vector<uint8_t> &p, uint32_t v, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		p.push_back(v >> (8 * i));
+}
+
+static void put_ubx(std::vector<uint8_t> &out, uint8_t cls, uint8_t id,
+		const std::vector<uint8_t> &payload, bool corrupt = false)
+{
+	size_t start = out.size();
+
+	out.push_back(0xb5);
+	out.push_back(0x62);
+	out.push_back(cls);
+	out.push_back(id);
+	put_le(out, payload.size(), 2);
+	out.insert(out.end(), payload.begin(), payload.end());
+
+	uint8_t a = 0, b = 0;
+	for (size_t i = start + 2; i < out.size(); i++) {
+		a += out[i];
+		b += a;
+	}
+	out.push_back(a);
+	out.push_back(b);
+
+	if (corrupt)
+		out[start + 8] ^= 0x10;
+}
+
+/*
+ * The messages a u-blox 6 sends each epoch once configured by ubx_cfg.c,
+ * in the order it sends them, with SVINFO and a zero length message once
+ * a second and a little line noise between epochs.
+ */
+static std::vector<uint8_t> ubx_capture(uint32_t tow_base)
+{
+	std::vector<uint8_t> out;
+
+	for (int n = 0; n < EPOCHS; n++) {
+		uint32_t tow = tow_base + n * 100;
+		std::vector<uint8_t> p;
+
+		put_le(p, tow, 4);		/* POSLLH */
+		put_le(p, epoch_lon(n), 4);
+		put_le(p, epoch_lat(n), 4);
+		put_le(p, 500000 + n, 4);
+		put_le(p, 452000 + n, 4);
+		put_le(p, 1500, 4);
+		put_le(p, 2500, 4);
+		put_ubx(out, 0x01, 0x02, p);
+
+		p.clear();			/* DOP */
+		put_le(p, tow, 4);
+		for (int i = 0; i < 7; i++)
+			put_le(p, 120 + i * 10, 2);
+		put_ubx(out, 0x01, 0x04, p, n % CORRUPT_EVERY == 0);
+
+		p.clear();			/* SOL */
+		put_le(p, tow, 4);
+		put_le(p, 0, 4);
+		put_le(p, 1950, 2);
+		p.push_back(3);			/* 3D fix */
+		p.push_back(0x0d);		/* fix ok, week and tow valid */
+		for (int i = 0; i < 3; i++)
+			put_le(p, 400000000 + i, 4);
+		put_le(p, 180, 4);
+		for (int i = 0; i < 3; i++)
+			put_le(p, 10 * i, 4);
+		put_le(p, 40, 4);
+		put_le(p, 150, 2);
+		p.push_back(0);
+		p.push_back(12);
+		put_le(p, 0, 4);
+		put_ubx(out, 0x01, 0x06, p);
+
+		p.clear();			/* VELNED */
+		put_le(p, tow, 4);
+		put_le(p, 310, 4);
+		put_le(p, -205, 4);
+		put_le(p, 12, 4);
+		put_le(p, 372, 4);
+		put_le(p, 371, 4);
+		put_le(p, 32650000, 4);
+		put_le(p, 35, 4);
+		put_le(p, 120000, 4);
+		put_ubx(out, 0x01, 0x12, p);
+
+		p.clear();			/* TIMEUTC */
+		put_le(p, tow, 4);
+		put_le(p, 25, 4);
+		put_le(p, 0, 4);
+		put_le(p, 2017, 2);
+		p.push_back(6);
+		p.push_back(21);
+		p.push_back(12);
+		p.push_back(n / 600);
+		p.push_back(n / 10 % 60);
+		p.push_back(0x07);
+		put_ubx(out, 0x01, 0x21, p);
+
+		if (n % 10 == 9) {
+			p.clear();		/* SVINFO, 16 channels */
+			put_le(p, tow, 4);
+			p.push_back(16);
+			p.push_back(0x03);
+			put_le(p, 0, 2);
+			for (int i = 0; i < 16; i++) {
+				p.push_back(i);
+				p.push_back(i * 2 + 1);
+				p.push_back(0x0d);
+				p.push_back(0x07);
+				p.push_back(i < 12 ? 30 + i : 0);
+				p.push_back(20 + i * 4);
+				put_le(p, i * 22, 2);
+				put_le(p, 0, 4);
+			}
+			put_ubx(out, 0x01, 0x30, p);
+
+			p.clear();		/* an ACK-less poll echo */
+			put_ubx(out, 0x06, 0x01, p);
+
+			/* noise, with a sync character that leads nowhere */
+			const uint8_t noise[] = { 0x00, 0xb5, 0x00, 0xff, 0x24, 0xb5 };
+			out.insert(out.end(), noise, noise + sizeof(noise));
+		}
+	}
+
+	return out;
+}
+
+static void put_nmea(std::vector<uint8_t> &out, const char *body, bool corrupt = false)
+{
+	uint8_t ck = 0;
+	for (const char *c = body; *c; c++)
+		ck ^= *c;
+
+	char sentence[128];
+	int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, ck);
+
+	if (corrupt)
+		sentence[8] ^= 0x01;
+
+	out.insert(out.end(), sentence, sentence + len);
+}
+
+static void nmea_latlon(char *buf, size_t len, int32_t deg7, int degree_digits)
+{
+	int32_t whole = deg7 / 10000000;
+	double minutes = (deg7 - whole * 10000000) * 60.0 / 10000000;
+
+	snprintf(buf, len, "%0*d%08.5f", degree_digits, whole, minutes);
+}
+
+/*
+ * What a receiver in NMEA mode sends at 10 Hz: GGA, GSA, RMC and VTG
+ * each epoch, GSV once a second, and some binary noise now and then.
+ */
+static std::vector<uint8_t> nmea_capture(void)
+{
+	std::vector<uint8_t> out;
+	char body[100], lat[16], lon[16];
+
+	for (int n = 0; n < EPOCHS; n++) {
+		int s = n / 10;
+		char utc[16];
+
+		snprintf(utc, sizeof(utc), "%02d%02d%02d.%02d",
+				12 + s / 3600, s / 60 % 60, s % 60, n % 10 * 10);
+		nmea_latlon(lat, sizeof(lat), epoch_lat(n), 2);
+		nmea_latlon(lon, sizeof(lon), epoch_lon(n), 3);
+
+		snprintf(body, sizeof(body), "GPGGA,%s,%s,N,%s,E,1,12,0.92,452.0,M,47.9,M,,", utc, lat, lon);
+		put_nmea(out, body, n % CORRUPT_EVERY == 0);
+		put_nmea(out, "GPGSA,A,3,01,03,05,07,09,11,13,15,17,19,21,23,1.50,0.92,1.18");
+		snprintf(body, sizeof(body), "GPRMC,%s,A,%s,N,%s,E,0.72,326.50,210617,,,A", utc, lat, lon);
+		put_nmea(out, body);
+		put_nmea(out, "GPVTG,326.50,T,,M,0.72,N,1.34,K,A");
+
+		if (n % 10 == 9) {
+			put_nmea(out, "GPGSV,3,1,12,01,02,000,30,03,04,022,31,05,06,044,32,07,08,066,33");
+			put_nmea(out, "GPGSV,3,2,12,09,10,088,34,11,12,110,35,13,14,132,36,15,16,154,37");
+			put_nmea(out, "GPGSV,3,3,12,17,18,176,38,19,20,198,39,21,22,220,40,23,24,242,41");
+
+			const uint8_t noise[] = { 0xb5, 0x62, 0x01, 0x02, 0x00, 0x0d, '\r', 0x8a };
+			out.insert(out.end(), noise, noise + sizeof(noise));
+		}
+	}
+
+	return out;
+}
+
+static std::vector<uint8_t> read_capture(const char *file)
+{
+	std::vector<uint8_t> data;
+	FILE *f = fopen(file, "rb");
+
+	if (f) {
+		uint8_t buf[4096];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+			data.insert(data.end(), buf, buf + n);
+		fclose(f);
+	}
+
+	return data;
+}
+
+class GPSParserTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		position_sets = 0;
+		memset(&last_position, 0, sizeof(last_position));
+		memset(&position, 0, sizeof(position));
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	virtual void TearDown() {
+	}
+
+	typedef int (*parser_t)(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+	/* Feeds the capture in blocks of the given size, as the task
+	 * would get them from the COM fifo.  Returns the completions. */
+	int feed(parser_t parse, const std::vector<uint8_t> &data, size_t block) {
+		int complete = 0;
+
+		for (size_t i = 0; i < data.size(); i += block) {
+			size_t n = data.size() - i < block ? data.size() - i : block;
+			if (parse(&data[i], n, (char *) rx_buffer, &position, &stats) == PARSER_COMPLETE)
+				complete++;
+		}
+
+		return complete;
+	}
+
+	/* Runs the capture and prints throughput and the cost per fix.
+	 * A replayed UBX capture is parsed in full but its fixes are stale
+	 * and not published, so the fixes are counted on a first pass. */
+	void benchmark(const char *name, parser_t parse, const std::vector<uint8_t> &data, size_t block) {
+		const int reps = 5;
+
+		position_sets = 0;
+		feed(parse, data, block);
+		int fixes = position_sets;
+
+		uint64_t t0 = ut_now_ns();
+		for (int r = 0; r < reps; r++)
+			feed(parse, data, block);
+		uint64_t t = ut_now_ns() - t0;
+
+		double bytes = (double) data.size() * reps;
+		printf("%-5s %4zu byte blocks: %7.1f MB/s, %6.2f ns/byte, %7.0f ns per fix\n",
+				name, block, bytes / t * 1000, t / bytes,
+				fixes ? (double) t / reps / fixes : 0.0);
+	}
+
+	GPSPositionData position;
+	struct GPS_RX_STATS stats;
+	/* Room for any UBX packet or NMEA sentence, aligned for the payloads */
+	uint32_t rx_buffer[1024];
+};
+
+TEST_F(GPSParserTest, UBXAnyBlockSize) {
+	const size_t blocks[] = { 1, 3, 32, 100, 4096 };
+
+	for (size_t i = 0; i < NELEMENTS(blocks); i++) {
+		SetUp();
+		/* Epochs must move forward across runs, or the message
+		 * tracker drops them as stale */
+		std::vector<uint8_t> capture = ubx_capture(10000000 * (i + 1));
+
+		feed(parse_ubx_stream, capture, blocks[i]);
+
+		EXPECT_EQ(EPOCHS - corrupted_epochs(), position_sets) << "block " << blocks[i];
+		EXPECT_EQ(corrupted_epochs(), stats.gpsRxChkSumError) << "block " << blocks[i];
+		EXPECT_EQ(0, stats.gpsRxOverflow) << "block " << blocks[i];
+		EXPECT_EQ(epoch_lat(EPOCHS - 1), last_position.Latitude);
+		EXPECT_EQ(epoch_lon(EPOCHS - 1), last_position.Longitude);
+		EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, last_position.Status);
+		EXPECT_EQ(12, last_position.Satellites);
+		EXPECT_FLOAT_EQ(1.3f, last_position.PDOP);
+	}
+}
+
+TEST_F(GPSParserTest, NMEAAnyBlockSize) {
+	const size_t blocks[] = { 1, 3, 32, 100, 4096 };
+	std::vector<uint8_t> capture = nmea_capture();
+
+	for (size_t i = 0; i < NELEMENTS(blocks); i++) {
+		SetUp();
+
+		feed(parse_nmea_stream, capture, blocks[i]);
+
+		EXPECT_EQ(EPOCHS - corrupted_epochs(), position_sets) << "block " << blocks[i];
+		EXPECT_EQ(corrupted_epochs(), stats.gpsRxChkSumError) << "block " << blocks[i];
+		EXPECT_EQ(0, stats.gpsRxOverflow) << "block " << blocks[i];
+		EXPECT_EQ(0, stats.gpsRxParserError) << "block " << blocks[i];
+		EXPECT_NEAR(epoch_lat(EPOCHS - 1), last_position.Latitude, 2);
+		EXPECT_NEAR(epoch_lon(EPOCHS - 1), last_position.Longitude, 2);
+		EXPECT_EQ(12, last_position.Satellites);
+		EXPECT_FLOAT_EQ(1.5f, last_position.PDOP);
+	}
+}
+
+TEST_F(GPSParserTest, NMEAOverlongSentence) {
+	std::vector<uint8_t> data;
+	const char *junk = "$GPTXT,";
+
+	data.insert(data.end(), junk, junk + strlen(junk));
+	data.insert(data.end(), NMEA_MAX_PACKET_LENGTH, 'x');
+	put_nmea(data, "GPGGA,120000.00,4723.86200,N,00832.73000,E,1,09,1.0,400.0,M,47.9,M,,");
+
+	feed(parse_nmea_stream, data, 32);
+
+	EXPECT_EQ(1, stats.gpsRxOverflow);
+	EXPECT_EQ(1, position_sets);
+}
+
+/* Not a pass/fail test: reports the parsing cost on this host.  Set
+ * GPS_UBX_CAPTURE or GPS_NMEA_CAPTURE to a raw receiver log to measure
+ * a recorded stream instead of the generated one. */
+TEST_F(GPSParserTest, DISABLED_Benchmark) {
+	const char *file;
+
+	std::vector<uint8_t> ubx = (file = getenv("GPS_UBX_CAPTURE")) ?
+		read_capture(file) : ubx_capture(400000000);
+	std::vector<uint8_t> nmea = (file = getenv("GPS_NMEA_CAPTURE")) ?
+		read_capture(file) : nmea_capture();
+
+	/* One byte per call is what the task used to do, minus the
+	 * fifo round trip for each byte */
+	benchmark("UBX", parse_ubx_stream, ubx, 1);
+	std::vector<uint8_t> later = getenv("GPS_UBX_CAPTURE") ? ubx : ubx_capture(500000000);
+	benchmark("UBX", parse_ubx_stream, later, 32);
+	benchmark("NMEA", parse_nmea_stream, nmea, 1);
+	benchmark("NMEA", parse_nmea_stream, nmea, 32);
+
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @file       unittest_helpers.h
+ * @author     dRonin, http://dronin.org, Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Timing and deterministic input helpers shared by the unit tests
+ *
+ * Benchmarks built on these are named DISABLED_*, so they only run when
+ * asked for with --gtest_also_run_disabled_tests.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef UNITTEST_HELPERS_H
+#define UNITTEST_HELPERS_H
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Monotonic wall clock, for timeouts and benchmarks.
+ * @returns nanoseconds since an arbitrary start point
+ */
+static inline uint64_t ut_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Step a linear congruential generator, so test inputs are the same on
+ * every host and run.
+ * @param[in,out] state generator state, seed it with any value
+ * @returns the new state
+ */
+static inline uint32_t ut_rand(uint32_t *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+
+	return *state;
+}
+
+/**
+ * Uniform noise from ut_rand.
+ * @param[in,out] state generator state
+ * @returns a value in [-0.5, 0.5)
+ */
+static inline float ut_noise(uint32_t *state)
+{
+	return ((ut_rand(state) >> 8) / 16777216.0f) - 0.5f;
+}
+
+#endif /* UNITTEST_HELPERS_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,214 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memcpy */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* fabsf */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>		/* __rdtsc */
+#endif
+
+#define NUMX 14
+#define NUMW 10
+
+extern "C" {
+#include "insgps.h"
+#include "unittest_helpers.h"
+
+/* Filter internals, so the prediction can be checked against a reference */
+extern float F[NUMX][NUMX], G[NUMX][NUMW], P[NUMX][NUMX], Q[NUMW];
+}
+
+/*
+ * Straightforward dense evaluation of
+ *   Pnew = (I+F*T)*P*(I+F*T)' + T^2*(G*Q*G' + Qbias)
+ * where Qbias is the random walk of the bias states.  This is the
+ * definition the sparse version in the filter has to agree with.
+ */
+static void reference_prediction(float dT, float Pout[NUMX][NUMX])
+{
+	double Phi[NUMX][NUMX], PhiP[NUMX][NUMX];
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++)
+			Phi[i][j] = (i == j) + F[i][j] * (double) dT;
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++) {
+			PhiP[i][j] = 0;
+			for (int k = 0; k < NUMX; k++)
+				PhiP[i][j] += Phi[i][k] * P[k][j];
+		}
+
+	for (int i = 0; i < NUMX; i++)
+		for (int j = 0; j < NUMX; j++) {
+			double p = 0;
+			for (int k = 0; k < NUMX; k++)
+				p += PhiP[i][k] * Phi[j][k];
+			for (int k = 0; k < 6; k++)
+				p += (double) dT * dT * Q[k] * G[i][k] * G[j][k];
+			if (i == j && i >= 10)
+				p += (double) dT * dT * Q[i - 4];
+			Pout[i][j] = p;
+		}
+}
+
+class INSGPSTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		INSGPSInit();
+		step = 0;
+	}
+
+	virtual void TearDown() {
+	}
+
+	/* Advance the state along a gently manoeuvring trajectory,
+	 * correcting from all sensors now and then so P stays
+	 * representative of flight rather than just growing. */
+	void advance(float dT) {
+		float gyro[3], accel[3];
+
+		for (int i = 0; i < 3; i++) {
+			gyro[i] = 0.5f * sinf(step * 0.01f * (i + 1));
+			accel[i] = 0.3f * cosf(step * 0.02f * (i + 1));
+		}
+		accel[2] -= 9.81f;
+
+		INSStatePrediction(gyro, accel, dT);
+
+		if (step % 10 == 9) {
+			const float mag[3] = { 1, 0, 0.3f };
+			const float pos[3] = { 0.1f, -0.2f, 0.05f };
+			const float vel[3] = { 0, 0.1f, 0 };
+
+			INSCovariancePrediction(dT);
+			INSCorrection(mag, pos, vel, -0.05f, FULL_SENSORS);
+		}
+
+		step++;
+	}
+
+	int step;
+};
+
+TEST_F(INSGPSTest, CovariancePredictionMatchesDense) {
+	const float dT = 0.002f;
+	float Pref[NUMX][NUMX];
+	float worst = 0;
+
+	for (int n = 0; n < 2000; n++) {
+		advance(dT);
+
+		reference_prediction(dT, Pref);
+		INSCovariancePrediction(dT);
+
+		for (int i = 0; i < NUMX; i++)
+			for (int j = 0; j < NUMX; j++) {
+				/* Scale by the variances involved, since
+				 * the entries span many decades */
+				float scale = sqrtf(Pref[i][i] * Pref[j][j]);
+				float err = fabsf(P[i][j] - Pref[i][j]) / scale;
+
+				if (err > worst)
+					worst = err;
+			}
+	}
+
+	EXPECT_LT(worst, 1e-5f);
+}
+
+TEST_F(INSGPSTest, CovariancePredictionSymmetric) {
+	for (int n = 0; n < 500; n++) {
+		advance(0.002f);
+		INSCovariancePrediction(0.002f);
+	}
+
+	for (int i = 0; i < NUMX; i++) {
+		EXPECT_GT(P[i][i], 0.0f);
+
+		for (int j = 0; j < i; j++)
+			EXPECT_EQ(P[i][j], P[j][i]);
+	}
+}
+
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* Not a pass/fail test: reports the cost of a prediction on this host so
+ * changes to the filter core can be compared. */
+TEST_F(INSGPSTest, DISABLED_CovariancePredictionBenchmark) {
+	const int iterations = 20000;
+	float Pref[NUMX][NUMX];
+
+	for (int n = 0; n < 100; n++)
+		advance(0.002f);
+
+	float Psaved[NUMX][NUMX];
+	memcpy(Psaved, P, sizeof(Psaved));
+
+	uint64_t t0 = ut_now_ns(), c0 = now_cycles();
+	for (int n = 0; n < iterations; n++) {
+		memcpy(P, Psaved, sizeof(Psaved));
+		INSCovariancePrediction(0.002f);
+	}
+	uint64_t t1 = ut_now_ns(), c1 = now_cycles();
+	for (int n = 0; n < iterations; n++) {
+		memcpy(P, Psaved, sizeof(Psaved));
+		reference_prediction(0.002f, Pref);
+	}
+	uint64_t t2 = ut_now_ns(), c2 = now_cycles();
+
+	printf("INSCovariancePrediction: %.0f ns, %.0f cycles per call\n",
+			(double)(t1 - t0) / iterations,
+			(double)(c1 - c0) / iterations);
+	printf("dense reference:         %.0f ns, %.0f cycles per call\n",
+			(double)(t2 - t1) / iterations,
+			(double)(c2 - c1) / iterations);
+
+	EXPECT_GT(P[0][0], 0.0f);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,17 @@
+#ifndef LOOPLATENCY_H
+#define LOOPLATENCY_H
+
+/* The object as generated; Initialize and Set are provided by the test */
+#define LOOPLATENCY_P50_NUMELEM 6
+
+typedef struct {
+	uint16_t P50[6];
+	uint16_t P99[6];
+	uint16_t Max[6];
+	uint16_t Samples[6];
+} LoopLatencyData;
+
+int32_t LoopLatencyInitialize(void);
+int32_t LoopLatencySet(const LoopLatencyData *data);
+
+#endif /* LOOPLATENCY_H */
@@ -0,0 +1,7 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Just what the latency trace needs from the real openpilot.h */
+#include "pios.h"
+
+#endif /* OPENPILOT_H */
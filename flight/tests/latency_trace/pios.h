@@ -0,0 +1,15 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DONT_BUILD_IF(COND,MSG) typedef char static_assertion_##MSG[(COND)?-1:1]
+
+/* Provided by the test; raw delay ticks are microseconds */
+void *PIOS_malloc(size_t size);
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later);
+
+#endif /* PIOS_H */
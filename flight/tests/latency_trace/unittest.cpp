@@ -0,0 +1,212 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memset */
+
+extern "C" {
+#include "openpilot.h"
+#include "latency_trace.h"
+#include "looplatency.h"
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+	return later - raw;
+}
+
+static int sets;
+static LoopLatencyData published;
+
+int32_t LoopLatencyInitialize(void)
+{
+	return 0;
+}
+
+int32_t LoopLatencySet(const LoopLatencyData *data)
+{
+	sets++;
+	published = *data;
+	return 0;
+}
+}
+
+/* Records a latency of us, with the raw clock just about to wrap */
+static void record(enum latency_trace_stage stage, uint32_t us)
+{
+	uint32_t from = 0xfffffff0;
+
+	latency_trace_record(stage, from, from + us);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class LatencyTrace : public testing::Test {
+protected:
+	virtual void SetUp() {
+		sets = 0;
+		memset(&published, 0xff, sizeof(published));
+	}
+
+	virtual void TearDown() {
+	}
+};
+
+/* Must run first: the trace can't be stopped once started */
+TEST_F(LatencyTrace, NothingBeforeInit) {
+	record(LATENCY_TRACE_TOTAL, 100);
+	latency_trace_publish();
+	EXPECT_EQ(0, sets);
+
+	ASSERT_EQ(0, latency_trace_init());
+
+	/* ... and the sample before it isn't counted */
+	latency_trace_publish();
+	EXPECT_EQ(1, sets);
+	EXPECT_EQ(0, published.Samples[LATENCY_TRACE_TOTAL]);
+	EXPECT_EQ(0, published.Max[LATENCY_TRACE_TOTAL]);
+}
+
+TEST_F(LatencyTrace, Percentiles) {
+	for (uint32_t us = 1; us <= 1000; us++) {
+		record(LATENCY_TRACE_STABILIZATION, us);
+	}
+
+	for (int i = 0; i < 50; i++) {
+		record(LATENCY_TRACE_SENSORS, 3);
+	}
+
+	latency_trace_publish();
+
+	/* Buckets are a quarter octave, so within 25% above */
+	const enum latency_trace_stage s = LATENCY_TRACE_STABILIZATION;
+	EXPECT_EQ(1000, published.Samples[s]);
+	EXPECT_GE(published.P50[s], 500);
+	EXPECT_LE(published.P50[s], 500 * 5 / 4);
+	EXPECT_GE(published.P99[s], 990);
+	EXPECT_LE(published.P99[s], 990 * 5 / 4);
+	EXPECT_EQ(1000, published.Max[s]);
+
+	/* Short latencies are exact */
+	EXPECT_EQ(50, published.Samples[LATENCY_TRACE_SENSORS]);
+	EXPECT_EQ(3, published.P50[LATENCY_TRACE_SENSORS]);
+	EXPECT_EQ(3, published.P99[LATENCY_TRACE_SENSORS]);
+	EXPECT_EQ(3, published.Max[LATENCY_TRACE_SENSORS]);
+
+	/* Stages that saw nothing say so */
+	EXPECT_EQ(0, published.Samples[LATENCY_TRACE_ACTUATOR]);
+	EXPECT_EQ(0, published.P50[LATENCY_TRACE_ACTUATOR]);
+	EXPECT_EQ(0, published.Max[LATENCY_TRACE_ACTUATOR]);
+}
+
+TEST_F(LatencyTrace, EveryLatencyBucketedUpwards) {
+	const enum latency_trace_stage s = LATENCY_TRACE_ACTUATOR_WAKE;
+
+	for (uint32_t us = 0; us < 16384; us++) {
+		record(s, us);
+		latency_trace_publish();
+
+		ASSERT_EQ(1, published.Samples[s]);
+		ASSERT_EQ(us, published.Max[s]);
+		ASSERT_GE(published.P50[s], us);
+		ASSERT_LE(published.P50[s], us + us / 4) << us;
+		ASSERT_EQ(published.P50[s], published.P99[s]);
+	}
+}
+
+TEST_F(LatencyTrace, OneSecondWindows) {
+	const enum latency_trace_stage s = LATENCY_TRACE_TOTAL;
+
+	record(s, 5000);
+	latency_trace_publish();
+	EXPECT_EQ(1, published.Samples[s]);
+	EXPECT_EQ(5000, published.Max[s]);
+
+	/* The long one is forgotten, not mixed into the next window */
+	for (int i = 0; i < 100; i++) {
+		record(s, 200);
+	}
+	latency_trace_publish();
+	EXPECT_EQ(100, published.Samples[s]);
+	EXPECT_EQ(200, published.Max[s]);
+	EXPECT_LE(published.P99[s], 250);
+
+	/* A quiet window, then one more sample */
+	latency_trace_publish();
+	EXPECT_EQ(0, published.Samples[s]);
+	EXPECT_EQ(0, published.Max[s]);
+
+	record(s, 40);
+	latency_trace_publish();
+	EXPECT_EQ(1, published.Samples[s]);
+	EXPECT_EQ(40, published.Max[s]);
+}
+
+TEST_F(LatencyTrace, CountsWrap) {
+	const enum latency_trace_stage s = LATENCY_TRACE_ACTUATOR;
+
+	/* 8kHz for long enough that the 16 bit counts wrap */
+	for (int window = 0; window < 20; window++) {
+		for (int i = 0; i < 8000; i++) {
+			record(s, 100 + i % 2);
+		}
+		latency_trace_publish();
+
+		ASSERT_EQ(8000, published.Samples[s]);
+		ASSERT_EQ(101, published.Max[s]);
+		ASSERT_GE(published.P50[s], 100);
+		ASSERT_LE(published.P50[s], 125);
+	}
+}
+
+TEST_F(LatencyTrace, Overflow) {
+	const enum latency_trace_stage s = LATENCY_TRACE_TOTAL;
+
+	record(s, 100);
+	record(s, 100000);
+	latency_trace_publish();
+
+	EXPECT_EQ(2, published.Samples[s]);
+	EXPECT_EQ(UINT16_MAX, published.Max[s]);
+	/* The last bucket is open ended; only the maximum says how far */
+	EXPECT_EQ(16383, published.P99[s]);
+}
+
+/**
+ * @}
+ * @}
+ */
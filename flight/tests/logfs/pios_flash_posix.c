@@ -17,6 +17,8 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	uint32_t read_count;
+	uint32_t *erase_counts;
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -42,6 +44,10 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	flash_dev->read_count = 0;
+	flash_dev->erase_counts = PIOS_malloc(cfg->size_of_flash / cfg->size_of_sector * sizeof(uint32_t));
+	assert(flash_dev->erase_counts);
+	memset(flash_dev->erase_counts, 0, cfg->size_of_flash / cfg->size_of_sector * sizeof(uint32_t));
 
 	flash_dev->flash_file = fopen ("theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
@@ -65,9 +71,28 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 
 	fclose(flash_dev->flash_file);
 
+	PIOS_free(flash_dev->erase_counts);
 	PIOS_free(flash_dev);
 }
 
+/* Number of read_data calls so far, to see how hard a filesystem works */
+uint32_t PIOS_Flash_Posix_GetReadCount(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return flash_dev->read_count;
+}
+
+/* Number of times a sector has been erased since init, to check wear */
+uint32_t PIOS_Flash_Posix_GetEraseCount(uintptr_t chip_id, uint32_t sector)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	assert(sector < flash_dev->cfg->size_of_flash / flash_dev->cfg->size_of_sector);
+
+	return flash_dev->erase_counts[sector];
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -117,6 +142,8 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 		assert(0);
 	}
 
+	flash_dev->erase_counts[chip_offset / flash_dev->cfg->size_of_sector]++;
+
 	unsigned char buf[flash_dev->cfg->size_of_sector];
 
 	memset((void *)buf, 0xFF, flash_dev->cfg->size_of_sector);
@@ -163,6 +190,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	/* assert(flash_dev->transaction_in_progress); */
 
+	flash_dev->read_count++;
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
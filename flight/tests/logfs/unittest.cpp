@@ -36,6 +36,7 @@
 #include <stdlib.h>		/* abort */
 #include <string.h>		/* memset */
 #include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
 
 extern "C" {
 
@@ -54,6 +55,7 @@ extern struct pios_flash_posix_cfg flash_config;
 #include "pios_flashfs_logfs_priv.h"
 
 extern struct flashfs_logfs_cfg flashfs_config_settings;
+extern struct flashfs_logfs_cfg flashfs_config_settings_indexed;
 extern struct flashfs_logfs_cfg flashfs_config_waypoints;
 
 #include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
@@ -424,3 +426,332 @@ TEST_F(LogfsTestCookedMultiPart, WriteLarge) {
   memset(obj4_check, 0, sizeof(obj4_check));
   EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id_b, OBJ4_ID, 0, obj4_check, sizeof(obj4_check)));
 }
+
+class LogfsTestIndexed : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    LogfsTestRaw::SetUp();
+
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings_indexed, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  virtual void TearDown() {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  /* Unmount and mount again, as at boot */
+  void Remount(struct flashfs_logfs_cfg *cfg) {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfg, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  uintptr_t fs_id;
+};
+
+TEST_F(LogfsTestIndexed, WriteVerifyDeleteVerifyOne) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 0));
+
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+}
+
+TEST_F(LogfsTestIndexed, FillFilesystemAndGarbageCollect) {
+  for (uint32_t i = 0; i < (flashfs_config_settings_indexed.arena_size / flashfs_config_settings_indexed.slot_size) - 1; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+  }
+
+  EXPECT_EQ(-4, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+  /* Triggers gc, which moves everything and so rebuilds the index */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint32_t i = 1; i < (flashfs_config_settings_indexed.arena_size / flashfs_config_settings_indexed.slot_size) - 1; i++) {
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+  }
+
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+}
+
+TEST_F(LogfsTestIndexed, WriteManyRemountVerify) {
+  for (uint32_t i = 0; i < 2000; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, 0, NULL, 0));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 123, obj1_alt, sizeof(obj1_alt)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, 0, obj3, sizeof(obj3)));
+  }
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+
+  /* What the index wrote must read back the same with and without it */
+  struct flashfs_logfs_cfg *cfgs[] = {
+    &flashfs_config_settings, &flashfs_config_settings_indexed,
+  };
+
+  for (uint32_t c = 0; c < 2; c++) {
+    Remount(cfgs[c]);
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, 0, NULL, 0));
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 123, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    memset(obj3_check, 0, sizeof(obj3_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+    EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+  }
+}
+
+#define BOOT_NUM_OBJS 120
+
+static uint64_t now_us()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* Mount and load every settings object, as UAVObjLoadSettings does at boot */
+static void boot_load(struct flashfs_logfs_cfg *cfg, unsigned char *buf,
+    uint32_t *mount_reads, uint32_t *load_reads, uint64_t *load_us)
+{
+  uintptr_t fs_id;
+
+  uint32_t start = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, cfg, FLASH_PARTITION_LABEL_SETTINGS));
+  uint32_t mounted = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id);
+
+  uint64_t t = now_us();
+
+  for (uint32_t i = 0; i < BOOT_NUM_OBJS; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, buf, OBJ1_SIZE));
+    EXPECT_EQ((unsigned char) i, buf[0]);
+  }
+
+  *load_us = now_us() - t;
+  *mount_reads = mounted - start;
+  *load_reads = PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id) - mounted;
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+}
+
+TEST_F(LogfsTestIndexed, BootLoad) {
+  /* A settings partition as it looks after some use: every object
+   * saved a few times, so the live copies are spread over the log */
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    for (uint32_t i = 0; i < BOOT_NUM_OBJS; i++) {
+      obj1[0] = i;
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, 0, obj1, sizeof(obj1)));
+    }
+  }
+
+  unsigned char buf[OBJ1_SIZE];
+  uint32_t mount_reads, load_reads, idx_mount_reads, idx_load_reads;
+  uint64_t load_us, idx_load_us;
+
+  boot_load(&flashfs_config_settings, buf, &mount_reads, &load_reads, &load_us);
+  boot_load(&flashfs_config_settings_indexed, buf, &idx_mount_reads, &idx_load_reads, &idx_load_us);
+
+  printf("Loading %d objects: %u flash reads in %lluus scanning, "
+      "%u in %lluus indexed (mount %u/%u)\n", BOOT_NUM_OBJS,
+      load_reads, (unsigned long long) load_us,
+      idx_load_reads, (unsigned long long) idx_load_us,
+      mount_reads, idx_mount_reads);
+
+  /* Building the index costs nothing extra at mount */
+  EXPECT_EQ(mount_reads, idx_mount_reads);
+
+  /* One header and one data read per object */
+  EXPECT_EQ(2U * BOOT_NUM_OBJS, idx_load_reads);
+
+  /* Scanning reads the header of every slot before the live one */
+  EXPECT_GT(load_reads, 20U * idx_load_reads);
+}
+
+/* The settings partition is sectors 0-31, one arena per sector */
+#define SETTINGS_NUM_ARENAS 32
+
+static uint32_t settings_erases()
+{
+  uint32_t erases = 0;
+
+  for (uint32_t i = 0; i < SETTINGS_NUM_ARENAS; i++) {
+    erases += PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id, i);
+  }
+
+  return erases;
+}
+
+TEST_F(LogfsTestCooked, DeleteDuringCompaction) {
+  /* obj2 first, then enough objects that copying takes several steps */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  for (uint32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, i, obj3, sizeof(obj3)));
+  }
+
+  /* Save obj1 until one of the saves starts a compaction */
+  uint32_t erases = settings_erases();
+  for (uint32_t i = 0; settings_erases() == erases; i++) {
+    ASSERT_LT(i, flashfs_config_settings.arena_size / flashfs_config_settings.slot_size);
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  }
+
+  /* The next save copies obj2 along with the first few others... */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  /* ...so deleting it now must also delete the copy */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+
+  /* Finish off in the background */
+  int32_t rc;
+  while ((rc = PIOS_FLASHFS_Compact(fs_id)) == 1);
+  EXPECT_EQ(0, rc);
+  EXPECT_EQ(erases + 1, settings_erases());
+
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    unsigned char obj2_check[OBJ2_SIZE];
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    for (uint32_t i = 0; i < 8; i++) {
+      memset(obj3_check, 0, sizeof(obj3_check));
+      EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, i, obj3_check, sizeof(obj3_check)));
+      EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+    }
+
+    /* Same again after a reboot */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
+#define RANDOM_NUM_OBJS 24
+#define RANDOM_NUM_SAVES 100000
+
+/*
+ * Save objects of random size in random order, optionally letting the
+ * background compaction run to completion between saves, and report the
+ * slowest save and how the erases were spread over the arenas.
+ */
+static void random_saves(uintptr_t fs_id, bool idle_compact, uint32_t *max_save_erases)
+{
+  unsigned char buf[OBJ3_SIZE];
+  uint16_t sizes[RANDOM_NUM_OBJS];
+  uint8_t contents[RANDOM_NUM_OBJS];
+
+  srand(42);
+
+  for (uint32_t i = 0; i < RANDOM_NUM_OBJS; i++) {
+    sizes[i] = rand() % (OBJ3_SIZE + 1);
+  }
+
+  uint64_t max_us = 0, total_us = 0;
+  uint32_t start_erases = settings_erases();
+
+  *max_save_erases = 0;
+
+  for (uint32_t n = 0; n < RANDOM_NUM_SAVES; n++) {
+    uint32_t i = rand() % RANDOM_NUM_OBJS;
+
+    contents[i] = rand();
+    memset(buf, contents[i], sizes[i]);
+
+    uint32_t erases = settings_erases();
+    uint64_t t = now_us();
+
+    ASSERT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID + i, 0, buf, sizes[i]));
+
+    t = now_us() - t;
+    erases = settings_erases() - erases;
+
+    total_us += t;
+    if (t > max_us) {
+      max_us = t;
+    }
+    if (erases > *max_save_erases) {
+      *max_save_erases = erases;
+    }
+
+    if (idle_compact) {
+      int32_t rc;
+      while ((rc = PIOS_FLASHFS_Compact(fs_id)) == 1);
+      ASSERT_EQ(0, rc);
+    }
+  }
+
+  uint32_t min_arena = UINT32_MAX, max_arena = 0;
+  for (uint32_t i = 0; i < SETTINGS_NUM_ARENAS; i++) {
+    uint32_t e = PIOS_Flash_Posix_GetEraseCount(pios_posix_flash_id, i);
+
+    if (e < min_arena) min_arena = e;
+    if (e > max_arena) max_arena = e;
+  }
+
+  printf("%d saves%s: worst %lluus, mean %lluus, at most %u erase(s) in one save; "
+      "%u erases, %u-%u per arena\n", RANDOM_NUM_SAVES,
+      idle_compact ? " (compacting when idle)" : "",
+      (unsigned long long) max_us,
+      (unsigned long long) (total_us / RANDOM_NUM_SAVES),
+      *max_save_erases, settings_erases() - start_erases,
+      min_arena, max_arena);
+
+  /* Arenas are picked by erase count, so wear stays level */
+  EXPECT_LE(max_arena - min_arena, 1U);
+
+  for (uint32_t i = 0; i < RANDOM_NUM_OBJS; i++) {
+    unsigned char check[OBJ3_SIZE];
+    memset(check, ~contents[i], sizes[i]);
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID + i, 0, check, sizes[i]));
+    for (uint32_t j = 0; j < sizes[i]; j++) {
+      EXPECT_EQ(contents[i], check[j]);
+    }
+  }
+}
+
+TEST_F(LogfsTestCooked, RandomSavesLatencyAndWear) {
+  uint32_t max_save_erases;
+
+  random_saves(fs_id, false, &max_save_erases);
+
+  /* Compaction is spread out, so no save erases more than one arena */
+  EXPECT_EQ(1U, max_save_erases);
+}
+
+TEST_F(LogfsTestCooked, RandomSavesIdleCompaction) {
+  uint32_t max_save_erases;
+
+  random_saves(fs_id, true, &max_save_erases);
+
+  /* With time to compact between saves, saves never wait for an erase */
+  EXPECT_EQ(0U, max_save_erases);
+}
@@ -0,0 +1,304 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sinf */
+
+extern "C" {
+#include "lpfilter.h"
+#include "unittest_helpers.h"
+}
+
+/* Deterministic test input: a chirp per axis plus some LCG noise */
+static uint32_t seed;
+
+static float test_input(int n, int axis)
+{
+	return 100.0f * sinf(0.0005f * n * n * (axis + 1)) +
+		20.0f * ut_noise(&seed);
+}
+
+static const uint8_t golden_orders[] = { 1, 2, 3, 4, 7 };
+
+/*
+ * Output of an 80Hz filter at 1kHz on test_input(), every 32nd sample,
+ * captured from the axis-by-axis implementation before it was
+ * restructured.
+ */
+static const float golden[5][16][3] = {
+	{ /* order 1 */
+		{ 44.7365265f, 81.3900604f, 89.7086029f },
+		{ 94.7716904f, -61.9706497f, -56.1754951f },
+		{ -91.6985779f, 58.229248f, 47.0956726f },
+		{ 98.8103333f, -7.06973743f, -77.4652405f },
+		{ -17.4739323f, -24.1846714f, -22.7724419f },
+		{ -68.0489883f, -75.4007568f, -41.4936447f },
+		{ -52.4336662f, -63.4813004f, -56.8307495f },
+		{ 61.0025101f, 72.1488113f, 25.8351231f },
+		{ 3.88035297f, 1.35812569f, -21.3724213f },
+		{ 19.2246323f, 30.1751614f, 43.2091446f },
+		{ -83.7615662f, -2.66517067f, 41.7482338f },
+		{ -40.9997673f, 58.3758087f, -19.9998474f },
+		{ -58.259407f, 50.2086334f, 3.9681797f },
+		{ -70.6529236f, -50.8585243f, -26.7834091f },
+		{ 67.195137f, 25.1480293f, -31.8026733f },
+		{ -65.2242203f, 12.2951689f, 34.6622467f },
+	},
+	{ /* order 2 */
+		{ 42.3960304f, 75.0058441f, 91.4836655f },
+		{ 95.1363983f, -47.1580772f, -80.437851f },
+		{ -90.5595398f, 79.4058685f, 12.3446636f },
+		{ 100.048073f, 25.0942078f, -74.7055664f },
+		{ -34.9513397f, -69.0074463f, -71.3029785f },
+		{ -87.0201721f, -60.0049934f, 26.4531784f },
+		{ -80.2009125f, -74.3120422f, -14.3808012f },
+		{ 27.6631813f, 40.5530624f, 36.9113083f },
+		{ 46.825222f, -56.2385445f, 25.3384914f },
+		{ -32.5968094f, -38.7149353f, -13.1268444f },
+		{ -72.3599243f, 41.8200607f, 2.72554207f },
+		{ 9.4887352f, 2.11353493f, -12.8160477f },
+		{ -2.72423744f, 10.6616383f, -10.3877068f },
+		{ -72.7869568f, 8.4982872f, 10.6730766f },
+		{ 11.265377f, 18.6736374f, 6.14329052f },
+		{ -13.7809277f, 17.6717167f, -6.85552502f },
+	},
+	{ /* order 3 */
+		{ 40.065506f, 70.8917236f, 91.5118256f },
+		{ 96.1466904f, -39.9614983f, -88.2732315f },
+		{ -87.3877563f, 86.7232819f, -6.14743042f },
+		{ 97.7731323f, 42.7627716f, -60.6335945f },
+		{ -44.1417084f, -86.3888779f, -78.628006f },
+		{ -92.000061f, -40.3442955f, 53.4673691f },
+		{ -88.7400208f, -59.5196953f, 16.883604f },
+		{ 11.1395874f, 5.40171814f, 10.9645777f },
+		{ 65.2514954f, -57.9509201f, 13.2149363f },
+		{ -54.8565521f, -50.2718964f, -12.9753551f },
+		{ -54.8498077f, 27.4070587f, -5.56968117f },
+		{ 39.9931412f, -18.9938507f, -2.3354497f },
+		{ 30.8652229f, -10.403739f, -0.295664072f },
+		{ -53.2359505f, 11.5751839f, 2.75103998f },
+		{ -28.001915f, 1.37945366f, 2.505193f },
+		{ 25.8337059f, 3.01455307f, -3.65802026f },
+	},
+	{ /* order 4 */
+		{ 33.769989f, 62.7158279f, 87.2839203f },
+		{ 97.7807312f, -24.4871902f, -98.8676682f },
+		{ -79.4873505f, 96.2007523f, -47.1986465f },
+		{ 89.0455017f, 76.2674789f, -10.1760712f },
+		{ -64.3923187f, -100.331512f, -43.3190918f },
+		{ -95.4289551f, 18.0860596f, 44.6628532f },
+		{ -97.0095215f, 0.822294235f, 27.894104f },
+		{ -26.0454865f, -57.6912498f, -14.3279028f },
+		{ 91.8032227f, -10.0575237f, -8.11111546f },
+		{ -89.4505844f, -18.1890087f, 1.27074838f },
+		{ -0.465589523f, -11.9189024f, -0.894325733f },
+		{ 86.6806335f, -14.2595644f, 0.142146945f },
+		{ 81.0276489f, -10.571703f, 2.43758631f },
+		{ 11.3202133f, -2.61080551f, -3.36660004f },
+		{ -76.1258469f, -5.7835474f, -0.788982511f },
+		{ 69.0616608f, -3.88076186f, 2.15294456f },
+	},
+	{ /* order 7 */
+		{ 24.6651535f, 49.6290207f, 72.6482544f },
+		{ 98.2993011f, 11.2401819f, -98.4829865f },
+		{ -58.9100685f, 92.512085f, -98.7556915f },
+		{ 63.8906631f, 101.98822f, 85.370224f },
+		{ -93.075058f, -52.6004562f, 82.1168747f },
+		{ -74.3247757f, 98.1901703f, -61.5906715f },
+		{ -82.2206192f, 91.0986557f, -19.4290257f },
+		{ -85.4526825f, -21.7259178f, 3.87297964f },
+		{ 80.9091568f, 39.2724762f, -2.35421968f },
+		{ -83.3551178f, 11.2403498f, 1.71381116f },
+		{ 89.5111542f, 3.97282195f, 1.69383121f },
+		{ 67.6865082f, -0.262955427f, 0.958326459f },
+		{ 51.3054962f, 4.48497295f, -1.79895294f },
+		{ 88.0860977f, -2.79743052f, 0.833612561f },
+		{ 2.72140312f, 0.365898252f, 0.440921247f },
+		{ -26.8481426f, 0.785491586f, 4.58208275f },
+	},
+};
+
+TEST(LPFilter, GoldenVectors) {
+	for (unsigned o = 0; o < sizeof(golden_orders); o++) {
+		lpfilter_state_t f = NULL;
+
+		seed = 12345;
+		lpfilter_create(&f, 80.0f, 1.0f / 1000, golden_orders[o], 3);
+
+		for (int n = 0; n < 512; n++) {
+			float s[3];
+
+			for (int a = 0; a < 3; a++)
+				s[a] = test_input(n, a);
+
+			lpfilter_run(f, s);
+
+			if (n % 32 == 31) {
+				for (int a = 0; a < 3; a++)
+					EXPECT_NEAR(golden[o][n / 32][a], s[a],
+							1e-4f * fabsf(golden[o][n / 32][a]) + 1e-4f)
+						<< "order " << (int)golden_orders[o] << " sample " << n << " axis " << a;
+			}
+		}
+	}
+}
+
+TEST(LPFilter, SingleMatchesVector) {
+	lpfilter_state_t fv = NULL, fs = NULL;
+
+	lpfilter_create(&fv, 50.0f, 1.0f / 1000, 5, 3);
+	lpfilter_create(&fs, 50.0f, 1.0f / 1000, 5, 3);
+	lpfilter_set_notch(fv, 0, 120.0f, 2.0f, 1.0f / 1000);
+	lpfilter_set_notch(fs, 0, 120.0f, 2.0f, 1.0f / 1000);
+
+	seed = 1;
+
+	for (int n = 0; n < 1000; n++) {
+		float s[3];
+
+		for (int a = 0; a < 3; a++)
+			s[a] = test_input(n, a);
+
+		float single[3];
+		for (int a = 0; a < 3; a++)
+			single[a] = lpfilter_run_single(fs, a, s[a]);
+
+		lpfilter_run(fv, s);
+
+		for (int a = 0; a < 3; a++)
+			ASSERT_EQ(s[a], single[a]);
+	}
+}
+
+/* RMS of the second half of the output for a pure tone */
+static float tone_gain(lpfilter_state_t f, float freq, float dT)
+{
+	double in_sq = 0, out_sq = 0;
+
+	for (int n = 0; n < 4000; n++) {
+		float s = sinf(2 * (float)M_PI * freq * n * dT);
+		float y = lpfilter_run_single(f, 0, s);
+
+		if (n >= 2000) {
+			in_sq += s * s;
+			out_sq += y * y;
+		}
+	}
+
+	return sqrt(out_sq / in_sq);
+}
+
+TEST(LPFilter, Notch) {
+	const float dT = 1.0f / 8000;
+	lpfilter_state_t f = NULL;
+
+	/* Bypassed lowpass, so only the notch acts */
+	lpfilter_create(&f, 0, dT, 0, 1);
+	lpfilter_set_notch(f, 1, 250.0f, 4.0f, dT);
+
+	EXPECT_LT(tone_gain(f, 250.0f, dT), 0.01f);
+	EXPECT_GT(tone_gain(f, 100.0f, dT), 0.95f);
+	EXPECT_GT(tone_gain(f, 600.0f, dT), 0.95f);
+
+	/* Disabling it passes everything again */
+	lpfilter_set_notch(f, 1, 0, 4.0f, dT);
+	EXPECT_NEAR(tone_gain(f, 250.0f, dT), 1.0f, 1e-6f);
+}
+
+TEST(LPFilter, TrackingNotch) {
+	const float dT = 1.0f / 8000;
+	lpfilter_state_t f = NULL;
+
+	lpfilter_create(&f, 0, dT, 0, 1);
+
+	/* A tone sweeping 200 -> 400Hz, with the notch retuned every
+	 * sample to follow it */
+	double phase = 0, out_sq = 0;
+	for (int n = 0; n < 16000; n++) {
+		float freq = 200.0f + 200.0f * n / 16000;
+
+		lpfilter_set_notch(f, 0, freq, 2.0f, dT);
+
+		phase += 2 * M_PI * freq * dT;
+		float y = lpfilter_run_single(f, 0, sinf(phase));
+
+		ASSERT_TRUE(isfinite(y));
+		if (n >= 800)
+			out_sq += y * y;
+	}
+
+	EXPECT_LT(sqrt(out_sq / (16000 - 800)), 0.05f);
+}
+
+/* Not a pass/fail test: reports the cost of gyro-style prefiltering on
+ * this host so changes to the filter can be compared. */
+TEST(LPFilter, DISABLED_Benchmark) {
+	const float dT = 1.0f / 8000;
+	const int iterations = 200000;
+	lpfilter_state_t f = NULL;
+	float s[3] = { 0, 0, 0 };
+
+	lpfilter_create(&f, 100.0f, dT, 4, 3);
+
+	seed = 1;
+	uint64_t t0 = ut_now_ns();
+	for (int n = 0; n < iterations; n++) {
+		s[0] += ut_noise(&seed);
+		lpfilter_run(f, s);
+	}
+	uint64_t t1 = ut_now_ns();
+
+	lpfilter_set_notch(f, 0, 180.0f, 3.0f, dT);
+	lpfilter_set_notch(f, 1, 360.0f, 3.0f, dT);
+
+	uint64_t t2 = ut_now_ns();
+	for (int n = 0; n < iterations; n++) {
+		s[0] += ut_noise(&seed);
+		lpfilter_run(f, s);
+	}
+	uint64_t t3 = ut_now_ns();
+
+	printf("3 axis 4th order lowpass:            %.1f ns per sample\n",
+			(double)(t1 - t0) / iterations);
+	printf("3 axis 4th order lowpass + 2 notch:  %.1f ns per sample\n",
+			(double)(t3 - t2) / iterations);
+
+	EXPECT_TRUE(isfinite(s[0]));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,9 @@
+/* Only what lla_to_ned() touches; it isn't exercised by the test */
+typedef struct {
+	float GeoidSeparation;
+} GPSPositionData;
+
+static inline void GPSPositionGet(GPSPositionData *data)
+{
+	memset(data, 0, sizeof(*data));
+}
@@ -0,0 +1,11 @@
+/* Only what lla_to_ned() touches; it isn't exercised by the test */
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+} HomeLocationData;
+
+static inline void HomeLocationGet(HomeLocationData *data)
+{
+	memset(data, 0, sizeof(*data));
+}
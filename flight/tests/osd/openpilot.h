@@ -0,0 +1,11 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Just what the OSD drawing code needs from the real openpilot.h */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,25 @@
+#ifndef PIOS_VIDEO_H
+#define PIOS_VIDEO_H
+
+/* The parts of the F4 pios_video.h the OSD drawing code uses, for the split
+ * buffer (mask and level plane) layout */
+struct pios_video_type_boundary {
+	uint16_t graphics_right;
+	uint16_t graphics_bottom;
+};
+
+extern const struct pios_video_type_boundary *pios_video_type_boundary_act;
+#define GRAPHICS_LEFT        0
+#define GRAPHICS_TOP         0
+#define GRAPHICS_RIGHT       pios_video_type_boundary_act->graphics_right
+#define GRAPHICS_BOTTOM      pios_video_type_boundary_act->graphics_bottom
+
+#define GRAPHICS_X_MIDDLE	((GRAPHICS_RIGHT + 1) / 2)
+#define GRAPHICS_Y_MIDDLE	((GRAPHICS_BOTTOM + 1) / 2)
+
+#define GRAPHICS_WIDTH_REAL  376
+#define GRAPHICS_HEIGHT_REAL 266
+#define BUFFER_WIDTH         (GRAPHICS_WIDTH_REAL / 8  + 1)
+#define BUFFER_HEIGHT        (GRAPHICS_HEIGHT_REAL)
+
+#endif /* PIOS_VIDEO_H */
@@ -0,0 +1,368 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* getenv, rand */
+#include <string.h>		/* memcmp */
+
+#define restrict		/* neuter restrict keyword since it's not in C++ */
+
+extern "C" {
+#include "osd_utils.h"
+#include "unittest_helpers.h"
+
+/* Single buffer primitives, not in the header */
+void write_hline(uint8_t *buff, int x0, int x1, int y, int mode);
+void write_vline(uint8_t *buff, int x, int y0, int y1, int mode);
+void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height, int mode);
+void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info);
+
+/* Normally provided by the video driver */
+const struct pios_video_type_boundary *pios_video_type_boundary_act;
+uint8_t *draw_buffer_level;
+uint8_t *draw_buffer_mask;
+uint8_t *disp_buffer_level;
+uint8_t *disp_buffer_mask;
+}
+
+#define PLANE_SIZE (BUFFER_WIDTH * BUFFER_HEIGHT)
+
+static const struct pios_video_type_boundary pal = { 359, 265 };
+
+/* Two mask/level pairs, standing in for the driver's double buffer */
+static uint8_t planes[2][2][PLANE_SIZE] __attribute__((aligned(4)));
+
+static void select_buffer(int n)
+{
+	draw_buffer_mask = planes[n][0];
+	draw_buffer_level = planes[n][1];
+}
+
+/*
+ * The per-pixel line drawing the span versions replaced, as the definition
+ * of which pixels a line covers.
+ */
+static void ref_line(int x0, int y0, int x1, int y1, int mmode,
+		int omode, int imode, int dots, bool outline)
+{
+	int steep = abs(y1 - y0) > abs(x1 - x0);
+
+	if (steep) {
+		SWAP(x0, y0);
+		SWAP(x1, y1);
+	}
+	if (x0 > x1) {
+		SWAP(x0, x1);
+		SWAP(y0, y1);
+	}
+	int deltax = x1 - x0, deltay = abs(y1 - y0);
+	int ystep = (y0 < y1) ? 1 : -1;
+
+	for (int pass = outline ? 0 : 1; pass < 2; pass++) {
+		int error = deltax / 2, y = y0, dot_cnt = 0, draw = 1;
+
+		for (int x = x0; x < x1; x++) {
+			if (dots && !(dot_cnt++ % dots))
+				draw++;
+			if (draw % 2) {
+				int px = steep ? y : x, py = steep ? x : y;
+
+				if (pass == 0) {
+					write_pixel_lm(px - 1, py, mmode, omode);
+					write_pixel_lm(px + 1, py, mmode, omode);
+					write_pixel_lm(px, py - 1, mmode, omode);
+					write_pixel_lm(px, py + 1, mmode, omode);
+				} else {
+					write_pixel_lm(px, py, mmode, imode);
+				}
+			}
+			error -= deltay;
+			if (error < 0) {
+				y += ystep;
+				error += deltax;
+			}
+		}
+	}
+}
+
+class OSDTest : public testing::Test {
+protected:
+	virtual void SetUp() {
+		pios_video_type_boundary_act = &pal;
+		memset(planes, 0, sizeof(planes));
+		srand(1234);
+	}
+
+	virtual void TearDown() {
+	}
+
+	/* Start both buffers from the same busy background */
+	void scribble() {
+		for (int i = 0; i < PLANE_SIZE; i++) {
+			planes[0][0][i] = planes[1][0][i] = rand();
+			planes[0][1][i] = planes[1][1][i] = rand();
+		}
+	}
+
+	bool same() {
+		return !memcmp(planes[0], planes[1], sizeof(planes[0]));
+	}
+
+	int coord(int range) {
+		return rand() % (range + 40) - 20;
+	}
+};
+
+TEST_F(OSDTest, LinesMatchPerPixel) {
+	for (int n = 0; n < 2000; n++) {
+		int x0 = coord(360), y0 = coord(266), x1 = coord(360), y1 = coord(266);
+		int mmode = rand() % 3, lmode = rand() % 3;
+
+		scribble();
+		select_buffer(0);
+		write_line_lm(x0, y0, x1, y1, mmode, lmode);
+		select_buffer(1);
+		ref_line(x0, y0, x1, y1, mmode, 0, lmode, 0, false);
+
+		ASSERT_TRUE(same()) << x0 << "," << y0 << " " << x1 << "," << y1;
+	}
+}
+
+TEST_F(OSDTest, OutlinedLinesMatchPerPixel) {
+	for (int n = 0; n < 2000; n++) {
+		int x0 = coord(360), y0 = coord(266), x1 = coord(360), y1 = coord(266);
+		int mode = rand() % 2, dots = (n % 3) ? 0 : rand() % 6;
+
+		scribble();
+		select_buffer(0);
+		write_line_outlined_dashed(x0, y0, x1, y1, 2, 2, mode, 1, dots);
+		select_buffer(1);
+		ref_line(x0, y0, x1, y1, 1, mode, !mode, dots, true);
+
+		ASSERT_TRUE(same()) << x0 << "," << y0 << " " << x1 << "," << y1 << " dots " << dots;
+	}
+}
+
+TEST_F(OSDTest, SpansMatchPerBuffer) {
+	for (int n = 0; n < 3000; n++) {
+		int x0 = coord(360), y0 = coord(266), x1 = coord(360), y1 = coord(266);
+		int w = rand() % 40 - 2, h = rand() % 20 - 2;
+		int mmode = rand() % 3, lmode = rand() % 3;
+
+		scribble();
+		select_buffer(0);
+		write_hline_lm(x0, x1, y0, lmode, mmode);
+		write_vline_lm(x0, y0, y1, lmode, mmode);
+		write_filled_rectangle_lm(x1, y1, w, h, lmode, mmode);
+		select_buffer(1);
+		write_hline(draw_buffer_level, x0, x1, y0, lmode);
+		write_hline(draw_buffer_mask, x0, x1, y0, mmode);
+		write_vline(draw_buffer_level, x0, y0, y1, lmode);
+		write_vline(draw_buffer_mask, x0, y0, y1, mmode);
+		write_filled_rectangle(draw_buffer_mask, x1, y1, w, h, mmode);
+		write_filled_rectangle(draw_buffer_level, x1, y1, w, h, lmode);
+
+		ASSERT_TRUE(same()) << x0 << "," << y0 << " " << x1 << "," << y1 << " " << w << "x" << h;
+	}
+}
+
+TEST_F(OSDTest, CachedStringsMatchCharacters) {
+	static const char *strs[] = {
+		"ALT 123.4m", "12:34", "HOME 1.2km", "-45", "N", "SATS 9",
+		"~#&@!", "A very long status line that won't fit the cache",
+	};
+
+	for (int n = 0; n < 1500; n++) {
+		const char *str = strs[rand() % SIZEOF_ARRAY(strs)];
+		const struct FontEntry *font_info = get_font_info(rand() % NUM_FONTS);
+		int x = coord(360), y = coord(266), xs = rand() % 3;
+
+		/* Twice, so cache hits are checked as well as fills */
+		for (int i = 0; i < 2; i++) {
+			scribble();
+			select_buffer(0);
+			write_string((char *)str, x, y, xs, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0,
+					font_info == get_font_info(0) ? 0 :
+					font_info == get_font_info(1) ? 1 :
+					font_info == get_font_info(2) ? 2 : 3);
+			select_buffer(1);
+			for (int c = 0, xx = x; str[c]; c++, xx += font_info->width + xs) {
+				if (xx >= 0 && xx < GRAPHICS_WIDTH_REAL)
+					write_char(str[c], xx, y, font_info);
+			}
+
+			ASSERT_TRUE(same()) << str << " at " << x << "," << y;
+		}
+	}
+}
+
+/* Whatever was drawn, clearing leaves each buffer blank, even with the
+ * buffers swapped part way through drawing a frame. */
+TEST_F(OSDTest, ClearUndoesDrawing) {
+	static const uint8_t blank[PLANE_SIZE] = { 0 };
+
+	for (int frame = 0; frame < 200; frame++) {
+		select_buffer(frame % 2);
+		clearGraphics();
+		ASSERT_EQ(0, memcmp(draw_buffer_mask, blank, PLANE_SIZE));
+		ASSERT_EQ(0, memcmp(draw_buffer_level, blank, PLANE_SIZE));
+
+		for (int n = 0; n < 20; n++) {
+			if (rand() % 40 == 0)
+				select_buffer(!(draw_buffer_mask == planes[1][0]));
+
+			switch (rand() % 5) {
+			case 0:
+				write_line_outlined(coord(360), coord(266), coord(360), coord(266), 2, 2, 0, 1);
+				break;
+			case 1:
+				write_filled_rectangle_lm(coord(360), coord(266), rand() % 50, rand() % 30, 1, 1);
+				break;
+			case 2:
+				write_string((char *)"123.4", coord(360), coord(266), 0, 0, TEXT_VA_TOP, TEXT_HA_LEFT, 0, rand() % NUM_FONTS);
+				break;
+			case 3:
+				write_hline_outlined(coord(360), coord(360), coord(266), 2, 2, 0, 1);
+				break;
+			case 4:
+				write_vline_outlined(coord(360), coord(266), coord(266), 2, 2, 1, 1);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * Something like a busy page: scales, a compass strip, the horizon ladder,
+ * an airplane symbol and a couple of dozen strings, a few of which change
+ * every frame.
+ */
+static void draw_page(int frame)
+{
+	static const point_t plane[] = { {0, -10}, {8, 8}, {0, 4}, {-8, 8} };
+	char buf[16];
+
+	clearGraphics();
+
+	for (int i = 0; i < 2; i++) {
+		int x = i ? 330 : 30;
+
+		write_vline_outlined(x, 60, 200, 2, 2, 0, 1);
+		for (int y = 60 + (frame % 10); y < 200; y += 10)
+			write_hline_outlined(x - 4, x + 4, y, 2, 2, 0, 1);
+		sprintf(buf, "%d", 100 + frame % 37);
+		write_string(buf, x, 130, 0, 0, TEXT_VA_MIDDLE, TEXT_HA_CENTER, 0, FONT_OUTLINED8X14);
+	}
+
+	write_hline_outlined(100, 260, 20, 2, 2, 0, 1);
+	for (int x = 100 + (frame % 15); x < 260; x += 15) {
+		write_vline_outlined(x, 20, 26, 2, 2, 0, 1);
+		write_string((char *)"N", x, 30, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, FONT8X10);
+	}
+
+	float roll = (frame % 60) - 30;
+	for (int step = -3; step <= 3; step++) {
+		float s = sinf(roll * (float)M_PI / 180), c = cosf(roll * (float)M_PI / 180);
+		int cx = 180 - s * step * 30, cy = 133 + c * step * 30;
+		int dx = c * 40, dy = s * 40;
+
+		if (step < 0)
+			write_line_outlined_dashed(cx - dx, cy - dy, cx + dx, cy + dy, 2, 2, 0, 1, 5);
+		else
+			write_line_outlined(cx - dx, cy - dy, cx + dx, cy + dy, 2, 2, 0, 1);
+	}
+	draw_polygon(180, 133, frame % 360, plane, SIZEOF_ARRAY(plane), 0, 1);
+
+	for (int i = 0; i < 20; i++) {
+		if (i < 4)
+			sprintf(buf, "V%d %d.%d", i, frame % 100, i);
+		else
+			sprintf(buf, "LABEL %d", i);
+		write_string(buf, 50 + (i % 2) * 200, 40 + (i / 2) * 20, 0, 0,
+				TEXT_VA_TOP, TEXT_HA_LEFT, 0, (i % 3) ? FONT8X10 : FONT_OUTLINED8X14);
+	}
+}
+
+static void write_ppm(const char *name)
+{
+	FILE *f = fopen(name, "w");
+
+	if (!f)
+		return;
+
+	fprintf(f, "P6 %d %d 255\n", GRAPHICS_WIDTH_REAL, BUFFER_HEIGHT);
+	for (int y = 0; y < BUFFER_HEIGHT; y++) {
+		for (int x = 0; x < GRAPHICS_WIDTH_REAL; x++) {
+			int addr = y * BUFFER_WIDTH + x / 8, bit = 0x80 >> (x & 7);
+			uint8_t v = !(draw_buffer_mask[addr] & bit) ? 0x80 :
+					(draw_buffer_level[addr] & bit) ? 0xff : 0x00;
+
+			fputc(v, f);
+			fputc(v, f);
+			fputc(v, f);
+		}
+	}
+	fclose(f);
+}
+
+/* Not a pass/fail test: reports the cost of clearing and drawing a page on
+ * this host, to compare changes to the drawing code.  Set OSD_PPM to a file
+ * name to look at the page. */
+TEST_F(OSDTest, DISABLED_PageBenchmark) {
+	const int frames = 500;
+	uint64_t best = UINT64_MAX;
+
+	/* Best of a few passes, hosts are noisy */
+	for (int pass = 0; pass < 5; pass++) {
+		uint64_t t0 = ut_now_ns();
+		for (int frame = 0; frame < frames; frame++) {
+			select_buffer(frame % 2);
+			draw_page(frame);
+		}
+		uint64_t t = ut_now_ns() - t0;
+
+		if (t < best)
+			best = t;
+	}
+
+	printf("page: %.1f us per frame\n", (double)best / frames / 1000);
+
+	if (getenv("OSD_PPM"))
+		write_ppm(getenv("OSD_PPM"));
+}
+
+/**
+ * @}
+ * @}
+ */
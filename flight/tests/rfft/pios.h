@@ -0,0 +1,5 @@
+#include <stdlib.h>
+
+/* Would be from pios_heap.h / pios_debug.h but those pull on way too many dependencies */
+#define PIOS_malloc_no_dma(size) malloc(size)
+#define PIOS_Assert(x) if (!(x)) { abort(); }
@@ -0,0 +1,153 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* sin, cos */
+
+extern "C" {
+#include "rfft.h"
+#include "unittest_helpers.h"
+}
+
+static uint32_t seed;
+
+/* Bin k of the transform, unpacked from the CMSIS style layout */
+static void bin(const float *buf, uint16_t n, uint16_t k, double *re, double *im)
+{
+	if (k == 0) {
+		*re = buf[0];
+		*im = 0;
+	} else if (k == n / 2) {
+		*re = buf[1];
+		*im = 0;
+	} else {
+		*re = buf[2 * k];
+		*im = buf[2 * k + 1];
+	}
+}
+
+TEST(RFFT, RejectsBadLengths) {
+	EXPECT_EQ(NULL, rfft_create(0));
+	EXPECT_EQ(NULL, rfft_create(4));
+	EXPECT_EQ(NULL, rfft_create(100));
+	EXPECT_EQ(NULL, rfft_create(8192));
+}
+
+TEST(RFFT, MatchesDFT) {
+	float x[1024], buf[1024];
+
+	seed = 1;
+
+	for (uint16_t n = 8; n <= 1024; n *= 2) {
+		rfft_state_t fft = rfft_create(n);
+		ASSERT_TRUE(fft != NULL);
+
+		for (int i = 0; i < n; i++)
+			x[i] = buf[i] = ut_noise(&seed);
+
+		rfft_run(fft, buf);
+
+		for (int k = 0; k <= n / 2; k++) {
+			double re = 0, im = 0;
+
+			for (int i = 0; i < n; i++) {
+				re += x[i] * cos(2 * M_PI * k * i / n);
+				im -= x[i] * sin(2 * M_PI * k * i / n);
+			}
+
+			double got_re, got_im;
+			bin(buf, n, k, &got_re, &got_im);
+
+			EXPECT_NEAR(re, got_re, 1e-5 * n) << "n " << n << " bin " << k;
+			EXPECT_NEAR(im, got_im, 1e-5 * n) << "n " << n << " bin " << k;
+		}
+	}
+}
+
+TEST(RFFT, SineLandsInItsBin) {
+	const uint16_t n = 256;
+	float buf[n];
+	rfft_state_t fft = rfft_create(n);
+
+	for (int i = 0; i < n; i++)
+		buf[i] = 3.0f * sinf(2 * (float) M_PI * 37 * i / n);
+
+	rfft_run(fft, buf);
+
+	for (int k = 0; k <= n / 2; k++) {
+		double re, im;
+		bin(buf, n, k, &re, &im);
+
+		double mag = sqrt(re * re + im * im);
+
+		if (k == 37)
+			EXPECT_NEAR(3.0 * n / 2, mag, 1e-3 * n);
+		else
+			EXPECT_LT(mag, 1e-3 * n);
+	}
+}
+
+/* Not a pass/fail test: reports the cost of the window sizes the vibration
+ * analysis uses on this host. */
+TEST(RFFT, DISABLED_Benchmark) {
+	float buf[256];
+	float sum = 0;
+
+	seed = 1;
+
+	for (uint16_t n = 16; n <= 256; n *= 4) {
+		const int iterations = 2000000 / n;
+		rfft_state_t fft = rfft_create(n);
+
+		uint64_t t0 = ut_now_ns();
+		for (int it = 0; it < iterations; it++) {
+			for (int i = 0; i < n; i++)
+				buf[i] = ut_noise(&seed);
+			rfft_run(fft, buf);
+			sum += buf[2];
+		}
+		uint64_t t1 = ut_now_ns();
+
+		printf("%4d point real FFT (with input generation): %.0f ns\n",
+				n, (double)(t1 - t0) / iterations);
+	}
+
+	EXPECT_TRUE(isfinite(sum));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <time.h>		/* clock_gettime */
+#include <unistd.h>		/* usleep */
+
+extern "C" {
+#include "pios.h"
+#include "pios_vtime.h"
+}
+
+/*
+ * A thread that uses a known amount of stack and CPU checks what it is
+ * charged with.
+ */
+
+static struct pios_thread *acct_thread;
+static uint32_t acct_runtime_us;
+static uint32_t acct_stack_remaining;
+static volatile bool acct_done;
+
+static uint32_t __attribute__((noinline)) use_stack(int depth)
+{
+	volatile uint8_t buf[1024];
+
+	memset((void *) buf, depth, sizeof(buf));
+
+	if (depth > 1) {
+		return buf[depth] + use_stack(depth - 1);
+	}
+
+	return buf[0];
+}
+
+static void acct_task(void *)
+{
+	use_stack(8);
+
+	struct timespec start, now;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+
+	do {
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000LL +
+			(now.tv_nsec - start.tv_nsec) < 20000000);
+
+	acct_runtime_us = PIOS_Thread_Get_Runtime(acct_thread);
+	acct_stack_remaining = PIOS_Thread_Get_Stack_Usage(acct_thread);
+
+	acct_done = true;
+}
+
+static void acct_init_task(void *)
+{
+	/* Lower priority, so it only runs once the handle is stored */
+	acct_thread = PIOS_Thread_Create(acct_task, "acct", 16384, NULL,
+			PIOS_THREAD_PRIO_LOW);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class ThreadStats : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(ThreadStats, RuntimeAndStack) {
+  acct_done = false;
+
+  PIOS_VTIME_Enable();
+
+  PIOS_Thread_Create(acct_init_task, "init", PIOS_THREAD_STACK_SIZE_MIN,
+      NULL, PIOS_THREAD_PRIO_HIGHEST);
+
+  while (!acct_done) {
+    usleep(1000);
+  }
+
+  usleep(10000);
+
+  EXPECT_GE(acct_runtime_us, 20000U);
+  EXPECT_LT(acct_runtime_us, 200000U);
+
+  /* 8k of frames out of 16k */
+  EXPECT_GT(acct_stack_remaining, 4096U);
+  EXPECT_LT(acct_stack_remaining, 16384U - 8192U);
+}
@@ -0,0 +1,8 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <pios.h>
+
+#include "uavobjectmanager.h"
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,20 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include <pios_thread.h>
+#include <pios_mutex.h>
+#include <pios_queue.h>
+#include <pios_flashfs.h>
+#include <pios_heap.h>
+#include <pios_delay.h>
+
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
@@ -0,0 +1,810 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <pthread.h>		/* pthread_* */
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* nanosleep */
+
+extern "C" {
+#include "openpilot.h"
+}
+
+#include "unittest_helpers.h"
+
+#define TEST_OBJ_ID       0xB3AFA3C4
+#define TEST_MULTI_OBJ_ID 0x65F74BDA
+
+/* Same shape as Gyros: a handful of floats updated at loop rate */
+struct test_obj {
+	float x;
+	float y;
+	float z;
+	float temperature;
+};
+
+static void test_obj_init(UAVObjHandle obj_handle, uint16_t instId)
+{
+	struct test_obj data;
+
+	memset(&data, 0, sizeof(data));
+	data.temperature = 25.0f;
+
+	UAVObjSetInstanceData(obj_handle, instId, &data);
+}
+
+static void count_cb(UAVObjEvent *, void *ctx, void *obj, int len)
+{
+	struct test_obj *last = (struct test_obj *) ctx;
+
+	memcpy(last, obj, len);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class ObjMgr : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(ObjMgr, RegisterAndLookup) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  /* Duplicate registration is refused */
+  EXPECT_TRUE(UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init) == NULL);
+
+  EXPECT_EQ(obj, UAVObjGetByID(TEST_OBJ_ID));
+  EXPECT_EQ(UAVObjGetLinkedObj(obj), UAVObjGetByID(TEST_OBJ_ID + 1));
+  EXPECT_TRUE(UAVObjGetByID(TEST_OBJ_ID + 2) == NULL);
+
+  EXPECT_EQ(TEST_OBJ_ID, UAVObjGetID(obj));
+  EXPECT_EQ(sizeof(struct test_obj), UAVObjGetNumBytes(obj));
+}
+
+TEST_F(ObjMgr, SetGetData) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct test_obj data;
+  ASSERT_EQ(0, UAVObjGetData(obj, &data));
+  EXPECT_EQ(25.0f, data.temperature);
+
+  data.x = 1.0f; data.y = 2.0f; data.z = 3.0f;
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+
+  float y = 0;
+  ASSERT_EQ(0, UAVObjGetDataField(obj, &y, offsetof(struct test_obj, y),
+      sizeof(y)));
+  EXPECT_EQ(2.0f, y);
+
+  float z = 9.0f;
+  ASSERT_EQ(0, UAVObjSetDataField(obj, &z, offsetof(struct test_obj, z),
+      sizeof(z)));
+  ASSERT_EQ(0, UAVObjGetData(obj, &data));
+  EXPECT_EQ(9.0f, data.z);
+
+  /* Reads past the end of the object and of missing instances fail */
+  EXPECT_EQ(-1, UAVObjGetDataField(obj, &y, sizeof(struct test_obj),
+      sizeof(y)));
+  EXPECT_EQ(-1, UAVObjGetInstanceData(obj, 1, &data));
+
+  /* Packing goes through the same path */
+  uint8_t packed[sizeof(struct test_obj)];
+  ASSERT_EQ(0, UAVObjPack(obj, 0, packed));
+  EXPECT_EQ(0, memcmp(packed, &data, sizeof(data)));
+}
+
+TEST_F(ObjMgr, MultiInstance) {
+  UAVObjHandle obj = UAVObjRegister(TEST_MULTI_OBJ_ID, false, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  for (uint16_t i = 1; i < 8; i++) {
+    EXPECT_EQ(i, UAVObjCreateInstance(obj, test_obj_init));
+  }
+  EXPECT_EQ(8, UAVObjGetNumInstances(obj));
+
+  struct test_obj data;
+  for (uint16_t i = 0; i < 8; i++) {
+    memset(&data, 0, sizeof(data));
+    data.x = i;
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, i, &data));
+  }
+
+  for (uint16_t i = 0; i < 8; i++) {
+    ASSERT_EQ(0, UAVObjGetInstanceData(obj, i, &data));
+    EXPECT_EQ((float) i, data.x);
+  }
+
+  /* Unpacking a later instance fills in the gap */
+  data.x = 42.0f;
+  ASSERT_EQ(0, UAVObjUnpack(obj, 11, (const uint8_t *) &data));
+  EXPECT_EQ(12, UAVObjGetNumInstances(obj));
+  ASSERT_EQ(0, UAVObjGetInstanceData(obj, 11, &data));
+  EXPECT_EQ(42.0f, data.x);
+}
+
+TEST_F(ObjMgr, CallbackSeesUpdate) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct test_obj last;
+  memset(&last, 0, sizeof(last));
+
+  ASSERT_EQ(0, UAVObjConnectCallback(obj, count_cb, &last,
+      EV_MASK_ALL_UPDATES));
+
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+  data.x = 7.0f;
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+  EXPECT_EQ(7.0f, last.x);
+
+  ASSERT_EQ(0, UAVObjDisconnectCallback(obj, count_cb, &last));
+  data.x = 8.0f;
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+  EXPECT_EQ(7.0f, last.x);
+}
+
+struct blocking_cb_ctx {
+  UAVObjHandle obj;
+  volatile bool blocked;
+  volatile bool other_wrote;
+  pthread_t writer;
+};
+
+static void *blocked_cb_writer(void *arg)
+{
+  struct blocking_cb_ctx *ctx = (struct blocking_cb_ctx *) arg;
+  struct test_obj data;
+
+  memset(&data, 0, sizeof(data));
+  data.x = 2.0f;
+
+  /* Lands while the callback is still running; only the dispatch of
+   * its own event has to wait for it */
+  UAVObjSetData(ctx->obj, &data);
+
+  return NULL;
+}
+
+static void blocking_cb(UAVObjEvent *, void *cb_ctx, void *, int)
+{
+  struct blocking_cb_ctx *ctx = (struct blocking_cb_ctx *) cb_ctx;
+
+  if (ctx->blocked) {
+    return;
+  }
+
+  ctx->blocked = true;
+
+  pthread_create(&ctx->writer, NULL, blocked_cb_writer, ctx);
+
+  struct test_obj data;
+  uint64_t give_up = ut_now_ns() + 2000000000ULL;
+
+  do {
+    UAVObjGetData(ctx->obj, &data);
+  } while (data.x != 2.0f && ut_now_ns() < give_up);
+
+  ctx->other_wrote = (data.x == 2.0f);
+}
+
+TEST_F(ObjMgr, CallbackOutsideDataLock) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct blocking_cb_ctx ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.obj = obj;
+
+  ASSERT_EQ(0, UAVObjConnectCallback(obj, blocking_cb, &ctx,
+      EV_MASK_ALL_UPDATES));
+
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+  data.x = 1.0f;
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+
+  ASSERT_TRUE(ctx.blocked);
+  pthread_join(ctx.writer, NULL);
+
+  EXPECT_TRUE(ctx.other_wrote);
+
+  ASSERT_EQ(0, UAVObjDisconnectCallback(obj, blocking_cb, &ctx));
+}
+
+TEST_F(ObjMgr, TracedSetCarriesOrigin) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct pios_queue *queue = PIOS_Queue_Create(2, sizeof(UAVObjEvent));
+  ASSERT_TRUE(queue != NULL);
+  ASSERT_EQ(0, UAVObjConnectQueue(obj, queue, EV_MASK_ALL_UPDATES));
+
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+
+  /* A plain update is its own origin */
+  uint32_t before = PIOS_DELAY_GetRaw();
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+
+  UAVObjEvent ev;
+  ASSERT_TRUE(PIOS_Queue_Receive(queue, &ev, 0));
+  EXPECT_LE(before, ev.timestamp);
+  EXPECT_LE(ev.timestamp, PIOS_DELAY_GetRaw());
+  EXPECT_EQ(ev.timestamp, ev.origin);
+
+  /* A traced one passes its origin on, and is stamped when fired */
+  uint32_t origin = before - 1234;
+  ASSERT_EQ(0, UAVObjSetDataTraced(obj, &data, origin));
+
+  ASSERT_TRUE(PIOS_Queue_Receive(queue, &ev, 0));
+  EXPECT_EQ(EV_UPDATED, ev.event);
+  EXPECT_EQ(origin, ev.origin);
+  EXPECT_LE(before, ev.timestamp);
+}
+
+TEST_F(ObjMgr, RingCoalesces) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct UAVObjEventRing *ring = UAVObjEventRingCreate(4);
+  ASSERT_TRUE(ring != NULL);
+
+  ASSERT_EQ(0, UAVObjConnectRing(obj, ring, EV_MASK_ALL_UPDATES));
+
+  UAVObjEvent ev;
+  EXPECT_FALSE(UAVObjEventRingReceive(ring, &ev, 0));
+
+  /* A burst of updates with nobody reading gives one event */
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+  for (int i = 0; i < 100; i++) {
+    data.x = i;
+    ASSERT_EQ(0, UAVObjSetData(obj, &data));
+  }
+
+  ASSERT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+  EXPECT_EQ(obj, ev.obj);
+  EXPECT_EQ(0, ev.instId);
+  EXPECT_EQ(EV_UPDATED, ev.event);
+  EXPECT_FALSE(UAVObjEventRingReceive(ring, &ev, 0));
+
+  /* ... and the reader sees the latest data */
+  ASSERT_EQ(0, UAVObjGetData(obj, &data));
+  EXPECT_EQ(99.0f, data.x);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(99U, stats.eventRingCoalesced);
+  EXPECT_EQ(0U, stats.eventRingDrops);
+
+  /* Once consumed, the next update is queued again */
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+  EXPECT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+
+  ASSERT_EQ(0, UAVObjDisconnectRing(obj, ring));
+  ASSERT_EQ(0, UAVObjSetData(obj, &data));
+  EXPECT_FALSE(UAVObjEventRingReceive(ring, &ev, 0));
+  EXPECT_EQ(-1, UAVObjDisconnectRing(obj, ring));
+}
+
+TEST_F(ObjMgr, RingDropsWhenFull) {
+  UAVObjHandle obj = UAVObjRegister(TEST_MULTI_OBJ_ID, false, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  for (uint16_t i = 1; i < 8; i++) {
+    ASSERT_EQ(i, UAVObjCreateInstance(obj, test_obj_init));
+  }
+
+  struct UAVObjEventRing *ring = UAVObjEventRingCreate(4);
+  ASSERT_TRUE(ring != NULL);
+
+  ASSERT_EQ(0, UAVObjConnectRing(obj, ring, EV_UPDATED));
+
+  /* Distinct instances can't be coalesced */
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+  for (uint16_t i = 0; i < 8; i++) {
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, i, &data));
+  }
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(4U, stats.eventRingDrops);
+  EXPECT_EQ(4U, stats.eventQueueErrors);
+  EXPECT_EQ((uint32_t) TEST_MULTI_OBJ_ID, stats.lastQueueErrorID);
+
+  UAVObjEvent ev;
+  for (uint16_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+    EXPECT_EQ(i, ev.instId);
+  }
+  EXPECT_FALSE(UAVObjEventRingReceive(ring, &ev, 0));
+}
+
+TEST_F(ObjMgr, RingCoalescesAfterInterleaving) {
+  UAVObjHandle obj = UAVObjRegister(TEST_MULTI_OBJ_ID, false, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+  ASSERT_EQ(1, UAVObjCreateInstance(obj, test_obj_init));
+
+  struct UAVObjEventRing *ring = UAVObjEventRingCreate(4);
+  ASSERT_TRUE(ring != NULL);
+
+  ASSERT_EQ(0, UAVObjConnectRing(obj, ring, EV_MASK_ALL_UPDATES));
+
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+  ASSERT_EQ(0, UAVObjSetInstanceData(obj, 0, &data));
+  ASSERT_EQ(0, UAVObjSetInstanceData(obj, 1, &data));
+
+  /* Taking the older event off must not stop updates coalescing into
+   * the newer one that is still queued */
+  UAVObjEvent ev;
+  ASSERT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+  EXPECT_EQ(0, ev.instId);
+
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(0, UAVObjSetInstanceData(obj, 1, &data));
+  }
+
+  ASSERT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+  EXPECT_EQ(1, ev.instId);
+  EXPECT_FALSE(UAVObjEventRingReceive(ring, &ev, 0));
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(10U, stats.eventRingCoalesced);
+  EXPECT_EQ(0U, stats.eventRingDrops);
+
+  /* ... and once that is taken too, the next update is queued */
+  ASSERT_EQ(0, UAVObjSetInstanceData(obj, 1, &data));
+  EXPECT_TRUE(UAVObjEventRingReceive(ring, &ev, 0));
+}
+
+#define RING_UPDATES 200000
+
+struct ring_ctx {
+  UAVObjHandle obj;
+  struct UAVObjEventRing *ring;
+  unsigned long long received;
+  float last_x;
+};
+
+static void *ring_consumer(void *arg)
+{
+  struct ring_ctx *ctx = (struct ring_ctx *) arg;
+
+  UAVObjEvent ev;
+  struct test_obj data;
+
+  while (UAVObjEventRingReceive(ctx->ring, &ev, 1000)) {
+    ctx->received++;
+
+    UAVObjGetData(ctx->obj, &data);
+    ctx->last_x = data.x;
+
+    if (data.x == RING_UPDATES) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+TEST_F(ObjMgr, RingProducerConsumer) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  struct ring_ctx ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.obj = obj;
+  ctx.ring = UAVObjEventRingCreate(8);
+  ASSERT_TRUE(ctx.ring != NULL);
+
+  ASSERT_EQ(0, UAVObjConnectRing(obj, ctx.ring, EV_MASK_ALL_UPDATES));
+
+  pthread_t consumer;
+  ASSERT_EQ(0, pthread_create(&consumer, NULL, ring_consumer, &ctx));
+
+  struct test_obj data;
+  memset(&data, 0, sizeof(data));
+
+  uint64_t start = ut_now_ns();
+  for (int i = 1; i <= RING_UPDATES; i++) {
+    data.x = i;
+    UAVObjSetData(obj, &data);
+  }
+  uint64_t elapsed = ut_now_ns() - start;
+
+  pthread_join(consumer, NULL);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+
+  printf("ring: %d updates, %llu events, %u coalesced, %u dropped, "
+      "%llu ns/update\n", RING_UPDATES, ctx.received,
+      stats.eventRingCoalesced, stats.eventRingDrops,
+      (unsigned long long) (elapsed / RING_UPDATES));
+
+  /* No update is ever lost to coalescing: the consumer always ends up
+   * seeing the final value. */
+  EXPECT_EQ((float) RING_UPDATES, ctx.last_x);
+  EXPECT_EQ(0U, stats.eventRingDrops);
+  EXPECT_EQ((unsigned long long) RING_UPDATES,
+      ctx.received + stats.eventRingCoalesced);
+}
+
+/*
+ * Dispatch benchmark.  Registers as many objects as the flight code
+ * defines (IDs are hashes, so pseudo-random even values stand in for
+ * them) and measures the cost of the lookup + unpack that UAVTalk does
+ * for every received object packet.
+ */
+
+#define BENCH_NUM_OBJECTS 130
+#define BENCH_MULTI_INSTANCES 64
+#define BENCH_PACKETS 1000000
+
+TEST_F(ObjMgr, DISABLED_DispatchBenchmark) {
+  static UAVObjHandle handles[BENCH_NUM_OBJECTS];
+  static uint32_t ids[BENCH_NUM_OBJECTS];
+  uint32_t seed = 0x5eed;
+
+  for (int i = 0; i < BENCH_NUM_OBJECTS; i++) {
+    do {
+      ids[i] = ut_rand(&seed) & 0xFFFFFFFE;
+    } while (UAVObjGetByID(ids[i]) || UAVObjGetByID(ids[i] + 1));
+
+    /* A few multi-instance objects, like Waypoint */
+    bool single = (i % 40) != 0;
+    uint32_t size = 4 + (ut_rand(&seed) % 200);
+
+    handles[i] = UAVObjRegister(ids[i], single, false, size, NULL);
+    ASSERT_TRUE(handles[i] != NULL);
+
+    if (!single) {
+      for (int j = 1; j < BENCH_MULTI_INSTANCES; j++) {
+        ASSERT_EQ(j, UAVObjCreateInstance(handles[i], NULL));
+      }
+    }
+  }
+
+  EXPECT_EQ(BENCH_NUM_OBJECTS, UAVObjCount());
+
+  for (int i = 0; i < BENCH_NUM_OBJECTS; i++) {
+    EXPECT_EQ(handles[i], UAVObjGetByID(ids[i]));
+    EXPECT_EQ(UAVObjGetLinkedObj(handles[i]), UAVObjGetByID(ids[i] + 1));
+  }
+
+  /* Pre-generate the packet stream so only dispatch is timed */
+  static uint32_t pkt_id[BENCH_PACKETS];
+  static uint16_t pkt_inst[BENCH_PACKETS];
+
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    int idx = ut_rand(&seed) % BENCH_NUM_OBJECTS;
+
+    pkt_id[i] = ids[idx];
+    pkt_inst[i] = UAVObjGetNumInstances(handles[idx]) - 1;
+  }
+
+  uint8_t buf[256];
+  memset(buf, 0, sizeof(buf));
+
+  /* Reference: the previous linear walk of the object list */
+  uint64_t start = ut_now_ns();
+  uint32_t found = 0;
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    for (int j = 0; j < BENCH_NUM_OBJECTS; j++) {
+      if (UAVObjGetID(handles[j]) == pkt_id[i]) {
+        found++;
+        break;
+      }
+    }
+  }
+  uint64_t linear_ns = ut_now_ns() - start;
+  EXPECT_EQ((uint32_t) BENCH_PACKETS, found);
+
+  start = ut_now_ns();
+  found = 0;
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    if (UAVObjGetByID(pkt_id[i])) {
+      found++;
+    }
+  }
+  uint64_t hashed_ns = ut_now_ns() - start;
+  EXPECT_EQ((uint32_t) BENCH_PACKETS, found);
+
+  start = ut_now_ns();
+  for (int i = 0; i < BENCH_PACKETS; i++) {
+    UAVObjHandle obj = UAVObjGetByID(pkt_id[i]);
+
+    ASSERT_EQ(0, UAVObjUnpack(obj, pkt_inst[i], buf));
+  }
+  uint64_t dispatch_ns = ut_now_ns() - start;
+
+  printf("%d objects, %d packets\n", BENCH_NUM_OBJECTS, BENCH_PACKETS);
+  printf("  linear lookup:     %6.1f ns/packet\n",
+      (double) linear_ns / BENCH_PACKETS);
+  printf("  hashed lookup:     %6.1f ns/packet\n",
+      (double) hashed_ns / BENCH_PACKETS);
+  printf("  lookup + unpack:   %6.1f ns/packet\n",
+      (double) dispatch_ns / BENCH_PACKETS);
+}
+
+/*
+ * Contention benchmark.  One writer publishes at full speed while several
+ * readers poll the object, as the stabilization/telemetry/logging tasks do
+ * with Gyros and AttitudeActual.  Every field of a sample carries the same
+ * value, so a torn read is detectable.
+ *
+ * The "locked" run emulates the previous global-mutex behaviour by forcing
+ * readers and writers through one shared mutex; the "lockless" run uses the
+ * object manager as-is.
+ */
+
+#define HIST_BUCKETS 24		/* log2 buckets of nanoseconds */
+#define BENCH_READERS 3
+#define BENCH_DURATION_NS 250000000ULL
+
+struct histogram {
+  uint64_t bucket[HIST_BUCKETS];
+  uint64_t count;
+  uint64_t max;
+};
+
+static void hist_add(struct histogram *h, uint64_t ns)
+{
+  int b = 0;
+
+  while ((ns >> (b + 1)) && (b < HIST_BUCKETS - 1)) {
+    b++;
+  }
+
+  h->bucket[b]++;
+  h->count++;
+
+  if (ns > h->max) {
+    h->max = ns;
+  }
+}
+
+static uint64_t hist_percentile(const struct histogram *h, int pct)
+{
+  uint64_t want = (h->count * pct + 99) / 100;
+  uint64_t seen = 0;
+
+  for (int b = 0; b < HIST_BUCKETS; b++) {
+    seen += h->bucket[b];
+
+    if (seen >= want) {
+      return 2ULL << b;
+    }
+  }
+
+  return h->max;
+}
+
+static void hist_print(const char *name, const struct histogram *h)
+{
+  printf("  %-16s n=%-9llu p50<%-6llu p99<%-6llu max=%llu ns\n", name,
+      (unsigned long long) h->count,
+      (unsigned long long) hist_percentile(h, 50),
+      (unsigned long long) hist_percentile(h, 99),
+      (unsigned long long) h->max);
+
+  for (int b = 0; b < HIST_BUCKETS; b++) {
+    if (h->bucket[b]) {
+      printf("    <%9llu ns: %llu\n", 2ULL << b,
+          (unsigned long long) h->bucket[b]);
+    }
+  }
+}
+
+struct bench_ctx {
+  UAVObjHandle obj;
+  bool emulate_global_lock;
+  pthread_mutex_t global_lock;
+  volatile bool stop;
+  volatile unsigned long long torn_reads;
+
+  struct histogram write_wait;
+  struct histogram write_hold;
+  struct histogram read[BENCH_READERS];
+};
+
+struct reader_arg {
+  struct bench_ctx *ctx;
+  int idx;
+};
+
+static void *bench_writer(void *arg)
+{
+  struct bench_ctx *ctx = (struct bench_ctx *) arg;
+  struct test_obj data;
+  float value = 0;
+
+  while (!ctx->stop) {
+    value += 1.0f;
+    data.x = data.y = data.z = data.temperature = value;
+
+    uint64_t start = ut_now_ns();
+
+    if (ctx->emulate_global_lock) {
+      pthread_mutex_lock(&ctx->global_lock);
+    }
+
+    uint64_t locked = ut_now_ns();
+
+    UAVObjSetData(ctx->obj, &data);
+
+    if (ctx->emulate_global_lock) {
+      pthread_mutex_unlock(&ctx->global_lock);
+    }
+
+    uint64_t done = ut_now_ns();
+
+    hist_add(&ctx->write_wait, locked - start);
+    hist_add(&ctx->write_hold, done - locked);
+  }
+
+  return NULL;
+}
+
+static void *bench_reader(void *arg)
+{
+  struct reader_arg *rarg = (struct reader_arg *) arg;
+  struct bench_ctx *ctx = rarg->ctx;
+  struct test_obj data;
+
+  while (!ctx->stop) {
+    uint64_t start = ut_now_ns();
+
+    if (ctx->emulate_global_lock) {
+      pthread_mutex_lock(&ctx->global_lock);
+    }
+
+    UAVObjGetData(ctx->obj, &data);
+
+    if (ctx->emulate_global_lock) {
+      pthread_mutex_unlock(&ctx->global_lock);
+    }
+
+    hist_add(&ctx->read[rarg->idx], ut_now_ns() - start);
+
+    if ((data.x != data.y) || (data.y != data.z) ||
+        (data.z != data.temperature)) {
+      __sync_fetch_and_add(&ctx->torn_reads, 1);
+    }
+  }
+
+  return NULL;
+}
+
+static void run_bench(UAVObjHandle obj, bool emulate_global_lock,
+    bool report, unsigned long long *torn_reads)
+{
+  struct bench_ctx *ctx = new bench_ctx();
+  struct reader_arg rargs[BENCH_READERS];
+  pthread_t writer, readers[BENCH_READERS];
+
+  ctx->obj = obj;
+  ctx->emulate_global_lock = emulate_global_lock;
+  pthread_mutex_init(&ctx->global_lock, NULL);
+
+  pthread_create(&writer, NULL, bench_writer, ctx);
+  for (int i = 0; i < BENCH_READERS; i++) {
+    rargs[i].ctx = ctx;
+    rargs[i].idx = i;
+    pthread_create(&readers[i], NULL, bench_reader, &rargs[i]);
+  }
+
+  uint64_t end = ut_now_ns() + BENCH_DURATION_NS;
+  while (ut_now_ns() < end) {
+    struct timespec ts = { 0, 10000000 };
+    nanosleep(&ts, NULL);
+  }
+
+  ctx->stop = true;
+
+  pthread_join(writer, NULL);
+  for (int i = 0; i < BENCH_READERS; i++) {
+    pthread_join(readers[i], NULL);
+  }
+
+  if (report) {
+    printf("%s reads:\n", emulate_global_lock ? "Global lock" : "Lockless");
+    hist_print("writer wait", &ctx->write_wait);
+    hist_print("writer hold", &ctx->write_hold);
+
+    for (int i = 0; i < BENCH_READERS; i++) {
+      char name[32];
+      snprintf(name, sizeof(name), "reader %d", i);
+      hist_print(name, &ctx->read[i]);
+    }
+  }
+
+  *torn_reads = ctx->torn_reads;
+
+  pthread_mutex_destroy(&ctx->global_lock);
+  delete ctx;
+}
+
+TEST_F(ObjMgr, ConcurrentReadsNotTorn) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  unsigned long long torn_reads;
+
+  run_bench(obj, false, false, &torn_reads);
+  EXPECT_EQ(0ULL, torn_reads);
+}
+
+TEST_F(ObjMgr, DISABLED_ContentionBenchmark) {
+  UAVObjHandle obj = UAVObjRegister(TEST_OBJ_ID, true, false,
+      sizeof(struct test_obj), test_obj_init);
+  ASSERT_TRUE(obj != NULL);
+
+  unsigned long long torn_reads;
+
+  run_bench(obj, true, true, &torn_reads);
+  EXPECT_EQ(0ULL, torn_reads);
+
+  run_bench(obj, false, true, &torn_reads);
+  EXPECT_EQ(0ULL, torn_reads);
+}
+
+/**
+ * @}
+ * @}
+ */
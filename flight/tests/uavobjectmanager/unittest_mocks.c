@@ -0,0 +1,61 @@
+/*
+ * Minimal stand-ins for the PiOS services the object manager depends on,
+ * so that it can be exercised on the host.
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "pios.h"
+
+uintptr_t pios_uavo_settings_fs_id;
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void * PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void * buf)
+{
+	free(buf);
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	struct timespec monotime;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime);
+
+	return monotime.tv_sec * 1000 + monotime.tv_nsec / 1000000;
+}
+
+/* Raw delay ticks are microseconds here */
+uint32_t PIOS_DELAY_GetRaw(void)
+{
+	struct timespec monotime;
+
+	clock_gettime(CLOCK_MONOTONIC, &monotime);
+
+	return monotime.tv_sec * 1000000 + monotime.tv_nsec / 1000;
+}
+
+/* No settings storage; every object comes up with its defaults */
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return -1;
+}
@@ -0,0 +1,21 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pios_thread.h>
+#include <pios_mutex.h>
+#include <pios_queue.h>
+#include <pios_semaphore.h>
+#include <pios_heap.h>
+
+#define PIOS_Assert(x) if (!(x)) { abort(); }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
@@ -0,0 +1,271 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2017
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <unistd.h>		/* usleep */
+#include <vector>
+
+extern "C" {
+#include "pios.h"
+#include "pios_vtime.h"
+#include "unittest_helpers.h"
+}
+
+/*
+ * A miniature flight controller: a sensor task feeding a stabilization
+ * task through a queue, a telemetry task woken by a semaphore that holds
+ * a shared mutex across a sleep, and a low priority background task.
+ * Every step is logged with the simulated time at which it happened.
+ */
+
+enum who {
+	WHO_SENSORS,
+	WHO_STAB,
+	WHO_TELEM,
+	WHO_BACKGROUND,
+};
+
+struct trace_ent {
+	uint8_t who;
+	uint32_t time_us;
+	uint32_t val;
+
+	bool operator==(const trace_ent &o) const {
+		return (who == o.who) && (time_us == o.time_us) &&
+			(val == o.val);
+	}
+};
+
+static std::vector<trace_ent> trace;
+
+static uint32_t run_ms;
+static volatile int finished;
+
+static struct pios_queue *sample_queue;
+static struct pios_semaphore *telem_sema;
+static struct pios_mutex *state_mutex;
+static uint32_t shared_state;
+
+static void log_step(enum who who, uint32_t val)
+{
+	trace_ent ent;
+
+	ent.who = who;
+	ent.time_us = PIOS_VTIME_Now_us();
+	ent.val = val;
+
+	trace.push_back(ent);
+}
+
+static void sensors_task(void *)
+{
+	uint32_t tm = PIOS_Thread_Systime();
+	uint32_t sample = 0;
+
+	while (PIOS_Thread_Systime() < run_ms) {
+		sample++;
+
+		PIOS_Queue_Send(sample_queue, &sample, 0);
+		log_step(WHO_SENSORS, sample);
+
+		PIOS_Thread_Sleep_Until(&tm, 2);
+	}
+
+	finished++;
+}
+
+static void stab_task(void *)
+{
+	uint32_t sample;
+
+	while (PIOS_Thread_Systime() < run_ms) {
+		if (!PIOS_Queue_Receive(sample_queue, &sample, 10)) {
+			continue;
+		}
+
+		log_step(WHO_STAB, sample);
+
+		PIOS_Mutex_Lock(state_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		shared_state += sample;
+		PIOS_Mutex_Unlock(state_mutex);
+
+		if ((sample % 10) == 0) {
+			PIOS_Semaphore_Give(telem_sema);
+		}
+	}
+
+	finished++;
+}
+
+static void telem_task(void *)
+{
+	while (PIOS_Thread_Systime() < run_ms) {
+		if (!PIOS_Semaphore_Take(telem_sema, 100)) {
+			continue;
+		}
+
+		PIOS_Mutex_Lock(state_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+		/* Holding the lock while blocked forces stab to wait on it */
+		PIOS_Thread_Sleep(1);
+		log_step(WHO_TELEM, shared_state);
+
+		PIOS_Mutex_Unlock(state_mutex);
+	}
+
+	finished++;
+
+	PIOS_Thread_Delete(NULL);
+}
+
+static void background_task(void *)
+{
+	uint32_t n = 0;
+
+	while (PIOS_Thread_Systime() < run_ms) {
+		log_step(WHO_BACKGROUND, n++);
+
+		PIOS_Thread_Sleep(7);
+	}
+
+	finished++;
+}
+
+static void init_task(void *)
+{
+	sample_queue = PIOS_Queue_Create(2, sizeof(uint32_t));
+	telem_sema = PIOS_Semaphore_Create();
+	state_mutex = PIOS_Mutex_Create();
+
+	PIOS_Thread_Create(background_task, "background",
+			PIOS_THREAD_STACK_SIZE_MIN, NULL, PIOS_THREAD_PRIO_LOW);
+	PIOS_Thread_Create(telem_task, "telem",
+			PIOS_THREAD_STACK_SIZE_MIN, NULL, PIOS_THREAD_PRIO_NORMAL);
+	PIOS_Thread_Create(sensors_task, "sensors",
+			PIOS_THREAD_STACK_SIZE_MIN, NULL, PIOS_THREAD_PRIO_HIGH);
+	PIOS_Thread_Create(stab_task, "stab",
+			PIOS_THREAD_STACK_SIZE_MIN, NULL, PIOS_THREAD_PRIO_HIGHEST);
+}
+
+/* Runs the scenario for the given simulated time, returns real ns taken */
+static uint64_t run_scenario(uint32_t ms)
+{
+  trace.clear();
+  shared_state = 0;
+  finished = 0;
+  run_ms = ms;
+
+  PIOS_VTIME_Enable();
+
+  uint64_t start = ut_now_ns();
+
+  PIOS_Thread_Create(init_task, "init", PIOS_THREAD_STACK_SIZE_MIN, NULL,
+      PIOS_THREAD_PRIO_HIGHEST);
+
+  while (finished < 4) {
+    usleep(1000);
+  }
+
+  /* Let the last thread finish leaving the scheduler */
+  usleep(10000);
+
+  return ut_now_ns() - start;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class VirtualTime : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(VirtualTime, Schedule) {
+  run_scenario(1000);
+
+  unsigned int sensors = 0, stab = 0, telem = 0, background = 0;
+
+  for (size_t i = 0; i < trace.size(); i++) {
+    const trace_ent &ent = trace[i];
+
+    switch (ent.who) {
+    case WHO_SENSORS:
+      /* Exactly every 2ms, and stab preempted us to consume it */
+      EXPECT_EQ(sensors * 2000, ent.time_us);
+      ASSERT_GT(i, 0U);
+      EXPECT_EQ(WHO_STAB, trace[i - 1].who);
+      EXPECT_EQ(ent.val, trace[i - 1].val);
+      EXPECT_EQ(ent.time_us, trace[i - 1].time_us);
+      sensors++;
+      break;
+    case WHO_STAB:
+      stab++;
+      break;
+    case WHO_TELEM:
+      telem++;
+      break;
+    case WHO_BACKGROUND:
+      EXPECT_EQ(background * 7000, ent.time_us);
+      background++;
+      break;
+    }
+  }
+
+  EXPECT_EQ(500U, sensors);
+  EXPECT_EQ(500U, stab);
+  /* Semaphores start out given, hence the extra one */
+  EXPECT_EQ(51U, telem);
+  EXPECT_EQ(143U, background);
+}
+
+TEST_F(VirtualTime, Reproducible) {
+  /* Two minutes of simulated flight */
+  uint64_t first_ns = run_scenario(120000);
+  std::vector<trace_ent> first = trace;
+
+  uint64_t second_ns = run_scenario(120000);
+
+  printf("120s simulated in %.2fs and %.2fs\n", first_ns / 1e9,
+      second_ns / 1e9);
+
+  EXPECT_EQ(first.size(), trace.size());
+  EXPECT_TRUE(first == trace);
+
+  /* Needs to be a lot faster than real time to be useful */
+  EXPECT_LT(first_ns, 12000000000ULL);
+}
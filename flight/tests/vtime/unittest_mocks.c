@@ -0,0 +1,25 @@
+/*
+ * Minimal stand-ins for the PiOS services the posix primitives depend on,
+ * so that they can be exercised outside the simulator.
+ */
+
+#include <stdlib.h>
+
+#include "pios.h"
+
+bool are_realtime;
+
+void * PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void * PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void * buf)
+{
+	free(buf);
+}
@@ -0,0 +1,104 @@
+/**
+******************************************************************************
+*
+* @file       decodedtilecache.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      LRU cache of tiles already decoded for display
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "decodedtilecache.h"
+#include <QMutexLocker>
+
+namespace core {
+    /* Costs are kept in KiB so a multi-hundred-MB budget fits the int
+     * QCache uses.  The default holds ~500 256x256 tiles, enough to
+     * cover a 4K display at two zoom levels. */
+    DecodedTileCache::DecodedTileCache() : tiles(128 * 1024)
+    {
+    }
+
+    QImage DecodedTileCache::GetTile(const RawTile &tile)
+    {
+        QMutexLocker locker(&lock);
+
+        QImage *img = tiles.object(tile);
+        if (img)
+            return *img;
+
+        return QImage();
+    }
+
+    void DecodedTileCache::AddTile(const RawTile &tile, const QImage &image)
+    {
+        if (image.isNull())
+            return;
+
+        QMutexLocker locker(&lock);
+
+        int cost = qMax(1, image.byteCount() / 1024);
+#ifdef DEBUG_MEMORY_CACHE
+        qDebug()<<"Decoded cache="<<tiles.totalCost()<<"KiB in"<<tiles.count()<<"tiles";
+#endif
+        tiles.insert(tile, new QImage(image), cost);
+    }
+
+    void DecodedTileCache::Clear()
+    {
+        QMutexLocker locker(&lock);
+        tiles.clear();
+    }
+
+    /**
+     * @brief DecodedTileCache::setCapacity
+     * @param value budget in MB
+     */
+    void DecodedTileCache::setCapacity(const int &value)
+    {
+        QMutexLocker locker(&lock);
+        tiles.setMaxCost(value * 1024);
+    }
+
+    int DecodedTileCache::Capacity()
+    {
+        QMutexLocker locker(&lock);
+        return tiles.maxCost() / 1024;
+    }
+
+    double DecodedTileCache::Size()
+    {
+        QMutexLocker locker(&lock);
+        return tiles.totalCost() / 1024.0;
+    }
+
+    QImage DecodedTileCache::Decode(const QByteArray &array)
+    {
+        QImage img = QImage::fromData(array);
+
+        if (img.isNull())
+            return img;
+
+        // Premultiplied ARGB / RGB32 are the formats the raster engine
+        // draws without a per-paint conversion
+        if (img.hasAlphaChannel())
+            return img.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        return img.convertToFormat(QImage::Format_RGB32);
+    }
+}
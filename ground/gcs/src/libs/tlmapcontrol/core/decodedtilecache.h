@@ -0,0 +1,66 @@
+/**
+******************************************************************************
+*
+* @file       decodedtilecache.h
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      LRU cache of tiles already decoded for display
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef DECODEDTILECACHE_H
+#define DECODEDTILECACHE_H
+
+#include "rawtile.h"
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QDebug>
+#include "debugheader.h"
+
+namespace core {
+    /**
+     * Holds tiles in the form they are painted in, so that a tile that
+     * scrolls back into view (or is revisited after a zoom) is not
+     * decoded from PNG/JPEG again.  MemoryCache keeps the compressed
+     * bytes; this keeps what the painter needs.  Least recently used
+     * tiles are dropped once the budget is exceeded.
+     *
+     * Accessed from the tile loader threads, so every call locks.
+     */
+    class DecodedTileCache
+    {
+    public:
+        DecodedTileCache();
+
+        QImage GetTile(const RawTile &tile);
+        void AddTile(const RawTile &tile, const QImage &image);
+        void Clear();
+
+        void setCapacity(const int &value);
+        int Capacity();
+        double Size();
+
+        //! Decode a tile and convert it to a format the raster paint engine blits directly
+        static QImage Decode(const QByteArray &array);
+    private:
+        QMutex lock;
+        QCache<RawTile, QImage> tiles;
+    };
+}
+#endif // DECODEDTILECACHE_H
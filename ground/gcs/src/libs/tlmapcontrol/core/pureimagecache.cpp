@@ -36,6 +36,68 @@ namespace core {
 
     }
 
+    PureImageCache::Connection::Connection(const QString &file, qlonglong id):file(file),name(QString::number(id)),selectTile(0),findTile(0),insertTile(0),insertData(0),open(false)
+    {
+        QSqlDatabase cn=QSqlDatabase::addDatabase("QSQLITE",name);
+        cn.setDatabaseName(file);
+        if(!cn.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Connection: Unable to open database"<<cn.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+        {
+            QSqlQuery query(cn);
+            // Readers don't wait for the tile writer, and a commit only
+            // syncs the log
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            // Caches created before the index existed
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+        }
+        selectTile=new QSqlQuery(cn);
+        selectTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        findTile=new QSqlQuery(cn);
+        findTile->prepare("SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?");
+        insertTile=new QSqlQuery(cn);
+        insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+        insertData=new QSqlQuery(cn);
+        insertData->prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+        open=true;
+    }
+    PureImageCache::Connection::~Connection()
+    {
+        delete selectTile;
+        delete findTile;
+        delete insertTile;
+        delete insertData;
+        {
+            QSqlDatabase cn=QSqlDatabase::database(name,false);
+            cn.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    /**
+     * Get the calling thread's connection to the cache, opening it if
+     * needed.  Must be called with the lock held.
+     */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        QString db=gtilecache+"Data.qmdb";
+        Connection *cn=connections.localData();
+        if(cn && cn->file==db && cn->isOpen())
+            return cn;
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        cn=new Connection(db,id);
+        // Replaces (and deletes) a failed one or one for an old location
+        connections.setLocalData(cn);
+        return cn;
+    }
+
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
@@ -162,6 +224,16 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            // Covers the tile lookup; the id is part of every index
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+            if(query.numRowsAffected()==-1)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -171,91 +243,111 @@ namespace core {
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
+    bool PureImageCache::insertImage(Connection *cn,const QByteArray &tile,const MapType::Types &type,const Point &pos,const int &zoom,const QString &date)
+    {
+        cn->insertTile->bindValue(0,pos.X());
+        cn->insertTile->bindValue(1,pos.Y());
+        cn->insertTile->bindValue(2,zoom);
+        cn->insertTile->bindValue(3,(int)type);
+        cn->insertTile->bindValue(4,date);
+        if(!cn->insertTile->exec())
+            return false;
+        cn->insertData->bindValue(0,tile);
+        return cn->insertData->exec();
+    }
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    {
+        CacheItemQueue item(type,pos,tile,zoom);
+        QList<CacheItemQueue*> tiles;
+        tiles.append(&item);
+        return PutImagesToCache(tiles);
+    }
+    /**
+     * Store a batch of tiles in one transaction, so the whole batch costs
+     * a single commit.
+     */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return false;
         lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        Connection *cn=connection();
+        bool ret=cn->isOpen();
+        if(ret)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            QSqlDatabase db=QSqlDatabase::database(cn->name,false);
+            QString date=QDateTime::currentDateTime().toString();
+            db.transaction();
+            foreach(CacheItemQueue *task,tiles)
             {
+                if(!insertImage(cn,task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom(),date))
                 {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
+#ifdef DEBUG_PUREIMAGECACHE
+                    qDebug()<<"PutImagesToCache: "<<cn->insertTile->lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
                 }
-                cn.close();
             }
+            ret=db.commit();
+            if(!ret)
+                db.rollback();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
-        lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *cn=connection();
+        if(cn->isOpen())
         {
-            QString db=dir+"Data.qmdb";
+            QSqlQuery *query=cn->selectTile;
+            query->bindValue(0,pos.X());
+            query->bindValue(1,pos.Y());
+            query->bindValue(2,zoom);
+            query->bindValue(3,(int)type);
+            if(query->exec() && query->next())
             {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
+                ar=query->value(0).toByteArray();
             }
+            // Don't hold the read snapshot open until the next lookup
+            query->finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
+    /**
+     * Whether a tile is stored, without reading its data.  Only touches
+     * the index, so it is cheap enough to check a whole area with.
+     */
+    bool PureImageCache::HasImage(MapType::Types type, Point pos, int zoom)
+    {
+        bool found=false;
+        if(gtilecache.isEmpty()|gtilecache.isNull())
+            return found;
+        lock.lockForRead();
+        Connection *cn=connection();
+        if(cn->isOpen())
+        {
+            QSqlQuery *query=cn->findTile;
+            query->bindValue(0,pos.X());
+            query->bindValue(1,pos.Y());
+            query->bindValue(2,zoom);
+            query->bindValue(3,(int)type);
+            found=query->exec() && query->next();
+            query->finish();
+        }
+        lock.unlock();
+        return found;
+    }
     void PureImageCache::deleteOlderTiles(int const& days)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
@@ -42,6 +42,8 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
     class PureImageCache
     {
@@ -50,15 +52,40 @@ namespace core {
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
+        bool HasImage(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        /**
+         * A database connection with its prepared statements.  Qt only lets
+         * a connection be used by the thread that opened it, so each thread
+         * keeps one open for as long as it lives.
+         */
+        class Connection
+        {
+        public:
+            Connection(const QString &file, qlonglong id);
+            ~Connection();
+            bool isOpen() const {return open;}
+            QString file;
+            QString name;
+            QSqlQuery *selectTile;
+            QSqlQuery *findTile;
+            QSqlQuery *insertTile;
+            QSqlQuery *insertData;
+        private:
+            bool open;
+        };
+        Connection *connection();
+        bool insertImage(Connection *cn,const QByteArray &tile,const MapType::Types &type,const core::Point &pos,const int &zoom,const QString &date);
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
+        QThreadStorage<Connection*> connections;
         static qlonglong ConnCounter;
 
     };
@@ -79,21 +79,23 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"Cache";
 #endif //DEBUG_TILECACHEQUEUE
         if(tileCacheQueue.count()>0)
         {
+            // Write out everything that piled up while the last batch was
+            // being committed, in one transaction
+            QList<CacheItemQueue*> batch;
             mutex.lock();
-            task=tileCacheQueue.dequeue();
+            while(tileCacheQueue.count()>0 && batch.count()<MAX_BATCH)
+                batch.append(tileCacheQueue.dequeue());
             mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+            qDebug()<<"Cache engine Put:"<<batch.count();
 #endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
+            Cache::Instance()->ImageCache.PutImagesToCache(batch);
+            qDeleteAll(batch);
         }
 
         else
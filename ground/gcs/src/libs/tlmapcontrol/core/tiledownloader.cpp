@@ -0,0 +1,210 @@
+/**
+******************************************************************************
+*
+* @file       tiledownloader.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Fetches many tiles into the tile database at once
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "tiledownloader.h"
+
+namespace core {
+    TileDownloader::TileDownloader(PureImageCache *cache, QObject *parent):QObject(parent),cache(cache),
+        nextHost(0),queued(0),maxConnections(MaxConnections),maxPerHost(MaxPerHost),timeout(30000),maxAttempts(3),
+        total(0),skipped(0),received(0),failed(0),peakPerHost(0),running(false),cancelled(false)
+    {
+        connect(&network,SIGNAL(finished(QNetworkReply*)),this,SLOT(replyFinished(QNetworkReply*)));
+        connect(&timeoutCheck,SIGNAL(timeout()),this,SLOT(checkTimeouts()));
+    }
+
+    TileDownloader::~TileDownloader()
+    {
+        Flush();
+    }
+
+    bool TileDownloader::Enqueue(const MapType::Types &type,const Point &pos,const int &zoom,const QNetworkRequest &request)
+    {
+        ++total;
+        if(!request.url().isValid())
+        {
+            ++failed;
+            return false;
+        }
+        if(cache->HasImage(type,pos,zoom))
+        {
+            ++skipped;
+            return false;
+        }
+
+        Job job;
+        job.type=type;
+        job.pos=pos;
+        job.zoom=zoom;
+        job.request=request;
+        job.attempts=0;
+
+        QString host=HostOf(request.url());
+        if(!waiting.contains(host))
+            hosts.append(host);
+        waiting[host].enqueue(job);
+        ++queued;
+
+        if(running)
+            Dispatch();
+        return true;
+    }
+
+    /**
+     * Starts fetching the queue; finished() is emitted once it is empty, or
+     * after Cancel().  Call it from the event loop, so a queue that is done
+     * right away doesn't signal before the caller is waiting.
+     */
+    void TileDownloader::Start()
+    {
+        running=true;
+        timeoutCheck.start(250);
+        emit progress(skipped+received+failed,total);
+        Dispatch();
+        if(inFlight.isEmpty())
+            Finish();
+    }
+
+    void TileDownloader::Cancel()
+    {
+        cancelled=true;
+        if(!running)
+            return;
+        // Aborting emits finished() for each reply, which ends the run
+        // once the last one is in
+        foreach(QNetworkReply *reply,inFlight.keys())
+            reply->abort();
+        if(inFlight.isEmpty())
+            Finish();
+    }
+
+    QString TileDownloader::HostOf(const QUrl &url)
+    {
+        return url.host()+':'+QString::number(url.port());
+    }
+
+    /**
+     * Starts requests until the connection limits are reached.  Hosts are
+     * visited in turn, so one with a long queue doesn't hold up the others.
+     */
+    void TileDownloader::Dispatch()
+    {
+        int idle=0;
+        while(!cancelled && inFlight.count()<maxConnections && idle<hosts.count())
+        {
+            QString host=hosts[nextHost];
+            nextHost=(nextHost+1)%hosts.count();
+
+            QQueue<Job> &queue=waiting[host];
+            if(queue.isEmpty() || busy.value(host)>=maxPerHost)
+            {
+                ++idle;
+                continue;
+            }
+            idle=0;
+
+            Request r;
+            r.job=queue.dequeue();
+            --queued;
+            r.job.attempts++;
+            r.host=host;
+            r.started.start();
+            peakPerHost=qMax(peakPerHost,++busy[host]);
+            inFlight.insert(network.get(r.job.request),r);
+        }
+    }
+
+    void TileDownloader::replyFinished(QNetworkReply *reply)
+    {
+        reply->deleteLater();
+        if(!inFlight.contains(reply))
+            return;
+        Request r=inFlight.take(reply);
+        busy[r.host]--;
+
+        QByteArray img;
+        if(reply->error()==QNetworkReply::NoError)
+            img=reply->readAll();
+
+        if(!img.isEmpty())
+        {
+            batch.append(new CacheItemQueue(r.job.type,r.job.pos,img,r.job.zoom));
+            ++received;
+            if(batch.count()>=BatchSize)
+                Flush();
+        }
+        else if(!cancelled)
+            Retry(r.job);
+
+        emit progress(skipped+received+failed,total);
+
+        Dispatch();
+        if(inFlight.isEmpty() && (cancelled || queued==0))
+            Finish();
+    }
+
+    /**
+     * Puts a failed tile at the back of its host's queue, so the other
+     * tiles go first and a busy server gets some time before it is asked
+     * again.
+     */
+    void TileDownloader::Retry(const Job &job)
+    {
+        if(job.attempts>=maxAttempts)
+        {
+            ++failed;
+            return;
+        }
+        waiting[HostOf(job.request.url())].enqueue(job);
+        ++queued;
+    }
+
+    void TileDownloader::checkTimeouts()
+    {
+        foreach(QNetworkReply *reply,inFlight.keys())
+        {
+            if(inFlight.contains(reply) && inFlight[reply].started.elapsed()>timeout)
+                reply->abort();
+        }
+    }
+
+    void TileDownloader::Flush()
+    {
+        if(batch.isEmpty())
+            return;
+        cache->PutImagesToCache(batch);
+        qDeleteAll(batch);
+        batch.clear();
+    }
+
+    void TileDownloader::Finish()
+    {
+        if(!running)
+            return;
+        running=false;
+        timeoutCheck.stop();
+        Flush();
+        emit finished();
+    }
+}
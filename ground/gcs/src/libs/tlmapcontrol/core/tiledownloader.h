@@ -0,0 +1,147 @@
+/**
+******************************************************************************
+*
+* @file       tiledownloader.h
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Fetches many tiles into the tile database at once
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TILEDOWNLOADER_H
+#define TILEDOWNLOADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkProxy>
+#include "maptype.h"
+#include "point.h"
+#include "pureimagecache.h"
+#include "cacheitemqueue.h"
+
+namespace core {
+    /**
+     * Downloads a queue of tiles straight into a PureImageCache, for the
+     * map ripper.  Up to MaxConnections requests are in flight, at most
+     * MaxPerHost of them to one host, and the hosts are served in turn.
+     *
+     * Tiles already in the cache are skipped when queued, and the received
+     * ones are written in batches as they arrive, so the database itself
+     * records the progress: an interrupted area is resumed by queueing it
+     * again.
+     *
+     * Lives in, and must be used from, a thread running an event loop.
+     */
+    class TileDownloader:public QObject
+    {
+        Q_OBJECT
+    public:
+        TileDownloader(PureImageCache *cache, QObject *parent = 0);
+        ~TileDownloader();
+
+        void SetMaxConnections(int value){maxConnections=qMax(1,value);}
+        void SetMaxPerHost(int value){maxPerHost=qMax(1,value);}
+        //! Milliseconds a request may take before it is aborted
+        void SetTimeout(int value){timeout=value;}
+        void SetMaxAttempts(int value){maxAttempts=qMax(1,value);}
+        void SetProxy(QNetworkProxy const& proxy){network.setProxy(proxy);}
+
+        /**
+        * @brief Queues a tile unless the cache already holds it
+        *
+        * @return false if the tile was skipped
+        */
+        bool Enqueue(const MapType::Types &type,const core::Point &pos,const int &zoom,const QNetworkRequest &request);
+
+        int Total()const{return total;}
+        int Skipped()const{return skipped;}
+        int Received()const{return received;}
+        int Failed()const{return failed;}
+        //! Highest number of requests that were in flight to one host
+        int PeakPerHost()const{return peakPerHost;}
+
+        static const int MaxConnections = 8;
+        static const int MaxPerHost = 2;
+        static const int BatchSize = 64;
+    public slots:
+        void Start();
+        void Cancel();
+    signals:
+        void progress(int done, int total);
+        void finished();
+    private slots:
+        void replyFinished(QNetworkReply *reply);
+        void checkTimeouts();
+    private:
+        struct Job
+        {
+            MapType::Types type;
+            core::Point pos;
+            int zoom;
+            QNetworkRequest request;
+            int attempts;
+        };
+        struct Request
+        {
+            Job job;
+            QString host;
+            QElapsedTimer started;
+        };
+
+        static QString HostOf(const QUrl &url);
+        void Dispatch();
+        void Retry(const Job &job);
+        void Flush();
+        void Finish();
+
+        PureImageCache *cache;
+        QNetworkAccessManager network;
+        QTimer timeoutCheck;
+
+        // Waiting jobs per host, and the order hosts are served in
+        QHash<QString, QQueue<Job> > waiting;
+        QStringList hosts;
+        int nextHost;
+        int queued;
+        QHash<QString, int> busy;
+        QHash<QNetworkReply*, Request> inFlight;
+
+        QList<CacheItemQueue*> batch;
+
+        int maxConnections;
+        int maxPerHost;
+        int timeout;
+        int maxAttempts;
+
+        int total;
+        int skipped;
+        int received;
+        int failed;
+        int peakPerHost;
+        bool running;
+        bool cancelled;
+    };
+}
+#endif // TILEDOWNLOADER_H
@@ -30,6 +30,7 @@
 
 #include "debugheader.h"
 #include "memorycache.h"
+#include "decodedtilecache.h"
 #include "rawtile.h"
 #include "cache.h"
 #include "accessmode.h"
@@ -66,7 +67,13 @@ namespace core {
 
 
         QByteArray GetImageFromServer(const MapType::Types &type,const core::Point &pos,const int &zoom);
+        /**
+        * @brief Request for a tile from its provider, as GetImageFromServer
+        *        would make it
+        */
+        QNetworkRequest ImageRequest(const MapType::Types &type,const core::Point &pos,const int &zoom);
         QByteArray GetImageFromFile(const MapType::Types &type,const core::Point &pos,const int &zoom, double hScale, double vScale, QString userImageFileName, internals::PureProjection *projection);
+        DecodedTileCache DecodedTiles;
         bool UseMemoryCache(){return useMemoryCache;}//TODO
         void setUseMemoryCache(const bool& value){useMemoryCache=value;}
         void setLanguage(const LanguageType::Types& language);
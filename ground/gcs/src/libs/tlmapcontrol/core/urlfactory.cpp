@@ -494,6 +494,88 @@ QString UrlFactory::MakeImageUrl(const MapType::Types &type,const Point &pos,con
 
     return QString::null;
 }
+/**
+     * @brief UrlFactory::MakeImageRequest Make the request for the desired
+     *        quadtile, with the headers its provider expects
+     */
+QNetworkRequest UrlFactory::MakeImageRequest(const MapType::Types &type,const Point &pos,const int &zoom,const QString &language)
+{
+    QNetworkRequest qheader;
+    qheader.setUrl(QUrl(MakeImageUrl(type,pos,zoom,language)));
+    qheader.setRawHeader("User-Agent",UserAgent);
+    qheader.setRawHeader("Accept","*/*");
+    switch(type)
+    {
+    case MapType::GoogleMap:
+    case MapType::GoogleSatellite:
+    case MapType::GoogleLabels:
+    case MapType::GoogleTerrain:
+    case MapType::GoogleHybrid:
+        {
+            qheader.setRawHeader("Referrer", "http://maps.google.com/");
+        }
+        break;
+
+    case MapType::GoogleMapChina:
+    case MapType::GoogleSatelliteChina:
+    case MapType::GoogleLabelsChina:
+    case MapType::GoogleTerrainChina:
+    case MapType::GoogleHybridChina:
+        {
+            qheader.setRawHeader("Referrer", "http://ditu.google.cn/");
+        }
+        break;
+
+    case MapType::BingHybrid:
+    case MapType::BingMap:
+    case MapType::BingSatellite:
+        {
+            qheader.setRawHeader("Referrer", "http://www.bing.com/maps/");
+        }
+        break;
+
+    case MapType::YahooHybrid:
+    case MapType::YahooLabels:
+    case MapType::YahooMap:
+    case MapType::YahooSatellite:
+        {
+            qheader.setRawHeader("Referrer", "http://maps.yahoo.com/");
+        }
+        break;
+
+    case MapType::ArcGIS_MapsLT_Map_Labels:
+    case MapType::ArcGIS_MapsLT_Map:
+    case MapType::ArcGIS_MapsLT_OrtoFoto:
+    case MapType::ArcGIS_MapsLT_Map_Hybrid:
+        {
+            qheader.setRawHeader("Referrer", "http://www.maps.lt/map_beta/");
+        }
+        break;
+
+    case MapType::OpenStreetMapSurfer:
+    case MapType::OpenStreetMapSurferTerrain:
+        {
+            qheader.setRawHeader("Referrer", "http://www.mapsurfer.net/");
+        }
+        break;
+
+    case MapType::OpenStreetMap:
+    case MapType::OpenStreetOsm:
+        {
+            qheader.setRawHeader("Referrer", "http://www.openstreetmap.org/");
+        }
+        break;
+
+    case MapType::YandexMapRu:
+        {
+            qheader.setRawHeader("Referrer", "http://maps.yandex.ru/");
+        }
+        break;
+    default:
+        break;
+    }
+    return qheader;
+}
 void UrlFactory::GetSecGoogleWords(const Point &pos,  QString &sec1, QString &sec2)
 {
     sec1 = ""; // after &x=...
@@ -63,6 +63,7 @@ namespace core {
             internals::PointLatLng coordinates;
         };
         QString MakeImageUrl(const MapType::Types &type,const core::Point &pos,const int &zoom,const QString &language);
+        QNetworkRequest MakeImageRequest(const MapType::Types &type,const core::Point &pos,const int &zoom,const QString &language);
         QList <UrlFactory::geoCodingStruct> GetLatLngFromGeodecoder(const QString &keywords,GeoCoderStatusCode::Types &status,const QString &language);
         QList <UrlFactory::geoCodingStruct> GetPlacemarkFromGeocoder(internals::PointLatLng location, GeoCoderStatusCode::Types &status, const QString &language);
         double GetElevationFromCoordinate(const internals::PointLatLng &coordinate, GeoCoderStatusCode::Types &status);
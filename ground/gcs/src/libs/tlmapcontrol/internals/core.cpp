@@ -115,6 +115,23 @@ namespace internals {
                         {
                             int retry = 0;
 
+                            // A user image depends on more than the tile
+                            // coordinates, so it isn't kept decoded
+                            bool cacheDecoded = (tl != MapType::UserImage) && TLMaps::Instance()->UseMemoryCache();
+                            RawTile key(tl, task.Pos, task.Zoom);
+
+                            if(cacheDecoded)
+                            {
+                                QImage decoded = TLMaps::Instance()->DecodedTiles.GetTile(key);
+                                if(!decoded.isNull())
+                                {
+                                    Moverlays.lock();
+                                    t->Overlays.append(decoded);
+                                    Moverlays.unlock();
+                                    continue;
+                                }
+                            }
+
                             do
                             {
                                 QByteArray tileImage;
@@ -139,11 +156,20 @@ namespace internals {
 #endif //DEBUG_CORE
                                 }
 
+                                // Decode here, on the loader thread, rather
+                                // than on every repaint in the GUI thread
+                                QImage decoded;
                                 if(tileImage.length()!=0)
+                                    decoded = DecodedTileCache::Decode(tileImage);
+
+                                if(!decoded.isNull())
                                 {
+                                    if(cacheDecoded)
+                                        TLMaps::Instance()->DecodedTiles.AddTile(key, decoded);
+
                                     Moverlays.lock();
                                     {
-                                        t->Overlays.append(tileImage);
+                                        t->Overlays.append(decoded);
 #ifdef DEBUG_CORE
                                         qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
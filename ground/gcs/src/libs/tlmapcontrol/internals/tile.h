@@ -53,7 +53,8 @@ public:
         this->pos=cSource.pos;
     }
     bool HasValue(){return !(zoom==0);}
-    QList<QByteArray> Overlays;
+    //! One image per map layer, already decoded by the loader thread
+    QList<QImage> Overlays;
 protected:
 
     QMutex mutex;
@@ -148,6 +148,20 @@ public:
     */
     void SetTileMemorySize(int const& value){core::TLMaps::Instance()->TilesInMemory.setMemoryCacheCapacity(value);}
 
+    /**
+    * @brief  Returns the memory used by tiles kept decoded for display
+    *
+    * @return size in Mb
+    */
+    double DecodedTileMemoryUsed()const{return core::TLMaps::Instance()->DecodedTiles.Size();}
+
+    /**
+    * @brief  Sets the budget for tiles kept decoded for display
+    *
+    * @param  value size in Mb, least recently drawn tiles are dropped beyond it
+    */
+    void SetDecodedTileMemorySize(int const& value){core::TLMaps::Instance()->DecodedTiles.setCapacity(value);}
+
     /**
     * @brief Sets the location for the SQLite Database used for caching and the geocoding cache files
     *
@@ -32,8 +32,7 @@
 #include "uavmapfollowtype.h"
 #include "uavtrailtype.h"
 #include <QtSvg/QSvgRenderer>
-#include "trailitem.h"
-#include "traillineitem.h"
+#include "traillayeritem.h"
 #include "../core/corecommon.h"
 
 namespace mapcontrol
@@ -191,9 +190,7 @@ namespace mapcontrol
         QPixmap pic;
         core::Point localposition;
         TLMapWidget* mapwidget;
-        QGraphicsItemGroup* trail;
-        QGraphicsItemGroup * trailLine;
-        internals::PointLatLng lasttrailline;
+        TrailLayerItem* trail;
         QTime timer;
         bool showtrail;
         bool showtrailline;
@@ -209,8 +206,6 @@ namespace mapcontrol
     signals:
         void UAVReachedWayPoint(int const& waypointnumber,WayPointItem* waypoint);
         void UAVLeftSafetyBouble(internals::PointLatLng const& position);
-        void setChildPosition();
-        void setChildLine();
     };
 }
 #endif // GPSITEM_H
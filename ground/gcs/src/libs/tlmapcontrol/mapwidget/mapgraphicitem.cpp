@@ -37,7 +37,7 @@ namespace mapcontrol
         core(core), config(configuration), MapRenderTransform(1), maxZoom(17),
         minZoom(2), zoomReal(0), zoomDigi(0), isSelected(false), rotation(0)
     {
-        dragons.load(QString::fromUtf8(":/markers/images/grid.jpg"));
+        dragons = QImage(QString::fromUtf8(":/markers/images/grid.jpg")).convertToFormat(QImage::Format_RGB32);
         showTileGridLines=false;
         isMouseOverMarker=false;
         maprect=QRectF(0,0,1022,680);
@@ -352,7 +352,7 @@ namespace mapcontrol
     }
     void MapGraphicItem::DrawMap2D(QPainter *painter)
     {
-        painter->drawImage(this->boundingRect(),dragons.toImage());
+        painter->drawImage(this->boundingRect(),dragons);
          if(!lastimage.isNull())
             painter->drawImage(core->GetrenderOffset().X()-lastimagepoint.X(),core->GetrenderOffset().Y()-lastimagepoint.Y(),lastimage);
 
@@ -377,14 +377,16 @@ namespace mapcontrol
                             //lock(t.Overlays)
                             if(t!=0)
                             {
-                                foreach(QByteArray img,t->Overlays)
+                                // Overlays are decoded by the loader threads, so
+                                // painting a tile is only a blit
+                                foreach(const QImage &img,t->Overlays)
                                 {
-                                    if(img.count()!=0)
+                                    if(!img.isNull())
                                     {
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            painter->drawImage(QRect(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height()),img);
                                         }
                                     }
                                 }
@@ -43,6 +43,7 @@ namespace mapcontrol
 {
     class WayPointItem;
     class TLMapWidget;
+    class TrailLayerItem;
     /**
     * @brief The main graphicsItem used on the widget, contains the map and map logic
     *
@@ -51,6 +52,7 @@ namespace mapcontrol
     class TLMAPWIDGET_EXPORT MapGraphicItem:public QObject,public QGraphicsItem
     {
         friend class mapcontrol::TLMapWidget;
+        friend class mapcontrol::TrailLayerItem;
         Q_OBJECT
         Q_INTERFACES(QGraphicsItem)
     public:
@@ -148,7 +150,7 @@ namespace mapcontrol
         QRectF maprect;
         bool isSelected;
         bool isMouseOverMarker;
-        QPixmap dragons;
+        QImage dragons;
         void SetIsMouseOverMarker(bool const& value){isMouseOverMarker = value;}
 
         qreal rotation;
@@ -25,10 +25,12 @@
 * with this program; if not, see <http://www.gnu.org/licenses/>
 */
 #include "mapripper.h"
+#include <QEventLoop>
+#include <QTimer>
 namespace mapcontrol
 {
 
-MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect):sleep(100),cancel(false),progressForm(0),core(core),yesToAll(false)
+MapRipper::MapRipper(internals::Core * core, const internals::RectLatLng & rect):cancel(false),progressForm(0),core(core),yesToAll(false),downloader(0)
     {
         if(!rect.IsEmpty())
         {
@@ -104,53 +106,48 @@ void MapRipper::finish()
 
     void MapRipper::run()
     {
-        int countOk = 0;
-        bool goodtile=false;
-        //  Stuff.Shuffle<Point>(ref list);
-        QVector<core::MapType::Types> types = TLMaps::Instance()->GetAllLayersOfType(type);
-        int all=points.count();
-        for(int i = 0; i < all; i++)
+        TLMaps *maps=TLMaps::Instance();
+        core::TileDownloader tiles(&Cache::Instance()->ImageCache);
+        tiles.SetProxy(maps->Proxy);
+        tiles.SetTimeout(maps->Timeout);
+        connect(&tiles,SIGNAL(progress(int,int)),this,SLOT(downloadProgress(int,int)),Qt::DirectConnection);
+
+        emit providerChanged(core::MapType::StrByType(type),zoom);
+        QVector<core::MapType::Types> types = maps->GetAllLayersOfType(type);
+        foreach(core::Point p,points)
         {
-            emit numberOfTilesChanged(all,i+1);
             if(cancel)
-                break;
+                return;
+            foreach(core::MapType::Types layer,types)
+                tiles.Enqueue(layer,p,zoom,maps->ImageRequest(layer,p,zoom));
+        }
 
-            core::Point p = points[i];
-            {
-                //qDebug()<<"offline fetching:"<<p.ToString();
-                foreach(core::MapType::Types type,types)
-                {
-                    emit providerChanged(core::MapType::StrByType(type),zoom);
-                    QByteArray img = TLMaps::Instance()->GetImageFromServer(type, p, zoom);
-                    if(img.length()!=0)
-                    {
-                        goodtile=true;
-                        img=NULL;
-                    }
-                    else
-                        goodtile=false;
-                }
-                if(goodtile)
-                {
-                    countOk++;
-                }
-                else
-                {
-                    i--;
-                    QThread::msleep(1000);
-                    continue;
-                }
-            }
-            emit percentageChanged((int) ((i+1)*100/all));//, i+1);
-            // worker.ReportProgress((int) ((i+1)*100/all), i+1);
+        QEventLoop loop;
+        connect(&tiles,SIGNAL(finished()),&loop,SLOT(quit()));
+        mutex.lock();
+        downloader=&tiles;
+        if(cancel)
+            tiles.Cancel();
+        mutex.unlock();
+        QTimer::singleShot(0,&tiles,SLOT(Start()));
+        loop.exec();
+        mutex.lock();
+        downloader=0;
+        mutex.unlock();
+    }
 
-            QThread::msleep(sleep);
-        }
+    void MapRipper::downloadProgress(int done,int total)
+    {
+        emit numberOfTilesChanged(total,done);
+        emit percentageChanged(total>0?done*100/total:100);
     }
 
     void MapRipper::stopFetching()
     {
         QMutexLocker locker(&mutex);
         cancel=true;
+        // The downloader belongs to the ripping thread
+        if(downloader)
+            QMetaObject::invokeMethod(downloader,"Cancel",Qt::QueuedConnection);
     }
 }
@@ -30,12 +30,21 @@
 #include <QThread>
 #include "../internals/core.h"
 #include "mapripform.h"
+#include "../core/tiledownloader.h"
 #include <QObject>
 #include <QMessageBox>
 #include "../core/corecommon.h"
 
 namespace mapcontrol
 {
+    /**
+    * @brief Downloads every tile of an area into the tile database, one
+    *        zoom level at a time, with a TileDownloader.  Tiles the
+    *        database already holds are skipped, so ripping an area again
+    *        picks up where an interrupted rip stopped.
+    *
+    * @class MapRipper mapripper.h "mapripper.h"
+    */
     class TLMAPWIDGET_EXPORT MapRipper:public QThread
     {
         Q_OBJECT
@@ -46,7 +55,6 @@ namespace mapcontrol
         QList<core::Point> points;
         int zoom;
         core::MapType::Types type;
-        int sleep;
         internals::RectLatLng area;
         bool cancel;
         MapRipForm * progressForm;
@@ -54,6 +62,7 @@ namespace mapcontrol
         internals::Core * core;
         bool yesToAll;
         QMutex mutex;
+        core::TileDownloader * downloader;
 
     signals:
         void percentageChanged(int const& perc);
@@ -64,6 +73,8 @@ namespace mapcontrol
     public slots:
         void stopFetching();
         void finish();
+    private slots:
+        void downloadProgress(int done,int total);
     };
 }
 #endif // MAPRIPPER_H
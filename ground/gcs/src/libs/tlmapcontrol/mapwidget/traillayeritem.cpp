@@ -0,0 +1,146 @@
+/**
+******************************************************************************
+*
+* @file       traillayeritem.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      A graphicsItem drawing a whole vehicle trail
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "traillayeritem.h"
+#include <QDateTime>
+#include <QGraphicsSceneHoverEvent>
+
+namespace mapcontrol
+{
+    TrailLayerItem::TrailLayerItem(QColor const& dotColor, QColor const& lineColor, MapGraphicItem *map) :
+        QGraphicsItem(map), m_map(map), m_dotBrush(dotColor),
+        showDots(true), showLine(true)
+    {
+        m_linePen.setColor(lineColor);
+        m_linePen.setWidth(1);
+        m_linePen.setCosmetic(true);
+        setAcceptHoverEvents(true);
+        connect(map,SIGNAL(childRefreshPosition()),this,SLOT(RefreshPos()));
+    }
+
+    void TrailLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+
+        if(showDots)
+        {
+            painter->setPen(QPen(Qt::black));
+            painter->setBrush(m_dotBrush);
+            painter->drawPath(trail.DotPath());
+        }
+
+        if(showLine)
+        {
+            painter->setPen(m_linePen);
+            painter->setBrush(Qt::NoBrush);
+            painter->drawPath(trail.LinePath());
+            painter->drawPolyline(trail.TailLine());
+        }
+    }
+
+    QRectF TrailLayerItem::boundingRect()const
+    {
+        if(trail.Count() == 0)
+            return QRectF();
+
+        const qreal margin = TrailPath::DotRadius + 1;
+        return trail.Bounds().adjusted(-margin, -margin, margin, margin);
+    }
+
+    int TrailLayerItem::type()const
+    {
+        return Type;
+    }
+
+    void TrailLayerItem::AddPoint(internals::PointLatLng const& coord, int const& altitude)
+    {
+        prepareGeometryChange();
+        trail.Append(coord, altitude, QDateTime::currentDateTime().toTime_t());
+        RefreshPos();
+        update();
+    }
+
+    void TrailLayerItem::Clear()
+    {
+        prepareGeometryChange();
+        trail.Clear();
+        setToolTip(QString());
+    }
+
+    void TrailLayerItem::SetShowDots(bool const& value)
+    {
+        showDots = value;
+        setVisible(showDots || showLine);
+        update();
+    }
+
+    void TrailLayerItem::SetShowLine(bool const& value)
+    {
+        showLine = value;
+        setVisible(showDots || showLine);
+        update();
+    }
+
+    /**
+     * @brief TrailLayerItem::RefreshPos Follows the map.  Reprojects the
+     * trail only when the zoom step changed; otherwise a pan or digital
+     * zoom is a move and a scale of this item.
+     */
+    void TrailLayerItem::RefreshPos()
+    {
+        if(trail.Count() == 0)
+            return;
+
+        int zoom = m_map->ZoomStep();
+        internals::PureProjection *projection = m_map->Projection();
+
+        if(zoom != trail.Zoom() || projection != trail.Projection())
+            prepareGeometryChange();
+
+        // Also rebuilds the geometry after samples were dropped from the ring
+        trail.SetZoom(projection, zoom);
+
+        core::Point origin = m_map->FromLatLngToLocal(trail.Origin());
+        setPos(origin.X(), origin.Y());
+        setScale(m_map->MapRenderTransform);
+    }
+
+    void TrailLayerItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        int i = showDots ? trail.NearestDot(event->pos(), TrailPath::DotRadius + 2) : -1;
+
+        if(i < 0)
+        {
+            setToolTip(QString());
+            return;
+        }
+
+        internals::PointLatLng coord = trail.Coord(i);
+        QDateTime time = QDateTime::fromTime_t(trail.Time(i));
+        QString coord_str = " " + QString::number(coord.Lat(), 'f', 6) + "   " + QString::number(coord.Lng(), 'f', 6);
+        setToolTip(QString(tr("Position:")+"%1\n"+tr("Altitude:")+"%2\n"+tr("Time:")+"%3").arg(coord_str).arg(QString::number(trail.Altitude(i))).arg(time.toString()));
+    }
+}
@@ -0,0 +1,86 @@
+/**
+******************************************************************************
+*
+* @file       traillayeritem.h
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      A graphicsItem drawing a whole vehicle trail
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TRAILLAYERITEM_H
+#define TRAILLAYERITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QObject>
+#include "../internals/pointlatlng.h"
+#include "mapgraphicitem.h"
+#include "trailpath.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief One item holding every point of a trail, replacing an item
+    *        per dot and per segment.  The geometry lives in a TrailPath in
+    *        pixels at the map's zoom step; panning moves the item and
+    *        digital zoom scales it, only a zoom step change reprojects.
+    *
+    * @class TrailLayerItem traillayeritem.h "traillayeritem.h"
+    */
+    class TLMAPWIDGET_EXPORT TrailLayerItem:public QObject,public QGraphicsItem
+    {
+        Q_OBJECT
+        Q_INTERFACES(QGraphicsItem)
+    public:
+        enum { Type = UserType + 10 };
+        TrailLayerItem(QColor const& dotColor, QColor const& lineColor, MapGraphicItem * map);
+        void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                    QWidget *widget);
+        QRectF boundingRect() const;
+        int type() const;
+
+        /**
+        * @brief Adds a point at the head of the trail
+        *
+        * @param coord position of the point
+        * @param altitude altitude shown in the point's tooltip
+        */
+        void AddPoint(internals::PointLatLng const& coord, int const& altitude);
+        /**
+        * @brief Deletes all the trail points
+        */
+        void Clear();
+        void SetShowDots(bool const& value);
+        void SetShowLine(bool const& value);
+        int Count()const{return trail.Count();}
+    protected:
+        void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+    private:
+        TrailPath trail;
+        MapGraphicItem * m_map;
+        QBrush m_dotBrush;
+        QPen m_linePen;
+        bool showDots;
+        bool showLine;
+    public slots:
+        void RefreshPos();
+    };
+}
+#endif // TRAILLAYERITEM_H
@@ -0,0 +1,357 @@
+/**
+******************************************************************************
+*
+* @file       trailpath.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Storage and simplified geometry of a vehicle trail
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#include "trailpath.h"
+#include <QPair>
+
+namespace mapcontrol
+{
+    const qreal TrailPath::LineTolerance = 0.75;
+    const qreal TrailPath::DotSpacing = 6;
+    const qreal TrailPath::DotRadius = 2;
+
+    // Raw vertices allowed at the head of the line before they are simplified
+    static const int TailLength = 64;
+
+    TrailPath::TrailPath(int capacity) :
+        ring(qMax(capacity, 16)), pixels(qMax(capacity, 16)),
+        first(0), next(0), projection(0), projZoom(-1),
+        hasBounds(false), tailFrom(0), geometryValid(false)
+    {
+    }
+
+    void TrailPath::Append(internals::PointLatLng const& coord, int altitude, uint time)
+    {
+        if(Count() == ring.size())
+            DropOldest();
+
+        if(Count() == 0)
+        {
+            origin = coord;
+            geometryValid = false;
+        }
+
+        Sample &s = ring[next % ring.size()];
+        s.lat = qRound(coord.Lat() * 1e7);
+        s.lng = qRound(coord.Lng() * 1e7);
+        s.time = time;
+        s.altitude = qBound(-32768, altitude, 32767);
+
+        int seq = next++;
+
+        if(!geometryValid)
+            return;
+
+        Project(seq);
+        AddDot(seq);
+        kept.append(seq);
+
+        if(kept.size() - tailFrom > TailLength)
+            SimplifyTail();
+    }
+
+    void TrailPath::Clear()
+    {
+        first = next = 0;
+        geometryValid = false;
+        kept.clear();
+        dots.clear();
+        linePath = QPainterPath();
+        dotPath = QPainterPath();
+        hasBounds = false;
+        bounds = QRectF();
+    }
+
+    internals::PointLatLng TrailPath::Coord(int i)const
+    {
+        const Sample &s = At(first + i);
+        return internals::PointLatLng(s.lat / 1e7, s.lng / 1e7);
+    }
+
+    int TrailPath::Altitude(int i)const
+    {
+        return At(first + i).altitude;
+    }
+
+    uint TrailPath::Time(int i)const
+    {
+        return At(first + i).time;
+    }
+
+    bool TrailPath::SetZoom(internals::PureProjection *projection, int zoom)
+    {
+        if(geometryValid && projection == this->projection && zoom == projZoom)
+            return false;
+
+        this->projection = projection;
+        projZoom = zoom;
+        Rebuild();
+
+        return true;
+    }
+
+    const QPainterPath &TrailPath::LinePath()
+    {
+        if(!geometryValid)
+            Rebuild();
+
+        return linePath;
+    }
+
+    QPolygonF TrailPath::TailLine()
+    {
+        if(!geometryValid)
+            Rebuild();
+
+        QPolygonF tail;
+        tail.reserve(kept.size() - tailFrom);
+        for(int i = tailFrom; i < kept.size(); i++)
+            tail.append(Pixel(kept[i]));
+
+        return tail;
+    }
+
+    const QPainterPath &TrailPath::DotPath()
+    {
+        if(!geometryValid)
+            Rebuild();
+
+        return dotPath;
+    }
+
+    int TrailPath::NearestDot(QPointF const& pos, qreal maxDistance)const
+    {
+        qreal best = maxDistance * maxDistance;
+        int found = -1;
+
+        foreach(int seq, dots)
+        {
+            QPointF d = Pixel(seq) - pos;
+            qreal dist = d.x() * d.x() + d.y() * d.y();
+
+            if(dist <= best)
+            {
+                best = dist;
+                found = seq - first;
+            }
+        }
+
+        return found;
+    }
+
+    void TrailPath::Project(int seq)
+    {
+        const Sample &s = At(seq);
+        core::Point p = projection->FromLatLngToPixel(s.lat / 1e7, s.lng / 1e7, projZoom);
+        QPointF px(p.X() - originPixel.X(), p.Y() - originPixel.Y());
+
+        pixels[seq % pixels.size()] = px;
+
+        if(!hasBounds)
+        {
+            bounds = QRectF(px, px);
+            hasBounds = true;
+        }
+        else
+        {
+            bounds.setLeft(qMin(bounds.left(), px.x()));
+            bounds.setRight(qMax(bounds.right(), px.x()));
+            bounds.setTop(qMin(bounds.top(), px.y()));
+            bounds.setBottom(qMax(bounds.bottom(), px.y()));
+        }
+    }
+
+    void TrailPath::Rebuild()
+    {
+        kept.clear();
+        dots.clear();
+        linePath = QPainterPath();
+        dotPath = QPainterPath();
+        hasBounds = false;
+        bounds = QRectF();
+        tailFrom = 0;
+
+        if(!projection)
+            return;
+
+        originPixel = projection->FromLatLngToPixel(origin, projZoom);
+
+        for(int seq = first; seq < next; seq++)
+        {
+            Project(seq);
+            AddDot(seq);
+        }
+
+        if(Count() > 0)
+        {
+            Simplify(first, next - 1, kept);
+            tailFrom = kept.size() - 1;
+
+            linePath.moveTo(Pixel(kept[0]));
+            for(int i = 1; i <= tailFrom; i++)
+                linePath.lineTo(Pixel(kept[i]));
+        }
+
+        geometryValid = true;
+    }
+
+    /**
+     * Drops a chunk of the oldest samples, rather than one per append, so
+     * the paths only have to be rebuilt now and then.  Only the segment
+     * the cut falls in is simplified again.
+     */
+    void TrailPath::DropOldest()
+    {
+        first += ring.size() / 16;
+
+        if(!geometryValid)
+            return;
+
+        int j = 0;
+        while(kept[j] < first)
+            j++;
+
+        // kept[j] is the last vertex of the new head
+        QVector<int> head;
+        Simplify(first, kept[j], head);
+        tailFrom = qMax(tailFrom, j) - j + head.size() - 1;
+
+        head.reserve(head.size() + kept.size() - j - 1);
+        for(int i = j + 1; i < kept.size(); i++)
+            head.append(kept[i]);
+        kept = head;
+
+        linePath = QPainterPath();
+        linePath.moveTo(Pixel(kept[0]));
+        for(int i = 1; i <= tailFrom; i++)
+            linePath.lineTo(Pixel(kept[i]));
+
+        QVector<int> oldDots = dots;
+        dots.clear();
+        dotPath = QPainterPath();
+        foreach(int seq, oldDots)
+        {
+            if(seq >= first)
+            {
+                dots.append(seq);
+                dotPath.addEllipse(Pixel(seq), DotRadius, DotRadius);
+            }
+        }
+    }
+
+    /**
+     * Simplifies the raw vertices at the head of the line.  The part that
+     * is already simplified isn't touched, so the cached path only ever
+     * grows at its end.
+     */
+    void TrailPath::SimplifyTail()
+    {
+        int from = kept[tailFrom];
+
+        kept.resize(tailFrom);
+        Simplify(from, next - 1, kept);
+
+        for(int i = tailFrom + 1; i < kept.size(); i++)
+            linePath.lineTo(Pixel(kept[i]));
+
+        tailFrom = kept.size() - 1;
+    }
+
+    /**
+     * Douglas-Peucker over the samples from..to, measuring the distance to
+     * the segment rather than the infinite line so loiters and reversals
+     * are kept.  Appends the retained sequence numbers, from included.
+     */
+    void TrailPath::Simplify(int from, int to, QVector<int> &out)
+    {
+        out.append(from);
+        if(to <= from)
+            return;
+
+        const qreal tolerance = LineTolerance * LineTolerance;
+        QVector<bool> keep(to - from + 1, false);
+        QVector<QPair<int, int> > stack;
+
+        keep[to - from] = true;
+        stack.append(qMakePair(from, to));
+
+        while(!stack.isEmpty())
+        {
+            QPair<int, int> seg = stack.takeLast();
+            const QPointF a = Pixel(seg.first);
+            const QPointF d = Pixel(seg.second) - a;
+            const qreal len = d.x() * d.x() + d.y() * d.y();
+
+            qreal worst = tolerance;
+            int worstSeq = -1;
+
+            for(int seq = seg.first + 1; seq < seg.second; seq++)
+            {
+                QPointF p = Pixel(seq) - a;
+
+                if(len > 0)
+                {
+                    qreal t = qBound(0.0, (p.x() * d.x() + p.y() * d.y()) / len, 1.0);
+                    p -= t * d;
+                }
+
+                qreal dist = p.x() * p.x() + p.y() * p.y();
+                if(dist > worst)
+                {
+                    worst = dist;
+                    worstSeq = seq;
+                }
+            }
+
+            if(worstSeq >= 0)
+            {
+                keep[worstSeq - from] = true;
+                stack.append(qMakePair(seg.first, worstSeq));
+                stack.append(qMakePair(worstSeq, seg.second));
+            }
+        }
+
+        for(int seq = from + 1; seq <= to; seq++)
+        {
+            if(keep[seq - from])
+                out.append(seq);
+        }
+    }
+
+    void TrailPath::AddDot(int seq)
+    {
+        const QPointF &p = Pixel(seq);
+
+        if(!dots.isEmpty())
+        {
+            QPointF d = p - Pixel(dots.last());
+            if(d.x() * d.x() + d.y() * d.y() < DotSpacing * DotSpacing)
+                return;
+        }
+
+        dots.append(seq);
+        dotPath.addEllipse(p, DotRadius, DotRadius);
+    }
+}
@@ -0,0 +1,134 @@
+/**
+******************************************************************************
+*
+* @file       trailpath.h
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Storage and simplified geometry of a vehicle trail
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+#ifndef TRAILPATH_H
+#define TRAILPATH_H
+
+#include <QVector>
+#include <QPainterPath>
+#include <QRectF>
+#include <QPolygonF>
+#include "../internals/pointlatlng.h"
+#include "../internals/pureprojection.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+     * Trail samples kept in a fixed size ring, plus the geometry needed to
+     * draw them at one zoom level.  Pixel positions are only recomputed when
+     * the zoom changes; panning just moves the item holding the paths.
+     *
+     * The line is a Douglas-Peucker simplification of the samples at the
+     * projected zoom, done incrementally on the newest samples so appending
+     * stays cheap.  Dots are decimated so they don't overlap.  Both are
+     * kept as cached QPainterPaths, in pixels relative to Origin().
+     *
+     * When the ring is full the oldest 1/16th of it is dropped at once.
+     */
+    class TLMAPWIDGET_EXPORT TrailPath
+    {
+    public:
+        TrailPath(int capacity = 65536);
+
+        void Append(internals::PointLatLng const& coord, int altitude, uint time);
+        void Clear();
+
+        int Count()const{return next - first;}
+        internals::PointLatLng Coord(int i)const;
+        int Altitude(int i)const;
+        uint Time(int i)const;
+
+        /**
+        * @brief Reprojects the samples if the zoom differs from the last call
+        *
+        * @return true if the geometry was rebuilt
+        */
+        bool SetZoom(internals::PureProjection *projection, int zoom);
+        int Zoom()const{return projZoom;}
+        internals::PureProjection *Projection()const{return projection;}
+
+        internals::PointLatLng Origin()const{return origin;}
+        QRectF Bounds()const{return bounds;}
+        //! The simplified line, up to the vertices TailLine() still holds raw
+        const QPainterPath &LinePath();
+        QPolygonF TailLine();
+        const QPainterPath &DotPath();
+
+        /**
+        * @brief Returns the index of the drawn dot closest to pos, or -1 if
+        *        none is within maxDistance pixels
+        */
+        int NearestDot(QPointF const& pos, qreal maxDistance)const;
+
+        //! Maximum distance, in pixels, of the simplified line from the samples
+        static const qreal LineTolerance;
+        //! Minimum distance, in pixels, between two drawn dots
+        static const qreal DotSpacing;
+        static const qreal DotRadius;
+    private:
+        struct Sample
+        {
+            qint32 lat;     //!< 1e-7 degrees
+            qint32 lng;     //!< 1e-7 degrees
+            quint32 time;   //!< seconds since the epoch
+            qint16 altitude;
+        };
+
+        const Sample &At(int seq)const{return ring[seq % ring.size()];}
+        const QPointF &Pixel(int seq)const{return pixels[seq % pixels.size()];}
+        void Project(int seq);
+        void Rebuild();
+        void DropOldest();
+        void SimplifyTail();
+        void Simplify(int from, int to, QVector<int> &out);
+        void AddDot(int seq);
+
+        QVector<Sample> ring;
+        QVector<QPointF> pixels;
+        // Sequence numbers of the oldest and one past the newest sample
+        int first;
+        int next;
+
+        internals::PureProjection *projection;
+        int projZoom;
+        internals::PointLatLng origin;
+        core::Point originPixel;
+        QRectF bounds;
+        bool hasBounds;
+
+        // Sequence numbers of the line vertices.  Those up to tailFrom are
+        // simplified and already in linePath.
+        QVector<int> kept;
+        int tailFrom;
+        QPainterPath linePath;
+
+        QVector<int> dots;
+        QPainterPath dotPath;
+
+        bool geometryValid;
+    };
+}
+#endif // TRAILPATH_H
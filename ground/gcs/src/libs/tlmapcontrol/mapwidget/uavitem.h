@@ -32,8 +32,7 @@
 #include "mappointitem.h"
 #include "uavmapfollowtype.h"
 #include "uavtrailtype.h"
-#include "trailitem.h"
-#include "traillineitem.h"
+#include "traillayeritem.h"
 #include "../core/corecommon.h"
 
 namespace mapcontrol
@@ -232,9 +231,7 @@ namespace mapcontrol
         double ringTime;
         QPixmap pic;
         core::Point localposition;
-        QGraphicsItemGroup* trail;
-        QGraphicsItemGroup * trailLine;
-        internals::PointLatLng lasttrailline;
+        TrailLayerItem* trail;
         QTime timer;
         bool showtrail;
         bool showtrailline;
@@ -258,8 +255,6 @@ namespace mapcontrol
     signals:
         void UAVReachedWayPoint(int const& waypointnumber,WayPointItem* waypoint);
         void UAVLeftSafetyBouble(internals::PointLatLng const& position);
-        void setChildPosition();
-        void setChildLine();
     };
 }
 #endif // UAVITEM_H
@@ -0,0 +1,272 @@
+/**
+******************************************************************************
+*
+* @file       main.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Tile downloader test against a local stand-in tile server
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+
+/*
+ * Serves generated PNG tiles over HTTP on the loopback, answering each
+ * request after a fixed latency and refusing the first request for every
+ * seventh tile with a 503.  The tiles are spread over two host names, as
+ * the providers spread them over numbered servers.
+ *
+ * An area is ripped into a scratch database and cancelled part way, then
+ * ripped again: the second run must skip what the first one stored, end
+ * with every tile in the database, byte for byte, and never have had more
+ * than MaxPerHost requests open to a host.  The same area is also ripped
+ * one tile at a time, as the ripper used to, for comparison.
+ */
+
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <cstdio>
+
+#include "../../core/tiledownloader.h"
+
+using namespace core;
+
+static const int Zoom = 14;
+static const int Side = 32;             // the area is Side x Side tiles
+static const int Latency = 20;          // ms per request
+static const int TileX = 8500;
+static const int TileY = 5700;
+
+static QByteArray tile(int zoom, int x, int y)
+{
+    QImage img(256, 256, QImage::Format_RGB32);
+    QRgb base = qRgb(x * 37 % 256, y * 53 % 256, zoom * 17 % 256);
+    for(int j = 0; j < 256; j++)
+    {
+        QRgb *line = (QRgb *) img.scanLine(j);
+        for(int i = 0; i < 256; i++)
+            line[i] = ((i / 32 + j / 32) & 1) ? base : ~base;
+    }
+
+    QByteArray png;
+    QBuffer buf(&png);
+    buf.open(QIODevice::WriteOnly);
+    img.save(&buf, "PNG");
+    return png;
+}
+
+class TileServer : public QTcpServer
+{
+public:
+    TileServer() : requests(0), rejected(0) {}
+
+    int requests;
+    int rejected;
+    QHash<QString, int> active;
+    QHash<QString, int> peak;
+
+protected:
+    void incomingConnection(qintptr fd)
+    {
+        QTcpSocket *s = new QTcpSocket(this);
+        s->setSocketDescriptor(fd);
+        connect(s, &QTcpSocket::readyRead, this, [this, s]() {
+            pending[s] += s->readAll();
+            handle(s);
+        });
+        connect(s, &QTcpSocket::disconnected, this, [this, s]() {
+            pending.remove(s);
+            s->deleteLater();
+        });
+    }
+
+private:
+    void handle(QTcpSocket *s)
+    {
+        QByteArray &buf = pending[s];
+        int end;
+        while((end = buf.indexOf("\r\n\r\n")) >= 0)
+        {
+            QList<QByteArray> lines = buf.left(end).split('\n');
+            buf.remove(0, end + 4);
+
+            QByteArray path = lines[0].split(' ').value(1);
+            QString host;
+            foreach(QByteArray line, lines)
+            {
+                if(line.toLower().startsWith("host:"))
+                    host = line.mid(5).trimmed();
+            }
+
+            requests++;
+            int n = ++active[host];
+            peak[host] = qMax(peak.value(host), n);
+
+            QTimer::singleShot(Latency, s, [this, s, path, host]() {
+                active[host]--;
+                s->write(response(path));
+            });
+        }
+    }
+
+    QByteArray response(QByteArray const& path)
+    {
+        QList<QByteArray> parts = path.mid(1).replace(".png", "").split('/');
+        int z = parts.value(0).toInt();
+        int x = parts.value(1).toInt();
+        int y = parts.value(2).toInt();
+
+        if((x + y) % 7 == 0 && !refused.contains(path))
+        {
+            refused.insert(path);
+            rejected++;
+            return "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+        }
+
+        QByteArray body = tile(z, x, y);
+        return "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: "
+                + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+    }
+
+    QHash<QTcpSocket *, QByteArray> pending;
+    QSet<QByteArray> refused;
+};
+
+static QNetworkRequest request(quint16 port, int x, int y)
+{
+    const char *host = (x + 2 * y) % 2 ? "localhost" : "127.0.0.1";
+    return QNetworkRequest(QUrl(QString("http://%1:%2/%3/%4/%5.png")
+                                .arg(host).arg(port).arg(Zoom).arg(x).arg(y)));
+}
+
+struct Run
+{
+    int skipped;
+    int received;
+    int failed;
+    int peakPerHost;
+    qint64 ms;
+};
+
+/* Rips the area; stopAfter cancels once that many tiles are done */
+static Run rip(PureImageCache &cache, quint16 port, int connections, int perHost, int stopAfter = -1)
+{
+    TileDownloader downloader(&cache);
+    downloader.SetMaxConnections(connections);
+    downloader.SetMaxPerHost(perHost);
+
+    for(int y = TileY; y < TileY + Side; y++)
+        for(int x = TileX; x < TileX + Side; x++)
+            downloader.Enqueue(MapType::OpenStreetMap, Point(x, y), Zoom, request(port, x, y));
+
+    QEventLoop loop;
+    QObject::connect(&downloader, &TileDownloader::finished, &loop, &QEventLoop::quit);
+    if(stopAfter >= 0)
+    {
+        QObject::connect(&downloader, &TileDownloader::progress, [&](int done, int) {
+            if(done >= stopAfter)
+                downloader.Cancel();
+        });
+    }
+
+    QElapsedTimer t;
+    t.start();
+    QTimer::singleShot(0, &downloader, SLOT(Start()));
+    loop.exec();
+
+    Run r;
+    r.skipped = downloader.Skipped();
+    r.received = downloader.Received();
+    r.failed = downloader.Failed();
+    r.peakPerHost = downloader.PeakPerHost();
+    r.ms = t.elapsed();
+    return r;
+}
+
+static bool check(bool ok, const char *what)
+{
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    TileServer server;
+    if(!server.listen(QHostAddress::Any))
+    {
+        printf("can't listen: %s\n", qPrintable(server.errorString()));
+        return 1;
+    }
+    quint16 port = server.serverPort();
+    const int tiles = Side * Side;
+
+    QTemporaryDir dir;
+    PureImageCache cache;
+    cache.setGtileCache(dir.path() + "/parallel/");
+
+    Run first = rip(cache, port, TileDownloader::MaxConnections, TileDownloader::MaxPerHost, tiles / 3);
+    printf("interrupted: %d received, %d failed in %lld ms\n", first.received, first.failed, first.ms);
+
+    Run second = rip(cache, port, TileDownloader::MaxConnections, TileDownloader::MaxPerHost);
+    printf("resumed:     %d skipped, %d received, %d failed in %lld ms\n",
+           second.skipped, second.received, second.failed, second.ms);
+    printf("server:      %d requests, %d refused\n", server.requests, server.rejected);
+
+    bool ok = true;
+    ok &= check(first.received > 0 && first.received < tiles, "first run stopped part way");
+    ok &= check(second.skipped == first.received, "second run skipped the stored tiles");
+    ok &= check(second.skipped + second.received == tiles && second.failed == 0,
+                "every tile fetched once");
+
+    int missing = 0;
+    for(int y = TileY; y < TileY + Side; y++)
+        for(int x = TileX; x < TileX + Side; x++)
+        {
+            if(cache.GetImageFromCache(MapType::OpenStreetMap, Point(x, y), Zoom) != tile(Zoom, x, y))
+                missing++;
+        }
+    ok &= check(missing == 0, "database holds every tile as served");
+
+    int peak = 0;
+    foreach(int n, server.peak)
+        peak = qMax(peak, n);
+    ok &= check(server.peak.count() == 2 && peak <= TileDownloader::MaxPerHost,
+                "per host limit held at the server");
+    ok &= check(second.peakPerHost == TileDownloader::MaxPerHost, "per host limit reached");
+
+    PureImageCache serialCache;
+    serialCache.setGtileCache(dir.path() + "/serial/");
+    Run serial = rip(serialCache, port, 1, 1);
+    Run again = rip(cache, port, 1, 1);
+    printf("serial:      %d tiles in %lld ms\n", serial.received, serial.ms);
+    printf("parallel:    %d tiles in %lld ms, %.1fx\n", first.received + second.received,
+           first.ms + second.ms, (double) serial.ms / (first.ms + second.ms));
+    ok &= check(again.skipped == tiles && again.received == 0, "complete area is a no-op");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+# Rips an area from a local stand-in tile server into a scratch tile
+# database, interrupting and resuming it, and reports the throughput.
+# Standalone: builds the few map sources it needs rather than the library.
+#   qmake && make && ./tileripper
+QT += network sql
+TARGET = tileripper
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+DEFINES += TLMAPWIDGET_LIBRARY
+SOURCES += main.cpp \
+    ../../core/tiledownloader.cpp \
+    ../../core/pureimagecache.cpp \
+    ../../core/cacheitemqueue.cpp \
+    ../../core/point.cpp \
+    ../../core/size.cpp
+HEADERS += ../../core/tiledownloader.h
@@ -0,0 +1,207 @@
+/**
+******************************************************************************
+*
+* @file       main.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2017
+* @brief      Frame time benchmark for the map trail layer
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, see <http://www.gnu.org/licenses/>
+*/
+
+/*
+ * Replays two hours of a synthetic 10 Hz position log: survey legs, loiters
+ * and GPS noise.  Each sample goes into the trail and a 4K frame is painted
+ * with the map following the vehicle, as UAVItem does in CenterMap mode.
+ * The zoom steps every five minutes so reprojection is included.
+ *
+ * --legacy repeats the first ten minutes with one scene item per dot and
+ * per segment, repositioned every frame, the way the trail used to work.
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
+#include <QImage>
+#include <QPainter>
+#include <QStringList>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "../../mapwidget/trailpath.h"
+#include "../../internals/projections/mercatorprojection.h"
+
+using namespace mapcontrol;
+
+static const int Rate = 10;                 // samples per second
+static const int Duration = 2 * 3600;       // seconds
+static const int FrameWidth = 3840;
+static const int FrameHeight = 2160;
+
+static internals::PointLatLng flightPosition(int n)
+{
+    const double t = n / (double) Rate;
+    const double mPerDegLat = 111320;
+    const double mPerDegLng = mPerDegLat * cos(47.0 * M_PI / 180);
+    double north, east;
+
+    // Alternate 20 minutes of survey with 5 minute loiters
+    int phase = (int)(t / 1500);
+    double local = fmod(t, 1500);
+
+    if(local < 1200)
+    {
+        double leg = local / 60;           // one leg a minute
+        double along = fmod(leg, 1.0) * 900;
+        if((int) leg % 2)
+            along = 900 - along;
+        north = along;
+        east = floor(leg) * 40 + phase * 900;
+    }
+    else
+    {
+        double a = (local - 1200) * 0.08;
+        north = 450 + 120 * sin(a);
+        east = phase * 900 + 400 + 120 * cos(a);
+    }
+
+    // A little GPS noise, so the simplification has something to do
+    north += 0.8 * sin(n * 12.9898);
+    east += 0.8 * sin(n * 78.233);
+
+    return internals::PointLatLng(47.0 + north / mPerDegLat, 8.0 + east / mPerDegLng);
+}
+
+static void report(const char *name, QVector<qint64> &ns)
+{
+    std::sort(ns.begin(), ns.end());
+    double total = 0;
+    foreach(qint64 v, ns)
+        total += v;
+
+    printf("%-8s %6d frames  mean %7.3f ms  p50 %7.3f ms  p99 %7.3f ms  max %7.3f ms\n",
+           name, ns.size(), total / ns.size() / 1e6,
+           ns[ns.size() / 2] / 1e6, ns[ns.size() * 99 / 100] / 1e6, ns.last() / 1e6);
+}
+
+static void runLayer(internals::PureProjection *projection)
+{
+    TrailPath trail;
+    QImage frame(FrameWidth, FrameHeight, QImage::Format_ARGB32_Premultiplied);
+    QPen linePen(Qt::red);
+    linePen.setCosmetic(true);
+    QVector<qint64> frames;
+    QElapsedTimer timer;
+    int zoom = 17;
+
+    frames.reserve(Duration * Rate);
+
+    for(int n = 0; n < Duration * Rate; n++)
+    {
+        if(n % (300 * Rate) == 0)
+            zoom = 15 + (n / (300 * Rate)) % 4;
+
+        internals::PointLatLng pos = flightPosition(n);
+        frame.fill(Qt::transparent);
+
+        timer.start();
+        trail.Append(pos, 100, n / Rate);
+        trail.SetZoom(projection, zoom);
+
+        // The item is placed so the trail's origin lands where the map,
+        // centred on the vehicle, puts it
+        core::Point o = projection->FromLatLngToPixel(trail.Origin(), zoom);
+        core::Point c = projection->FromLatLngToPixel(pos, zoom);
+
+        QPainter painter(&frame);
+        painter.translate(FrameWidth / 2 + o.X() - c.X(), FrameHeight / 2 + o.Y() - c.Y());
+        painter.setPen(QPen(Qt::black));
+        painter.setBrush(Qt::green);
+        painter.drawPath(trail.DotPath());
+        painter.setPen(linePen);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawPath(trail.LinePath());
+        painter.drawPolyline(trail.TailLine());
+        painter.end();
+        frames.append(timer.nsecsElapsed());
+    }
+
+    report("layer", frames);
+    printf("         %d samples kept of %d\n", trail.Count(), Duration * Rate);
+}
+
+static void runLegacy(internals::PureProjection *projection)
+{
+    const int samples = 600 * Rate;
+    const int zoom = 17;
+    QGraphicsScene scene(0, 0, FrameWidth, FrameHeight);
+    QImage frame(FrameWidth, FrameHeight, QImage::Format_ARGB32_Premultiplied);
+    QVector<internals::PointLatLng> coords;
+    QVector<QGraphicsEllipseItem *> dots;
+    QVector<QGraphicsLineItem *> lines;
+    QVector<qint64> frames;
+    QElapsedTimer timer;
+
+    for(int n = 0; n < samples; n++)
+    {
+        internals::PointLatLng pos = flightPosition(n);
+        core::Point c = projection->FromLatLngToPixel(pos, zoom);
+        frame.fill(Qt::transparent);
+
+        timer.start();
+        coords.append(pos);
+        dots.append(scene.addEllipse(-2, -2, 4, 4, QPen(Qt::black), QBrush(Qt::green)));
+        if(coords.size() > 1)
+            lines.append(scene.addLine(QLineF(), QPen(Qt::red)));
+
+        // setPosSLOT()/setLineSlot() for every item, on every pan
+        for(int i = 0; i < coords.size(); i++)
+        {
+            core::Point p = projection->FromLatLngToPixel(coords[i], zoom);
+            QPointF local(FrameWidth / 2 + p.X() - c.X(), FrameHeight / 2 + p.Y() - c.Y());
+            dots[i]->setPos(local);
+            if(i > 0)
+                lines[i - 1]->setLine(QLineF(dots[i - 1]->pos(), local));
+        }
+
+        QPainter painter(&frame);
+        scene.render(&painter);
+        painter.end();
+        frames.append(timer.nsecsElapsed());
+    }
+
+    report("legacy", frames);
+    printf("         first %d samples only\n", samples);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    projections::MercatorProjection projection;
+
+    runLayer(&projection);
+
+    if(a.arguments().contains("--legacy"))
+        runLegacy(&projection);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+# Replays a long flight into the map trail and reports frame times.
+# Standalone: builds the few map sources it needs rather than the library.
+#   qmake && make && ./trailbench -platform offscreen [--legacy]
+QT += widgets
+TARGET = trailbench
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+DEFINES += TLMAPWIDGET_LIBRARY
+SOURCES += main.cpp \
+    ../../mapwidget/trailpath.cpp \
+    ../../internals/pureprojection.cpp \
+    ../../internals/projections/mercatorprojection.cpp \
+    ../../internals/pointlatlng.cpp \
+    ../../internals/sizelatlng.cpp \
+    ../../internals/rectlatlng.cpp \
+    ../../core/point.cpp \
+    ../../core/size.cpp
+HEADERS += ../../mapwidget/trailpath.h
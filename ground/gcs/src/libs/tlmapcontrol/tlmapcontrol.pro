@@ -9,11 +9,11 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/waypointitem.cpp \
     mapwidget/uavitem.cpp \
     mapwidget/gpsitem.cpp \
-    mapwidget/trailitem.cpp \
+    mapwidget/trailpath.cpp \
     mapwidget/homeitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
-    mapwidget/traillineitem.cpp \
+    mapwidget/traillayeritem.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
     mapwidget/waypointcurve.cpp \
@@ -22,11 +22,13 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     core/pureimage.cpp \
     core/rawtile.cpp \
     core/memorycache.cpp \
+    core/decodedtilecache.cpp \
     core/cache.cpp \
     core/languagetype.cpp \
     core/providerstrings.cpp \
     core/cacheitemqueue.cpp \
     core/tilecachequeue.cpp \
+    core/tiledownloader.cpp \
     core/alllayersoftype.cpp \
     core/urlfactory.cpp \
     core/point.cpp \
@@ -61,11 +63,11 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/gpsitem.h \
     mapwidget/uavmapfollowtype.h \
     mapwidget/uavtrailtype.h \
-    mapwidget/trailitem.h \
+    mapwidget/trailpath.h \
     mapwidget/homeitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
-    mapwidget/traillineitem.h \
+    mapwidget/traillayeritem.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
     mapwidget/waypointcurve.h \
@@ -76,12 +78,14 @@ HEADERS += mapwidget/mapgraphicitem.h \
     core/pureimage.h \
     core/rawtile.h \
     core/memorycache.h \
+    core/decodedtilecache.h \
     core/cache.h \
     core/accessmode.h \
     core/languagetype.h \
     core/providerstrings.h \
     core/cacheitemqueue.h \
     core/tilecachequeue.h \
+    core/tiledownloader.h \
     core/alllayersoftype.h \
     core/urlfactory.h \
     core/geodecoderstatus.h \
@@ -32,6 +32,7 @@
 #include <uavobjects/uavobjectmanager.h>
 #include "uavobjectutil/uavobjectutilmanager.h"
 #include <extensionsystem/pluginmanager.h>
+#include "uavtalk/telemetrymanager.h"
 
 #include "loggingstats.h"
 
@@ -40,6 +41,12 @@
 #include <QFileDialog>
 #include <QDebug>
 
+//! File ids from here on are onboard logs, by log number
+static const quint32 LOG_FILE_ID_BASE = 0x00010000;
+
+//! More than any log partition will hold
+static const quint32 MAX_LOG_SIZE = 256 * 1024 * 1024;
+
 FlightLogDownload::FlightLogDownload(QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::FlightLogDownload)
@@ -113,7 +120,8 @@ void FlightLogDownload::updateReceived()
         logging.FileSectorNum++;
         loggingStats->setData(logging);
         loggingStats->updated();
-        ui->sectorLabel->setText(QString::number(logging.FileSectorNum));
+        ui->sectorLabel->setText(
+            tr("%0 KiB").arg(logging.FileSectorNum * LoggingStats::FILESECTOR_NUMELEM / 1024));
         qDebug() << "Requesting sector num: " << logging.FileSectorNum;
 
         ui->lb_operationStatus->setText("Downloading...");
@@ -131,6 +139,7 @@ void FlightLogDownload::updateReceived()
         logFile->close();
 
         ui->lb_operationStatus->setText("Download complete.");
+        ui->saveButton->setEnabled(true);
         break;
     }
     case LoggingStats::OPERATION_ERROR:
@@ -141,6 +150,7 @@ void FlightLogDownload::updateReceived()
         loggingStats->setMetadata(mdata);
 
         ui->lb_operationStatus->setText("Download error.");
+        ui->saveButton->setEnabled(true);
         break;
     default:
         qDebug() << "Unhandled";
@@ -148,9 +158,10 @@ void FlightLogDownload::updateReceived()
 }
 
 /**
- * @brief FlightLogDownload::startDownload set up the metadata
- * on the logging object and start a download after checking the
- * file name is valid.
+ * @brief FlightLogDownload::startDownload stop any logging in progress
+ * and fetch the selected log.  Uses the file transfer channel when the
+ * firmware serves logs on it, otherwise the LoggingStats sector
+ * protocol.
  */
 void FlightLogDownload::startDownload()
 {
@@ -159,11 +170,7 @@ void FlightLogDownload::startDownload()
     if (!ok)
         return;
 
-    logFile = new QFile(ui->fileName->text(), this);
-    if (!logFile->open(QIODevice::WriteOnly))
-        return;
-
-    log.clear();
+    QString fileName = ui->fileName->text();
 
     LoggingStats::DataFields logging = loggingStats->getData();
 
@@ -173,14 +180,105 @@ void FlightLogDownload::startDownload()
     loggingStats->setData(logging);
     loggingStats->updated();
 
+    ui->saveButton->setEnabled(false);
+
+    if (downloadWindowed(file_id, fileName)) {
+        ui->saveButton->setEnabled(true);
+        return;
+    }
+
+    startSectorDownload(file_id, fileName);
+}
+
+/**
+ * @brief FlightLogDownload::downloadWindowed fetch a log over the file
+ * transfer channel, keeping several requests in flight.  Data goes to a
+ * ".part" file next to the destination which is kept if the transfer is
+ * interrupted, so pressing download again carries on from there.
+ * @return false if the firmware doesn't serve logs this way, true
+ * otherwise (whether or not the download succeeded)
+ */
+bool FlightLogDownload::downloadWindowed(qint32 fileId, const QString &fileName)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
+
+    if (!telMngr || !telMngr->isConnected())
+        return false;
+
+    QFile part(QString("%0.%1.part").arg(fileName).arg(fileId));
+
+    if (!part.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        ui->lb_operationStatus->setText(tr("Can't write %0").arg(part.fileName()));
+        return true;
+    }
+
+    quint32 resumeFrom = part.size();
+
+    if (resumeFrom) {
+        qDebug() << "Resuming log" << fileId << "at" << resumeFrom;
+    }
+
+    ui->lb_operationStatus->setText(tr("Downloading..."));
+
+    bool ok = telMngr->downloadFile(LOG_FILE_ID_BASE + fileId, &part, MAX_LOG_SIZE,
+            [&](quint32 received) {
+                ui->sectorLabel->setText(tr("%0 KiB").arg(received / 1024));
+            });
+
+    quint32 received = part.size();
+
+    part.close();
+
+    if (ok && !received) {
+        // Nothing at all; older firmware only offers the sector protocol
+        part.remove();
+        return false;
+    }
+
+    if (!ok) {
+        ui->lb_operationStatus->setText(
+            tr("Download interrupted at %0 KiB; download again to resume.").arg(received / 1024));
+        return true;
+    }
+
+    QFile::remove(fileName);
+
+    if (!part.rename(fileName)) {
+        ui->lb_operationStatus->setText(tr("Can't write %0").arg(fileName));
+        return true;
+    }
+
+    ui->lb_operationStatus->setText(tr("Download complete."));
+
+    return true;
+}
+
+/**
+ * @brief FlightLogDownload::startSectorDownload set up the metadata
+ * on the logging object and start a download one LoggingStats sector
+ * at a time.
+ */
+void FlightLogDownload::startSectorDownload(qint32 fileId, const QString &fileName)
+{
+    logFile = new QFile(fileName, this);
+    if (!logFile->open(QIODevice::WriteOnly)) {
+        ui->saveButton->setEnabled(true);
+        return;
+    }
+
+    log.clear();
+
+    LoggingStats::DataFields logging = loggingStats->getData();
+
     UAVObject::Metadata mdata = loggingStats->getMetadata();
     UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_ONCHANGE);
     loggingStats->setMetadata(mdata);
 
-    qDebug() << "Download file id: " << file_id;
+    qDebug() << "Download file id: " << fileId;
     dl_state = DL_DOWNLOADING;
     logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
-    logging.FileRequest = file_id;
+    logging.FileRequest = fileId;
     logging.FileSectorNum = 0;
     loggingStats->setData(logging);
     loggingStats->updated();
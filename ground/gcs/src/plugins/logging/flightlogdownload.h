@@ -51,6 +51,9 @@ private slots:
     void getFilename();
 
 private:
+    bool downloadWindowed(qint32 fileId, const QString &fileName);
+    void startSectorDownload(qint32 fileId, const QString &fileName);
+
     LoggingStats *loggingStats;
     QByteArray log;
     QFile *logFile;
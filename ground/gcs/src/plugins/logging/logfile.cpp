@@ -29,12 +29,29 @@
 #include <QtGlobal>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+
+#include <algorithm>
 
 #include <coreplugin/coreconstants.h>
 
+// Header of the cached seek index
+static const quint32 INDEX_MAGIC = 0x44524c49; // "DRLI"
+static const quint32 INDEX_VERSION = 1;
+// Serialized size of an index entry: timestamp and offset
+static const quint64 INDEX_ENTRY_SIZE = sizeof(quint32) + sizeof(quint64);
+
 LogFile::LogFile(QObject *parent)
     : QIODevice(parent)
-    , timestampBufferIdx(0)
+    , map(NULL)
+    , mapSize(0)
+    , bodyStart(0)
+    , cursor(0)
+    , firstTimestamp(0)
+    , pendingIdx(0)
+    , pendingBytes(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -150,7 +167,8 @@ bool LogFile::open(OpenMode mode)
     // Must call parent function for QIODevice to pass calls to writeData
     // We always open ReadWrite, because otherwise we will get tons of warnings
     // during a logfile replay. Read nature is checked upon write ops below.
-    QIODevice::open(QIODevice::ReadWrite);
+    // Unbuffered, since readData already hands out data from memory.
+    QIODevice::open(QIODevice::ReadWrite | QIODevice::Unbuffered);
 
     return true;
 }
@@ -161,6 +179,18 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    mutex.lock();
+    pending.resize(0);
+    pendingIdx = 0;
+    pendingBytes = 0;
+    mutex.unlock();
+
+    if (map) {
+        file.unmap(map);
+        map = NULL;
+    }
+
     file.close();
     QIODevice::close();
 }
@@ -185,130 +215,269 @@ qint64 LogFile::writeData(const char *data, qint64 dataSize)
 qint64 LogFile::readData(char *data, qint64 maxSize)
 {
     QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize, (qint64)dataBuffer.size());
-    memcpy(data, dataBuffer.data(), toRead);
-    dataBuffer.remove(0, toRead);
-    return toRead;
+    qint64 done = 0;
+
+    while (done < maxSize && pendingIdx < pending.size()) {
+        Span &span = pending[pendingIdx];
+        qint64 len = qMin(maxSize - done, (qint64)span.length);
+
+        memcpy(data + done, map + span.offset, len);
+
+        done += len;
+        span.offset += len;
+        span.length -= len;
+
+        if (!span.length) {
+            pendingIdx++;
+        }
+    }
+
+    pendingBytes -= done;
+
+    if (pendingIdx == pending.size()) {
+        // Keeps the allocation for the next batch
+        pending.resize(0);
+        pendingIdx = 0;
+    }
+
+    return done;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return pendingBytes;
 }
 
-void LogFile::timerFired()
+/**
+ * Find the first plausible packet at or after a position in the mapped log.
+ * A corrupted log is resynced by stepping forward a byte at a time.
+ * @param pos Where to start looking
+ * @param timestamp Returns the packet timestamp
+ * @param size Returns the packet data length
+ * @return Offset of the packet header, or mapSize at the end of the log
+ */
+quint64 LogFile::nextPacket(quint64 pos, quint32 *timestamp, quint32 *size) const
 {
-    qint64 dataSize;
+    quint64 start = pos;
 
-    if (file.bytesAvailable() > 4) {
+    for (; pos + PACKET_HEADER_SIZE <= mapSize; pos++) {
+        qint64 dataSize;
 
-        int time;
-        time = myTime.elapsed();
+        memcpy(timestamp, map + pos, sizeof(*timestamp));
+        memcpy(&dataSize, map + pos + sizeof(*timestamp), sizeof(dataSize));
 
-        // Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset) * playbackSpeed)
-                > (lastTimeStamp - firstTimestamp))) {
-            lastPlayTime += ((time - lastPlayTimeOffset) * playbackSpeed);
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
+        if (dataSize >= 1 && dataSize <= MAX_PACKET_SIZE
+            && pos + PACKET_HEADER_SIZE + dataSize <= mapSize) {
+            if (pos != start) {
+                qDebug() << "Logfile resynced from 0x" << QString::number(start, 16) << "to 0x"
+                         << QString::number(pos, 16);
             }
 
-            file.seek(lastTimeStampPos + sizeof(lastTimeStamp));
+            *size = dataSize;
+            return pos;
+        }
+    }
 
-            file.read((char *)&dataSize, sizeof(dataSize));
+    return mapSize;
+}
 
-            if (dataSize < 1 || dataSize > (1024 * 1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if (file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+/**
+ * Queue everything that is due at the current play time.  The data stays
+ * in the mapped file until UAVTalk reads it.
+ */
+void LogFile::timerFired()
+{
+    int time = myTime.elapsed();
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
 
-            if (file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+    quint32 until = firstTimestamp + (quint32)lastPlayTime;
+    bool queued = false;
+
+    mutex.lock();
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+    while (cursor < mapSize) {
+        quint32 timestamp, size;
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+        cursor = nextPacket(cursor, &timestamp, &size);
+
+        if (cursor >= mapSize || timestamp > until) {
+            break;
         }
-    } else {
+
+        Span span = { cursor + PACKET_HEADER_SIZE, size };
+        pending.append(span);
+        pendingBytes += size;
+
+        cursor += PACKET_HEADER_SIZE + size;
+        queued = true;
+    }
+
+    mutex.unlock();
+
+    // Consumers read synchronously, so a whole tick's worth goes in one go
+    if (queued) {
+        emit readyRead();
+    }
+
+    if (cursor >= mapSize) {
         stopReplay();
     }
 }
 
+/**
+ * Scan the log and build the sparse timestamp to offset index.
+ * @return false if timestamps went backwards somewhere
+ */
+bool LogFile::buildIndex()
+{
+    bool ordered = true;
+    quint32 prevTimestamp = 0;
+    quint32 timestamp, size;
+
+    index.clear();
+
+    for (quint64 pos = nextPacket(bodyStart, &timestamp, &size); pos < mapSize;
+         pos = nextPacket(pos + PACKET_HEADER_SIZE + size, &timestamp, &size)) {
+        if (!index.isEmpty() && timestamp < prevTimestamp) {
+            qDebug() << "Timestamp: " << prevTimestamp << " " << timestamp;
+            ordered = false;
+        }
+
+        if (index.isEmpty() || timestamp >= index.last().timestamp + INDEX_INTERVAL_MS) {
+            IndexEntry entry = { timestamp, pos };
+            index.append(entry);
+        }
+
+        prevTimestamp = timestamp;
+    }
+
+    return ordered;
+}
+
+QString LogFile::indexFileName() const
+{
+    return file.fileName() + ".idx";
+}
+
+/**
+ * Load the index cached next to the log, if it is still valid for it.
+ */
+bool LogFile::loadIndex()
+{
+    QFile idxFile(indexFileName());
+
+    if (!idxFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&idxFile);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version, count;
+    quint64 size, start;
+    qint64 modified;
+
+    in >> magic >> version >> size >> modified >> start >> count;
+
+    if (in.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION
+        || size != mapSize || start != bodyStart
+        || modified != QFileInfo(file).lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+
+    // Don't let a damaged cache size the index beyond the entries it
+    // holds, nor beyond the one per packet the log could have
+    quint64 remaining = idxFile.size() - idxFile.pos();
+
+    if (count * INDEX_ENTRY_SIZE > remaining || count > mapSize) {
+        return false;
+    }
+
+    index.resize(count);
+
+    for (quint32 i = 0; i < count; i++) {
+        in >> index[i].timestamp >> index[i].offset;
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        index.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Cache the index next to the log.  Failure (e.g. a read-only directory)
+ * only means it gets rebuilt next time.
+ */
+void LogFile::saveIndex()
+{
+    QFile idxFile(indexFileName());
+
+    if (!idxFile.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&idxFile);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << INDEX_MAGIC << INDEX_VERSION << mapSize
+        << QFileInfo(file).lastModified().toMSecsSinceEpoch() << bodyStart
+        << (quint32)index.size();
+
+    foreach (const IndexEntry &entry, index) {
+        out << entry.timestamp << entry.offset;
+    }
+}
+
 bool LogFile::startReplay()
 {
-    dataBuffer.clear();
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    // Read all log timestamps into array
-    timestampBuffer.clear(); // Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
+    pending.resize(0);
+    pendingIdx = 0;
+    pendingBytes = 0;
 
-    while (!file.atEnd()) {
-        qint64 dataSize;
+    // Map the whole log; the header has already been consumed by open()
+    bodyStart = file.pos();
+    mapSize = file.size();
 
-        // Get time stamp position
-        timestampPos.append(file.pos());
-
-        // Read timestamp and logfile packet size
-        file.read((char *)&lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *)&dataSize, sizeof(dataSize));
-
-        // Check if dataSize sync bytes are correct.
-        // TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN
-        // THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
-            qDebug() << "Wrong sync byte. At file location 0x"
-                     << QString("%1").arg(file.pos(), 0, 16) << "Got 0x"
-                     << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16)
-                     << ", but expected 0x"
-                        "00"
-                        ".";
-            file.seek(timestampPos.last() + 1);
-            timestampPos.pop_back();
-            continue;
-        }
+    if (mapSize > bodyStart) {
+        map = file.map(0, mapSize);
 
-        // Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()) {
+        if (!map) {
             QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected "
-                                      "behavior"); //<--TODO: add hyperlink to webpage with better
-                                                   //description.
+            msgBox.setText("Cannot read logfile.");
+            msgBox.setInformativeText(file.errorString());
             msgBox.exec();
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+            stopReplay();
+            return false;
         }
 
-        timestampBuffer.append(lastTimeStamp);
+        if (!loadIndex()) {
+            if (!buildIndex()) {
+                QMessageBox msgBox;
+                msgBox.setText("Corrupted file.");
+                msgBox.setInformativeText("Timestamps are not sequential. Playback may have "
+                                          "unexpected behavior"); //<--TODO: add hyperlink to
+                                                                  //webpage with better
+                                                                  //description.
+                msgBox.exec();
+            }
 
-        file.seek(timestampPos.last() + sizeof(lastTimeStamp) + sizeof(dataSize) + dataSize);
+            saveIndex();
+        }
     }
 
     // Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0) {
+    if (index.isEmpty()) {
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -318,12 +487,8 @@ bool LogFile::startReplay()
         return false;
     }
 
-    // Reset to log beginning.
-    file.seek(logFileStartIdx + sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    firstTimestamp = index.first().timestamp;
+    cursor = index.first().offset;
 
     timer.setInterval(10);
     timer.start();
@@ -351,20 +516,42 @@ void LogFile::resumeReplay()
 
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx = 0;
-    while (timestampBuffer[tmpIdx++] <= val * 1000 && tmpIdx <= timestampBufferIdx) {
+    if (!map || index.isEmpty()) {
+        return;
+    }
+
+    quint32 target = firstTimestamp + val * 1000;
+
+    // Last index entry at or before the requested time, then scan forward
+    QVector<IndexEntry>::const_iterator entry =
+        std::upper_bound(index.constBegin(), index.constEnd(), target,
+                         [](quint32 t, const IndexEntry &e) { return t < e.timestamp; });
+
+    if (entry != index.constBegin()) {
+        --entry;
+    }
+
+    quint64 pos = entry->offset;
+    quint32 timestamp = target, size;
+
+    while ((pos = nextPacket(pos, &timestamp, &size)) < mapSize && timestamp < target) {
+        pos += PACKET_HEADER_SIZE + size;
     }
 
-    lastTimeStampPos = timestampPos[tmpIdx];
-    lastTimeStamp = timestampBuffer[tmpIdx];
-    timestampBufferIdx = tmpIdx;
+    mutex.lock();
+    cursor = pos;
+    pending.resize(0);
+    pendingIdx = 0;
+    pendingBytes = 0;
+    mutex.unlock();
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime = lastTimeStamp;
+    lastPlayTime = target - firstTimestamp;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val * 1000;
+    qDebug() << "Replaying at: " << timestamp - firstTimestamp << ", but requestion at"
+             << val * 1000;
 }
@@ -33,6 +33,7 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QVector>
 #include "uavobjects/uavobjectmanager.h"
 #include <math.h>
 
@@ -71,23 +72,51 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
-    quint32 lastPlayTime;
+    double lastPlayTime;
     QMutex mutex;
 
     int lastPlayTimeOffset;
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    // Each packet is a 32 bit ms timestamp, a 64 bit length, then the data
+    static const quint64 PACKET_HEADER_SIZE = sizeof(quint32) + sizeof(qint64);
+    static const qint64 MAX_PACKET_SIZE = 0xffff;
+
+    // Spacing of the seek index; seeks scan at most this much of the log
+    static const quint32 INDEX_INTERVAL_MS = 100;
+
+    struct IndexEntry {
+        quint32 timestamp;
+        quint64 offset;
+    };
+
+    // Packet data queued for UAVTalk, still in the mapped file
+    struct Span {
+        quint64 offset;
+        quint32 length;
+    };
+
+    quint64 nextPacket(quint64 pos, quint32 *timestamp, quint32 *size) const;
+    bool buildIndex();
+    bool loadIndex();
+    void saveIndex();
+    QString indexFileName() const;
+
+    uchar *map;
+    quint64 mapSize;
+    quint64 bodyStart;
+    quint64 cursor;
     quint32 firstTimestamp;
+
+    QVector<IndexEntry> index;
+
+    QVector<Span> pending;
+    int pendingIdx;
+    qint64 pendingBytes;
 };
 
 #endif // LOGFILE_H
@@ -52,7 +52,7 @@ public:
     virtual void setXMaximum(double val) { xMaximum = val; }
     void setYMinimum(double val) { yMinimum = val; }
     void setYMaximum(double val) { yMaximum = val; }
-    void setXWindowSize(double val) { m_xWindowSize = val; }
+    virtual void setXWindowSize(double val) { m_xWindowSize = val; }
     void setScalePower(int val) { scalePower = val; }
     void setMeanSamples(int val) { meanSamples = val; }
     void setMathFunction(QString val) { mathFunction = val; }
@@ -0,0 +1,260 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ringseriesdata.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scopes2d/ringseriesdata.h"
+
+#include <math.h>
+
+static const int INITIAL_CAPACITY = 1024;
+
+RingSeriesData::RingSeriesData(bool xIsIndex)
+    : xIsIndex(xIsIndex)
+    , fixedCapacity(false)
+    , head(0)
+    , used(0)
+{
+    ys.resize(INITIAL_CAPACITY);
+
+    if (!xIsIndex)
+        xs.resize(INITIAL_CAPACITY);
+}
+
+/**
+ * @brief RingSeriesData::setCapacity Fix the number of samples kept. Once
+ * full, each append replaces the oldest sample.
+ * @param capacity Number of samples
+ */
+void RingSeriesData::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 1);
+
+    QVector<double> newXs;
+    QVector<double> newYs(capacity);
+
+    if (!xIsIndex)
+        newXs.resize(capacity);
+
+    // Keep the newest samples that fit
+    int keep = qMin(used, capacity);
+
+    for (int i = 0; i < keep; i++) {
+        QPointF p = at(used - keep + i);
+
+        if (!xIsIndex)
+            newXs[i] = p.x();
+        newYs[i] = p.y();
+    }
+
+    xs = newXs;
+    ys = newYs;
+    head = 0;
+    used = keep;
+    fixedCapacity = true;
+}
+
+/**
+ * @brief RingSeriesData::grow Double the capacity, keeping the samples
+ */
+void RingSeriesData::grow()
+{
+    int capacity = ys.size();
+
+    setCapacity(capacity * 2);
+    fixedCapacity = false;
+}
+
+void RingSeriesData::append(double x, double y)
+{
+    int capacity = ys.size();
+
+    if (used == capacity) {
+        if (fixedCapacity) {
+            head = (head + 1) % capacity;
+            used--;
+        } else {
+            grow();
+            capacity = ys.size();
+        }
+    }
+
+    int pos = (head + used) % capacity;
+
+    if (!xIsIndex)
+        xs[pos] = x;
+    ys[pos] = y;
+
+    used++;
+}
+
+/**
+ * @brief RingSeriesData::dropBefore Remove samples older than x
+ */
+void RingSeriesData::dropBefore(double x)
+{
+    while (used && at(0).x() < x) {
+        head = (head + 1) % ys.size();
+        used--;
+    }
+}
+
+void RingSeriesData::clear()
+{
+    head = 0;
+    used = 0;
+    points.clear();
+    bounds = QRectF();
+}
+
+double RingSeriesData::lastX() const
+{
+    return used ? at(used - 1).x() : 0;
+}
+
+/**
+ * @brief RingSeriesData::at Raw sample, oldest first
+ */
+QPointF RingSeriesData::at(int i) const
+{
+    int pos = (head + i) % ys.size();
+
+    return QPointF(xIsIndex ? i : xs[pos], ys[pos]);
+}
+
+/**
+ * @brief RingSeriesData::lowerBound Index of the first sample at or after x
+ */
+int RingSeriesData::lowerBound(double x) const
+{
+    int lo = 0;
+    int hi = used;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (at(mid).x() < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/**
+ * @brief RingSeriesData::decimate Prepare the samples to draw. For every
+ * pixel column only the lowest and highest samples are kept, in the order
+ * they arrived, so spikes still show up.
+ * @param xMin Left edge of the visible range
+ * @param xMax Right edge of the visible range
+ * @param pixels Width of the visible range in pixels
+ */
+void RingSeriesData::decimate(double xMin, double xMax, int pixels)
+{
+    points.resize(0);
+
+    // One sample beyond each edge, so the line runs off the plot
+    int first = qMax(lowerBound(xMin) - 1, 0);
+    int last = qMin(lowerBound(xMax) + 1, used);
+
+    if (first >= last) {
+        bounds = QRectF();
+        return;
+    }
+
+    double yMin = at(first).y();
+    double yMax = yMin;
+
+    if (pixels <= 0 || xMax <= xMin || (last - first) <= 4 * pixels) {
+        for (int i = first; i < last; i++) {
+            QPointF p = at(i);
+
+            yMin = qMin(yMin, p.y());
+            yMax = qMax(yMax, p.y());
+            points.append(p);
+        }
+    } else {
+        // Columns are aligned to x, not to the edge, so that scrolling
+        // doesn't make the decimated curve shimmer
+        double scale = pixels / (xMax - xMin);
+        int i = first;
+
+        while (i < last) {
+            QPointF low = at(i);
+            QPointF high = low;
+            int lowIdx = i;
+            int highIdx = i;
+            double column = floor(low.x() * scale);
+
+            for (i++; i < last; i++) {
+                QPointF p = at(i);
+
+                if (floor(p.x() * scale) != column)
+                    break;
+
+                if (p.y() < low.y()) {
+                    low = p;
+                    lowIdx = i;
+                } else if (p.y() > high.y()) {
+                    high = p;
+                    highIdx = i;
+                }
+            }
+
+            if (lowIdx < highIdx) {
+                points.append(low);
+                points.append(high);
+            } else if (lowIdx > highIdx) {
+                points.append(high);
+                points.append(low);
+            } else {
+                points.append(low);
+            }
+
+            yMin = qMin(yMin, low.y());
+            yMax = qMax(yMax, high.y());
+        }
+    }
+
+    bounds = QRectF(points.first().x(), yMin, points.last().x() - points.first().x(), yMax - yMin);
+}
+
+size_t RingSeriesData::size() const
+{
+    return points.size();
+}
+
+QPointF RingSeriesData::sample(size_t i) const
+{
+    return points[i];
+}
+
+QRectF RingSeriesData::boundingRect() const
+{
+    if (points.isEmpty())
+        return QRectF(1.0, 1.0, -2.0, -2.0); // Invalid, as Qwt expects
+
+    return bounds;
+}
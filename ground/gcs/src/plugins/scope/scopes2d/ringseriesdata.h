@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ *
+ * @file       ringseriesdata.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2017
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef RINGSERIESDATA_H
+#define RINGSERIESDATA_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+/**
+ * @brief The RingSeriesData class Curve samples kept in a ring buffer, so
+ * that dropping the oldest sample is O(1).
+ *
+ * The curve does not draw the raw samples.  decimate() reduces the visible
+ * part to the minimum and maximum of each pixel column, which looks the
+ * same but keeps the cost of drawing proportional to the plot width rather
+ * than the history length.
+ */
+class RingSeriesData : public QwtSeriesData<QPointF>
+{
+public:
+    /**
+     * @param xIsIndex Samples are plotted against their position in the
+     * buffer, oldest at 0, rather than their own x value
+     */
+    RingSeriesData(bool xIsIndex);
+
+    void setCapacity(int capacity);
+    void append(double x, double y);
+    void dropBefore(double x);
+    void clear();
+
+    int count() const { return used; }
+    double lastX() const;
+
+    void decimate(double xMin, double xMax, int pixels);
+
+    // QwtSeriesData, the decimated samples
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    QPointF at(int i) const;
+    int lowerBound(double x) const;
+    void grow();
+
+    bool xIsIndex;
+    bool fixedCapacity;
+
+    QVector<double> xs;
+    QVector<double> ys;
+    int head; // Oldest sample
+    int used;
+
+    QVector<QPointF> points;
+    QRectF bounds;
+};
+
+#endif // RINGSERIESDATA_H
@@ -34,9 +34,141 @@
 #include "scopegadgetwidget.h"
 
 #include "qwt/src/qwt.h"
+#include "qwt/src/qwt_interval.h"
 #include "qwt/src/qwt_plot.h"
 #include "qwt/src/qwt_plot_curve.h"
 
+/**
+ * @brief ScatterplotData::ScatterplotData Base constructor for 2d curves
+ * @param uavObject The plotted UAVO name
+ * @param uavField The plotted UAVO field name
+ * @param xIsIndex Plot against sample number instead of time
+ */
+ScatterplotData::ScatterplotData(QString uavObject, QString uavField, bool xIsIndex)
+    : Plot2dData(uavObject, uavField)
+    , curve(0)
+    , series(new RingSeriesData(xIsIndex))
+    , haveObjId(false)
+    , uavObjId(0)
+    , fieldObj(0)
+    , field(0)
+    , fieldIndex(0)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    UAVObject *obj = objManager->getObject(uavObjectName);
+
+    if (obj) {
+        uavObjId = obj->getObjID();
+        haveObjId = true;
+    }
+}
+
+ScatterplotData::~ScatterplotData()
+{
+    if (!curve)
+        delete series;
+}
+
+/**
+ * @brief ScatterplotData::setCurve Set the curve, which takes over the samples
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    curve->setSamples(series);
+}
+
+/**
+ * @brief ScatterplotData::readValue Get the plotted value from an updated UAVO
+ * @param obj UAVO with new data
+ * @param value Returns the scaled value
+ * @return true if obj is the plotted object
+ */
+bool ScatterplotData::readValue(UAVObject *obj, double *value)
+{
+    if (!haveObjId || obj->getObjID() != uavObjId)
+        return false;
+
+    if (obj != fieldObj) {
+        field = obj->getField(uavFieldName);
+
+        if (!field)
+            return false;
+
+        fieldIndex = 0;
+
+        if (haveSubField) {
+            fieldIndex = field->getElementNames().indexOf(uavSubFieldName);
+
+            if (fieldIndex < 0)
+                return false;
+        }
+
+        fieldObj = obj;
+    }
+
+    *value = field->getDouble(fieldIndex) * pow(10, scalePower);
+
+    return true;
+}
+
+/**
+ * @brief ScatterplotData::applyMath Perform scope math, if necessary
+ * @param currentValue Newest sample
+ * @return The value to plot
+ */
+double ScatterplotData::applyMath(double currentValue)
+{
+    if (mathFunction != "Boxcar average" && mathFunction != "Standard deviation")
+        return currentValue;
+
+    // Put the new value at the back
+    yDataHistory->append(currentValue);
+
+    // calculate average value
+    meanSum += currentValue;
+    if (yDataHistory->size() > (int)meanSamples) {
+        meanSum -= yDataHistory->first();
+        yDataHistory->pop_front();
+    }
+
+    // make sure to correct the sum every meanSamples steps to prevent it
+    // from running away due to floating point rounding errors
+    correctionSum += currentValue;
+    if (++correctionCount >= (int)meanSamples) {
+        meanSum = correctionSum;
+        correctionSum = 0.0f;
+        correctionCount = 0;
+    }
+
+    double boxcarAvg = meanSum / yDataHistory->size();
+
+    if (mathFunction == "Standard deviation") {
+        // Calculate square of sample standard deviation, with Bessel's correction
+        double stdSum = 0;
+        for (int i = 0; i < yDataHistory->size(); i++) {
+            stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
+        }
+        return sqrt(stdSum);
+    }
+
+    return boxcarAvg;
+}
+
+/**
+ * @brief ScatterplotData::updateCurve Decimate the samples for the current
+ * x axis and canvas width, and have the curve redrawn
+ */
+void ScatterplotData::updateCurve(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    QwtInterval xInterval = scopeGadgetWidget->axisInterval(QwtPlot::xBottom);
+
+    series->decimate(xInterval.minValue(), xInterval.maxValue(),
+                     scopeGadgetWidget->canvas()->width());
+    curve->itemChanged();
+}
+
 /**
  * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
  * @param scopeGadgetWidget
@@ -46,17 +178,16 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
-
-    // Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
     toTime += NOW.time().msec() / 1000.0;
 
     scopeGadgetWidget->setAxisScale(QwtPlot::xBottom, toTime - m_xWindowSize, toTime);
+
+    // Plot new data
+    if (readAndResetUpdatedFlag() == true)
+        updateCurve(scopeGadgetWidget);
 }
 
 /**
@@ -68,11 +199,20 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
     // Plot new data
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        updateCurve(scopeGadgetWidget);
+}
+
+/**
+ * @brief SeriesPlotData::setXWindowSize The window is a number of samples,
+ * which is also the buffer size
+ */
+void SeriesPlotData::setXWindowSize(double val)
+{
+    ScatterplotData::setXWindowSize(val);
+    series->setCapacity(val);
 }
 
 /**
@@ -82,64 +222,15 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject *obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            // Perform scope math, if necessary
-            if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
-                // Put the new value at the front
-                yDataHistory->append(currentValue);
-
-                // calculate average value
-                meanSum += currentValue;
-                if (yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum += currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg = meanSum / yDataHistory->size();
-
-                if (mathFunction == "Standard deviation") {
-                    // Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum = 0;
-                    for (int i = 0; i < yDataHistory->size(); i++) {
-                        stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
-                    }
-                    yData->append(sqrt(stdSum));
-                } else {
-                    yData->append(boxcarAvg);
-                }
-            } else {
-                yData->append(currentValue);
-            }
-
-            if (yData->size()
-                > getXWindowSize()) { // If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
-
-            return true;
-        }
-    }
+    double currentValue;
 
-    return false;
+    if (!readValue(obj, &currentValue))
+        return false;
+
+    // Once the window is full, this drops the oldest sample
+    series->append(0, applyMath(currentValue));
+
+    return true;
 }
 
 /**
@@ -149,63 +240,21 @@ bool SeriesPlotData::append(UAVObject *obj)
  */
 bool TimeSeriesPlotData::append(UAVObject *obj)
 {
-    if (uavObjectName == obj->getName()) {
-        // Get the field of interest
-        UAVObjectField *field = obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); // THINK ABOUT REIMPLEMENTING THIS TO SHOW
-                                                          // UAVO TIME, NOT SYSTEM TIME
-            double currentValue =
-                valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            // Perform scope math, if necessary
-            if (mathFunction == "Boxcar average" || mathFunction == "Standard deviation") {
-                // Put the new value at the back
-                yDataHistory->append(currentValue);
-
-                // calculate average value
-                meanSum += currentValue;
-                if (yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum += currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg = meanSum / yDataHistory->size();
-
-                if (mathFunction == "Standard deviation") {
-                    // Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum = 0;
-                    for (int i = 0; i < yDataHistory->size(); i++) {
-                        stdSum += pow(yDataHistory->at(i) - boxcarAvg, 2) / (meanSamples - 1);
-                    }
-                    yData->append(sqrt(stdSum));
-                } else {
-                    yData->append(boxcarAvg);
-                }
-            } else {
-                yData->append(currentValue);
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
-
-            // Remove stale data
-            removeStaleData();
-
-            return true;
-        }
-    }
+    double currentValue;
+
+    if (!readValue(obj, &currentValue))
+        return false;
 
-    return false;
+    QDateTime NOW = QDateTime::currentDateTime(); // THINK ABOUT REIMPLEMENTING THIS TO SHOW
+                                                  // UAVO TIME, NOT SYSTEM TIME
+    double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+
+    series->append(valueX, applyMath(currentValue));
+
+    // Remove stale data
+    removeStaleData();
+
+    return true;
 }
 
 /**
@@ -213,22 +262,7 @@ bool TimeSeriesPlotData::append(UAVObject *obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    series->dropBefore(series->lastX() - getXWindowSize());
 }
 
 /**
@@ -256,6 +290,8 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    series->clear();
+
+    if (curve)
+        curve->itemChanged();
 }
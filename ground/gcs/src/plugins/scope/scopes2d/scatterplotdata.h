@@ -28,6 +28,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/ringseriesdata.h"
 #include "uavobjects/uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -42,20 +43,29 @@ class ScatterplotData : public Plot2dData
 {
     Q_OBJECT
 public:
-    ScatterplotData(QString uavObject, QString uavField)
-        : Plot2dData(uavObject, uavField)
-    {
-        curve = 0;
-    }
-    ~ScatterplotData() {}
+    ScatterplotData(QString uavObject, QString uavField, bool xIsIndex);
+    ~ScatterplotData();
 
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    void setCurve(QwtPlotCurve *val) { curve = val; }
+    void setCurve(QwtPlotCurve *val);
 
 protected:
+    bool readValue(UAVObject *obj, double *value);
+    double applyMath(double value);
+    void updateCurve(ScopeGadgetWidget *scopeGadgetWidget);
+
     QwtPlotCurve *curve;
+    RingSeriesData *series; // Owned by the curve once it is set
+
+private:
+    // The field is resolved on the first update rather than on every one
+    bool haveObjId;
+    quint32 uavObjId;
+    UAVObject *fieldObj;
+    UAVObjectField *field;
+    int fieldIndex;
 };
 
 /**
@@ -67,11 +77,13 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-        : ScatterplotData(uavObject, uavField)
+        : ScatterplotData(uavObject, uavField, true)
     {
     }
     ~SeriesPlotData() {}
 
+    virtual void setXWindowSize(double val);
+
     /*!
       \brief Append new data to the plot
       */
@@ -93,7 +105,7 @@ class TimeSeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     TimeSeriesPlotData(QString uavObject, QString uavField)
-        : ScatterplotData(uavObject, uavField)
+        : ScatterplotData(uavObject, uavField, false)
     {
         scalePower = 1;
     }
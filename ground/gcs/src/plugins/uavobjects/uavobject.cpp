@@ -286,6 +286,80 @@ qint32 UAVObject::pack(quint8 *dataOut)
  * @returns The number of bytes copied
  */
 qint32 UAVObject::unpack(const quint8 *dataIn)
+{
+    deltaReference = QByteArray((const char *)dataIn, numBytes);
+
+    unpackFields(dataIn);
+
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Unpack a delta update, applying it to the data of the last unpack().
+ * The delta is a bitmap with one bit per 4-byte word of the object, LSB
+ * first, followed by the words whose bit is set; a final partial word is
+ * sent at its actual length.
+ * @param deltaIn The delta
+ * @param length Length of the delta
+ * @returns The number of bytes unpacked, or -1 if the delta doesn't apply
+ */
+qint32 UAVObject::unpackDelta(const quint8 *deltaIn, quint32 length)
+{
+    const quint32 wordBytes = 4;
+    quint32 words = (numBytes + wordBytes - 1) / wordBytes;
+    quint32 bitmapBytes = (words + 7) / 8;
+
+    if ((quint32)deltaReference.size() != numBytes || length < bitmapBytes) {
+        return -1;
+    }
+
+    QByteArray dataIn(deltaReference);
+    const quint8 *in = deltaIn + bitmapBytes;
+    const quint8 *end = deltaIn + length;
+
+    for (quint32 i = 0; i < words; i++) {
+        if (!(deltaIn[i / 8] & (1 << (i % 8)))) {
+            continue;
+        }
+
+        quint32 offset = i * wordBytes;
+        quint32 n = qMin(wordBytes, numBytes - offset);
+
+        if ((quint32)(end - in) < n) {
+            return -1;
+        }
+
+        memcpy(dataIn.data() + offset, in, n);
+        in += n;
+    }
+
+    if (in != end) {
+        return -1;
+    }
+
+    unpackFields((const quint8 *)dataIn.constData());
+
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Get the data of the last full unpack(), which delta updates apply to
+ */
+const QByteArray &UAVObject::getDeltaReference()
+{
+    return deltaReference;
+}
+
+/**
+ * Unpack the fields from a byte array
+ */
+void UAVObject::unpackFields(const quint8 *dataIn)
 {
     qint32 offset = 0;
     for (QList<UAVObjectField *>::iterator iter = fields.begin(); iter != fields.end(); ++iter) {
@@ -293,10 +367,6 @@ qint32 UAVObject::unpack(const quint8 *dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
-    emit objectUnpacked(this); // trigger object updated event
-    emit objectUpdated(this);
-
-    return numBytes;
 }
 
 /**
@@ -43,6 +43,7 @@
 #include <QString>
 #include <QList>
 #include <QFile>
+#include <QByteArray>
 #include <qglobal.h>
 #include "uavobjects/uavobjectfield.h"
 
@@ -128,6 +129,8 @@ public:
     quint32 getNumBytes();
     qint32 pack(quint8 *dataOut);
     qint32 unpack(const quint8 *dataIn);
+    qint32 unpackDelta(const quint8 *deltaIn, quint32 length);
+    const QByteArray &getDeltaReference();
     virtual void setMetadata(const Metadata &mdata) = 0;
     virtual Metadata getMetadata() = 0;
     virtual Metadata getDefaultMetadata() = 0;
@@ -252,6 +255,9 @@ protected:
     quint32 numBytes;
     quint8 *data;
     QList<UAVObjectField *> fields;
+    // Last full copy unpacked, which delta updates apply to
+    QByteArray deltaReference;
+    void unpackFields(const quint8 *dataIn);
     void initializeFields(QList<UAVObjectField *> &fields, quint8 *data, quint32 numBytes);
     void setDescription(const QString &description);
     void setCategory(const QString &category);
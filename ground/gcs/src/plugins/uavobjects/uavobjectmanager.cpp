@@ -82,6 +82,7 @@ bool UAVObjectManager::registerObject(UAVDataObject *obj)
                 QMap<quint32, UAVObject *> ppp;
                 ppp.insert(instidx, cobj);
                 objects[objID].insert(instidx, cobj);
+                instances.insert(instanceKey(objID, instidx), cobj);
                 getObject(cobj->getObjID())->emitNewInstance(cobj); // TODO??
                 emit newInstance(cobj);
             }
@@ -92,6 +93,7 @@ bool UAVObjectManager::registerObject(UAVDataObject *obj)
         }
         // Add the actual object instance in the list
         objects[objID].insert(obj->getInstID(), obj);
+        instances.insert(instanceKey(objID, obj->getInstID()), obj);
         getObject(objID)->emitNewInstance(obj);
         emit newInstance(obj);
         return true;
@@ -131,6 +133,7 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject *obj)
             ->emitInstanceRemoved(objects.value(objID).value(x));
         emit instanceRemoved(objects.value(objID).value(x));
         objects[objID].remove(x);
+        instances.remove(instanceKey(objID, x));
     }
     return true;
 }
@@ -141,6 +144,7 @@ void UAVObjectManager::addObject(UAVObject *obj)
     QMap<quint32, UAVObject *> list;
     list.insert(obj->getInstID(), obj);
     objects.insert(obj->getObjID(), list);
+    instances.insert(instanceKey(obj->getObjID(), obj->getInstID()), obj);
 
     objectsByName.insert(obj->getName(), list);
 
@@ -237,9 +241,9 @@ UAVObject *UAVObjectManager::getObject(const QString &name, quint32 objId, quint
         }
 
         return NULL;
-    } else if (objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    }
+
+    return instances.value(instanceKey(objId, instId));
 }
 
 /**
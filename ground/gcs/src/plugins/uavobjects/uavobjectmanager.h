@@ -81,6 +81,13 @@ private:
     static const quint32 MAX_INSTANCES = 1000;
     QHash<quint32, QMap<quint32, UAVObject *>> objects;
     QHash<QString, QMap<quint32, UAVObject *>> objectsByName;
+    // Flat index of every instance, for the lookup telemetry does per frame
+    QHash<quint64, UAVObject *> instances;
+
+    static quint64 instanceKey(quint32 objId, quint32 instId)
+    {
+        return ((quint64)objId << 32) | instId;
+    }
 
     void addObject(UAVObject *obj);
     UAVObject *getObject(const QString &name, quint32 objId, quint32 instId);
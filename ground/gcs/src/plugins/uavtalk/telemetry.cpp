@@ -37,6 +37,8 @@
 #include "hwtaulink.h"
 #include "objectpersistence.h"
 #include <QTime>
+#include <QBuffer>
+#include <QElapsedTimer>
 #include <QtGlobal>
 #include <stdlib.h>
 #include <QDebug>
@@ -405,8 +407,6 @@ void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
 QByteArray *Telemetry::downloadFile(quint32 fileId, quint32 maxSize,
         std::function<void(quint32)>progressCb)
 {
-    quint32 curOffset = 0;
-
     QByteArray *result = new QByteArray();
 
     quint32 sizeGuess = 32 * 1024;
@@ -415,83 +415,265 @@ QByteArray *Telemetry::downloadFile(quint32 fileId, quint32 maxSize,
         sizeGuess = maxSize;
     }
 
-    result->reserve(maxSize);
+    result->reserve(sizeGuess);
+
+    QBuffer buffer(result);
+    buffer.open(QIODevice::WriteOnly);
 
-    bool newReqNeeded = false;
-    bool completed = false;
-    int inactivityCount = 0;
-    int failCount = 0;
+    if (!downloadFile(fileId, &buffer, maxSize, progressCb)) {
+        qDebug() << "Aborting file transfer";
+        delete result;
+        return NULL;
+    }
+
+    return result;
+}
+
+/**
+ * Fetch a file from the flight controller, appending it to dest.
+ *
+ * Each request returns a run of chunks.  Up to FILE_WINDOW requests are
+ * kept in flight; chunks arriving ahead of a gap are held until it is
+ * filled, and only the requests whose replies were lost or incomplete
+ * are sent again.  Whatever dest already holds is taken to be the start
+ * of the file, so an interrupted transfer picks up where it stopped.
+ *
+ * \param[in] fileId The file to fetch
+ * \param[in] dest Open, writable device positioned at its end
+ * \param[in] maxSize Stop after this many bytes of file
+ * \param[in] progressCb Called with the length fetched so far
+ * \return true if the file was fetched up to its end or maxSize
+ */
+bool Telemetry::downloadFile(quint32 fileId, QIODevice *dest, quint32 maxSize,
+        std::function<void(quint32)>progressCb)
+{
+    struct Request {
+        QElapsedTimer sent;
+        quint32 received = 0;
+        int retries = 0;
+    };
+
+    // Bytes of file in dest so far; always contiguous
+    quint32 written = dest->size();
+    quint32 nextReq = written;
+    // Bytes per request, learned from the first reply
+    quint32 span = 0;
+    qint64 eofAt = -1;
+    bool failed = false;
+
+    QMap<quint32, Request> inFlight;
+    QMap<quint32, QByteArray> held;
+    QList<quint32> resend;
+
+    // The link can go away (and us with it) while we wait
+    QPointer<Telemetry> self(this);
 
     QEventLoop loop;
     QTimer timeStep;
 
     timeStep.setSingleShot(false);
-    timeStep.start(150);
+    timeStep.start(FILE_TICK_MS);
 
     connect(&timeStep, &QTimer::timeout, &loop, &QEventLoop::quit);
 
     connect(utalk, &UAVTalk::fileDataReceived, &loop,
             [&](quint32 recvFileId, quint32 offset, quint8 *data, quint32 dataLen,
-                bool eof, bool lastInSeq) {
+                bool eof, bool lastInSeq, bool error) {
                     if (recvFileId != fileId) {
                         return;
                     }
 
-                    if (offset != curOffset) {
-                        if (lastInSeq) {
-                            newReqNeeded = true;
-                            loop.exit();
+                    if (error) {
+                        qDebug() << "File" << fileId << "unreadable on the remote end";
+                        failed = true;
+                        loop.exit();
+                        return;
+                    }
+
+                    if (offset >= maxSize) {
+                        dataLen = 0;
+                    } else if (dataLen > maxSize - offset) {
+                        dataLen = maxSize - offset;
+                    }
+
+                    quint32 end = offset + dataLen;
+
+                    if (end > written) {
+                        if (offset <= written) {
+                            quint32 skip = written - offset;
+
+                            if (dest->write((const char *) data + skip, dataLen - skip) < 0) {
+                                failed = true;
+                            }
+
+                            written = end;
+
+                            // Flush whatever was waiting on this
+                            auto i = held.begin();
+
+                            while (i != held.end() && i.key() <= written) {
+                                quint32 heldEnd = i.key() + i.value().size();
+
+                                if (heldEnd > written) {
+                                    if (dest->write(i.value().constData() + (written - i.key()),
+                                            heldEnd - written) < 0) {
+                                        failed = true;
+                                    }
+
+                                    written = heldEnd;
+                                }
+
+                                i = held.erase(i);
+                            }
+                        } else if (!held.contains(offset)) {
+                            held.insert(offset, QByteArray((const char *) data, dataLen));
                         }
+                    }
 
+                    if (eof) {
+                        eofAt = end;
+                    }
+
+                    // The request this reply belongs to
+                    auto req = inFlight.upperBound(offset);
+
+                    if (req == inFlight.begin()) {
                         return;
                     }
 
-                    result->append((const char *) data, dataLen);
+                    --req;
 
-                    curOffset += dataLen;
+                    if (span && (offset >= req.key() + span)) {
+                        // Stray duplicate of a request already retired
+                        return;
+                    }
 
-                    if (eof) {
-                        completed = true;
-                        loop.exit();
-                    } else if (lastInSeq) {
-                        newReqNeeded = true;
-                        loop.exit();
+                    req->received += dataLen;
+
+                    if (!lastInSeq) {
+                        return;
                     }
 
-                    inactivityCount = 0;
-                    failCount = 0;
+                    quint32 reqStart = req.key();
+
+                    if (!span && !eof) {
+                        span = end - reqStart;
 
-                    if (progressCb) {
-                        progressCb(curOffset);
+                        if (nextReq == reqStart) {
+                            nextReq += span;
+                        }
                     }
+
+                    if (req->received < end - reqStart) {
+                        // Lost something in the middle
+                        if (written < end) {
+                            resend.append(qMax(reqStart, written));
+                        }
+                    } else if (!eof && span && (end < reqStart + span)) {
+                        // Short reply; fetch the rest
+                        resend.append(end);
+                    }
+
+                    inFlight.erase(req);
+
+                    loop.exit();
                 }
             );
 
-    while (curOffset < maxSize && (!completed)) {
-        utalk->requestFile(fileId, curOffset);
+    QElapsedTimer progress, gapCheck;
+    quint32 lastWritten = written;
+
+    progress.start();
+    gapCheck.start();
+
+    while (!failed) {
+        if ((written >= maxSize) || ((eofAt >= 0) && (written >= eofAt))) {
+            break;
+        }
+
+        if (written != lastWritten) {
+            lastWritten = written;
+            progress.restart();
+
+            if (progressCb) {
+                progressCb(written);
+            }
+        } else if (progress.elapsed() > FILE_STALL_MS) {
+            qDebug() << "File transfer stalled at" << written;
+            failed = true;
+            break;
+        } else if ((progress.elapsed() > FILE_REQ_TIMEOUT_MS) &&
+                (gapCheck.elapsed() > FILE_REQ_TIMEOUT_MS) &&
+                !inFlight.contains(written)) {
+            // Replies keep coming, but not the one we are waiting on
+            resend.append(written);
+            gapCheck.restart();
+        }
+
+        // Anything past the end is moot
+        if (eofAt >= 0) {
+            while (!inFlight.isEmpty() && (inFlight.lastKey() >= eofAt)) {
+                inFlight.remove(inFlight.lastKey());
+            }
+        }
+
+        for (auto i = inFlight.begin(); i != inFlight.end(); ++i) {
+            if (i->sent.elapsed() > FILE_REQ_TIMEOUT_MS) {
+                if (++i->retries > FILE_MAX_RETRIES) {
+                    qDebug() << "Giving up on file offset" << i.key();
+                    failed = true;
+                    break;
+                }
+
+                i->received = 0;
+                i->sent.start();
+                utalk->requestFile(fileId, i.key());
+            }
+        }
+
+        while (!resend.isEmpty()) {
+            quint32 offset = resend.takeFirst();
+
+            if ((offset < written) || ((eofAt >= 0) && (offset >= eofAt))) {
+                continue;
+            }
+
+            Request &req = inFlight[offset];
+
+            req.received = 0;
+            req.sent.start();
+            utalk->requestFile(fileId, offset);
+        }
 
-        newReqNeeded = false;
-        inactivityCount = 0;
+        // Keep the window full.  Until the first reply says how much a
+        // request fetches there is only the one.
+        int window = span ? FILE_WINDOW : 1;
+
+        while ((inFlight.size() < window) && (eofAt < 0) && (nextReq < maxSize)) {
+            if (!inFlight.contains(nextReq)) {
+                inFlight[nextReq].sent.start();
+                utalk->requestFile(fileId, nextReq);
+            }
 
-        do {
-            if ((inactivityCount++) > 10) {
-                qDebug() << "Retrying file transfer because of inactivity";
-                failCount++;
+            if (!span) {
                 break;
             }
 
-            loop.exec();
+            nextReq += span;
+        }
 
-        } while (curOffset < maxSize && (!completed) && (!newReqNeeded));
+        loop.exec();
 
-        if (failCount > 5) {
-            qDebug() << "Aborting file transfer";
-            delete result;
-            return NULL;
+        if (!self) {
+            return false;
         }
     }
 
-    return result;
+    if (progressCb) {
+        progressCb(written);
+    }
+
+    return !failed;
 }
 
 /**
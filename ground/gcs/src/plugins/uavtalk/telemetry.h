@@ -42,6 +42,7 @@
 #include <QTimer>
 #include <QQueue>
 #include <QMap>
+#include <QIODevice>
 
 class TransactionKey;
 
@@ -86,6 +87,8 @@ public:
     TelemetryStats getStats();
     QByteArray *downloadFile(quint32 fileId, quint32 maxSize,
             std::function<void(quint32)>progressCb = nullptr);
+    bool downloadFile(quint32 fileId, QIODevice *dest, quint32 maxSize,
+            std::function<void(quint32)>progressCb = nullptr);
 
     void transactionTimeout(ObjectTransactionInfo *info);
 
@@ -102,6 +105,14 @@ private:
     static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
 
+    // File transfer: requests kept in flight, how long before one is
+    // resent, how many times, and how long without progress to give up
+    static const int FILE_WINDOW = 8;
+    static const int FILE_TICK_MS = 50;
+    static const int FILE_REQ_TIMEOUT_MS = 750;
+    static const int FILE_MAX_RETRIES = 6;
+    static const int FILE_STALL_MS = 10000;
+
     // Types
     /**
      * Events generated by objects
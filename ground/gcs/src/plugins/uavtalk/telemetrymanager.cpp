@@ -107,3 +107,13 @@ QByteArray *TelemetryManager::downloadFile(quint32 fileId, quint32 maxSize,
 
     return telemetry->downloadFile(fileId, maxSize, progressCb);
 }
+
+bool TelemetryManager::downloadFile(quint32 fileId, QIODevice *dest,
+        quint32 maxSize, std::function<void(quint32)>progressCb)
+{
+    if (!telemetry) {
+        return false;
+    }
+
+    return telemetry->downloadFile(fileId, dest, maxSize, progressCb);
+}
@@ -52,6 +52,8 @@ public:
     bool isConnected() const { return m_connected; }
     QByteArray *downloadFile(quint32 fileId, quint32 maxSize,
         std::function<void(quint32)>progressCb);
+    bool downloadFile(quint32 fileId, QIODevice *dest, quint32 maxSize,
+        std::function<void(quint32)>progressCb);
 
 signals:
     void connected();
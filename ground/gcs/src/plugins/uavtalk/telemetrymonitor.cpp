@@ -621,6 +621,10 @@ void TelemetryMonitor::processStatsUpdates()
     gcsStats.TxFailures += telStats.txErrors;
     gcsStats.TxRetries += telStats.txRetries;
 
+    // Tell the flight side which newer frame types UAVTalk parses
+    gcsStats.Features[GCSTelemetryStats::FEATURES_BATCHFRAMES] = GCSTelemetryStats::FEATURES_TRUE;
+    gcsStats.Features[GCSTelemetryStats::FEATURES_DELTAFRAMES] = GCSTelemetryStats::FEATURES_TRUE;
+
     // Check for a connection timeout
     bool connectionTimeout;
     if (telStats.rxObjects > 0) {
@@ -75,8 +75,8 @@ UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr)
 
     this->objMngr = objMngr;
 
-    startOffset = 0;
-    filledBytes = 0;
+    rxHead = 0;
+    rxTail = 0;
 
     memset(&stats, 0, sizeof(ComStats));
 
@@ -108,30 +108,48 @@ UAVTalk::ComStats UAVTalk::getStats()
 void UAVTalk::processInputStream()
 {
     while (io && io->isReadable()) {
-        if (startOffset > (sizeof(rxBuffer) - MAX_PACKET_LENGTH)) {
-            /* If we're not sure there's room for a frame, shift things left in
-             * the buffer so that we can do a bigger read.
-             */
-            memmove(rxBuffer, rxBuffer + startOffset, filledBytes - startOffset);
-
-            filledBytes -= startOffset;
-            startOffset = 0;
-        }
+        /* processInput() consumes everything but a partial frame, so there
+         * is always most of the ring free.  Read up to the end of it; the
+         * next pass picks up from the start.
+         */
+        quint32 pos = rxHead & RX_RING_MASK;
+        quint32 space = RX_RING_SIZE - (rxHead - rxTail);
 
-        int bytes = io->read((char *) (rxBuffer + filledBytes),
-                sizeof(rxBuffer) - filledBytes);
+        int bytes = io->read((char *) (rxRing + pos),
+                qMin(space, RX_RING_SIZE - pos));
 
         if (bytes <= 0) {
-            return;
+            break;
         }
 
-        filledBytes += bytes;
+        rxHead += bytes;
         stats.rxBytes += bytes;
 
         while (processInput());
     }
 }
 
+/**
+ * Get contiguous access to the next bytes of input.
+ * \param[in] length Number of bytes needed; must be available
+ * \return Pointer into the ring, or to a copy if the bytes wrap around
+ */
+quint8 *UAVTalk::rxPeek(quint32 length)
+{
+    quint32 pos = rxTail & RX_RING_MASK;
+
+    if (pos + length <= RX_RING_SIZE) {
+        return rxRing + pos;
+    }
+
+    quint32 first = RX_RING_SIZE - pos;
+
+    memcpy(rxFrame, rxRing + pos, first);
+    memcpy(rxFrame + first, rxRing, length - first);
+
+    return rxFrame;
+}
+
 /**
  * Request an update for the specified object, on success the object data would have been
  * updated by the GCS.
@@ -201,7 +219,78 @@ bool UAVTalk::receiveFileChunk(quint32 fileId, quint8 *data, quint32 length)
 
     emit fileDataReceived(fileId, hdr->offset, data, length,
             !!(hdr->flags & FILEDATA_FLAG_EOF),
-            !!(hdr->flags & FILEDATA_FLAG_LAST));
+            !!(hdr->flags & FILEDATA_FLAG_LAST),
+            !!(hdr->flags & FILEDATA_FLAG_ERROR));
+
+    return true;
+}
+
+/**
+ * Processes a frame carrying a batch of objects.  Records for objects we
+ * don't know, or of the wrong size, are skipped.
+ * \param data Buffer to the first record
+ * \param length Number of bytes of records
+ */
+bool UAVTalk::receiveBatch(quint8 *data, quint32 length)
+{
+    while (length >= sizeof(UAVTalkBatchRecord)) {
+        UAVTalkBatchRecord *rec = (UAVTalkBatchRecord *)data;
+
+        quint32 objId = qFromLittleEndian(rec->objId);
+        quint32 recordBytes = rec->length;
+
+        data += sizeof(*rec);
+        length -= sizeof(*rec);
+
+        if (recordBytes > length) {
+            break;
+        }
+
+        quint8 *payload = data;
+
+        data += recordBytes;
+        length -= recordBytes;
+
+        UAVObject *rxObj = objMngr->getObject(objId);
+
+        if (rxObj == Q_NULLPTR) {
+            stats.rxErrors++;
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: unknown object in batch");
+
+            continue;
+        }
+
+        quint16 rxInstId = 0;
+
+        if (!rxObj->isSingleInstance()) {
+            if (recordBytes < 2) {
+                stats.rxErrors++;
+
+                continue;
+            }
+
+            rxInstId = *(payload++);
+            rxInstId |= *(payload++) << 8;
+
+            recordBytes -= 2;
+        }
+
+        if (recordBytes != rxObj->getNumBytes()) {
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Unexpected payload size for obj in batch");
+            stats.rxErrors++;
+
+            continue;
+        }
+
+        receiveObject(TYPE_OBJ, rxObj, rxInstId, payload, recordBytes);
+        stats.rxObjectBytes += recordBytes;
+        stats.rxObjects++;
+    }
+
+    if (length != 0) {
+        UAVTALK_QXTLOG_DEBUG("UAVTalk: Truncated batch");
+        stats.rxErrors++;
+    }
 
     return true;
 }
@@ -213,67 +302,75 @@ bool UAVTalk::receiveFileChunk(quint32 fileId, quint8 *data, quint32 length)
  */
 bool UAVTalk::processInput()
 {
-    unsigned int bytesAvail = filledBytes - startOffset;
+    unsigned int bytesAvail = rxHead - rxTail;
 
     if (bytesAvail < sizeof(UAVTalkHeader)) {
         return false;
     }
 
-    UAVTalkHeader *hdr = (UAVTalkHeader *) (rxBuffer + startOffset);
-
-    /* Basic framing checks.  If these fail, skip forward one byte and retry
-     * to capture stream sync.
-     */
-    if (hdr->sync != SYNC_VAL) {
-        startOffset++;
+    /* Cheap resync before looking at anything else */
+    if (rxRing[rxTail & RX_RING_MASK] != SYNC_VAL) {
+        rxTail++;
         stats.rxErrors++;
 
         return true;
     }
 
+    UAVTalkHeader *hdr = (UAVTalkHeader *) rxPeek(sizeof(UAVTalkHeader));
+
+    /* Basic framing checks.  If these fail, skip forward one byte and retry
+     * to capture stream sync.
+     */
     if ((hdr->type & VER_MASK) != TYPE_VER) {
-        startOffset++;
+        rxTail++;
         stats.rxErrors++;
 
         return true;
     }
 
-    if (hdr->size < sizeof(UAVTalkHeader)) {
-        startOffset++;
+    /* The frame plus its CRC must fit rxFrame, and the ring */
+    if (hdr->size < sizeof(UAVTalkHeader) || hdr->size + 1u > MAX_PACKET_LENGTH) {
+        rxTail++;
         stats.rxErrors++;
 
         return true;
     }
 
-    /* OK, let's ensure we have enough bytes for the whole frame. 
+    /* OK, let's ensure we have enough bytes for the whole frame.
      * Size doesn't include CRC, so add one.
      */
 
-    if ((hdr->size + 1u) > bytesAvail) {
+    quint32 frameBytes = hdr->size + 1u;
+
+    if (frameBytes > bytesAvail) {
         return false;
     }
 
-    quint8 ourCrc = updateCRC(0, rxBuffer + startOffset, hdr->size);
-    quint8 *theirCrc = rxBuffer + startOffset + hdr->size;
+    quint8 *frame = rxPeek(frameBytes);
+    hdr = (UAVTalkHeader *) frame;
+
+    quint8 ourCrc = updateCRC(0, frame, hdr->size);
+    quint8 *theirCrc = frame + hdr->size;
 
     if (ourCrc != *theirCrc) {
         /* Since we can't trust hdr->size for sure, we should just skip
          * forward one byte.
          */
 
-        startOffset++;
+        rxTail++;
         stats.rxErrors++;
 
         return true;
     }
 
-    quint8 *payload = rxBuffer + startOffset + sizeof(*hdr);
+    quint8 *payload = frame + sizeof(*hdr);
     unsigned int payloadBytes = hdr->size - sizeof(*hdr);
 
-    /* At this point, we'll advance startOffset for the entire length of
-     * frame, and not touch startOffset again this function!
+    /* At this point, we'll advance rxTail for the entire length of
+     * frame, and not touch rxTail again this function!  The frame stays
+     * valid until the next read, which is after we are done with it.
      */
-    startOffset += hdr->size + 1;
+    rxTail += frameBytes;
 
     /* OK, we have a complete frame as encoded on the wire.  Time to do things
      * with it.
@@ -286,6 +383,10 @@ bool UAVTalk::processInput()
         return receiveFileChunk(rxObjId, payload, payloadBytes);
     }
 
+    if (rxType == TYPE_OBJ_BATCH) {
+        return receiveBatch(payload, payloadBytes);
+    }
+
     UAVObject *rxObj = objMngr->getObject(rxObjId);
 
     if (rxObj == Q_NULLPTR) {
@@ -312,7 +413,9 @@ bool UAVTalk::processInput()
     /* XXX timestamps */
 
     // Check data length
-    if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
+    if (rxType == TYPE_OBJ_DELTA) {
+        // Variable size, checked when applied
+    } else if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
         if (payloadBytes != 0) {
             UAVTALK_QXTLOG_DEBUG("UAVTalk: Unexpected data in req/ack/nack");
             stats.rxErrors++;
@@ -328,7 +431,7 @@ bool UAVTalk::processInput()
         }
     }
 
-    receiveObject(rxType, rxObjId, rxInstId, payload, payloadBytes);
+    receiveObject(rxType, rxObj, rxInstId, payload, payloadBytes);
     stats.rxObjectBytes += payloadBytes;
     stats.rxObjects++;
 
@@ -340,19 +443,19 @@ bool UAVTalk::processInput()
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] type Type of received message (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK,
  * TYPE_NACK)
- * \param[in] obj Handle of the received object
+ * \param[in] typeObj Instance 0 of the received object type
  * \param[in] instId The instance ID of UAVOBJ_ALL_INSTANCES for all instances.
  * \param[in] data Data buffer
  * \param[in] length Buffer length
  * \return Success (true), Failure (false)
  */
-bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
+bool UAVTalk::receiveObject(quint8 type, UAVObject *typeObj, quint16 instId,
         quint8 *data, quint32 length)
 {
-    Q_UNUSED(length);
     UAVObject *obj = Q_NULLPTR;
     bool error = false;
     bool allInstances = (instId == ALL_INSTANCES);
+    quint32 objId = typeObj->getObjID();
 
     // Process message type
     switch (type) {
@@ -360,7 +463,7 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         // All instances, not allowed for OBJ messages
         if (!allInstances) {
             // Get object and update its data
-            obj = updateObject(objId, instId, data);
+            obj = updateObject(typeObj, instId, data);
             if (obj == Q_NULLPTR) {
                 UAVTALK_QXTLOG_DEBUG(
                     QString("[uavtalk.cpp  ] Received a UAVObject update for a UAVObject we don't "
@@ -377,7 +480,7 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         // All instances, not allowed for OBJ_ACK messages
         if (!allInstances) {
             // Get object and update its data
-            obj = updateObject(objId, instId, data);
+            obj = updateObject(typeObj, instId, data);
             // Transmit ACK
             if (obj != Q_NULLPTR) {
                 transmitObject(obj, TYPE_ACK, false);
@@ -394,10 +497,25 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
             error = true;
         }
         break;
+    case TYPE_OBJ_DELTA: // We have received the changes to an object
+        if (!allInstances) {
+            obj = updateObjectDelta(typeObj, instId, data, length);
+            if (obj == Q_NULLPTR) {
+                // Usually just a missed keyframe; the next one resyncs
+                UAVTALK_QXTLOG_DEBUG(
+                    QString("[uavtalk.cpp  ] Could not apply delta OBJID:%0 INSTID:%1")
+                        .arg(QString(QString("0x") + QString::number(objId, 16).toUpper()))
+                        .arg(instId));
+                error = true;
+            }
+        } else {
+            error = true;
+        }
+        break;
     case TYPE_OBJ_REQ: // We are being asked for an object
         // Get object, if all instances are requested get instance 0 of the object
-        if (allInstances) {
-            obj = objMngr->getObject(objId);
+        if (allInstances || instId == 0) {
+            obj = typeObj;
         } else {
             obj = objMngr->getObject(objId, instId);
         }
@@ -467,19 +585,19 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
  * If the object instance could not be found in the list, then a
  * new one is created.
  */
-UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
+UAVObject *UAVTalk::updateObject(UAVObject *typeObj, quint16 instId, quint8 *data)
 {
     // Get object
-    UAVObject *obj = objMngr->getObject(objId, instId);
+    UAVObject *obj = typeObj;
+
+    if (instId != 0) {
+        obj = objMngr->getObject(typeObj->getObjID(), instId);
+    }
+
     // If the instance does not exist create it
     if (obj == Q_NULLPTR) {
-        // Get the object type
-        UAVObject *tobj = objMngr->getObject(objId);
-        if (tobj == Q_NULLPTR) {
-            return Q_NULLPTR;
-        }
         // Make sure this is a data object
-        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(tobj);
+        UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(typeObj);
         if (dobj == Q_NULLPTR) {
             return Q_NULLPTR;
         }
@@ -488,13 +606,46 @@ UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
         if (!objMngr->registerObject(instobj)) {
             return Q_NULLPTR;
         }
-        instobj->unpack(data);
-        return instobj;
-    } else {
-        // Unpack data into object instance
-        obj->unpack(data);
-        return obj;
+        obj = instobj;
+    }
+
+    // Unpack data into object instance
+    obj->unpack(data);
+
+    return obj;
+}
+
+/**
+ * Update the data of an object from a delta frame: the CRC-16 of the
+ * keyframe it applies to, followed by the delta proper (see
+ * UAVObject::unpackDelta).  Unlike updateObject(), the instance must
+ * already exist, since the keyframe created it.
+ */
+UAVObject *UAVTalk::updateObjectDelta(UAVObject *typeObj, quint16 instId, quint8 *data,
+                                      quint32 length)
+{
+    UAVObject *obj = typeObj;
+
+    if (instId != 0) {
+        obj = objMngr->getObject(typeObj->getObjID(), instId);
+    }
+
+    if (obj == Q_NULLPTR || length < DELTA_CRC_LENGTH) {
+        return Q_NULLPTR;
+    }
+
+    const QByteArray &ref = obj->getDeltaReference();
+    quint16 refCRC = data[0] | (data[1] << 8);
+
+    if (updateCRC16(0, (const quint8 *)ref.constData(), ref.size()) != refCRC) {
+        return Q_NULLPTR;
+    }
+
+    if (obj->unpackDelta(data + DELTA_CRC_LENGTH, length - DELTA_CRC_LENGTH) < 0) {
+        return Q_NULLPTR;
     }
+
+    return obj;
 }
 
 /**
@@ -694,3 +845,23 @@ quint8 UAVTalk::updateCRC(quint8 crc, const quint8 *data, qint32 length)
         crc = crc_table[crc ^ *data++];
     return crc;
 }
+
+/**
+ * Update a CRC-16-CCITT (poly 0x1021, not reflected) with new data, as
+ * PIOS_CRC16_CCITT_updateCRC() does on the flight side.  Used to name the
+ * keyframe a delta frame applies to.
+ *
+ * \param crc      The current crc value.
+ * \param data     Pointer to a buffer of \a data_len bytes.
+ * \param length   Number of bytes in the \a data buffer.
+ * \return         The updated crc value.
+ */
+quint16 UAVTalk::updateCRC16(quint16 crc, const quint8 *data, qint32 length)
+{
+    while (length--) {
+        crc ^= (quint16)(*data++) << 8;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+}
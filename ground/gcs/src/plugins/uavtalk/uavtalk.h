@@ -78,7 +78,7 @@ signals:
 
     // Or when we get some file data
     void fileDataReceived(quint32 fileId, quint32 offset, quint8 *data,
-            quint32 dataLen, bool eof, bool lastInSeq);
+            quint32 dataLen, bool eof, bool lastInSeq, bool error);
 
 private slots:
     void processInputStream(void);
@@ -96,11 +96,14 @@ protected:
     static const int TYPE_NACK = 0x04;
     static const int TYPE_FILEREQ = 0x08;
     static const int TYPE_FILEDATA = 0x09;
+    static const int TYPE_OBJ_BATCH = 0x0A;
+    static const int TYPE_OBJ_DELTA = 0x0B;
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = MIN_HEADER_LENGTH + 2; // instance ID(2, not used in single objs)
 
     static const int CHECKSUM_LENGTH = 1;
+    static const int DELTA_CRC_LENGTH = 2; // keyframe check at the start of a delta
 
     static const int MAX_PACKET_LENGTH = 256;
 
@@ -110,6 +113,11 @@ protected:
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BACKLOG_SIZE = 2 * 1024;
+
+    // Must be a power of two, and hold several frames so that a read is
+    // rarely limited by the space left.
+    static const quint32 RX_RING_SIZE = MAX_PACKET_LENGTH * 16;
+    static const quint32 RX_RING_MASK = RX_RING_SIZE - 1;
     static const quint8 crc_table[256];
 
 #pragma pack(push)
@@ -127,36 +135,52 @@ protected:
         quint8 flags;
     };
 
+    // Precedes each object in a TYPE_OBJ_BATCH frame; length counts the
+    // instance ID (multi-instance objects only) and data that follow.
+    struct UAVTalkBatchRecord {
+        quint32 objId;
+        quint8 length;
+    };
+
     static const quint8 FILEDATA_FLAG_EOF = 0x01;
     static const quint8 FILEDATA_FLAG_LAST = 0x02;
+    static const quint8 FILEDATA_FLAG_ERROR = 0x04;
 #pragma pack(pop)
 
     // Variables
     QPointer<QIODevice> io;
     UAVObjectManager *objMngr;
 
-    // This is a tradeoff between the frequency of the need to
-    // compact/copy left and buffer size.
-    quint8 rxBuffer[MAX_PACKET_LENGTH * 12];
+    // Received bytes are read straight into a ring and frames are parsed
+    // where they lie.  Only a frame that straddles the end of the ring is
+    // copied, into rxFrame.
+    quint8 rxRing[RX_RING_SIZE];
+    quint8 rxFrame[MAX_PACKET_LENGTH];
     quint8 txBuffer[MAX_PACKET_LENGTH];
 
-    // Variables used by the receive state machine
+    // Variables used by the receive state machine.  Both count bytes since
+    // the start and wrap freely; the difference is the fill level.
 
-    quint32 startOffset;
-    quint32 filledBytes;
+    quint32 rxHead;
+    quint32 rxTail;
 
     ComStats stats;
 
     // Methods
     bool objectTransaction(UAVObject *obj, quint8 type, bool allInstances);
-    bool receiveObject(quint8 type, quint32 objId, quint16 instId,
+    quint8 *rxPeek(quint32 length);
+    bool receiveObject(quint8 type, UAVObject *typeObj, quint16 instId,
             quint8 *data, quint32 length);
     bool receiveFileChunk(quint32 fileId, quint8 *data, quint32 length);
-    UAVObject *updateObject(quint32 objId, quint16 instId, quint8 *data);
+    bool receiveBatch(quint8 *data, quint32 length);
+    UAVObject *updateObject(UAVObject *typeObj, quint16 instId, quint8 *data);
+    UAVObject *updateObjectDelta(UAVObject *typeObj, quint16 instId, quint8 *data,
+                                 quint32 length);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject *obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject *obj, quint8 type, bool allInstances);
     quint8 updateCRC(quint8 crc, const quint8 *data, qint32 length);
+    quint16 updateCRC16(quint16 crc, const quint8 *data, qint32 length);
     bool transmitFrame(quint32 length, bool incrTxObj = true);
 };
 
@@ -26,6 +26,9 @@
 # Flags passed to the preprocessor.
 CPPFLAGS += -I$(GTEST_DIR)/include
 
+# Helpers shared between the unit tests
+CPPFLAGS += -I$(TOP)/flight/tests/inc
+
 # Flags passed to the C++ compiler.
 CXXFLAGS += -g -Wall -Wextra -Wno-missing-field-initializers
 
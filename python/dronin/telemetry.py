@@ -166,8 +166,14 @@ class TelemetryBase(with_metaclass(ABCMeta)):
                 break
 
     def __make_handshake(self, handshake):
+        kwargs = {}
+
+        # Batch and delta frames are parsed; older definitions can't say so
+        if hasattr(self.GCSTelemetryStats, 'ENUM_Features'):
+            kwargs['Features'] = (self.GCSTelemetryStats.ENUM_Features['TRUE'],) * 2
+
         return self.GCSTelemetryStats._make_to_send(
-                Status=self.GCSTelemetryStats.ENUM_Status[handshake])
+                Status=self.GCSTelemetryStats.ENUM_Status[handshake], **kwargs)
 
     def __remove_from_ack_set(self, obj):
         with self.ack_cond:
@@ -52,13 +52,44 @@ class UAVTupleClass():
         return cls._packstruct.size
 
     @classmethod
-    def from_bytes(cls, data, timestamp, instance_id, offset=0):
+    def apply_delta(cls, reference, data, offset=0):
+        """ Rebuilds the serialized object from a delta update.
+
+         - reference: the serialized object the delta applies to
+         - data: holds the delta; a bitmap with one bit per 4-byte word,
+           followed by the words whose bit is set
+         - offset: an optional index into data where the delta begins
+        """
+        size = cls._packstruct.size
+        words = (size + 3) // 4
+
+        bitmap = bytearray(data[offset:offset + (words + 7) // 8])
+        pos = offset + len(bitmap)
+
+        out = bytearray(reference)
+
+        for i in range(words):
+            if bitmap[i // 8] & (1 << (i % 8)):
+                n = min(4, size - 4 * i)
+                out[4 * i:4 * i + n] = data[pos:pos + n]
+                pos += n
+
+        return bytes(out)
+
+    @classmethod
+    def from_bytes(cls, data, timestamp, instance_id, offset=0, reference=None):
         """ Deserializes and creates an instance of this object.
 
          - data: the data to deserialize
          - timestamp: the timestamp to put on the object instance
          - offset: an optional index into data where to begin deserialization
+         - reference: if given, data holds a delta update against this
+           serialized copy of the object (see apply_delta)
         """
+        if reference is not None:
+            data = cls.apply_delta(reference, data, offset)
+            offset = 0
+
         unpack_field_values = cls._packstruct.unpack_from(data, offset)
 
         field_values = []
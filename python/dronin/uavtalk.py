@@ -26,7 +26,7 @@ from six import int2byte, indexbytes, byte2int, iterbytes
 (SYNC_VAL) = (0x3C)
 (TYPE_MASK, TYPE_VER) = (0x70, 0x20)
 (TIMESTAMPED) = (0x80)
-(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_FILEREQ, TYPE_FILEDATA, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS, ) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x08, 0x09, 0x80, 0x82)
+(TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_FILEREQ, TYPE_FILEDATA, TYPE_OBJ_BATCH, TYPE_OBJ_DELTA, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS, ) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x08, 0x09, 0x0A, 0x0B, 0x80, 0x82)
 (FILEDATA_EOF, FILEDATA_LAST) = (0x01, 0x02)
 
 # Serialization of header elements
@@ -38,6 +38,10 @@ timestamp_fmt = Struct("<H")
 instance_fmt = Struct("<H")
 filereq_fmt = Struct("<LH")
 fileresp_fmt = Struct("<LB")
+# objid(4) + len(1), followed by instance id (multi-instance only) and data
+batchrec_fmt = Struct("<LB")
+# CRC-16 of the keyframe a delta applies to
+delta_crc_fmt = Struct("<H")
 
 # CRC lookup table
 crc_table = [
@@ -81,6 +85,9 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
     pending_pieces = []
 
+    # Last full copy of each object instance, which deltas apply to
+    delta_refs = {}
+
     while True:
         # If we don't have sufficient data buffered, join up any chunks we've
         # been given to ensure pending_pieces is empty for the rest of this loop.
@@ -183,6 +190,12 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
         if (pack_type == TYPE_OBJ_REQ) or (pack_type == TYPE_ACK) or (pack_type == TYPE_NACK):
             obj_len = 0
             timestamp_len = 0
+        elif pack_type == TYPE_OBJ_DELTA:
+            # variable length: keyframe CRC-16, bitmap, changed words
+            timestamp_len = 0
+            obj_len = pack_len - header_fmt.size
+            if obj is not None and not obj._single:
+                obj_len -= instance_fmt.size
         else:
             if obj is not None:
                 timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
@@ -271,7 +284,23 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
         data_offset = header_fmt.size + instance_len + timestamp_len + buf_offset
 
-        if (obj_len > 0) and (obj is not None):
+        if (pack_type == TYPE_OBJ_DELTA) and (obj is not None):
+            # Starts with the CRC-16 of the keyframe it applies to
+            ref = delta_refs.get((objId, instance_id))
+
+            if (ref is not None) and (obj_len >= delta_crc_fmt.size) and \
+                    (calcCRC16(ref) == delta_crc_fmt.unpack_from(buf, data_offset)[0]):
+                objInstance = obj.from_bytes(buf, timestamp, instance_id,
+                        offset=data_offset + delta_crc_fmt.size, reference=ref)
+                received += 1
+
+                next_recv = yield objInstance
+            else:
+                # Keyframe missed; nothing to apply this to
+                next_recv = None
+        elif (obj_len > 0) and (obj is not None):
+            delta_refs[(objId, instance_id)] = buf[data_offset:data_offset + obj_len]
+
             objInstance = obj.from_bytes(buf, timestamp, instance_id,
                     offset=data_offset)
             received += 1
@@ -284,6 +313,45 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
         else:
             next_recv = None
 
+        if pack_type == TYPE_OBJ_BATCH:
+            # Several objects in one frame; hand them out one at a time
+            rec_offset = data_offset
+            rec_end = data_offset + obj_len
+
+            while rec_offset + batchrec_fmt.size <= rec_end:
+                (rec_id, rec_len) = batchrec_fmt.unpack_from(buf, rec_offset)
+                rec_offset += batchrec_fmt.size
+
+                if rec_offset + rec_len > rec_end:
+                    print("truncated batch")
+                    break
+
+                rec_obj = uavo_defs.get('{0:08x}'.format(rec_id))
+
+                if rec_obj is not None:
+                    rec_inst_len = 0 if rec_obj._single else instance_fmt.size
+
+                    if rec_len == rec_inst_len + rec_obj.get_size_of_data():
+                        if rec_inst_len:
+                            rec_inst_id = instance_fmt.unpack_from(buf, rec_offset)[0]
+                        else:
+                            rec_inst_id = None
+
+                        # Full copies are delta references too
+                        delta_refs[(rec_id, rec_inst_id)] = \
+                                buf[rec_offset + rec_inst_len:rec_offset + rec_len]
+
+                        objInstance = rec_obj.from_bytes(buf, timestamp,
+                                rec_inst_id, offset=rec_offset + rec_inst_len)
+                        received += 1
+
+                        rec_recv = yield objInstance
+
+                        if rec_recv is not None and rec_recv != '':
+                            pending_pieces.append(rec_recv)
+
+                rec_offset += rec_len
+
         if (obj is not None) and (pack_type == TYPE_ACK):
             if ack_callback is not None:
                 ack_callback(obj)
@@ -384,3 +452,19 @@ def calcCRC(s):
         cs = crc_table[cs ^ c]
 
     return cs
+
+def calcCRC16(s):
+    """
+    Calculate a CRC-16-CCITT as PIOS_CRC16_CCITT_updateCRC does on the
+    firmware side; it names the keyframe a delta applies to
+    """
+
+    cs = 0
+
+    for c in iterbytes(s):
+        cs ^= c << 8
+        for _ in range(8):
+            cs = ((cs << 1) ^ 0x1021) if cs & 0x8000 else (cs << 1)
+        cs &= 0xFFFF
+
+    return cs